@@ -3,12 +3,15 @@
 // Andrei Gaponenko, 2012
 //
 // Modifed by Brian Pollack to use shared_ptrs to BFMaps for consistent use across classes.
+//
+// Rewritten to be safe to share between threads: the map for a point is found
+// through a spatial index that is built once, in setMaps, and never modified
+// afterwards.  The only state that changes during lookups is a per-thread hint
+// and the per-thread lookup statistics.
 
 #ifndef BFCacheManager_hh
 #define BFCacheManager_hh
 
-#include <cassert>
-#include <map>
 #include <memory>
 #include <vector>
 
@@ -26,45 +29,18 @@ namespace mu2e {
     // then the "Outer" map list will be consulted in order, and the first map
     // that contains the point will be used.
     //
+    // The bounding boxes of all maps are binned on a uniform 3D grid.  Each bin holds
+    // the list of maps whose box touches the bin: inner maps first, then outer maps
+    // in the user-specified order.  A lookup computes the bin of the point and returns
+    // the first map in its list that contains the point, which gives the same answer
+    // as the rule above.  Because inner maps do not overlap, the last inner map used by
+    // each thread is tried before the bin lookup.
+    //
+    // Once setMaps has been called an instance may be used concurrently from any
+    // number of threads without locking.
 
     class BFCacheManager {
-        // typedef std::vector<const BFMap*> SequenceType;
-        // typedef std::vector<std::shared_ptr<const BFMap>> SequenceType;
         typedef std::vector<std::shared_ptr<BFMap>> MapContainerType;
-        struct MapList : public MapContainerType {
-            // return the first matching map or 0
-            std::shared_ptr<const BFMap> findMap(const CLHEP::Hep3Vector& x) const {
-                for (MapContainerType::const_iterator i = begin(); i != end(); ++i) {
-                    if ((*i)->isValid(x)) {
-                        return *i;
-                    }
-                }
-                return 0;
-            }
-        };
-
-        // An instance per (any) map, allows to optimize the lookup order of "inner" maps
-        struct CacheElement {
-            std::shared_ptr<const BFMap> myMap;  // the map this instance is attached to
-            // A list of "inner" maps optimized for the "my" map
-            // If "my" map is an inner map, it is not in the list.
-            MapList inner;
-
-            CacheElement(std::shared_ptr<const BFMap> my, const MapList& in)
-                : myMap(my), inner(in) {}
-        };
-
-        // Inner map lists optimized for the last used map
-        mutable const CacheElement* innerForLastInner;
-        mutable const CacheElement* innerForLastOuter;  // never null
-
-        // Outer maps in the user-specified order
-        MapList outer;
-
-        typedef std::map<std::shared_ptr<const BFMap>, CacheElement> CacheType;
-        CacheType innerCache;  // keys are all inner maps
-        CacheType outerCache;  // keys are outer maps and 0
-        int counter;
 
        public:
         BFCacheManager();
@@ -73,50 +49,51 @@ namespace mu2e {
 
         // Returns pointers to an appropriate field map, or 0.
         std::shared_ptr<const BFMap> findMap(const CLHEP::Hep3Vector& x) const {
-            // First try to find if the point belong to any of the inner maps
-
-            if (innerForLastInner) {  // we were in an inner map last time
-
-                if (innerForLastInner->myMap->isValid(x)) {
-                    // Cache update not needed, we are still in the same inner map
-                    return innerForLastInner->myMap;
-                }
-
-                // The lookup order here is optimized
-                std::shared_ptr<const BFMap> newinner = innerForLastInner->inner.findMap(x);
-                if (newinner) {  // Update cache
-                    CacheType::const_iterator p = innerCache.find(newinner);
-                    assert(p != innerCache.end());
-                    innerForLastInner = &p->second;
-                    return newinner;
-                }
-            } else {  // We were not in an inner map last time
-
-                // innerForLastOuter is never null
-                std::shared_ptr<const BFMap> newinner = innerForLastOuter->inner.findMap(x);
-                if (newinner) {  // Update cache
-                    CacheType::const_iterator p = innerCache.find(newinner);
-                    assert(p != innerCache.end());
-                    innerForLastInner = &p->second;
-                    return newinner;
-                }
-            }
-
-            // The current point is not in any of the inner maps
-            innerForLastInner = 0;
-
-            // The lookup order of the outer maps is always the same
-            std::shared_ptr<const BFMap> newouter = outer.findMap(x);
-
-            // Keep the inner map lookup optimized
-            if (innerForLastOuter->myMap != newouter) {
-                CacheType::const_iterator p = outerCache.find(newouter);
-                assert(p != outerCache.end());
-                innerForLastOuter = &p->second;
-            }
-
-            return newouter;
+            int i = findMapIndex(x);
+            return (i < 0) ? std::shared_ptr<const BFMap>() : maps_[i];
         }
+
+        // As above but without touching the shared_ptr reference count, which is a
+        // shared cache line when many threads look up the field.
+        const BFMap* findMapPtr(const CLHEP::Hep3Vector& x) const {
+            int i = findMapIndex(x);
+            return (i < 0) ? nullptr : rawMaps_[i];
+        }
+
+        // Counts of the lookups made by one thread, summed over all instances.
+        struct Statistics {
+            unsigned long long lookups = 0;        // calls to findMap or findMapPtr
+            unsigned long long hintHits = 0;       // answered by the last inner map used
+            unsigned long long binSearches = 0;    // answered, or not, by the spatial index
+            unsigned long long validityChecks = 0; // BFMap::isValid calls, including the hint
+            unsigned long long misses = 0;         // no map contains the point
+        };
+
+        // Statistics of the calling thread since it started or since the last reset.
+        static Statistics threadStatistics();
+        static void resetThreadStatistics();
+
+       private:
+        // Index into maps_ of the map to use at x, or -1.
+        int findMapIndex(const CLHEP::Hep3Vector& x) const;
+
+        // All maps, inner maps first then outer maps in the user-specified order.
+        std::vector<std::shared_ptr<const BFMap>> maps_;
+        std::vector<const BFMap*> rawMaps_;
+        unsigned ninner_;
+
+        // The uniform grid of bins covering the union of all map bounding boxes.
+        double xmin_, ymin_, zmin_;
+        double xbinInv_, ybinInv_, zbinInv_;
+        int nbx_, nby_, nbz_;
+
+        // Compressed lists of candidate maps: the maps for bin b are
+        // binMaps_[binStart_[b]] ... binMaps_[binStart_[b+1]-1].
+        std::vector<unsigned> binStart_;
+        std::vector<unsigned short> binMaps_;
+
+        // Identifies the map set for the per-thread hint; unique per call to setMaps.
+        unsigned id_;
     };
 }  // namespace mu2e
 
@@ -15,10 +15,14 @@
 //
 
 //#include <iosfwd>
+#include <cstddef>
+#include <memory>
 #include <ostream>
 #include <string>
+#include <vector>
 #include "BFieldGeom/inc/BFInterpolationStyle.hh"
 #include "BFieldGeom/inc/BFMap.hh"
+#include "BFieldGeom/inc/BFMapFile.hh"
 #include "BFieldGeom/inc/BFMapType.hh"
 #include "BFieldGeom/inc/Container3D.hh"
 #include "CLHEP/Vector/ThreeVector.h"
@@ -68,16 +72,53 @@ namespace mu2e {
               _field(_nx, _ny, _nz),
               _isDefined(_nx, _ny, _nz, false),
               _allDefined(false),
+              _batchField{},
               _interpStyle(style){};
 
+        // A map that uses the field values of a mapped file in place; the grid
+        // description comes from the file header.
+        BFGridMap(std::string filename,
+                  std::shared_ptr<const BFMapFile> file,
+                  BFMapType::enum_type atype,
+                  double scale,
+                  BFInterpolationStyle style,
+                  bool warnIfOutside = false);
+
         ~BFGridMap(){};
 
         virtual bool getBFieldWithStatus(const CLHEP::Hep3Vector&, CLHEP::Hep3Vector&) const;
 
+        // Field and its derivatives from one visit to the grid cell.  The derivatives are
+        // those of the interpolating polynomial, so they are exact for the interpolated
+        // field; the field is bit-identical to getBFieldWithStatus.
+        virtual bool getBFieldWithGradient(const CLHEP::Hep3Vector&,
+                                           CLHEP::Hep3Vector&,
+                                           double grad[3][3]) const;
+
+        // Evaluate the field at npoints points in one call.  The results, including the
+        // status flags, are bit-identical to calling getBFieldWithStatus point by point.
+        // Points are processed 8 (AVX-512) or 4 (AVX2) at a time when the cpu supports it,
+        // with a scalar loop for the remainder.  Requires fillBatchStore() to have been called.
+        void getBFieldBatch(const CLHEP::Hep3Vector* points,
+                            CLHEP::Hep3Vector* fields,
+                            bool* status,
+                            std::size_t npoints) const;
+
+        // Build the structure-of-arrays copy of the field used by getBFieldBatch and
+        // release _field; from then on all lookups use the structure-of-arrays copy.
+        // Nothing to do for maps that use a mapped file.
+        void fillBatchStore();
+        bool hasBatchStore() const { return _batchField[0] != nullptr; }
+
+        // True if this map reads its field values from a mapped file.
+        bool isMapped() const { return bool(_mappedFile); }
+
         // Validity checker
         virtual bool isValid(const CLHEP::Hep3Vector& point) const;
+        // Uses the grid dimensions, so it also works after _field has been released
+        // or for maps that use a mapped file.
         bool isValid(const GridPoint& ipoint) const {
-            return _field.isValid(ipoint.ix, ipoint.iy, ipoint.iz);
+            return ipoint.ix < _nx && ipoint.iy < _ny && ipoint.iz < _nz;
         }
 
         // Some extra checks for GMC format maps.
@@ -121,6 +162,14 @@ namespace mu2e {
         // If all grid points are valid then _isDefined is not needed.
         bool _allDefined;
 
+        // Structure-of-arrays copy of _field, one array per component, same index
+        // order as Container3D.  Padded at the end so that the upper corners of the
+        // last cell can always be read.  _batchField points either to these arrays
+        // or into _mappedFile.
+        std::vector<double> _fieldX, _fieldY, _fieldZ;
+        const double* _batchField[3];
+        std::shared_ptr<const BFMapFile> _mappedFile;
+
         // Flag to flip Y component for maps that assume XZ-plane symmetry.
         bool _flipy = true;
 
@@ -130,6 +179,18 @@ namespace mu2e {
 
         // Functions used internally and by the code that populates the maps.
 
+        // Field value and status at a grid point, from whichever storage is in use.
+        CLHEP::Hep3Vector fieldAt(unsigned ix, unsigned iy, unsigned iz) const {
+            if (_batchField[0]) {
+                const std::size_t i = (std::size_t(ix) * _ny + iy) * _nz + iz;
+                return CLHEP::Hep3Vector(_batchField[0][i], _batchField[1][i], _batchField[2][i]);
+            }
+            return _field(ix, iy, iz);
+        }
+        bool isDefined(unsigned ix, unsigned iy, unsigned iz) const {
+            return _allDefined || _isDefined(ix, iy, iz);
+        }
+
         // method to store the neighbors
         bool getNeighbors(int ix, int iy, int iz, CLHEP::Hep3Vector neighborsBF[3][3][3]) const;
 
@@ -137,6 +198,11 @@ namespace mu2e {
         CLHEP::Hep3Vector interpolate(CLHEP::Hep3Vector const vec[3][3][3],
                                       const CLHEP::Hep3Vector& frac) const;
 
+        // Derivatives of the interpolator with respect to frac; grad[i][j] = dB_i/dfrac_j
+        void interpolateGradient(CLHEP::Hep3Vector const vec[3][3][3],
+                                 const CLHEP::Hep3Vector& frac,
+                                 double grad[3][3]) const;
+
         // Polynomial fit function used by interpolator
         double gmcpoly2(double const f1d[3], double const& x) const;
 
@@ -147,8 +213,14 @@ namespace mu2e {
 
         std::size_t iZ(double z) const { return static_cast<int>((z - _zmin) / _dz + 0.5); }
 
-        bool interpolateTriLinear(const CLHEP::Hep3Vector&, CLHEP::Hep3Vector&) const;
-        bool interpolateQuadratic(const CLHEP::Hep3Vector&, CLHEP::Hep3Vector&) const;
+        // If grad is given, also fill it with the derivatives of the field, before the
+        // scale factor.
+        bool interpolateTriLinear(const CLHEP::Hep3Vector&,
+                                  CLHEP::Hep3Vector&,
+                                  double (*grad)[3] = nullptr) const;
+        bool interpolateQuadratic(const CLHEP::Hep3Vector&,
+                                  CLHEP::Hep3Vector&,
+                                  double (*grad)[3] = nullptr) const;
     };
 
     inline BFGridMap::GridPoint BFGridMap::point2grid(const CLHEP::Hep3Vector& pos) const {
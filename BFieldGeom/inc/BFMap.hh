@@ -53,6 +53,14 @@ namespace mu2e {
         // Accessors
         virtual bool getBFieldWithStatus(const CLHEP::Hep3Vector&, CLHEP::Hep3Vector&) const = 0;
 
+        // Field and its derivatives, grad[i][j] = dB_i/dx_j in tesla/mm.  Returns the same
+        // field and status as getBFieldWithStatus; the gradient is zero when the status is
+        // false.  The default uses central differences; maps that can differentiate their
+        // interpolation analytically override it.
+        virtual bool getBFieldWithGradient(const CLHEP::Hep3Vector&,
+                                           CLHEP::Hep3Vector&,
+                                           double grad[3][3]) const;
+
         // Validity checker
         virtual bool isValid(const CLHEP::Hep3Vector& point) const = 0;
 
@@ -0,0 +1,96 @@
+#ifndef BFieldGeom_BFMapFile_hh
+#define BFieldGeom_BFMapFile_hh
+//
+// A magnetic field map file that is used in place through mmap().
+//
+// The file holds a fixed size, self-describing header followed by the field
+// values as three arrays of doubles (Bx, By, Bz) in the index order of
+// Container3D.  Each array is zero padded at the end exactly as required by
+// BFGridMap::getBFieldBatch, so a BFGridMap can read both the single point
+// and the batch field values directly from the mapped pages.  The pages are
+// read-only and shared by all processes on a node that use the same file;
+// they are only read from disk when first touched.
+//
+// Only maps that are defined at every grid point can be stored in this format.
+//
+// Layout:
+//   Header                      at offset 0, sizeof(Header) bytes
+//   Bx[nstored]                 at header.dataOffset
+//   By[nstored]                 at header.dataOffset +   header.arrayStride
+//   Bz[nstored]                 at header.dataOffset + 2*header.arrayStride
+//
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace mu2e {
+
+    class BFMapFile {
+       public:
+        // The on-disk header.  All integers are in the byte order of the writer;
+        // the endian marker detects a mismatch.
+        struct Header {
+            char magic[8];              // "MU2EBMAP"
+            std::uint32_t endianMarker; // 0xDEADBEEF
+            std::uint32_t version;
+            std::uint32_t headerSize;   // sizeof(Header)
+            std::uint32_t flags;        // see Flags
+            std::uint32_t nx, ny, nz;
+            std::uint32_t unused;
+            double xmin, ymin, zmin;
+            double dx, dy, dz;
+            std::uint64_t nstored;      // entries per array, including padding
+            std::uint64_t dataOffset;   // bytes from start of file to Bx
+            std::uint64_t arrayStride;  // bytes from the start of one array to the next
+            std::uint64_t checksum;     // FNV-1a of the three arrays
+            char source[256];           // key of the map this file was converted from
+        };
+
+        enum Flags { flipY = 0x1 };
+
+        static const std::uint32_t currentVersion = 1;
+
+        // Map an existing file.  Throws if the file is not a valid map file.  If
+        // verifyChecksum is true, every page is read once to check the data.
+        explicit BFMapFile(const std::string& filename, bool verifyChecksum = false);
+        ~BFMapFile();
+
+        BFMapFile(const BFMapFile&) = delete;
+        BFMapFile& operator=(const BFMapFile&) = delete;
+
+        const Header& header() const { return *_header; }
+        const std::string& filename() const { return _filename; }
+
+        // The Bx, By and Bz arrays (i=0,1,2).
+        const double* field(int i) const { return _field[i]; }
+
+        bool flipy() const { return _header->flags & flipY; }
+
+        // Number of padding entries needed at the end of each array.
+        static std::size_t paddingSize(unsigned ny, unsigned nz) {
+            return std::size_t(ny) * nz + nz + 1;
+        }
+
+        // Write a new file.  The header grid description and flags must be filled in by
+        // the caller; everything else is computed here.  bx, by, bz hold nx*ny*nz values.
+        static void write(const std::string& filename,
+                          Header header,
+                          const double* bx,
+                          const double* by,
+                          const double* bz);
+
+        // Checksum used in the header.
+        static std::uint64_t checksum(const void* data, std::size_t nbytes, std::uint64_t seed);
+
+       private:
+        std::string _filename;
+        void* _addr;
+        std::size_t _length;
+        const Header* _header;
+        const double* _field[3];
+    };
+
+}  // end namespace mu2e
+
+#endif /* BFieldGeom_BFMapFile_hh */
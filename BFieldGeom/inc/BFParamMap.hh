@@ -10,9 +10,18 @@
 //
 // Original Brian Pollack, based on work by Krzysztof Genser, Rob Kutschke, Julie Managan, Bob
 // Bernstein.
+//
+// Evaluating the fit costs several hundred Bessel function terms per point.  Optionally,
+// see tabulate(), the fit is evaluated once at load time on a set of grids and lookups
+// use trilinear interpolation in those grids instead.  The volume of the map is divided
+// into blocks; each block has its own uniform grid, which is refined until the
+// interpolation error, checked against the fit at the midpoints of the grid cell edges
+// inside the fitted region, is below a given limit.  Blocks where the fit changes too
+// quickly for that, typically near the edges of the fitted region, are not tabulated.
 
 //#include <iosfwd>
 #include <cmath>
+#include <cstddef>
 #include <fstream>
 #include <iostream>
 #include <sstream>
@@ -48,10 +57,32 @@ namespace mu2e {
 
         virtual bool getBFieldWithStatus(const CLHEP::Hep3Vector&, CLHEP::Hep3Vector&) const;
 
+        // Always evaluate the fit, even if the map has been tabulated.
+        bool getAnalyticBFieldWithStatus(const CLHEP::Hep3Vector&, CLHEP::Hep3Vector&) const;
+
         virtual bool isValid(const CLHEP::Hep3Vector& point) const;
 
         virtual void print(std::ostream& os) const;
 
+        // Tabulate the fit.  The grid spacing starts at about spacing (mm).  In each block
+        // where the interpolation error is larger than maxError (tesla, before the scale
+        // factor) the spacing along the worst axis is halved, at most maxLevels times per
+        // axis; blocks where that is not enough keep using the fit.  The error is only
+        // checked within maxRadius (mm) of the axis of the fit: the series diverges outside
+        // of the region that was fitted.
+        void tabulate(double spacing, double maxError, int maxLevels, double maxRadius);
+
+        bool isTabulated() const { return !_blocks.empty(); }
+
+        // Largest interpolation error found while tabulating (tesla, before the scale factor).
+        double tabulationError() const { return _tabError; }
+
+        // Number of grid points in all of the tables.
+        std::size_t tabulationSize() const { return _tab.size() / 3; }
+
+        // Number of blocks that use the fit; see tabulate().
+        int untabulatedBlocks() const { return _untabulated; }
+
        private:
         // objects used to store the fit parameters
         int _ns;
@@ -61,14 +92,54 @@ namespace mu2e {
         vector<vector<double> > _Bs;
         vector<double> _Ds;
         vector<vector<double> > _kms;
-        mutable vector<vector<double> > _iv;
-        mutable vector<vector<double> > _ivp;
+
+        // The parts of the fit that depend only on x and y, or only on z.
+        struct RadialTerms {
+            double abs_r;
+            double cp, sp;             // cos(phi), sin(phi)
+            vector<double> cos_nphi;   // [n]
+            vector<double> sin_nphi;   // [n]
+            vector<double> iv;         // [n*_ms+m]
+            vector<double> ivp;        // [n*_ms+m]
+        };
+        struct ZTerms {
+            vector<double> cos_kmsz;  // [n*_ms+m]
+            vector<double> sin_kmsz;  // [n*_ms+m]
+        };
+
+        // One block of the tables: (nx+1)*(ny+1)*(nz+1) points starting at grid point
+        // offset in _tab, z fastest.
+        struct Block {
+            double x0, y0, z0;
+            double xinv, yinv, zinv;  // inverse grid spacing
+            int nx, ny, nz;           // number of cells; 0 if the block uses the fit
+            std::size_t offset;
+        };
+
+        // The tables: blocks, in x, y, z order with z fastest, and Bx, By, Bz at each grid
+        // point of all blocks.
+        int _nbx = 0, _nby = 0, _nbz = 0;
+        double _bxinv = 0., _byinv = 0., _bzinv = 0.;  // inverse block size
+        vector<Block> _blocks;
+        vector<double> _tab;
+        double _tabError = 0.;
+        int _untabulated = 0;
 
         // pre calculate additional constants needed for eval
         void calcConstants();
 
-        // evaluate the fit for a given point.
-        bool evalFit(const CLHEP::Hep3Vector&, CLHEP::Hep3Vector&) const;
+        void radialTerms(double x, double y, RadialTerms& rt) const;
+        void zTerms(double z, ZTerms& zt) const;
+        CLHEP::Hep3Vector combineTerms(const RadialTerms& rt, const ZTerms& zt) const;
+
+        // evaluate the fit for a given point inside the map.
+        void evalFit(const CLHEP::Hep3Vector&, CLHEP::Hep3Vector&) const;
+
+        // interpolate in the tables for a given point inside the map.
+        void evalTable(const CLHEP::Hep3Vector&, CLHEP::Hep3Vector&) const;
+
+        // Report, and optionally warn about, a point outside of the map.
+        bool outside(const CLHEP::Hep3Vector&, CLHEP::Hep3Vector&) const;
     };  // namespace mu2e
 
 }  // end namespace mu2e
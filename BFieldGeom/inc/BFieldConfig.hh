@@ -63,13 +63,37 @@ namespace mu2e {
         // to trigger the map-writing hack inside the BFieldManagerMaker code.
         bool writeBinaries() const { return writeBinaries_; }
 
+        // Same, but write the mmap-able format read by BFMapFile.
+        bool writeMappedMaps() const { return writeMappedMaps_; }
+
+        // Check the checksum of .bfmap files when they are opened; this reads every page.
+        bool verifyMapChecksum() const { return verifyMapChecksum_; }
+
+        // Replace the parametric maps by interpolation in tables made when they are loaded;
+        // see BFParamMap::tabulate for the meaning of the other parameters.
+        bool tabulateParamMaps() const { return tabulateParamMaps_; }
+        double paramTableSpacing() const { return paramTableSpacing_; }
+        double paramTableMaxError() const { return paramTableMaxError_; }
+        int paramTableMaxLevels() const { return paramTableMaxLevels_; }
+        double paramTableMaxRadius() const { return paramTableMaxRadius_; }
+
         int verbosityLevel() const { return verbosityLevel_; }
 
         bool flipBFieldMaps() const { return flipBFieldMaps_; }
 
        private:
         BFieldConfig()
-            : scaleFactor_(1.), writeBinaries_(false), verbosityLevel_(1), flipBFieldMaps_(false) {}
+            : scaleFactor_(1.),
+              writeBinaries_(false),
+              writeMappedMaps_(false),
+              verifyMapChecksum_(false),
+              tabulateParamMaps_(false),
+              paramTableSpacing_(50.),
+              paramTableMaxError_(1.e-3),
+              paramTableMaxLevels_(3),
+              paramTableMaxRadius_(800.),
+              verbosityLevel_(1),
+              flipBFieldMaps_(false) {}
 
         // GMC, G4BL or possible future types.
         BFMapType mapType_;
@@ -95,6 +119,13 @@ namespace mu2e {
         CLHEP::Hep3Vector dsGradientValue_;
 
         bool writeBinaries_;
+        bool writeMappedMaps_;
+        bool verifyMapChecksum_;
+        bool tabulateParamMaps_;
+        double paramTableSpacing_;
+        double paramTableMaxError_;
+        int paramTableMaxLevels_;
+        double paramTableMaxRadius_;
         int verbosityLevel_;
         bool flipBFieldMaps_;
     };
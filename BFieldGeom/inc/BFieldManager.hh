@@ -44,6 +44,17 @@ namespace mu2e {
                                  BFCacheManager const&,
                                  CLHEP::Hep3Vector&) const;
 
+        // Get field and its derivatives, grad[i][j] = dB_i/dx_j in tesla/mm, from the one
+        // map that contains the point; see BFMap::getBFieldWithGradient.  Both are zero
+        // for out of range.
+        bool getBFieldWithGradient(const CLHEP::Hep3Vector&,
+                                   CLHEP::Hep3Vector&,
+                                   double grad[3][3]) const;
+        bool getBFieldWithGradient(const CLHEP::Hep3Vector&,
+                                   BFCacheManager const&,
+                                   CLHEP::Hep3Vector&,
+                                   double grad[3][3]) const;
+
         // Just return zero for out of range.
         CLHEP::Hep3Vector getBField(const CLHEP::Hep3Vector& pos) const {
             // Default c'tor sets all components to zero - which is what we need here.
@@ -71,7 +82,8 @@ namespace mu2e {
           return result;
         }
 
-        BFCacheManager cacheManager() const { return cm_; }
+        // The cache manager is safe to share between threads; there is no need to copy it.
+        BFCacheManager const& cacheManager() const { return cm_; }
 
         const MapContainerType& getInnerMaps() const { return innerMaps_; }
         MapContainerType& getInnerMaps() { return innerMaps_; }
@@ -114,6 +126,14 @@ namespace mu2e {
                                                 double scaleFactor,
                                                 BFInterpolationStyle interpStyle);
 
+        // Add a grid-like map that uses a mapped file in place.  Used by BFieldManagerMaker.
+        std::shared_ptr<BFGridMap> addBFGridMap(MapContainerType* whichMap,
+                                                const std::string& key,
+                                                std::shared_ptr<const BFMapFile> file,
+                                                BFMapType::enum_type type,
+                                                double scaleFactor,
+                                                BFInterpolationStyle interpStyle);
+
         // Add an empty parametric map to the list.  Used by BFieldManagerMaker.
         std::shared_ptr<BFParamMap> addBFParamMap(MapContainerType* whichMap,
                                                   const std::string& key,
@@ -2,49 +2,182 @@
 
 #include "BFieldGeom/inc/BFCacheManager.hh"
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+
+#include "cetlib_except/exception.h"
+
 namespace mu2e {
 
-    BFCacheManager::BFCacheManager():
-    innerForLastInner(0),
-    innerForLastOuter(0),
-    counter(0)
-    {
-        outerCache.insert( std::make_pair<std::shared_ptr<const BFMap>>(0, CacheElement(0, MapList())) );
-        CacheType::const_iterator p = outerCache.find(0);
-        assert(p != outerCache.end());
-        innerForLastOuter = &p->second;
-    }
+    namespace {
+
+        // Number of bins along each axis of the spatial index.
+        const int nBinsPerAxis = 32;
+
+        // The last inner map used by this thread, and the map set it belongs to.  The
+        // statistics live here too, so that a lookup touches only one thread_local.
+        struct ThreadHint {
+            unsigned id = 0;
+            int index = -1;
+            BFCacheManager::Statistics stats;
+        };
+        thread_local ThreadHint hint;
+
+        // Source of unique map set ids; 0 is reserved for "no maps".
+        std::atomic<unsigned> nextId(1);
+
+        // Bin range [lo, hi] covered by the interval [a, b] on an axis.
+        void binRange(double a, double b, double origin, double inv, int nb, int& lo, int& hi) {
+            lo = std::max(0, std::min(nb - 1, int(std::floor((a - origin) * inv))));
+            hi = std::max(0, std::min(nb - 1, int(std::floor((b - origin) * inv))));
+        }
+
+    }  // end anonymous namespace
+
+    BFCacheManager::BFCacheManager()
+        : ninner_(0),
+          xmin_(0.),
+          ymin_(0.),
+          zmin_(0.),
+          xbinInv_(0.),
+          ybinInv_(0.),
+          zbinInv_(0.),
+          nbx_(0),
+          nby_(0),
+          nbz_(0),
+          id_(0) {}
 
     void BFCacheManager::setMaps(const MapContainerType& innerMaps,
                                  const MapContainerType& outerMaps) {
-        typedef MapContainerType::const_iterator Iter;
+        maps_.clear();
+        maps_.insert(maps_.end(), innerMaps.begin(), innerMaps.end());
+        maps_.insert(maps_.end(), outerMaps.begin(), outerMaps.end());
+        ninner_ = innerMaps.size();
 
-        // All inner maps in the input order
-        MapList defaultInnerList;
-        for (Iter i = innerMaps.begin(); i != innerMaps.end(); ++i) {
-            defaultInnerList.push_back(*i);
+        if (maps_.size() > std::numeric_limits<unsigned short>::max()) {
+            throw cet::exception("GEOM")
+                << "BFCacheManager: too many magnetic field maps: " << maps_.size() << "\n";
         }
 
-        // The fixed-order outer map list
-        for (Iter i = outerMaps.begin(); i != outerMaps.end(); ++i) {
-            this->outer.push_back(*i);
+        rawMaps_.clear();
+        for (auto const& m : maps_) {
+            rawMaps_.push_back(m.get());
         }
 
-        // Now populate the cache lookup structures
+        id_ = nextId++;
 
-        for (Iter i = innerMaps.begin(); i != innerMaps.end(); ++i) {
-            // or can assign a dedicated innerList for this map, e.g. using hints from FHICL
-            innerCache.insert(std::make_pair(*i, CacheElement(*i, defaultInnerList)));
+        binStart_.assign(1, 0);
+        binMaps_.clear();
+        nbx_ = nby_ = nbz_ = 0;
+        if (maps_.empty()) {
+            return;
         }
 
-        for (Iter i = outerMaps.begin(); i != outerMaps.end(); ++i) {
-            // or can assign a dedicated innerList for this map, e.g. using hints from FHICL
-            outerCache.insert(std::make_pair(*i, CacheElement(*i, defaultInnerList)));
+        // Bounding boxes.  Grid maps may be reflected about y=0, so the y range is
+        // widened to cover both reflections; isValid makes the final decision.
+        struct Box {
+            double xmin, xmax, ymin, ymax, zmin, zmax;
+        };
+        std::vector<Box> boxes;
+        double xmin(std::numeric_limits<double>::max()), xmax(-xmin);
+        double ymin(xmin), ymax(-xmin), zmin(xmin), zmax(-xmin);
+        for (auto const& m : maps_) {
+            Box b = {m->xmin(), m->xmax(), std::min(m->ymin(), -m->ymax()),
+                     std::max(m->ymax(), -m->ymin()), m->zmin(), m->zmax()};
+            boxes.push_back(b);
+            xmin = std::min(xmin, b.xmin);
+            xmax = std::max(xmax, b.xmax);
+            ymin = std::min(ymin, b.ymin);
+            ymax = std::max(ymax, b.ymax);
+            zmin = std::min(zmin, b.zmin);
+            zmax = std::max(zmax, b.zmax);
         }
 
-        CacheType::iterator p = outerCache.find(0);
-        assert(p != outerCache.end());
-        p->second = CacheElement(0, defaultInnerList);
-        innerForLastOuter = &p->second;
+        nbx_ = nby_ = nbz_ = nBinsPerAxis;
+        xmin_ = xmin;
+        ymin_ = ymin;
+        zmin_ = zmin;
+        xbinInv_ = (xmax > xmin) ? nbx_ / (xmax - xmin) : 0.;
+        ybinInv_ = (ymax > ymin) ? nby_ / (ymax - ymin) : 0.;
+        zbinInv_ = (zmax > zmin) ? nbz_ / (zmax - zmin) : 0.;
+
+        // Fill the candidate lists, preserving the priority order of maps_.
+        const std::size_t nbins = std::size_t(nbx_) * nby_ * nbz_;
+        std::vector<std::vector<unsigned short>> lists(nbins);
+        for (unsigned short im = 0; im < boxes.size(); ++im) {
+            const Box& b = boxes[im];
+            int ix0, ix1, iy0, iy1, iz0, iz1;
+            binRange(b.xmin, b.xmax, xmin_, xbinInv_, nbx_, ix0, ix1);
+            binRange(b.ymin, b.ymax, ymin_, ybinInv_, nby_, iy0, iy1);
+            binRange(b.zmin, b.zmax, zmin_, zbinInv_, nbz_, iz0, iz1);
+            for (int ix = ix0; ix <= ix1; ++ix) {
+                for (int iy = iy0; iy <= iy1; ++iy) {
+                    for (int iz = iz0; iz <= iz1; ++iz) {
+                        lists[(std::size_t(ix) * nby_ + iy) * nbz_ + iz].push_back(im);
+                    }
+                }
+            }
+        }
+
+        binStart_.reserve(nbins + 1);
+        for (auto const& l : lists) {
+            binMaps_.insert(binMaps_.end(), l.begin(), l.end());
+            binStart_.push_back(binMaps_.size());
+        }
+    }
+
+    BFCacheManager::Statistics BFCacheManager::threadStatistics() { return hint.stats; }
+
+    void BFCacheManager::resetThreadStatistics() { hint.stats = Statistics(); }
+
+    int BFCacheManager::findMapIndex(const CLHEP::Hep3Vector& x) const {
+        // Still in the same inner map as last time?
+        ThreadHint& h = hint;
+        ++h.stats.lookups;
+        if (h.id == id_ && h.index >= 0) {
+            ++h.stats.validityChecks;
+            if (rawMaps_[h.index]->isValid(x)) {
+                ++h.stats.hintHits;
+                return h.index;
+            }
+        }
+
+        ++h.stats.binSearches;
+        if (nbx_ == 0) {
+            ++h.stats.misses;
+            return -1;
+        }
+
+        const double fx = std::floor((x.x() - xmin_) * xbinInv_);
+        const double fy = std::floor((x.y() - ymin_) * ybinInv_);
+        const double fz = std::floor((x.z() - zmin_) * zbinInv_);
+
+        if (!(fx >= 0 && fx <= nbx_ && fy >= 0 && fy <= nby_ && fz >= 0 && fz <= nbz_)) {
+            ++h.stats.misses;
+            return -1;
+        }
+
+        // Points exactly on the upper edge of the index belong to the last bin.
+        const int ix = (fx == nbx_) ? nbx_ - 1 : int(fx);
+        const int iy = (fy == nby_) ? nby_ - 1 : int(fy);
+        const int iz = (fz == nbz_) ? nbz_ - 1 : int(fz);
+
+        const std::size_t bin = (std::size_t(ix) * nby_ + iy) * nbz_ + iz;
+        for (unsigned i = binStart_[bin]; i != binStart_[bin + 1]; ++i) {
+            const int im = binMaps_[i];
+            ++h.stats.validityChecks;
+            if (rawMaps_[im]->isValid(x)) {
+                // Only inner maps are remembered: outer maps can overlap inner ones.
+                if (unsigned(im) < ninner_) {
+                    h.id = id_;
+                    h.index = im;
+                }
+                return im;
+            }
+        }
+        ++h.stats.misses;
+        return -1;
     }
 }  // namespace mu2e
@@ -29,8 +29,62 @@
 
 using namespace std;
 
+namespace {
+
+    // The Lagrange basis of BFGridMap::gmcpoly2, nodes at 0, 1, 2, and its derivative.
+    void gmcbasis2(double x, double l[3], double dl[3]) {
+        l[0] = (x - 1.) * (x - 2.) / 2.;
+        l[1] = -x * (x - 2.);
+        l[2] = x * (x - 1.) / 2.;
+        dl[0] = x - 1.5;
+        dl[1] = 2. - 2. * x;
+        dl[2] = x - 0.5;
+    }
+
+    // Maps that assume XZ-plane symmetry are evaluated at |y| and By changes sign with y.
+    // For y < 0 this flips the sign of the derivatives of By along x and z and of the
+    // derivatives of Bx and Bz along y; dBy/dy keeps its sign.
+    void flipGradient(double grad[3][3]) {
+        grad[1][0] = -grad[1][0];
+        grad[1][2] = -grad[1][2];
+        grad[0][1] = -grad[0][1];
+        grad[2][1] = -grad[2][1];
+    }
+
+}  // end anonymous namespace
+
 namespace mu2e {
 
+    BFGridMap::BFGridMap(std::string filename,
+                         std::shared_ptr<const BFMapFile> file,
+                         BFMapType::enum_type atype,
+                         double scale,
+                         BFInterpolationStyle style,
+                         bool warnIfOutside)
+        : BFMap(filename,
+                file->header().xmin,
+                file->header().xmin + (file->header().nx - 1) * file->header().dx,
+                file->header().ymin,
+                file->header().ymin + (file->header().ny - 1) * file->header().dy,
+                file->header().zmin,
+                file->header().zmin + (file->header().nz - 1) * file->header().dz,
+                atype,
+                scale,
+                warnIfOutside),
+          _nx(file->header().nx),
+          _ny(file->header().ny),
+          _nz(file->header().nz),
+          _dx(file->header().dx),
+          _dy(file->header().dy),
+          _dz(file->header().dz),
+          _field(),
+          _isDefined(),
+          _allDefined(true),
+          _batchField{file->field(0), file->field(1), file->field(2)},
+          _mappedFile(file),
+          _flipy(file->flipy()),
+          _interpStyle(style) {}
+
     // function to determine if the point is in the map; take into account Y-symmetry
     bool BFGridMap::isValid(CLHEP::Hep3Vector const& point) const {
         if (point.x() < _xmin || point.x() > _xmax) {
@@ -76,9 +130,9 @@ namespace mu2e {
                 unsigned int yindex = iy + j - 1;
                 for (int k = 0; k != 3; ++k) {
                     unsigned int zindex = iz + k - 1;
-                    if (!_isDefined(xindex, yindex, zindex))
+                    if (!isDefined(xindex, yindex, zindex))
                         return false;
-                    neighborsBF[i][j][k] = _field(xindex, yindex, zindex);
+                    neighborsBF[i][j][k] = fieldAt(xindex, yindex, zindex);
                     /*
                               cout << "Neighbor(" << xindex << "," << yindex << "," << zindex
                               << ") = (" << neighborsBF(i,j,k).x() << ","
@@ -144,6 +198,33 @@ namespace mu2e {
         return CLHEP::Hep3Vector(gmcpoly2(x1d, zin), gmcpoly2(y1d, zin), gmcpoly2(z1d, zin));
     }
 
+    // Derivatives of the field returned by interpolate, computed from the same
+    // tensor product of 2nd order Lagrange polynomials.
+    void BFGridMap::interpolateGradient(CLHEP::Hep3Vector const vec[3][3][3],
+                                        const CLHEP::Hep3Vector& frac,
+                                        double grad[3][3]) const {
+        double lx[3], ly[3], lz[3], dlx[3], dly[3], dlz[3];
+        gmcbasis2(frac[0], lx, dlx);
+        gmcbasis2(frac[1], ly, dly);
+        gmcbasis2(frac[2], lz, dlz);
+
+        CLHEP::Hep3Vector d[3];
+        for (int i = 0; i != 3; ++i) {
+            for (int j = 0; j != 3; ++j) {
+                for (int k = 0; k != 3; ++k) {
+                    d[0] += vec[i][j][k] * (dlx[i] * ly[j] * lz[k]);
+                    d[1] += vec[i][j][k] * (lx[i] * dly[j] * lz[k]);
+                    d[2] += vec[i][j][k] * (lx[i] * ly[j] * dlz[k]);
+                }
+            }
+        }
+        for (int i = 0; i != 3; ++i) {
+            for (int j = 0; j != 3; ++j) {
+                grad[i][j] = d[j][i];
+            }
+        }
+    }
+
     // Standard Lagrange formula for 2nd order polynomial fit of
     // univariate function
     double BFGridMap::gmcpoly2(double const f1d[3], double const& x) const {
@@ -173,13 +254,45 @@ namespace mu2e {
         return retval;
     }
 
+    bool BFGridMap::getBFieldWithGradient(const CLHEP::Hep3Vector& testpoint,
+                                          CLHEP::Hep3Vector& result,
+                                          double grad[3][3]) const {
+        for (int i = 0; i != 3; ++i) {
+            for (int j = 0; j != 3; ++j) {
+                grad[i][j] = 0.;
+            }
+        }
+
+        bool retval(false);
+
+        if (_interpStyle == BFInterpolationStyle::trilinear) {
+            retval = interpolateTriLinear(testpoint, result, grad);
+
+        } else if (_interpStyle == BFInterpolationStyle::meco) {
+            retval = interpolateQuadratic(testpoint, result, grad);
+
+        } else {
+            throw cet::exception("GEOM")
+                << "Unrecognized option for interpolation into the BField: " << _interpStyle
+                << "\n";
+        }
+        result *= _scaleFactor;
+        for (int i = 0; i != 3; ++i) {
+            for (int j = 0; j != 3; ++j) {
+                grad[i][j] *= _scaleFactor;
+            }
+        }
+        return retval;
+    }
+
     // The algorithm is:
     // Find the grid cube in which the point lives - this defines eight corner points.
     // Assign a weight to each corner that is the "distance" to each corner - see below for
     // its precise definition.  The field value at the test point is the weighted sum of
     // each of the 8 corner points.
     bool BFGridMap::interpolateTriLinear(const CLHEP::Hep3Vector& p,
-                                         CLHEP::Hep3Vector& result) const {
+                                         CLHEP::Hep3Vector& result,
+                                         double (*grad)[3]) const {
         double px = p.x();
         double py = p.y();
         if (_flipy)
@@ -210,10 +323,10 @@ namespace mu2e {
         // Field values at the 8 corner points.
         // Guess that a copy is faster than a pointer for reasons of locality
         // of reference in the downstream code?
-        CLHEP::Hep3Vector c[8] = {_field(i, j, k),         _field(i + 1, j, k),
-                                  _field(i, j + 1, k),     _field(i + 1, j + 1, k),
-                                  _field(i, j, k + 1),     _field(i + 1, j, k + 1),
-                                  _field(i, j + 1, k + 1), _field(i + 1, j + 1, k + 1)};
+        CLHEP::Hep3Vector c[8] = {fieldAt(i, j, k),         fieldAt(i + 1, j, k),
+                                  fieldAt(i, j + 1, k),     fieldAt(i + 1, j + 1, k),
+                                  fieldAt(i, j, k + 1),     fieldAt(i + 1, j, k + 1),
+                                  fieldAt(i, j + 1, k + 1), fieldAt(i + 1, j + 1, k + 1)};
 
         double bx = c[0].x() * fx * fy * fz + c[1].x() * (1.0 - fx) * fy * fz +
                     c[2].x() * fx * (1.0 - fy) * fz + c[3].x() * (1.0 - fx) * (1.0 - fy) * fz +
@@ -239,12 +352,34 @@ namespace mu2e {
 
         result = CLHEP::Hep3Vector(bx, by, bz);
 
+        // The weights are linear in each coordinate, with dfx/dpx = -1/_dx etc.
+        if (grad) {
+            CLHEP::Hep3Vector d[3] = {
+                ((c[1] - c[0]) * fy * fz + (c[3] - c[2]) * (1.0 - fy) * fz +
+                 (c[5] - c[4]) * fy * (1.0 - fz) + (c[7] - c[6]) * (1.0 - fy) * (1.0 - fz)) /
+                    _dx,
+                ((c[2] - c[0]) * fx * fz + (c[3] - c[1]) * (1.0 - fx) * fz +
+                 (c[6] - c[4]) * fx * (1.0 - fz) + (c[7] - c[5]) * (1.0 - fx) * (1.0 - fz)) /
+                    _dy,
+                ((c[4] - c[0]) * fx * fy + (c[5] - c[1]) * (1.0 - fx) * fy +
+                 (c[6] - c[2]) * fx * (1.0 - fy) + (c[7] - c[3]) * (1.0 - fx) * (1.0 - fy)) /
+                    _dz};
+            for (int ii = 0; ii != 3; ++ii) {
+                for (int jj = 0; jj != 3; ++jj) {
+                    grad[ii][jj] = d[jj][ii];
+                }
+            }
+            if (_flipy && p.y() < 0)
+                flipGradient(grad);
+        }
+
         return true;
     }
 
     // Function to return the BField for any point
     bool BFGridMap::interpolateQuadratic(const CLHEP::Hep3Vector& testpoint,
-                                         CLHEP::Hep3Vector& result) const {
+                                         CLHEP::Hep3Vector& result,
+                                         double (*grad)[3]) const {
         result = CLHEP::Hep3Vector(0., 0., 0.);
 
         static const bool dflag = false;
@@ -322,12 +457,12 @@ namespace mu2e {
             cout << "Nearest Point:   " << grid2point(ix, iy, iz) << endl
                  << "Indices set to:  " << setw(4) << ix << " " << setw(4) << iy << " " << setw(4)
                  << iz << endl
-                 << "Field:              " << _field(ix, iy, iz) << endl;
+                 << "Field:              " << fieldAt(ix, iy, iz) << endl;
         }
 
         // check if the point had a field defined
 
-        if (!_isDefined(ix, iy, iz)) {
+        if (!isDefined(ix, iy, iz)) {
             if (_warnIfOutside) {
                 mf::LogWarning("GEOM")
                     << "Point's field is not defined in the map: " << _key << "\n"
@@ -375,9 +510,22 @@ namespace mu2e {
             cout << "Interpolated Field: " << result << endl;
         }
 
+        // Derivatives with respect to frac, then to the point
+        if (grad) {
+            interpolateGradient(neighborsBF, frac, grad);
+            for (int i = 0; i != 3; ++i) {
+                grad[i][0] /= _dx;
+                grad[i][1] /= _dy;
+                grad[i][2] /= _dz;
+            }
+        }
+
         // Reassign y sign
         if (_flipy && sign == -1) {
             result.setY(-result.y());
+            if (grad) {
+                flipGradient(grad);
+            }
         }
         return true;
     }
@@ -431,7 +579,7 @@ namespace mu2e {
 
         // check if the point had a field defined
 
-        if (!_isDefined(ix, iy, iz)) {
+        if (!isDefined(ix, iy, iz)) {
             if (_warnIfOutside) {
                 mf::LogWarning("GEOM")
                     << "Point's field is not defined in the map: " << _key << "\n"
@@ -449,7 +597,7 @@ namespace mu2e {
                 unsigned int yindex = iy + j - 1;
                 for (int k = 0; k != 3; ++k) {
                     unsigned int zindex = iz + k - 1;
-                    if (!_isDefined(xindex, yindex, zindex)) {
+                    if (!isDefined(xindex, yindex, zindex)) {
                         if (_warnIfOutside) {
                             mf::LogWarning("GEOM")
                                 << "Point's neighboring field is not defined in the map: " << _key
@@ -460,7 +608,7 @@ namespace mu2e {
                         }
                         return false;
                     }
-                    neighborBF[i][j][k] = _field(xindex, yindex, zindex);
+                    neighborBF[i][j][k] = fieldAt(xindex, yindex, zindex);
                     // Reassign y sign
                     if (_flipy && sign == -1) {
                         neighborBF[i][j][k].setY(-neighborBF[i][j][k].y());
@@ -490,11 +638,11 @@ namespace mu2e {
              << endl;
         cout << "Distance:       " << _dx << " " << _dy << " " << _dz << endl;
 
-        cout << "Field at the edges: " << _field(0, 0, 0) << ", " << _field(_nx - 1, 0, 0) << ", "
-             << _field(0, _ny - 1, 0) << ", " << _field(0, 0, _nz - 1) << ", "
-             << _field(_nx - 1, _ny - 1, 0) << ", " << _field(_nx - 1, _ny - 1, _nz - 1) << endl;
+        cout << "Field at the edges: " << fieldAt(0, 0, 0) << ", " << fieldAt(_nx - 1, 0, 0) << ", "
+             << fieldAt(0, _ny - 1, 0) << ", " << fieldAt(0, 0, _nz - 1) << ", "
+             << fieldAt(_nx - 1, _ny - 1, 0) << ", " << fieldAt(_nx - 1, _ny - 1, _nz - 1) << endl;
 
-        cout << "Field in the middle: " << _field(_nx / 2, _ny / 2, _nz / 2) << endl;
+        cout << "Field in the middle: " << fieldAt(_nx / 2, _ny / 2, _nz / 2) << endl;
 
         if (_warnIfOutside) {
             cout << "Will warn if outside of the valid region." << endl;
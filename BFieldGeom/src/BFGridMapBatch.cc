@@ -0,0 +1,456 @@
+//
+// Batch evaluation of a BFGridMap.
+//
+// The field values are kept in a structure-of-arrays copy of the grid so that
+// several points can be interpolated at once.  The interpolation kernels are
+// written once, as templates over a "lane" type: either a plain double
+// (the scalar fallback) or a gcc vector of 4 or 8 doubles (the AVX2 and AVX-512
+// versions).  Every arithmetic expression is written in the same order as in
+// BFGridMap::interpolateTriLinear and BFGridMap::interpolateQuadratic and
+// no fused multiply-add is enabled, so all three flavours give results that are
+// bit-identical to the single point code.  The instruction set is chosen at run
+// time, so the library does not need to be compiled with -march.
+//
+// The one exception: the single point trilinear code accepts points up to one cell
+// beyond the upper edge of the map and then reads past the end of the grid.  The
+// batch store is zero padded, so those points get a well defined answer here.
+//
+
+// C++ includes
+#include <cmath>
+#include <cstddef>
+
+// Framework includes
+#include "messagefacility/MessageLogger/MessageLogger.h"
+
+// Mu2e includes
+#include "BFieldGeom/inc/BFGridMap.hh"
+
+// Other includes
+#include "CLHEP/Vector/ThreeVector.h"
+#include "cetlib_except/exception.h"
+
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+namespace mu2e {
+
+    namespace {
+
+        typedef double v4d __attribute__((vector_size(4 * sizeof(double))));
+        typedef double v8d __attribute__((vector_size(8 * sizeof(double))));
+
+        // Access to one lane of a lane type.
+        template <typename V>
+        inline double& lane(V& v, int l) {
+            return v[l];
+        }
+        inline double& lane(double& v, int) { return v; }
+
+        // Everything the kernels need to know about one map.
+        struct BatchGrid {
+            double xmin, xmax, ymin, ymax, zmin, zmax;
+            double dx, dy, dz;
+            unsigned nx, ny, nz;
+            bool flipy;
+            bool warn;
+            double scale;
+            const double* field[3];
+            bool allDefined;
+            const Container3D<bool>* isDefined;
+            const std::string* key;
+        };
+
+        // Same as BFGridMap::gmcpoly2; arguments by reference to keep the psabi
+        // of the wide lane types out of the function signatures.
+        template <typename V>
+        inline __attribute__((always_inline)) void gmcpoly2(const V f1d[3], const V& x, V& out) {
+            static const double x0(0.), x1(1.), x2(2.);
+
+            out = f1d[0] * (x - x1) * (x - x2) / ((x0 - x1) * (x0 - x2)) +
+                  f1d[1] * (x - x0) * (x - x2) / ((x1 - x0) * (x1 - x2)) +
+                  f1d[2] * (x - x0) * (x - x1) / ((x2 - x0) * (x2 - x1));
+        }
+
+        // N points with trilinear interpolation; see BFGridMap::interpolateTriLinear.
+        template <typename V, int N>
+        inline __attribute__((always_inline)) void triLinearLanes(const BatchGrid& g,
+                                                                  const CLHEP::Hep3Vector* p,
+                                                                  CLHEP::Hep3Vector* result,
+                                                                  bool* status) {
+            V fx, fy, fz;
+            V c[3][8];
+            bool negy[N];
+
+            const std::size_t nyz = std::size_t(g.ny) * g.nz;
+            const std::size_t offset[8] = {0, nyz, g.nz, nyz + g.nz, 1, nyz + 1, g.nz + 1,
+                                           nyz + g.nz + 1};
+
+            for (int l = 0; l < N; ++l) {
+                double px = p[l].x();
+                double py = p[l].y();
+                if (g.flipy)
+                    py = std::abs(p[l].y());
+                double pz = p[l].z();
+
+                int i = floor((px - g.xmin) / g.dx);
+                int j = floor((py - g.ymin) / g.dy);
+                int k = floor((pz - g.zmin) / g.dz);
+
+                status[l] = !(i < 0 || i >= int(g.nx) || j < 0 || j >= int(g.ny) || k < 0 ||
+                              k >= int(g.nz));
+                negy[l] = g.flipy && p[l].y() < 0;
+
+                if (!status[l]) {
+                    if (g.warn) {
+                        mf::LogWarning("GEOM")
+                            << "Point is outside of the valid region of the map: " << *g.key
+                            << "\n"
+                            << "Point in input coordinates: " << p[l] << "\n";
+                    }
+                    lane(fx, l) = lane(fy, l) = lane(fz, l) = 0.;
+                    for (int m = 0; m < 3; ++m) {
+                        for (int n = 0; n < 8; ++n) {
+                            lane(c[m][n], l) = 0.;
+                        }
+                    }
+                    continue;
+                }
+
+                lane(fx, l) = 1.0 - (px - g.xmin - i * g.dx) / g.dx;
+                lane(fy, l) = 1.0 - (py - g.ymin - j * g.dy) / g.dy;
+                lane(fz, l) = 1.0 - (pz - g.zmin - k * g.dz) / g.dz;
+
+                const std::size_t base = std::size_t(i) * nyz + std::size_t(j) * g.nz + k;
+                for (int m = 0; m < 3; ++m) {
+                    const double* f = g.field[m] + base;
+                    for (int n = 0; n < 8; ++n) {
+                        lane(c[m][n], l) = f[offset[n]];
+                    }
+                }
+            }
+
+            V b[3];
+            for (int m = 0; m < 3; ++m) {
+                b[m] = c[m][0] * fx * fy * fz + c[m][1] * (1.0 - fx) * fy * fz +
+                       c[m][2] * fx * (1.0 - fy) * fz + c[m][3] * (1.0 - fx) * (1.0 - fy) * fz +
+                       c[m][4] * fx * fy * (1.0 - fz) + c[m][5] * (1.0 - fx) * fy * (1.0 - fz) +
+                       c[m][6] * fx * (1.0 - fy) * (1.0 - fz) +
+                       c[m][7] * (1.0 - fx) * (1.0 - fy) * (1.0 - fz);
+            }
+
+            for (int l = 0; l < N; ++l) {
+                if (!status[l]) {
+                    result[l] = CLHEP::Hep3Vector(0., 0., 0.);
+                } else {
+                    double by = lane(b[1], l);
+                    if (negy[l])
+                        by = -by;
+                    result[l] = CLHEP::Hep3Vector(lane(b[0], l), by, lane(b[2], l));
+                }
+                result[l] *= g.scale;
+            }
+        }
+
+        // Prologue of BFGridMap::interpolateQuadratic for one point: find the central grid
+        // point of the 3x3x3 neighborhood and check that the whole neighborhood is defined.
+        bool quadraticCell(const BatchGrid& g,
+                           const CLHEP::Hep3Vector& testpoint,
+                           CLHEP::Hep3Vector& point,
+                           unsigned& ix,
+                           unsigned& iy,
+                           unsigned& iz) {
+            point = testpoint;
+            if (g.flipy && testpoint.y() < 0) {
+                point.setY(-testpoint.y());
+            }
+
+            if (point.x() < g.xmin || point.x() > g.xmax ||
+                (g.flipy ? (std::abs(point.y()) < g.ymin || std::abs(point.y()) > g.ymax)
+                         : (point.y() < g.ymin || point.y() > g.ymax)) ||
+                point.z() < g.zmin || point.z() > g.zmax) {
+                if (g.warn) {
+                    mf::LogWarning("GEOM")
+                        << "Point is outside of the valid region of the map: " << *g.key << "\n"
+                        << "Point in input coordinates: " << testpoint << "\n";
+                }
+                return false;
+            }
+
+            ix = static_cast<int>((point.x() - g.xmin) / g.dx + 0.5);
+            iy = static_cast<int>((point.y() - g.ymin) / g.dy + 0.5);
+            iz = static_cast<int>((point.z() - g.zmin) / g.dz + 0.5);
+
+            // Correct for edge points by moving their NGPt just inside the edge
+            if (ix == 0) ++ix;
+            if (ix == g.nx - 1) --ix;
+            if (iy == 0) ++iy;
+            if (iy == g.ny - 1) --iy;
+            if (iz == 0) ++iz;
+            if (iz == g.nz - 1) --iz;
+
+            if (g.allDefined) {
+                return true;
+            }
+            for (unsigned i = ix - 1; i != ix + 2; ++i) {
+                for (unsigned j = iy - 1; j != iy + 2; ++j) {
+                    for (unsigned k = iz - 1; k != iz + 2; ++k) {
+                        if (!(*g.isDefined)(i, j, k)) {
+                            if (g.warn) {
+                                mf::LogWarning("GEOM")
+                                    << "Point's neighboring field is not defined in the map: "
+                                    << *g.key << "\n"
+                                    << "Point in input coordinates: " << testpoint << "\n";
+                                mf::LogWarning("GEOM")
+                                    << "ix=" << ix << " iy=" << iy << " iz=" << iz << "\n";
+                            }
+                            return false;
+                        }
+                    }
+                }
+            }
+            return true;
+        }
+
+        // N points with MECO style quadratic interpolation; see BFGridMap::interpolateQuadratic
+        // and BFGridMap::interpolate.
+        template <typename V, int N>
+        inline __attribute__((always_inline)) void quadraticLanes(const BatchGrid& g,
+                                                                  const CLHEP::Hep3Vector* p,
+                                                                  CLHEP::Hep3Vector* result,
+                                                                  bool* status) {
+            V frac[3];
+            V vec[3][3][3][3];  // [component][i][j][k]
+            bool negy[N];
+
+            const std::size_t nyz = std::size_t(g.ny) * g.nz;
+
+            for (int l = 0; l < N; ++l) {
+                CLHEP::Hep3Vector point;
+                unsigned ix(0), iy(0), iz(0);
+                status[l] = quadraticCell(g, p[l], point, ix, iy, iz);
+                negy[l] = g.flipy && p[l].y() < 0;
+
+                if (!status[l]) {
+                    for (int m = 0; m < 3; ++m) {
+                        lane(frac[m], l) = 0.;
+                        for (int i = 0; i != 3; ++i)
+                            for (int j = 0; j != 3; ++j)
+                                for (int k = 0; k != 3; ++k)
+                                    lane(vec[m][i][j][k], l) = 0.;
+                    }
+                    continue;
+                }
+
+                // Same as cellFraction(point, GridPoint(ix-1, iy-1, iz-1)).
+                const unsigned xindex = ix - 1;
+                const unsigned yindex = iy - 1;
+                const unsigned zindex = iz - 1;
+                lane(frac[0], l) = (point.x() - (g.xmin + xindex * g.dx)) / g.dx;
+                lane(frac[1], l) = (point.y() - (g.ymin + yindex * g.dy)) / g.dy;
+                lane(frac[2], l) = (point.z() - (g.zmin + zindex * g.dz)) / g.dz;
+
+                const std::size_t base = std::size_t(xindex) * nyz + std::size_t(yindex) * g.nz + zindex;
+                for (int m = 0; m < 3; ++m) {
+                    const double* f = g.field[m] + base;
+                    for (int i = 0; i != 3; ++i)
+                        for (int j = 0; j != 3; ++j)
+                            for (int k = 0; k != 3; ++k)
+                                lane(vec[m][i][j][k], l) = f[i * nyz + j * g.nz + k];
+                }
+            }
+
+            V b[3];
+            for (int m = 0; m < 3; ++m) {
+                V f1d[3];
+                V vecx[9];
+                V vecxy[3];
+
+                // First loop - interpolate xin
+                for (int j = 0; j != 3; ++j) {
+                    for (int k = 0; k != 3; ++k) {
+                        for (int i = 0; i != 3; ++i) {
+                            f1d[i] = vec[m][i][j][k];
+                        }
+                        gmcpoly2(f1d, frac[0], vecx[j * 3 + k]);
+                    }
+                }
+
+                // Second loop - interpolate yin
+                for (int k = 0; k != 3; ++k) {
+                    for (int j = 0; j != 3; ++j) {
+                        f1d[j] = vecx[j * 3 + k];
+                    }
+                    gmcpoly2(f1d, frac[1], vecxy[k]);
+                }
+
+                // Third loop - interpolate zin
+                gmcpoly2(vecxy, frac[2], b[m]);
+            }
+
+            for (int l = 0; l < N; ++l) {
+                if (!status[l]) {
+                    result[l] = CLHEP::Hep3Vector(0., 0., 0.);
+                } else {
+                    double by = lane(b[1], l);
+                    if (negy[l])
+                        by = -by;
+                    result[l] = CLHEP::Hep3Vector(lane(b[0], l), by, lane(b[2], l));
+                }
+                result[l] *= g.scale;
+            }
+        }
+
+        // Loop over all points, N at a time, then finish the remainder one at a time.
+        template <typename V, int N>
+        inline __attribute__((always_inline)) void batchLoop(const BatchGrid& g,
+                                                             bool trilinear,
+                                                             const CLHEP::Hep3Vector* p,
+                                                             CLHEP::Hep3Vector* result,
+                                                             bool* status,
+                                                             std::size_t n) {
+            std::size_t i = 0;
+            if (trilinear) {
+                for (; i + N <= n; i += N) {
+                    triLinearLanes<V, N>(g, p + i, result + i, status + i);
+                }
+                for (; i < n; ++i) {
+                    triLinearLanes<double, 1>(g, p + i, result + i, status + i);
+                }
+            } else {
+                for (; i + N <= n; i += N) {
+                    quadraticLanes<V, N>(g, p + i, result + i, status + i);
+                }
+                for (; i < n; ++i) {
+                    quadraticLanes<double, 1>(g, p + i, result + i, status + i);
+                }
+            }
+        }
+
+        void batchScalar(const BatchGrid& g,
+                         bool trilinear,
+                         const CLHEP::Hep3Vector* p,
+                         CLHEP::Hep3Vector* result,
+                         bool* status,
+                         std::size_t n) {
+            batchLoop<double, 1>(g, trilinear, p, result, status, n);
+        }
+
+        __attribute__((target("avx2"))) void batchAVX2(const BatchGrid& g,
+                                                        bool trilinear,
+                                                        const CLHEP::Hep3Vector* p,
+                                                        CLHEP::Hep3Vector* result,
+                                                        bool* status,
+                                                        std::size_t n) {
+            batchLoop<v4d, 4>(g, trilinear, p, result, status, n);
+        }
+
+        __attribute__((target("avx512f"))) void batchAVX512(const BatchGrid& g,
+                                                             bool trilinear,
+                                                             const CLHEP::Hep3Vector* p,
+                                                             CLHEP::Hep3Vector* result,
+                                                             bool* status,
+                                                             std::size_t n) {
+            batchLoop<v8d, 8>(g, trilinear, p, result, status, n);
+        }
+
+        typedef void (*BatchKernel)(const BatchGrid&,
+                                    bool,
+                                    const CLHEP::Hep3Vector*,
+                                    CLHEP::Hep3Vector*,
+                                    bool*,
+                                    std::size_t);
+
+        // Pick the widest kernel supported by this cpu; done once per process.
+        BatchKernel selectKernel() {
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx512f"))
+                return batchAVX512;
+            if (__builtin_cpu_supports("avx2"))
+                return batchAVX2;
+            return batchScalar;
+        }
+
+    }  // end anonymous namespace
+
+    void BFGridMap::fillBatchStore() {
+        if (hasBatchStore()) {
+            return;
+        }
+
+        // Extra zeros so that the upper corners of the last cell never read past the end.
+        const std::size_t n = std::size_t(_nx) * _ny * _nz;
+        const std::size_t npad = BFMapFile::paddingSize(_ny, _nz);
+        _fieldX.assign(n + npad, 0.);
+        _fieldY.assign(n + npad, 0.);
+        _fieldZ.assign(n + npad, 0.);
+
+        const CLHEP::Hep3Vector* f = &_field.get(0, 0, 0);
+        for (std::size_t i = 0; i < n; ++i) {
+            _fieldX[i] = f[i].x();
+            _fieldY[i] = f[i].y();
+            _fieldZ[i] = f[i].z();
+        }
+        _batchField[0] = _fieldX.data();
+        _batchField[1] = _fieldY.data();
+        _batchField[2] = _fieldZ.data();
+
+        // Only one copy of the field is kept.
+        _field.cleart();
+        if (_allDefined) {
+            _isDefined.cleart();
+        }
+    }
+
+    void BFGridMap::getBFieldBatch(const CLHEP::Hep3Vector* points,
+                                   CLHEP::Hep3Vector* fields,
+                                   bool* status,
+                                   std::size_t npoints) const {
+        if (!hasBatchStore()) {
+            throw cet::exception("GEOM")
+                << "BFGridMap::getBFieldBatch called before fillBatchStore for map: " << _key
+                << "\n";
+        }
+
+        bool trilinear(true);
+        if (_interpStyle == BFInterpolationStyle::trilinear) {
+            trilinear = true;
+        } else if (_interpStyle == BFInterpolationStyle::meco) {
+            trilinear = false;
+        } else {
+            throw cet::exception("GEOM")
+                << "Unrecognized option for interpolation into the BField: " << _interpStyle
+                << "\n";
+        }
+
+        BatchGrid g;
+        g.xmin = _xmin;
+        g.xmax = _xmax;
+        g.ymin = _ymin;
+        g.ymax = _ymax;
+        g.zmin = _zmin;
+        g.zmax = _zmax;
+        g.dx = _dx;
+        g.dy = _dy;
+        g.dz = _dz;
+        g.nx = _nx;
+        g.ny = _ny;
+        g.nz = _nz;
+        g.flipy = _flipy;
+        g.warn = _warnIfOutside;
+        g.scale = _scaleFactor;
+        g.field[0] = _batchField[0];
+        g.field[1] = _batchField[1];
+        g.field[2] = _batchField[2];
+        g.allDefined = _allDefined;
+        g.isDefined = &_isDefined;
+        g.key = &_key;
+
+        static const BatchKernel kernel = selectKernel();
+        kernel(g, trilinear, points, fields, status, npoints);
+    }
+
+}  // end namespace mu2e
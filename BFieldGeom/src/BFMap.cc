@@ -0,0 +1,49 @@
+//
+// Virtual class to hold one magnetic field map.
+//
+
+// Mu2e includes
+#include "BFieldGeom/inc/BFMap.hh"
+
+namespace mu2e {
+
+    // Central differences with a 5 mm step.  A neighbouring point at which the map gives
+    // no field is replaced by the central point, making that difference one-sided.
+    bool BFMap::getBFieldWithGradient(const CLHEP::Hep3Vector& point,
+                                      CLHEP::Hep3Vector& result,
+                                      double grad[3][3]) const {
+        static const double step(5.);  // mm
+
+        for (int i = 0; i != 3; ++i) {
+            for (int j = 0; j != 3; ++j) {
+                grad[i][j] = 0.;
+            }
+        }
+        if (!getBFieldWithStatus(point, result)) {
+            return false;
+        }
+
+        for (int j = 0; j != 3; ++j) {
+            CLHEP::Hep3Vector lo(point), hi(point);
+            lo[j] -= step;
+            hi[j] += step;
+            CLHEP::Hep3Vector blo, bhi;
+            double h(2. * step);
+            if (!getBFieldWithStatus(lo, blo)) {
+                blo = result;
+                h -= step;
+            }
+            if (!getBFieldWithStatus(hi, bhi)) {
+                bhi = result;
+                h -= step;
+            }
+            if (h > 0.) {
+                for (int i = 0; i != 3; ++i) {
+                    grad[i][j] = (bhi[i] - blo[i]) / h;
+                }
+            }
+        }
+        return true;
+    }
+
+}  // end namespace mu2e
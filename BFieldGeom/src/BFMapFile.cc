@@ -0,0 +1,204 @@
+//
+// A magnetic field map file that is used in place through mmap().
+//
+
+// C++ includes
+#include <cstring>
+#include <vector>
+
+// Includes from C ( needed for block IO ).
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+// Framework includes
+#include "cetlib_except/exception.h"
+
+// Mu2e includes
+#include "BFieldGeom/inc/BFMapFile.hh"
+
+namespace mu2e {
+
+    namespace {
+
+        const char magicString[8] = {'M', 'U', '2', 'E', 'B', 'M', 'A', 'P'};
+        const std::uint32_t deadbeef(0XDEADBEEF);
+
+        // Start of the data and of each array is page aligned.
+        const std::uint64_t alignment(4096);
+
+        std::uint64_t alignUp(std::uint64_t n) { return (n + alignment - 1) / alignment * alignment; }
+
+        // Write nbytes, throw on error.
+        void writeOrThrow(int fd, const void* buf, std::size_t nbytes, const std::string& filename) {
+            const char* p = static_cast<const char*>(buf);
+            while (nbytes > 0) {
+                ssize_t s = ::write(fd, p, nbytes);
+                if (s < 0) {
+                    int errsave = errno;
+                    char* errmsg = strerror(errsave);
+                    throw cet::exception("GEOM")
+                        << "BFMapFile::write Error writing to " << filename
+                        << "  errno: " << errsave << " " << errmsg << "\n";
+                }
+                p += s;
+                nbytes -= s;
+            }
+        }
+
+    }  // end anonymous namespace
+
+    std::uint64_t BFMapFile::checksum(const void* data, std::size_t nbytes, std::uint64_t seed) {
+        // 64 bit FNV-1a.
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        std::uint64_t h = seed ? seed : 0xcbf29ce484222325ULL;
+        for (std::size_t i = 0; i < nbytes; ++i) {
+            h ^= p[i];
+            h *= 0x100000001b3ULL;
+        }
+        return h;
+    }
+
+    BFMapFile::BFMapFile(const std::string& filename, bool verifyChecksum)
+        : _filename(filename), _addr(nullptr), _length(0), _header(nullptr), _field{} {
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            int errsave = errno;
+            char* errmsg = strerror(errsave);
+            throw cet::exception("GEOM") << "BFMapFile: Error opening " << filename
+                                         << "  errno: " << errsave << " " << errmsg << "\n";
+        }
+
+        struct stat info;
+        if (fstat(fd, &info)) {
+            int errsave = errno;
+            char* errmsg = strerror(errsave);
+            close(fd);
+            throw cet::exception("GEOM") << "BFMapFile: Error doing fstat() on " << filename
+                                         << "  errno: " << errsave << " " << errmsg << "\n";
+        }
+        _length = info.st_size;
+        if (_length < sizeof(Header)) {
+            close(fd);
+            throw cet::exception("GEOM") << "BFMapFile: " << filename
+                                         << " is too short to be a magnetic field map file.\n";
+        }
+
+        _addr = mmap(nullptr, _length, PROT_READ, MAP_SHARED, fd, 0);
+        int errsave = errno;
+        close(fd);
+        if (_addr == MAP_FAILED) {
+            _addr = nullptr;
+            char* errmsg = strerror(errsave);
+            throw cet::exception("GEOM") << "BFMapFile: Error doing mmap() on " << filename
+                                         << "  errno: " << errsave << " " << errmsg << "\n";
+        }
+
+        _header = static_cast<const Header*>(_addr);
+        const Header& h = *_header;
+
+        std::string error;
+        if (std::memcmp(h.magic, magicString, sizeof(magicString)) != 0) {
+            error = "not a Mu2e magnetic field map file";
+        } else if (h.endianMarker != deadbeef) {
+            error = "endian mismatch; convert the map again on this architecture";
+        } else if (h.version != currentVersion) {
+            error = "unsupported format version " + std::to_string(h.version);
+        } else if (h.headerSize != sizeof(Header)) {
+            error = "unexpected header size " + std::to_string(h.headerSize);
+        } else if (h.nstored != std::uint64_t(h.nx) * h.ny * h.nz + paddingSize(h.ny, h.nz)) {
+            error = "inconsistent grid size";
+        } else if (h.arrayStride < h.nstored * sizeof(double) ||
+                   h.dataOffset + 3 * h.arrayStride > _length) {
+            error = "file is truncated";
+        }
+        if (!error.empty()) {
+            munmap(_addr, _length);
+            _addr = nullptr;
+            throw cet::exception("GEOM") << "BFMapFile: " << filename << ": " << error << "\n";
+        }
+
+        const char* base = static_cast<const char*>(_addr) + h.dataOffset;
+        for (int i = 0; i < 3; ++i) {
+            _field[i] = reinterpret_cast<const double*>(base + i * h.arrayStride);
+        }
+
+        // Lookups jump around the grid; do not let the kernel read ahead.
+        madvise(_addr, _length, MADV_RANDOM);
+
+        if (verifyChecksum) {
+            std::uint64_t sum(0);
+            for (int i = 0; i < 3; ++i) {
+                sum = checksum(_field[i], h.nstored * sizeof(double), sum);
+            }
+            if (sum != h.checksum) {
+                munmap(_addr, _length);
+                _addr = nullptr;
+                throw cet::exception("GEOM")
+                    << "BFMapFile: checksum mismatch in " << filename << "\n";
+            }
+        }
+    }
+
+    BFMapFile::~BFMapFile() {
+        if (_addr) {
+            munmap(_addr, _length);
+        }
+    }
+
+    void BFMapFile::write(const std::string& filename,
+                          Header h,
+                          const double* bx,
+                          const double* by,
+                          const double* bz) {
+        const std::size_t npoints = std::size_t(h.nx) * h.ny * h.nz;
+
+        std::memcpy(h.magic, magicString, sizeof(magicString));
+        h.endianMarker = deadbeef;
+        h.version = currentVersion;
+        h.headerSize = sizeof(Header);
+        h.unused = 0;
+        h.nstored = npoints + paddingSize(h.ny, h.nz);
+        h.dataOffset = alignUp(sizeof(Header));
+        h.arrayStride = alignUp(h.nstored * sizeof(double));
+
+        // The padded arrays, as they will appear on disk.
+        std::vector<double> padding(h.nstored - npoints, 0.);
+        const double* arrays[3] = {bx, by, bz};
+        std::uint64_t sum(0);
+        for (int i = 0; i < 3; ++i) {
+            sum = checksum(arrays[i], npoints * sizeof(double), sum);
+            sum = checksum(padding.data(), padding.size() * sizeof(double), sum);
+        }
+        h.checksum = sum;
+
+        mode_t mode = S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH;
+        int flags = O_CREAT | O_WRONLY | O_TRUNC | O_EXCL;
+        int fd = open(filename.c_str(), flags, mode);
+        if (fd < 0) {
+            int errsave = errno;
+            if (errsave == EEXIST) {
+                throw cet::exception("GEOM") << "BFMapFile::write Error opening " << filename
+                                             << "  File already exists.\n";
+            }
+            char* errmsg = strerror(errsave);
+            throw cet::exception("GEOM") << "BFMapFile::write Error opening " << filename
+                                         << "  errno: " << errsave << " " << errmsg << "\n";
+        }
+
+        std::vector<char> zeros(alignment, 0);
+        writeOrThrow(fd, &h, sizeof(Header), filename);
+        writeOrThrow(fd, zeros.data(), h.dataOffset - sizeof(Header), filename);
+        for (int i = 0; i < 3; ++i) {
+            writeOrThrow(fd, arrays[i], npoints * sizeof(double), filename);
+            writeOrThrow(fd, padding.data(), padding.size() * sizeof(double), filename);
+            writeOrThrow(fd, zeros.data(), h.arrayStride - h.nstored * sizeof(double), filename);
+        }
+
+        close(fd);
+    }
+
+}  // end namespace mu2e
@@ -10,6 +10,7 @@
 // Bernstein.
 
 // C++ includes
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
 
@@ -45,84 +46,365 @@ namespace mu2e {
 
     bool BFParamMap::getBFieldWithStatus(const CLHEP::Hep3Vector& testpoint,
                                          CLHEP::Hep3Vector& result) const {
-        bool retval(false);
-
-        retval = evalFit(testpoint, result);
+        if (!isValid(testpoint)) {
+            return outside(testpoint, result);
+        }
 
-        /*
+        if (_blocks.empty()) {
+            evalFit(testpoint, result);
         } else {
-            throw cet::exception("GEOM")
-                << "Unrecognized option for interpolation into the BField: " << _interpStyle
-                << "\n";
+            evalTable(testpoint, result);
         }
-        */
         result *= _scaleFactor;
-        return retval;
+        return true;
     }
 
-    bool BFParamMap::evalFit(const CLHEP::Hep3Vector& p, CLHEP::Hep3Vector& result) const {
-        // Check validity.  Return a zero field and optionally print a warning.
-        if (!isValid(p)) {
-            if (_warnIfOutside) {
-                mf::LogWarning("GEOM")
-                    << "Point is outside of the valid region of the map: " << _key << "\n"
-                    << "Point in input coordinates: " << p << "\n";
-            }
-            result = CLHEP::Hep3Vector(0, 0, 0);
-            return false;
+    bool BFParamMap::getAnalyticBFieldWithStatus(const CLHEP::Hep3Vector& testpoint,
+                                                 CLHEP::Hep3Vector& result) const {
+        if (!isValid(testpoint)) {
+            return outside(testpoint, result);
         }
 
-        double r, phi;
+        evalFit(testpoint, result);
+        result *= _scaleFactor;
+        return true;
+    }
+
+    // Return a zero field and optionally print a warning.
+    bool BFParamMap::outside(const CLHEP::Hep3Vector& p, CLHEP::Hep3Vector& result) const {
+        if (_warnIfOutside) {
+            mf::LogWarning("GEOM") << "Point is outside of the valid region of the map: " << _key
+                                   << "\n"
+                                   << "Point in input coordinates: " << p << "\n";
+        }
+        result = CLHEP::Hep3Vector(0, 0, 0);
+        return false;
+    }
+
+    void BFParamMap::radialTerms(double x, double y, RadialTerms& rt) const {
+        double phi = atan2(y, x + 3896);
+        double r = sqrt(pow(x + 3896, 2) + pow(y, 2));
+        rt.abs_r = abs(r);
+        rt.cp = cos(phi);
+        rt.sp = sin(phi);
+
+        rt.cos_nphi.resize(_ns);
+        rt.sin_nphi.resize(_ns);
+        rt.iv.resize(_ns * _ms);
+        rt.ivp.resize(_ns * _ms);
+
         // The declarations below are to reduce computation time
         double bessels[2];
         double tmp_rho;
-        double cos_nphi, cos_kmsz;
-        double sin_nphi, sin_kmsz;
-        double abp, abm;
-        vector<double> out(3, 0);
-        phi = atan2(p.y(), p.x() + 3896);
-        r = sqrt(pow(p.x() + 3896, 2) + pow(p.y(), 2));
-        double abs_r = abs(r);
-
         for (int n = 0; n < _ns; ++n) {
-            for (int m = 1; m <= _ms; ++m) {
-                tmp_rho = _kms[n][m - 1] * abs_r;
+            rt.cos_nphi[n] = cos(n * phi + _Ds[n]);
+            rt.sin_nphi[n] = -sin(n * phi + _Ds[n]);
+            for (int m = 0; m < _ms; ++m) {
+                tmp_rho = _kms[n][m] * rt.abs_r;
                 bessels[0] = gsl_sf_bessel_In(n, tmp_rho);
                 bessels[1] = gsl_sf_bessel_In(n + 1, tmp_rho);
-                _iv[n][m - 1] = bessels[0];
+                rt.iv[n * _ms + m] = bessels[0];
                 if (tmp_rho == 0) {
-                    _ivp[n][m - 1] = 0.5 * (gsl_sf_bessel_In(n - 1, 0) + bessels[1]);
+                    rt.ivp[n * _ms + m] = 0.5 * (gsl_sf_bessel_In(n - 1, 0) + bessels[1]);
                 } else {
-                    _ivp[n][m - 1] = (n / tmp_rho) * bessels[0] + bessels[1];
+                    rt.ivp[n * _ms + m] = (n / tmp_rho) * bessels[0] + bessels[1];
                 }
             }
         }
+    }
 
+    void BFParamMap::zTerms(double z, ZTerms& zt) const {
+        zt.cos_kmsz.resize(_ns * _ms);
+        zt.sin_kmsz.resize(_ns * _ms);
+        for (int n = 0; n < _ns; ++n) {
+            for (int m = 0; m < _ms; ++m) {
+                zt.cos_kmsz[n * _ms + m] = cos(_kms[n][m] * z);
+                zt.sin_kmsz[n * _ms + m] = sin(_kms[n][m] * z);
+            }
+        }
+    }
+
+    CLHEP::Hep3Vector BFParamMap::combineTerms(const RadialTerms& rt, const ZTerms& zt) const {
+        double abp, abm;
         double br(0.0);
         double bphi(0.0);
         double bz(0.0);
         // Here is the meat of the calculation:
         for (int n = 0; n < _ns; ++n) {
-            cos_nphi = cos(n * phi + _Ds[n]);
-            sin_nphi = -sin(n * phi + _Ds[n]);
+            const double cos_nphi = rt.cos_nphi[n];
+            const double sin_nphi = rt.sin_nphi[n];
             for (int m = 0; m < _ms; ++m) {
-                cos_kmsz = cos(_kms[n][m] * p.z());
-                sin_kmsz = sin(_kms[n][m] * p.z());
-                abp = _As[n][m] * cos_kmsz + _Bs[n][m] * sin_kmsz;
-                abm = -_As[n][m] * sin_kmsz + _Bs[n][m] * cos_kmsz;
-                br += cos_nphi * _ivp[n][m] * _kms[n][m] * abp;
-                bz += cos_nphi * _iv[n][m] * _kms[n][m] * abm;
-                if (abs_r > 1e-10) {
-                    bphi += n * sin_nphi * (1 / abs_r) * _iv[n][m] * abp;
+                const int k = n * _ms + m;
+                abp = _As[n][m] * zt.cos_kmsz[k] + _Bs[n][m] * zt.sin_kmsz[k];
+                abm = -_As[n][m] * zt.sin_kmsz[k] + _Bs[n][m] * zt.cos_kmsz[k];
+                br += cos_nphi * rt.ivp[k] * _kms[n][m] * abp;
+                bz += cos_nphi * rt.iv[k] * _kms[n][m] * abm;
+                if (rt.abs_r > 1e-10) {
+                    bphi += n * sin_nphi * (1 / rt.abs_r) * rt.iv[k] * abp;
                 }
             }
         }
 
-        double cp = cos(phi);
-        double sp = sin(phi);
-        result = CLHEP::Hep3Vector(br * cp - bphi * sp, br * sp + bphi * cp, bz);
+        return CLHEP::Hep3Vector(br * rt.cp - bphi * rt.sp, br * rt.sp + bphi * rt.cp, bz);
+    }
 
-        return true;
+    // The work space is local so that the map can be used from several threads at once.
+    void BFParamMap::evalFit(const CLHEP::Hep3Vector& p, CLHEP::Hep3Vector& result) const {
+        RadialTerms rt;
+        ZTerms zt;
+        radialTerms(p.x(), p.y(), rt);
+        zTerms(p.z(), zt);
+        result = combineTerms(rt, zt);
+    }
+
+    void BFParamMap::evalTable(const CLHEP::Hep3Vector& p, CLHEP::Hep3Vector& result) const {
+        // The point is inside the map, so the block indices are not negative.
+        const int ibx = std::min(int((p.x() - _xmin) * _bxinv), _nbx - 1);
+        const int iby = std::min(int((p.y() - _ymin) * _byinv), _nby - 1);
+        const int ibz = std::min(int((p.z() - _zmin) * _bzinv), _nbz - 1);
+        const Block& b = _blocks[(ibx * _nby + iby) * _nbz + ibz];
+        if (b.nx == 0) {
+            evalFit(p, result);
+            return;
+        }
+
+        // Cell within the block and the fractional position in the cell.
+        const double u = (p.x() - b.x0) * b.xinv;
+        const double v = (p.y() - b.y0) * b.yinv;
+        const double w = (p.z() - b.z0) * b.zinv;
+        const int i = std::max(0, std::min(int(u), b.nx - 1));
+        const int j = std::max(0, std::min(int(v), b.ny - 1));
+        const int k = std::max(0, std::min(int(w), b.nz - 1));
+        const double tx = u - i;
+        const double ty = v - j;
+        const double tz = w - k;
+
+        const std::size_t sy = b.nz + 1;
+        const std::size_t sx = sy * (b.ny + 1);
+        const std::size_t i000 = b.offset + i * sx + j * sy + k;
+
+        // The three components of a grid point are stored together.
+        const double* t000 = &_tab[3 * i000];
+        const std::size_t tz1 = 3;
+        const std::size_t ty1 = 3 * sy;
+        const std::size_t tx1 = 3 * sx;
+        double bf[3];
+        for (int c = 0; c < 3; ++c) {
+            const double* t = t000 + c;
+            const double c00 = t[0] * (1. - tz) + t[tz1] * tz;
+            const double c01 = t[ty1] * (1. - tz) + t[ty1 + tz1] * tz;
+            const double c10 = t[tx1] * (1. - tz) + t[tx1 + tz1] * tz;
+            const double c11 = t[tx1 + ty1] * (1. - tz) + t[tx1 + ty1 + tz1] * tz;
+            const double c0 = c00 * (1. - ty) + c01 * ty;
+            const double c1 = c10 * (1. - ty) + c11 * ty;
+            bf[c] = c0 * (1. - tx) + c1 * tx;
+        }
+        result = CLHEP::Hep3Vector(bf[0], bf[1], bf[2]);
+    }
+
+    namespace {
+
+        // Grid cells along each axis of a block before any refinement.
+        const int cellsPerBlock = 8;
+
+        // Number of blocks along an axis of the given length.
+        int nBlocks(double length, double spacing) {
+            return std::max(1, int(std::ceil(length / (spacing * cellsPerBlock) - 1.e-6)));
+        }
+
+    }  // end anonymous namespace
+
+    void BFParamMap::tabulate(double spacing, double maxError, int maxLevels, double maxRadius) {
+        if (!(spacing > 0.) || !(maxError > 0.) || maxLevels < 0 || !(maxRadius > 0.)) {
+            throw cet::exception("GEOM")
+                << "BFParamMap::tabulate: bad arguments for map " << _key << ": spacing "
+                << spacing << " maxError " << maxError << " maxLevels " << maxLevels
+                << " maxRadius " << maxRadius << "\n";
+        }
+
+        const int nbx = nBlocks(_xmax - _xmin, spacing);
+        const int nby = nBlocks(_ymax - _ymin, spacing);
+        const int nbz = nBlocks(_zmax - _zmin, spacing);
+        const double blx = (_xmax - _xmin) / nbx;
+        const double bly = (_ymax - _ymin) / nby;
+        const double blz = (_zmax - _zmin) / nbz;
+
+        vector<Block> blocks(nbx * nby * nbz);
+        vector<double> tab;
+        double tabError(0.);
+        int untabulated(0);
+
+        // The radial terms are by far the most expensive part of the fit.  They do not
+        // depend on z, so they are computed once for each column of grid points, or of
+        // edge midpoints, at each x and y refinement level, and shared by all blocks
+        // along z.
+        struct Columns {
+            bool filled = false;
+            vector<RadialTerms> nodes;  // [i*(ny+1)+j]
+            vector<RadialTerms> xmid;   // midpoints of the x edges, [i*(ny+1)+j]
+            vector<RadialTerms> ymid;   // midpoints of the y edges, [i*ny+j]
+        };
+
+        vector<double> f[3];  // the field at the grid points of the current block
+        ZTerms zt;
+        for (int ibx = 0; ibx < nbx; ++ibx) {
+            for (int iby = 0; iby < nby; ++iby) {
+                const double x0 = _xmin + ibx * blx;
+                const double y0 = _ymin + iby * bly;
+                vector<Columns> columns((maxLevels + 1) * (maxLevels + 1));
+
+                for (int ibz = 0; ibz < nbz; ++ibz) {
+                    const double z0 = _zmin + ibz * blz;
+
+                    // Each pass halves the grid spacing along the axis with the largest
+                    // error, until the error is small enough or no axis can be refined.
+                    int level[3] = {0, 0, 0};
+                    double err(0.);
+                    int nx(0), ny(0), nz(0);
+                    for (;;) {
+                        nx = cellsPerBlock << level[0];
+                        ny = cellsPerBlock << level[1];
+                        nz = cellsPerBlock << level[2];
+                        const int nxp = nx + 1;
+                        const int nyp = ny + 1;
+                        const int nzp = nz + 1;
+                        const double dx = blx / nx;
+                        const double dy = bly / ny;
+                        const double dz = blz / nz;
+
+                        Columns& col = columns[level[0] * (maxLevels + 1) + level[1]];
+                        if (!col.filled) {
+                            col.nodes.resize(nxp * nyp);
+                            col.xmid.resize(nx * nyp);
+                            col.ymid.resize(nxp * ny);
+                            for (int i = 0; i < nxp; ++i) {
+                                for (int j = 0; j < nyp; ++j) {
+                                    const double x = x0 + i * dx;
+                                    const double y = y0 + j * dy;
+                                    radialTerms(x, y, col.nodes[i * nyp + j]);
+                                    if (i < nx) {
+                                        radialTerms(x + 0.5 * dx, y, col.xmid[i * nyp + j]);
+                                    }
+                                    if (j < ny) {
+                                        radialTerms(x, y + 0.5 * dy, col.ymid[i * ny + j]);
+                                    }
+                                }
+                            }
+                            col.filled = true;
+                        }
+
+                        for (auto& fc : f) {
+                            fc.resize(nxp * nyp * nzp);
+                        }
+                        for (int k = 0; k < nzp; ++k) {
+                            zTerms(z0 + k * dz, zt);
+                            for (int ij = 0; ij < nxp * nyp; ++ij) {
+                                const CLHEP::Hep3Vector b = combineTerms(col.nodes[ij], zt);
+                                for (int c = 0; c < 3; ++c) {
+                                    f[c][ij * nzp + k] = b[c];
+                                }
+                            }
+                        }
+
+                        // The field obeys Laplace's equation, so the errors from the second
+                        // derivatives along the three axes cancel at the cell centers.
+                        // Instead, find the largest error at the midpoints of the cell edges
+                        // along each axis; to second order, their sum is an upper bound for
+                        // the error anywhere in a cell.  Edges of cells that overlap the
+                        // fitted region are checked.  Stop as soon as one axis is known to
+                        // need refinement.
+                        const double checkRadius = maxRadius + 0.5 * std::hypot(dx, dy);
+                        double axisErr[3] = {0., 0., 0.};
+                        auto checkEdge = [&](int axis, const RadialTerms& rt, int i0, int i1) {
+                            if (rt.abs_r > checkRadius) {
+                                return;
+                            }
+                            const CLHEP::Hep3Vector b = combineTerms(rt, zt);
+                            CLHEP::Hep3Vector interp(0.5 * (f[0][i0] + f[0][i1]),
+                                                     0.5 * (f[1][i0] + f[1][i1]),
+                                                     0.5 * (f[2][i0] + f[2][i1]));
+                            axisErr[axis] = std::max(axisErr[axis], (interp - b).mag());
+                        };
+
+                        for (int k = 0; k < nzp; ++k) {
+                            zTerms(z0 + k * dz, zt);
+                            for (int i = 0; i < nxp; ++i) {
+                                for (int j = 0; j < nyp; ++j) {
+                                    const int i0 = (i * nyp + j) * nzp + k;
+                                    if (i < nx) {
+                                        checkEdge(0, col.xmid[i * nyp + j], i0, i0 + nyp * nzp);
+                                    }
+                                    if (j < ny) {
+                                        checkEdge(1, col.ymid[i * ny + j], i0, i0 + nzp);
+                                    }
+                                }
+                            }
+                            if (k < nz) {
+                                zTerms(z0 + (k + 0.5) * dz, zt);
+                                for (int ij = 0; ij < nxp * nyp; ++ij) {
+                                    checkEdge(2, col.nodes[ij], ij * nzp + k, ij * nzp + k + 1);
+                                }
+                            }
+                            if (*std::max_element(axisErr, axisErr + 3) > maxError) {
+                                break;
+                            }
+                        }
+                        err = axisErr[0] + axisErr[1] + axisErr[2];
+                        if (err <= maxError) {
+                            break;
+                        }
+
+                        int worst(-1);
+                        for (int a = 0; a < 3; ++a) {
+                            if (level[a] < maxLevels &&
+                                (worst < 0 || axisErr[a] > axisErr[worst])) {
+                                worst = a;
+                            }
+                        }
+                        if (worst < 0) {
+                            break;
+                        }
+                        ++level[worst];
+                    }
+
+                    Block& b = blocks[(ibx * nby + iby) * nbz + ibz];
+                    if (err > maxError) {
+                        b.nx = b.ny = b.nz = 0;
+                        ++untabulated;
+                        continue;
+                    }
+
+                    b.x0 = x0;
+                    b.y0 = y0;
+                    b.z0 = z0;
+                    b.xinv = nx / blx;
+                    b.yinv = ny / bly;
+                    b.zinv = nz / blz;
+                    b.nx = nx;
+                    b.ny = ny;
+                    b.nz = nz;
+                    b.offset = tab.size() / 3;
+                    for (std::size_t i = 0; i < f[0].size(); ++i) {
+                        for (int c = 0; c < 3; ++c) {
+                            tab.push_back(f[c][i]);
+                        }
+                    }
+                    tabError = std::max(tabError, err);
+                }
+            }
+        }
+
+        _nbx = nbx;
+        _nby = nby;
+        _nbz = nbz;
+        _bxinv = 1. / blx;
+        _byinv = 1. / bly;
+        _bzinv = 1. / blz;
+        _blocks.swap(blocks);
+        _tab.swap(tab);
+        _tab.shrink_to_fit();
+        _tabError = tabError;
+        _untabulated = untabulated;
     }
 
     void BFParamMap::print(std::ostream& os) const {
@@ -140,6 +422,12 @@ namespace mu2e {
         } else {
             cout << "Will not warn if outside of the valid region." << endl;
         }
+
+        if (!_blocks.empty()) {
+            cout << "Tabulated:  " << _nbx << " x " << _nby << " x " << _nbz << " blocks, "
+                 << tabulationSize() << " grid points, largest interpolation error "
+                 << _tabError << " T, " << _untabulated << " blocks use the fit" << endl;
+        }
     }
 
     void BFParamMap::calcConstants() {
@@ -149,13 +437,6 @@ namespace mu2e {
                 _kms[n].push_back(m * M_PI / _Reff);
             }
         }
-
-        for (int n = 0; n < _ns; ++n) {
-            vector<double> tmp_v1(_ms, 0.0);
-            vector<double> tmp_v2(_ms, 0.0);
-            _iv.push_back(tmp_v1);
-            _ivp.push_back(tmp_v2);
-        }
     }
 
 }  // end namespace mu2e
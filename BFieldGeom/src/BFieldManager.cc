@@ -33,7 +33,7 @@ namespace mu2e {
     bool BFieldManager::getBFieldWithStatus(const CLHEP::Hep3Vector& point,
                                             BFCacheManager const& cmgr,
                                             CLHEP::Hep3Vector& result) const {
-        auto m = cmgr.findMap(point);
+        const BFMap* m = cmgr.findMapPtr(point);
 
         if (m) {
             m->getBFieldWithStatus(point, result);
@@ -41,7 +41,34 @@ namespace mu2e {
             result = CLHEP::Hep3Vector(0., 0., 0.);
         }
 
-        return (m != 0);
+        return (m != nullptr);
+    }
+
+    bool BFieldManager::getBFieldWithGradient(const CLHEP::Hep3Vector& point,
+                                              CLHEP::Hep3Vector& result,
+                                              double grad[3][3]) const {
+        return getBFieldWithGradient(point, cm_, result, grad);
+    }
+
+    // As getBFieldWithStatus; the map is chosen once, for the point itself.
+    bool BFieldManager::getBFieldWithGradient(const CLHEP::Hep3Vector& point,
+                                              BFCacheManager const& cmgr,
+                                              CLHEP::Hep3Vector& result,
+                                              double grad[3][3]) const {
+        const BFMap* m = cmgr.findMapPtr(point);
+
+        if (m) {
+            m->getBFieldWithGradient(point, result, grad);
+        } else {
+            result = CLHEP::Hep3Vector(0., 0., 0.);
+            for (int i = 0; i != 3; ++i) {
+                for (int j = 0; j != 3; ++j) {
+                    grad[i][j] = 0.;
+                }
+            }
+        }
+
+        return (m != nullptr);
     }
 
 
@@ -74,6 +101,25 @@ namespace mu2e {
         return new_map;
     }
 
+    std::shared_ptr<BFGridMap> BFieldManager::addBFGridMap(MapContainerType* mapContainer,
+                                                           const std::string& key,
+                                                           std::shared_ptr<const BFMapFile> file,
+                                                           BFMapType::enum_type type,
+                                                           double scaleFactor,
+                                                           BFInterpolationStyle interpStyle) {
+        // If there already was another Map with the same key, then it is a hard error.
+        if (!mapKeys_.insert(key).second) {
+            throw cet::exception("GEOM")
+                << "Trying to add a new magnetic field when the named field map already exists: "
+                << key << "\n";
+        }
+
+        auto new_map = std::make_shared<BFGridMap>(key, file, type, scaleFactor, interpStyle);
+        mapContainer->push_back(new_map);
+
+        return new_map;
+    }
+
     // Create a new BFGridMap in the container of BFMaps.
     std::shared_ptr<BFParamMap> BFieldManager::addBFParamMap(MapContainerType* mapContainer,
                                                              const std::string& key,
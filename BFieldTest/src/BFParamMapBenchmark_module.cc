@@ -0,0 +1,152 @@
+//
+// Compare the two ways of evaluating a parametric magnetic field map: the fit itself and
+// interpolation in the tables made by BFParamMap::tabulate (bfield.tabulateParamMaps).
+//
+// For every parametric map, points are drawn uniformly inside the map and within maxRadius
+// of the axis of the fit.  The module reports the average time per lookup for each method
+// and the difference between them, and histograms the difference.
+//
+// The work is done in the beginRun member function.
+// The magnetic field map may depend on run number so it is
+// not available at c'to time or beginJob time.
+//
+
+#include "BFieldGeom/inc/BFParamMap.hh"
+#include "BFieldGeom/inc/BFieldManager.hh"
+#include "GeometryService/inc/GeomHandle.hh"
+#include "SeedService/inc/SeedService.hh"
+
+#include "art/Framework/Core/EDAnalyzer.h"
+#include "art/Framework/Core/ModuleMacros.h"
+#include "art/Framework/Principal/Event.h"
+#include "art/Framework/Principal/Run.h"
+#include "art_root_io/TFileDirectory.h"
+#include "art_root_io/TFileService.h"
+#include "messagefacility/MessageLogger/MessageLogger.h"
+
+#include "CLHEP/Random/RandFlat.h"
+#include "CLHEP/Vector/ThreeVector.h"
+
+#include "TH1F.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace mu2e {
+
+    class BFParamMapBenchmark : public art::EDAnalyzer {
+       public:
+        explicit BFParamMapBenchmark(const fhicl::ParameterSet& pset);
+
+        void beginRun(const art::Run& run) override;
+        void analyze(const art::Event&) override {}
+
+       private:
+        // Number of test points to draw.
+        int nPoints_;
+
+        // Number of times to repeat the timing loop for the tables.
+        int nRepeat_;
+
+        // Only draw points within this distance (mm) of the axis of the fit.
+        double maxRadius_;
+
+        // Uniform flat random distribution.
+        CLHEP::RandFlat flat_;
+
+        void benchmark(const BFParamMap& map, art::TFileService& tfs);
+    };
+
+}  // namespace mu2e
+
+mu2e::BFParamMapBenchmark::BFParamMapBenchmark(const fhicl::ParameterSet& pset)
+    : art::EDAnalyzer(pset),
+      nPoints_(pset.get<int>("nPoints")),
+      nRepeat_(pset.get<int>("nRepeat", 10)),
+      maxRadius_(pset.get<double>("maxRadius", 800.)),
+      flat_(createEngine(art::ServiceHandle<mu2e::SeedService>()->getSeed())) {}
+
+void mu2e::BFParamMapBenchmark::beginRun(const art::Run& run) {
+    art::ServiceHandle<art::TFileService> tfs;
+    GeomHandle<BFieldManager> bfmgr;
+
+    int nmaps(0);
+    for (auto maps : {&bfmgr->getInnerMaps(), &bfmgr->getOuterMaps()}) {
+        for (auto const& m : *maps) {
+            if (auto pm = dynamic_cast<const BFParamMap*>(m.get())) {
+                benchmark(*pm, *tfs);
+                ++nmaps;
+            }
+        }
+    }
+
+    if (nmaps == 0) {
+        throw cet::exception("GEOM") << "BFParamMapBenchmark: there are no parametric maps.\n";
+    }
+}
+
+void mu2e::BFParamMapBenchmark::benchmark(const BFParamMap& map, art::TFileService& tfs) {
+    // The axis of the fit; see BFParamMap::radialTerms.
+    const double x0(-3896.);
+
+    std::vector<CLHEP::Hep3Vector> points;
+    points.reserve(nPoints_);
+    while (int(points.size()) < nPoints_) {
+        CLHEP::Hep3Vector p(flat_.fire(map.xmin(), map.xmax()),
+                            flat_.fire(map.ymin(), map.ymax()),
+                            flat_.fire(map.zmin(), map.zmax()));
+        if (std::hypot(p.x() - x0, p.y()) <= maxRadius_) {
+            points.push_back(p);
+        }
+    }
+
+    typedef std::chrono::steady_clock Clock;
+    std::vector<CLHEP::Hep3Vector> analytic(points.size());
+    std::vector<CLHEP::Hep3Vector> tabulated(points.size());
+
+    auto t0 = Clock::now();
+    for (size_t i = 0; i < points.size(); ++i) {
+        map.getAnalyticBFieldWithStatus(points[i], analytic[i]);
+    }
+    auto t1 = Clock::now();
+    for (int r = 0; r < nRepeat_; ++r) {
+        for (size_t i = 0; i < points.size(); ++i) {
+            map.getBFieldWithStatus(points[i], tabulated[i]);
+        }
+    }
+    auto t2 = Clock::now();
+
+    const double nsAnalytic =
+        std::chrono::duration<double, std::nano>(t1 - t0).count() / points.size();
+    const double nsTabulated =
+        std::chrono::duration<double, std::nano>(t2 - t1).count() / (points.size() * nRepeat_);
+
+    art::TFileDirectory tfdir = tfs.mkdir(map.getKey().c_str());
+    TH1F* hDB = tfdir.make<TH1F>("hDB", "Log10(|B tables - B fit|), B in Tesla", 160, -16., 0.);
+
+    double maxDiff(0.);
+    double sumDiff(0.);
+    for (size_t i = 0; i < points.size(); ++i) {
+        const double d = (tabulated[i] - analytic[i]).mag();
+        hDB->Fill(d > 0. ? std::log10(d) : -15.99);
+        maxDiff = std::max(maxDiff, d);
+        sumDiff += d;
+    }
+
+    mf::LogInfo("GEOM") << "BFParamMapBenchmark: map " << map.getKey() << "\n"
+                        << "  tabulated:            " << (map.isTabulated() ? "yes" : "no")
+                        << "\n"
+                        << "  table grid points:    " << map.tabulationSize() << "\n"
+                        << "  blocks using the fit: " << map.untabulatedBlocks() << "\n"
+                        << "  fit:                  " << nsAnalytic << " ns/lookup\n"
+                        << "  getBFieldWithStatus:  " << nsTabulated << " ns/lookup\n"
+                        << "  |B difference|, T:    max " << maxDiff << " mean "
+                        << sumDiff / points.size() << "\n"
+                        << "  bound from tabulate:  " << map.tabulationError()
+                        << " (before the scale factor)\n";
+}
+
+DEFINE_ART_MODULE(mu2e::BFParamMapBenchmark);
@@ -0,0 +1,72 @@
+//
+// Write the positions of Geant4 steps to a text file, one "x y z" per line in the Mu2e
+// coordinate system, for use as the "steps" point stream of bfieldBench.
+//
+// Both ends of every StepPointMC in the input collections are written; these are
+// points at which Geant4 looked up the field while transporting the particle.
+//
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "art/Framework/Core/EDAnalyzer.h"
+#include "art/Framework/Core/ModuleMacros.h"
+#include "art/Framework/Principal/Event.h"
+#include "canvas/Utilities/InputTag.h"
+#include "cetlib_except/exception.h"
+#include "fhiclcpp/ParameterSet.h"
+
+#include "MCDataProducts/inc/StepPointMC.hh"
+#include "MCDataProducts/inc/StepPointMCCollection.hh"
+
+namespace mu2e {
+
+    class BFieldBenchStepDumper : public art::EDAnalyzer {
+       public:
+        explicit BFieldBenchStepDumper(const fhicl::ParameterSet& pset);
+        void analyze(const art::Event& event) override;
+
+       private:
+        std::vector<art::InputTag> inputs_;
+
+        // Stop writing after this many points; 0 means no limit.
+        unsigned long maxPoints_;
+        unsigned long nPoints_;
+
+        std::ofstream out_;
+    };
+
+    BFieldBenchStepDumper::BFieldBenchStepDumper(const fhicl::ParameterSet& pset)
+        : art::EDAnalyzer(pset),
+          inputs_(pset.get<std::vector<art::InputTag>>("inputs")),
+          maxPoints_(pset.get<unsigned long>("maxPoints", 0)),
+          nPoints_(0),
+          out_(pset.get<std::string>("outputFile").c_str()) {
+        if (!out_) {
+            throw cet::exception("GEOM")
+                << "BFieldBenchStepDumper: cannot open " << pset.get<std::string>("outputFile")
+                << "\n";
+        }
+        out_.precision(9);
+        out_ << "# x y z (mm, Mu2e coordinates) of StepPointMCs\n";
+    }
+
+    void BFieldBenchStepDumper::analyze(const art::Event& event) {
+        for (auto const& tag : inputs_) {
+            auto const& steps = *event.getValidHandle<StepPointMCCollection>(tag);
+            for (auto const& step : steps) {
+                for (auto const* p : {&step.position(), &step.postPosition()}) {
+                    if (maxPoints_ > 0 && nPoints_ >= maxPoints_) {
+                        return;
+                    }
+                    out_ << p->x() << " " << p->y() << " " << p->z() << "\n";
+                    ++nPoints_;
+                }
+            }
+        }
+    }
+
+}  // namespace mu2e
+
+DEFINE_ART_MODULE(mu2e::BFieldBenchStepDumper);
@@ -0,0 +1,345 @@
+//
+// Standalone benchmark of magnetic field lookups through BFieldManager.
+//
+// The field maps named in a geometry file are loaded by BFieldManagerMaker, exactly as
+// GeometryService does, and three streams of points are replayed through
+// BFieldManager::getBFieldWithStatus:
+//
+//   helix     conversion electron like tracks that start in the stopping target and are
+//             followed through the field, in steps of stepLength, until they leave the
+//             tracker;
+//   steps     positions read from a text file, one "x y z" (mm, Mu2e coordinates) per
+//             line, for example Geant4 steps written by BFieldBenchStepDumper;
+//   boundary  random points within boundaryWidth of the faces of the inner maps, where
+//             successive lookups move between maps.
+//
+// For each stream it prints the time per lookup, the BFCacheManager statistics and,
+// when a second geometry file is given, the largest difference between the fields of
+// the two map sets.  Use a second file that differs only in, for example,
+// bfield.interpolationStyle or bfield.tabulateParamMaps to measure the effect of that
+// option; see BFieldTest/test/geom_bfieldBench_meco.txt.
+//
+// Usage: bfieldBench [options] geometryFile
+//
+
+// C++ includes
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Framework includes
+#include "cetlib_except/exception.h"
+
+// Mu2e includes
+#include "BFieldGeom/inc/BFCacheManager.hh"
+#include "BFieldGeom/inc/BFieldConfig.hh"
+#include "BFieldGeom/inc/BFieldManager.hh"
+#include "BeamlineGeom/inc/Beamline.hh"
+#include "ConfigTools/inc/SimpleConfig.hh"
+#include "GeometryService/inc/BFieldConfigMaker.hh"
+#include "GeometryService/inc/BFieldManagerMaker.hh"
+#include "GeometryService/inc/BeamlineMaker.hh"
+
+// CLHEP includes
+#include "CLHEP/Vector/ThreeVector.h"
+
+using CLHEP::Hep3Vector;
+using namespace std;
+
+namespace {
+
+    struct Options {
+        string geometryFile;
+        string compareFile;  // optional second map set
+        string stepFile;     // optional file of step positions
+        size_t nPoints = 1000000;
+        int nRepeat = 5;
+        unsigned seed = 12345;
+        double stepLength = 5.;      // mm, along the helices
+        double boundaryWidth = 50.;  // mm, either side of the inner map faces
+    };
+
+    void usage(const char* prog) {
+        cerr << "Usage: " << prog << " [options] geometryFile\n"
+             << "  -c file   second geometry file; report the field difference to it\n"
+             << "  -s file   text file of step positions, one \"x y z\" per line\n"
+             << "  -n N      points in the helix and boundary streams (default 1000000)\n"
+             << "  -r N      times each stream is replayed for timing (default 5)\n"
+             << "  -l mm     step length along the helices (default 5)\n"
+             << "  -w mm     half width of the region around the map faces (default 50)\n"
+             << "  -S seed   random number seed (default 12345)\n";
+    }
+
+    unique_ptr<mu2e::BFieldManager> loadMaps(const string& geometryFile) {
+        mu2e::SimpleConfig config(geometryFile);
+        unique_ptr<mu2e::Beamline> beamline(mu2e::BeamlineMaker::make(config));
+        unique_ptr<mu2e::BFieldConfig> bfc(
+            mu2e::BFieldConfigMaker(config, *beamline).getBFieldConfig());
+        mu2e::BFieldManagerMaker maker(*bfc);
+        return maker.getBFieldManager();
+    }
+
+    // Electrons of the conversion momentum that start in the stopping target with
+    // pitches that reach the tracker.  The tracks are followed through the field
+    // itself, so they have the curvature and drift of real tracks.
+    vector<Hep3Vector> helixPoints(const mu2e::BFieldManager& bfmgr,
+                                   const Options& opt,
+                                   mt19937_64& engine) {
+        const double p = 104.97;       // MeV/c
+        const double xAxis = -3904.;   // DS axis, Mu2e coordinates
+        const double zTarget0 = 5400.; // stopping target region
+        const double zTarget1 = 6300.;
+        const double rTarget = 75.;
+        const double zEnd = 12000.;    // downstream end of the tracker
+        const double rMax = 800.;      // inside the DS warm bore
+        const double c = 0.299792458;  // MeV/c per T mm
+        const int maxSteps = 100000;
+
+        uniform_real_distribution<double> flat(0., 1.);
+        vector<Hep3Vector> points;
+        points.reserve(opt.nPoints);
+        int emptyTracks(0);
+        while (points.size() < opt.nPoints) {
+            const double rho = rTarget * sqrt(flat(engine));
+            const double phi = 2. * M_PI * flat(engine);
+            Hep3Vector x(xAxis + rho * cos(phi), rho * sin(phi),
+                         zTarget0 + (zTarget1 - zTarget0) * flat(engine));
+
+            const double cosTheta = 0.5 + 0.3 * flat(engine);
+            const double sinTheta = sqrt(1. - cosTheta * cosTheta);
+            const double phi0 = 2. * M_PI * flat(engine);
+            Hep3Vector u(sinTheta * cos(phi0), sinTheta * sin(phi0), cosTheta);
+
+            const size_t start = points.size();
+            for (int i = 0; i < maxSteps && points.size() < opt.nPoints; ++i) {
+                Hep3Vector b;
+                if (!bfmgr.getBFieldWithStatus(x, b)) {
+                    break;
+                }
+                points.push_back(x);
+
+                // Negative charge: the direction turns right-handed about B.
+                x += 0.5 * opt.stepLength * u;
+                const double bmag = b.mag();
+                if (bmag > 0.) {
+                    u.rotate(c * bmag * opt.stepLength / p, b / bmag);
+                }
+                x += 0.5 * opt.stepLength * u;
+
+                if (x.z() > zEnd || hypot(x.x() - xAxis, x.y()) > rMax) {
+                    break;
+                }
+            }
+
+            // The maps do not cover the stopping target; don't loop forever.
+            if (points.size() == start && ++emptyTracks > 1000) {
+                throw cet::exception("GEOM")
+                    << "bfieldBench: no field at the stopping target; wrong geometry file?\n";
+            }
+        }
+        return points;
+    }
+
+    vector<Hep3Vector> stepPoints(const string& filename) {
+        ifstream in(filename.c_str());
+        if (!in) {
+            throw cet::exception("GEOM") << "bfieldBench: cannot open " << filename << "\n";
+        }
+        vector<Hep3Vector> points;
+        string line;
+        while (getline(in, line)) {
+            if (line.empty() || line[0] == '#') {
+                continue;
+            }
+            istringstream is(line);
+            double x, y, z;
+            if (!(is >> x >> y >> z)) {
+                throw cet::exception("GEOM")
+                    << "bfieldBench: bad line in " << filename << ": " << line << "\n";
+            }
+            points.emplace_back(x, y, z);
+        }
+        return points;
+    }
+
+    // Points near the faces of the bounding boxes of the inner maps.
+    vector<Hep3Vector> boundaryPoints(const mu2e::BFieldManager& bfmgr,
+                                      const Options& opt,
+                                      mt19937_64& engine) {
+        const auto& maps = bfmgr.getInnerMaps();
+        vector<Hep3Vector> points;
+        if (maps.empty()) {
+            return points;
+        }
+
+        uniform_real_distribution<double> flat(0., 1.);
+        uniform_int_distribution<size_t> pickMap(0, maps.size() - 1);
+        uniform_int_distribution<int> pickFace(0, 5);
+        points.reserve(opt.nPoints);
+        while (points.size() < opt.nPoints) {
+            const mu2e::BFMap& m = *maps[pickMap(engine)];
+            const double lo[3] = {m.xmin(), m.ymin(), m.zmin()};
+            const double hi[3] = {m.xmax(), m.ymax(), m.zmax()};
+            double v[3];
+            for (int i = 0; i < 3; ++i) {
+                v[i] = lo[i] + (hi[i] - lo[i]) * flat(engine);
+            }
+            const int face = pickFace(engine);
+            const int axis = face / 2;
+            v[axis] = ((face % 2) ? hi[axis] : lo[axis]) +
+                      opt.boundaryWidth * (2. * flat(engine) - 1.);
+            points.emplace_back(v[0], v[1], v[2]);
+        }
+        return points;
+    }
+
+    void runStream(const string& name,
+                   const vector<Hep3Vector>& points,
+                   const mu2e::BFieldManager& bfmgr,
+                   const mu2e::BFieldManager* compare,
+                   const Options& opt) {
+        typedef chrono::steady_clock Clock;
+
+        if (points.empty()) {
+            cout << "\n" << name << ": no points\n";
+            return;
+        }
+
+        vector<Hep3Vector> fields(points.size());
+        vector<char> status(points.size());
+
+        // One untimed pass so that the maps are in memory.
+        for (size_t i = 0; i < points.size(); ++i) {
+            status[i] = bfmgr.getBFieldWithStatus(points[i], fields[i]);
+        }
+
+        mu2e::BFCacheManager::resetThreadStatistics();
+        Hep3Vector sum;
+        const auto t0 = Clock::now();
+        for (int r = 0; r < opt.nRepeat; ++r) {
+            for (size_t i = 0; i < points.size(); ++i) {
+                Hep3Vector b;
+                bfmgr.getBFieldWithStatus(points[i], b);
+                sum += b;
+            }
+        }
+        const auto t1 = Clock::now();
+        const mu2e::BFCacheManager::Statistics st =
+            mu2e::BFCacheManager::threadStatistics();
+
+        const double nlookups = double(points.size()) * opt.nRepeat;
+        const double ns = chrono::duration<double, nano>(t1 - t0).count() / nlookups;
+        const double nl = double(st.lookups);
+
+        cout << "\n"
+             << name << ": " << points.size() << " points, " << opt.nRepeat << " passes\n"
+             << "  time per lookup:          " << setprecision(4) << ns << " ns\n"
+             << "  hint hits:                " << 100. * st.hintHits / nl << " %\n"
+             << "  spatial index searches:   " << 100. * st.binSearches / nl << " %\n"
+             << "  isValid calls per lookup: " << st.validityChecks / nl << "\n"
+             << "  outside of all maps:      " << 100. * st.misses / nl << " %\n"
+             << "  (checksum " << sum.mag() << ")\n";
+
+        if (!compare) {
+            return;
+        }
+
+        double maxDiff(0.), sumDiff(0.);
+        size_t imax(0), nstatus(0);
+        for (size_t i = 0; i < points.size(); ++i) {
+            Hep3Vector b;
+            const bool ok = compare->getBFieldWithStatus(points[i], b);
+            if (ok != bool(status[i])) {
+                ++nstatus;
+            }
+            const double d = (b - fields[i]).mag();
+            sumDiff += d;
+            if (d > maxDiff) {
+                maxDiff = d;
+                imax = i;
+            }
+        }
+        cout << "  |B - B compare|, T:       max " << maxDiff << " mean "
+             << sumDiff / points.size() << "\n";
+        if (maxDiff > 0.) {
+            cout << "  largest difference at:    " << points[imax] << "\n";
+        }
+        cout << "  different status:         " << nstatus << " points\n";
+    }
+
+}  // end anonymous namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    int c;
+    while ((c = getopt(argc, argv, "c:s:n:r:l:w:S:h")) != -1) {
+        switch (c) {
+            case 'c':
+                opt.compareFile = optarg;
+                break;
+            case 's':
+                opt.stepFile = optarg;
+                break;
+            case 'n':
+                opt.nPoints = strtoul(optarg, nullptr, 10);
+                break;
+            case 'r':
+                opt.nRepeat = atoi(optarg);
+                break;
+            case 'l':
+                opt.stepLength = atof(optarg);
+                break;
+            case 'w':
+                opt.boundaryWidth = atof(optarg);
+                break;
+            case 'S':
+                opt.seed = strtoul(optarg, nullptr, 10);
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+    if (optind != argc - 1 || opt.nRepeat < 1 || !(opt.stepLength > 0.)) {
+        usage(argv[0]);
+        return 1;
+    }
+    opt.geometryFile = argv[optind];
+
+    try {
+        unique_ptr<mu2e::BFieldManager> bfmgr(loadMaps(opt.geometryFile));
+        unique_ptr<mu2e::BFieldManager> compare;
+        if (!opt.compareFile.empty()) {
+            compare = loadMaps(opt.compareFile);
+        }
+
+        cout << "Maps from " << opt.geometryFile << ": " << bfmgr->getInnerMaps().size()
+             << " inner, " << bfmgr->getOuterMaps().size() << " outer\n";
+        if (compare) {
+            cout << "Compared with the maps from " << opt.compareFile << "\n";
+        }
+
+        mt19937_64 engine(opt.seed);
+        runStream("helix", helixPoints(*bfmgr, opt, engine), *bfmgr, compare.get(), opt);
+        if (!opt.stepFile.empty()) {
+            runStream("steps", stepPoints(opt.stepFile), *bfmgr, compare.get(), opt);
+        }
+        runStream("boundary", boundaryPoints(*bfmgr, opt, engine), *bfmgr, compare.get(),
+                  opt);
+    } catch (cet::exception& e) {
+        cerr << e.what() << endl;
+        return 2;
+    }
+
+    return 0;
+}
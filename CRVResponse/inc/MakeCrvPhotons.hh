@@ -83,6 +83,12 @@ struct LookupBin
   void ReadVector(std::vector<unsigned char> &v, std::ifstream &i);
   void Write(const std::string &filename);
   void Read(std::ifstream &lookupfile, const unsigned int &i);
+
+  //cumulative sums of timeDelays and fiberEmissions (capped at probabilityScale) filled by Read.
+  //they allow the inverse-CDF sampling with a binary search instead of summing up the probabilities for every photon.
+  std::vector<unsigned char> timeDelaysCumulative;
+  std::vector<unsigned char> fiberEmissionsCumulative;
+  void MakeCumulative(const std::vector<unsigned char> &v, std::vector<unsigned char> &cumulative);
 };
 
 
@@ -130,10 +136,15 @@ class MakeCrvPhotons
     CLHEP::RandGaussQ         &_randGaussQ;
     CLHEP::RandPoissonQ       &_randPoissonQ;
 
+    std::vector<double>       _randomNumbers;    //reused buffers for the photons of one lookup bin
+    std::vector<int>          _photonEmissions;
+    std::vector<double>       _photonTimes;
+
     bool   IsInsideScintillator(const CLHEP::Hep3Vector &p);
     bool   IsInsideFiber(const CLHEP::Hep3Vector &p, const CLHEP::Hep3Vector &dir, double &r, double &phi);
-    double GetRandomTime(const LookupBin *theBin, bool &overflow);
-    int    GetRandomFiberEmissions(const LookupBin *theBin, bool &overflow);
+    double GetRandomTime(const LookupBin *theBin, double rand, bool &overflow);
+    int    GetRandomFiberEmissions(const LookupBin *theBin, double rand, bool &overflow);
+    void   MakePhotonsInBin(const LookupBin *theBin, int nPhotons, double t, std::vector<double> &arrivalTimes);
     double GetAverageNumberOfCerenkovPhotons(double beta, double charge, std::map<double,double> &photons);
     int    GetNumberOfPhotonsFromAverage(double average, int nSteps);
 
@@ -9,7 +9,9 @@ namespace mu2eCrv
 class MakeCrvRecoPulses
 {
   public:
-  MakeCrvRecoPulses();
+  //useROOTFit selects the original TF1/Minuit fit of the pulse shape instead of the built-in fit;
+  //only used to compare the two
+  MakeCrvRecoPulses(bool useROOTFit=false);
   void         SetWaveform(const std::vector<unsigned int> &waveform, unsigned int startTDC, 
                            double digitizationPeriod, double pedestal, double calibrationFactor, double calibrationFactorPulseHeight, bool darkNoise);
   unsigned int GetNPulses();
@@ -29,6 +31,7 @@ class MakeCrvRecoPulses
   int          GetPeakBin(int pulse);
 
   private:
+  bool                _useROOTFit;
   std::vector<int>    _PEs, _PEsPulseHeight;
   std::vector<double> _pulseTimes, _pulseHeights, _pulseBetas, _pulseFitChi2s;
   std::vector<double> _fitParams0, _fitParams1, _fitParams2, _t1s, _t2s;
@@ -0,0 +1,170 @@
+//
+// A module to compare the reco pulse fit of MakeCrvRecoPulses with the original ROOT (TF1/Minuit) fit.
+// Every waveform of the CrvDigiCollection is reconstructed with both fits.
+// The module reports the time spent in each fit and histograms the differences of the pulse parameters.
+//
+
+#include "CRVResponse/inc/MakeCrvRecoPulses.hh"
+
+#include "ConditionsService/inc/CrvParams.hh"
+#include "ConditionsService/inc/ConditionsHandle.hh"
+#include "RecoDataProducts/inc/CrvDigiCollection.hh"
+
+#include "art_root_io/TFileDirectory.h"
+#include "art_root_io/TFileService.h"
+#include "art/Framework/Services/Registry/ServiceHandle.h"
+#include "art/Framework/Core/EDAnalyzer.h"
+#include "art/Framework/Core/ModuleMacros.h"
+#include "art/Framework/Principal/Event.h"
+#include "art/Framework/Principal/Handle.h"
+#include "fhiclcpp/ParameterSet.h"
+#include "messagefacility/MessageLogger/MessageLogger.h"
+
+#include <TH1F.h>
+
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace mu2e
+{
+  class CrvRecoPulsesFitterBenchmark : public art::EDAnalyzer
+  {
+
+    public:
+    explicit CrvRecoPulsesFitterBenchmark(fhicl::ParameterSet const& pset);
+    void analyze(const art::Event& e);
+    void beginJob();
+    void beginRun(const art::Run &run);
+    void endJob();
+
+    private:
+    mu2eCrv::MakeCrvRecoPulses _makeCrvRecoPulses;
+    mu2eCrv::MakeCrvRecoPulses _makeCrvRecoPulsesROOT;
+
+    std::string _crvDigiModuleLabel;
+    bool        _darkNoise;
+    double      _digitizationPeriod;
+    double      _pedestal;
+    double      _calibrationFactor;
+    double      _calibrationFactorPulseHeight;
+
+    double      _time;       //ns spent in SetWaveform
+    double      _timeROOT;
+    size_t      _nWaveforms;
+    size_t      _nPulses;
+    size_t      _nPulsesROOT;
+    size_t      _nMismatches; //waveforms with a different number of pulses
+
+    TH1F       *_hPEs;
+    TH1F       *_hPulseTime;
+    TH1F       *_hPulseHeight;
+    TH1F       *_hPulseBeta;
+    TH1F       *_hPulseFitChi2;
+    TH1F       *_hLEtime;
+  };
+
+  CrvRecoPulsesFitterBenchmark::CrvRecoPulsesFitterBenchmark(fhicl::ParameterSet const& pset) :
+    art::EDAnalyzer{pset},
+    _makeCrvRecoPulses(false),
+    _makeCrvRecoPulsesROOT(true),
+    _crvDigiModuleLabel(pset.get<std::string>("crvDigiModuleLabel")),
+    _darkNoise(pset.get<bool>("darkNoise")),
+    _time(0), _timeROOT(0), _nWaveforms(0), _nPulses(0), _nPulsesROOT(0), _nMismatches(0)
+  {
+  }
+
+  void CrvRecoPulsesFitterBenchmark::beginJob()
+  {
+    art::ServiceHandle<art::TFileService> tfs;
+    _hPEs          = tfs->make<TH1F>("hPEs","PEs - PEs(ROOT fit);PEs",41,-20.5,20.5);
+    _hPulseTime    = tfs->make<TH1F>("hPulseTime","pulse time - pulse time(ROOT fit);ns",200,-1,1);
+    _hPulseHeight  = tfs->make<TH1F>("hPulseHeight","pulse height - pulse height(ROOT fit);ADC",200,-10,10);
+    _hPulseBeta    = tfs->make<TH1F>("hPulseBeta","pulse beta - pulse beta(ROOT fit);ns",200,-1,1);
+    _hPulseFitChi2 = tfs->make<TH1F>("hPulseFitChi2","fit chi2 - fit chi2(ROOT fit);ADC^{2}",200,-10,10);
+    _hLEtime       = tfs->make<TH1F>("hLEtime","LE time - LE time(ROOT fit);ns",200,-1,1);
+  }
+
+  void CrvRecoPulsesFitterBenchmark::beginRun(const art::Run &run)
+  {
+    mu2e::ConditionsHandle<mu2e::CrvParams> crvPar("ignored");
+    _digitizationPeriod = crvPar->digitizationPeriod;
+    _pedestal           = crvPar->pedestal;
+    _calibrationFactor  = crvPar->calibrationFactor;
+    _calibrationFactorPulseHeight  = crvPar->calibrationFactorPulseHeight;
+  }
+
+  void CrvRecoPulsesFitterBenchmark::analyze(const art::Event& event)
+  {
+    typedef std::chrono::steady_clock Clock;
+
+    art::Handle<CrvDigiCollection> crvDigiCollection;
+    event.getByLabel(_crvDigiModuleLabel,"",crvDigiCollection);
+
+    //same concatenation of consecutive digis as in CrvRecoPulsesFinder
+    size_t waveformIndex = 0;
+    while(waveformIndex<crvDigiCollection->size())
+    {
+      const CrvDigi &digi = crvDigiCollection->at(waveformIndex);
+      const CRSScintillatorBarIndex &barIndex = digi.GetScintillatorBarIndex();
+      int SiPM = digi.GetSiPMNumber();
+      unsigned int startTDC = digi.GetStartTDC();
+      std::vector<unsigned int> ADCs;
+      for(size_t i=0; i<CrvDigi::NSamples; i++) ADCs.push_back(digi.GetADCs()[i]);
+
+      while(++waveformIndex<crvDigiCollection->size())
+      {
+        const CrvDigi &nextDigi = crvDigiCollection->at(waveformIndex);
+        if(barIndex!=nextDigi.GetScintillatorBarIndex()) break;
+        if(SiPM!=nextDigi.GetSiPMNumber()) break;
+        if(startTDC+ADCs.size()!=nextDigi.GetStartTDC()) break;
+        for(size_t i=0; i<CrvDigi::NSamples; i++) ADCs.push_back(nextDigi.GetADCs()[i]);
+      }
+
+      auto t0 = Clock::now();
+      _makeCrvRecoPulses.SetWaveform(ADCs, startTDC, _digitizationPeriod, _pedestal, _calibrationFactor, _calibrationFactorPulseHeight, _darkNoise);
+      auto t1 = Clock::now();
+      _makeCrvRecoPulsesROOT.SetWaveform(ADCs, startTDC, _digitizationPeriod, _pedestal, _calibrationFactor, _calibrationFactorPulseHeight, _darkNoise);
+      auto t2 = Clock::now();
+      _time     += std::chrono::duration<double, std::nano>(t1-t0).count();
+      _timeROOT += std::chrono::duration<double, std::nano>(t2-t1).count();
+
+      unsigned int n     = _makeCrvRecoPulses.GetNPulses();
+      unsigned int nROOT = _makeCrvRecoPulsesROOT.GetNPulses();
+      ++_nWaveforms;
+      _nPulses     += n;
+      _nPulsesROOT += nROOT;
+
+      //pulses which fail one of the fits are dropped, so the pulses can only be matched if both fits kept the same number
+      if(n!=nROOT) {++_nMismatches; continue;}
+      for(unsigned int j=0; j<n; j++)
+      {
+        _hPEs->Fill(_makeCrvRecoPulses.GetPEs(j)-_makeCrvRecoPulsesROOT.GetPEs(j));
+        _hPulseTime->Fill(_makeCrvRecoPulses.GetPulseTime(j)-_makeCrvRecoPulsesROOT.GetPulseTime(j));
+        _hPulseHeight->Fill(_makeCrvRecoPulses.GetPulseHeight(j)-_makeCrvRecoPulsesROOT.GetPulseHeight(j));
+        _hPulseBeta->Fill(_makeCrvRecoPulses.GetPulseBeta(j)-_makeCrvRecoPulsesROOT.GetPulseBeta(j));
+        _hPulseFitChi2->Fill(_makeCrvRecoPulses.GetPulseFitChi2(j)-_makeCrvRecoPulsesROOT.GetPulseFitChi2(j));
+        _hLEtime->Fill(_makeCrvRecoPulses.GetLEtime(j)-_makeCrvRecoPulsesROOT.GetLEtime(j));
+      }
+    }
+  }
+
+  void CrvRecoPulsesFitterBenchmark::endJob()
+  {
+    if(_nWaveforms==0) return;
+    mf::LogInfo("CrvRecoPulsesFitterBenchmark")
+      << "waveforms:                       " << _nWaveforms << "\n"
+      << "pulses (closed form / ROOT):     " << _nPulses << " / " << _nPulsesROOT << "\n"
+      << "waveforms with other pulses:     " << _nMismatches << "\n"
+      << "time per waveform, closed form:  " << _time/_nWaveforms << " ns\n"
+      << "time per waveform, ROOT fit:     " << _timeROOT/_nWaveforms << " ns\n"
+      << "RMS pulse time difference:       " << _hPulseTime->GetRMS() << " ns\n"
+      << "RMS LE time difference:          " << _hLEtime->GetRMS() << " ns\n"
+      << "RMS PE difference:               " << _hPEs->GetRMS() << "\n";
+  }
+
+} // end namespace mu2e
+
+using mu2e::CrvRecoPulsesFitterBenchmark;
+DEFINE_ART_MODULE(CrvRecoPulsesFitterBenchmark)
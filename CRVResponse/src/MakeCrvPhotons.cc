@@ -1,5 +1,6 @@
 #include "CRVResponse/inc/MakeCrvPhotons.hh"
 
+#include <algorithm>
 #include <sstream>
 
 #include "CLHEP/Units/GlobalSystemOfUnits.h"
@@ -243,6 +244,20 @@ void LookupBin::Read(std::ifstream &lookupfile, const unsigned int &i)
   ReadVector(timeDelays, lookupfile);
   ReadVector(fiberEmissions, lookupfile);
   if(i!=binNumber) throw std::logic_error("Corrupt lookup table.");
+  MakeCumulative(timeDelays, timeDelaysCumulative);
+  MakeCumulative(fiberEmissions, fiberEmissionsCumulative);
+}
+void LookupBin::MakeCumulative(const std::vector<unsigned char> &v, std::vector<unsigned char> &cumulative)
+{
+  //random numbers are drawn below probabilityScale,
+  //so capping the sums at probabilityScale doesn't change the result of the sampling
+  cumulative.resize(v.size());
+  unsigned int sumProb=0;
+  for(size_t i=0; i<v.size(); i++)
+  {
+    sumProb+=v[i];
+    cumulative[i]=std::min(sumProb,static_cast<unsigned int>(probabilityScale));
+  }
 }
 
 void MakeCrvPhotons::LoadLookupTable(const std::string &filename)
@@ -384,39 +399,55 @@ void MakeCrvPhotons::MakePhotons(const CLHEP::Hep3Vector &stepStartTmp,   //they
         }
       }
 
-      //loop over all photons created at this point
-      int nPhotons = nPhotonsScintillation + nPhotonsCerenkov;
-      for(int i=0; i<nPhotons; i++)
-      {
-        //get the right bin
-        const LookupBin *theBin=cerenkovBin;
-        if(i<nPhotonsScintillation) theBin=scintillationBin;
-        if(theBin==NULL) continue;  //this can't actually happen
-
-        //photon arrival probability at SiPM
-        double probability = theBin->arrivalProbability;
-        if(_randFlat.fire()<=probability)  //a photon arrives at the SiPM --> calculate arrival time
-        {
-          //start time of photons
-          double arrivalTime = t;
-
-          //add fiber decay times depending on the number of emissions
-          bool overflow=false;
-          int nEmissions = GetRandomFiberEmissions(theBin,overflow);
-          if(overflow) continue;  //don't include photons which arrive very late. they are spread out, and can be ignored
-          for(int iEmission=0; iEmission<nEmissions; iEmission++) arrivalTime+=-_LC.WLSfiberDecayTime*log(_randFlat.fire());
-
-          //add additional time delay due to the photons bouncing around
-          arrivalTime+=GetRandomTime(theBin,overflow);
-          if(overflow) continue;  //don't include photons which arrive very late. they are spread out, and can be ignored
-
-          if(reflector!=-1) _arrivalTimes[SiPM].push_back(arrivalTime);
-          else _arrivalTimes[SiPM+1].push_back(arrivalTime);
+      //photons created at this point
+      std::vector<double> &arrivalTimes = (reflector!=-1?_arrivalTimes[SiPM]:_arrivalTimes[SiPM+1]);
+      if(scintillationBin!=NULL) MakePhotonsInBin(scintillationBin, nPhotonsScintillation, t, arrivalTimes);
+      if(cerenkovBin!=NULL) MakePhotonsInBin(cerenkovBin, nPhotonsCerenkov, t, arrivalTimes);
+    }//loop over all points along the track
+  }//loop over all SiPMs
+}
+
+//creates the photons which start at time t in a lookup bin.
+//the photons are handled as a batch: the number of photons arriving at the SiPM is drawn from a binomial distribution,
+//and the random numbers for all arriving photons are drawn in one call.
+//the sum of n exponentially distributed fiber decay times is Gamma distributed,
+//and is drawn as -decayTime*log(u_1*...*u_n), which needs only one log per photon.
+void MakeCrvPhotons::MakePhotonsInBin(const LookupBin *theBin, int nPhotons, double t, std::vector<double> &arrivalTimes)
+{
+  if(nPhotons<=0 || theBin->arrivalProbability<=0) return;
+
+  //photon arrival probability at SiPM
+  int nArrivals = static_cast<int>(CLHEP::RandBinomial::shoot(&_randFlat.engine(), nPhotons, theBin->arrivalProbability));
+  if(nArrivals<=0) return;
+
+  //number of fiber emissions and time delay due to the photons bouncing around
+  _randomNumbers.resize(2*nArrivals);
+  _randFlat.fireArray(2*nArrivals, _randomNumbers.data());
+  _photonEmissions.clear();
+  _photonTimes.clear();
+  int nEmissionsTotal=0;
+  for(int i=0; i<nArrivals; i++)
+  {
+    bool overflow=false;
+    int nEmissions = GetRandomFiberEmissions(theBin,_randomNumbers[2*i],overflow);
+    if(overflow) continue;  //don't include photons which arrive very late. they are spread out, and can be ignored
+    double timeDelay = GetRandomTime(theBin,_randomNumbers[2*i+1],overflow);
+    if(overflow) continue;  //don't include photons which arrive very late. they are spread out, and can be ignored
+    _photonEmissions.push_back(nEmissions);
+    _photonTimes.push_back(t+timeDelay);
+    nEmissionsTotal+=nEmissions;
+  }
 
-        }// if a photon was created
-      }//loop over all SiPMs
-    }//loop over all photons at this point
-  }//loop over all points along the track
+  //add fiber decay times depending on the number of emissions
+  _randomNumbers.resize(nEmissionsTotal);
+  _randFlat.fireArray(nEmissionsTotal, _randomNumbers.data());
+  const double *rand=_randomNumbers.data();
+  for(size_t i=0; i<_photonTimes.size(); i++)
+  {
+    double product=1.0;
+    for(int iEmission=0; iEmission<_photonEmissions[i]; iEmission++) product*=*rand++;  //at most maxFiberEmissions factors
+    arrivalTimes.push_back(_photonTimes[i]-_LC.WLSfiberDecayTime*log(product));
+  }
 }
 
 bool MakeCrvPhotons::IsInsideScintillator(const CLHEP::Hep3Vector &p)
@@ -469,40 +500,30 @@ bool MakeCrvPhotons::IsInsideFiber(const CLHEP::Hep3Vector &p, const CLHEP::Hep3
   return true;
 }
 
-double MakeCrvPhotons::GetRandomTime(const LookupBin *theBin, bool &overflow)
+double MakeCrvPhotons::GetRandomTime(const LookupBin *theBin, double rand, bool &overflow)
 {
-  //the lookup tables encodes probabilities as probability*probabilityScale(10000), 
-  //so that the probabilities can be stored as integers.
-  //therefore, the probability of 1 is stored as 10000.
-  double rand=_randFlat.fire()*LookupBin::probabilityScale;
-  double sumProb=0;
-  size_t timeDelay=0;
-  size_t maxTimeDelay=theBin->timeDelays.size();
-  for(; timeDelay<maxTimeDelay; timeDelay++)
-  {
-    sumProb+=theBin->timeDelays[timeDelay];
-    if(rand<=sumProb) break;
-  }
-  if(rand>sumProb) overflow=true; else overflow=false;
+  //the lookup tables encodes probabilities as probability*probabilityScale(255),
+  //so that the probabilities can be stored as unsigned chars.
+  //therefore, the probability of 1 is stored as 255.
+  //returns the first time delay at which the cumulative probability reaches rand.
+  rand*=LookupBin::probabilityScale;
+  const std::vector<unsigned char> &cumulative=theBin->timeDelaysCumulative;
+  size_t timeDelay=std::lower_bound(cumulative.begin(),cumulative.end(),rand)-cumulative.begin();
+  overflow=(timeDelay==cumulative.size());
 
   return timeDelay;
 }
 
-int MakeCrvPhotons::GetRandomFiberEmissions(const LookupBin *theBin, bool &overflow)
+int MakeCrvPhotons::GetRandomFiberEmissions(const LookupBin *theBin, double rand, bool &overflow)
 {
-  //the lookup tables encodes probabilities as probability*probabilityScale(10000), 
-  //so that the probabilities can be stored as integers.
-  //therefore, the probability of 1 is stored as 10000.
-  double rand=_randFlat.fire()*LookupBin::probabilityScale;
-  double sumProb=0;
-  size_t emissions=0;
-  size_t maxEmissions=theBin->fiberEmissions.size();
-  for(; emissions<maxEmissions; emissions++)
-  {
-    sumProb+=theBin->fiberEmissions[emissions];
-    if(rand<=sumProb) break;
-  }
-  if(rand>sumProb) overflow=true; else overflow=false;
+  //the lookup tables encodes probabilities as probability*probabilityScale(255),
+  //so that the probabilities can be stored as unsigned chars.
+  //therefore, the probability of 1 is stored as 255.
+  //returns the first number of emissions at which the cumulative probability reaches rand.
+  rand*=LookupBin::probabilityScale;
+  const std::vector<unsigned char> &cumulative=theBin->fiberEmissionsCumulative;
+  size_t emissions=std::lower_bound(cumulative.begin(),cumulative.end(),rand)-cumulative.begin();
+  overflow=(emissions==cumulative.size());
 
   return emissions;
 }
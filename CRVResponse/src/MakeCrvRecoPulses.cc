@@ -4,11 +4,132 @@
 #include <TF1.h>
 #include <TGraph.h>
 #include <TMath.h>
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+  //The pulse shape is the Gumbel function A*exp(-(t-mu)/beta-exp(-(t-mu)/beta)).
+  //It is fitted by minimizing the sum of the squared residuals (i.e. like an unweighted TGraph fit)
+  //with Levenberg-Marquardt steps using the analytic derivatives.
+  //The fit runs for every pulse, so it works on small fixed-size buffers and allocates nothing.
+  const int maxFitPoints  = 16;   //the pulse selection below uses at most 9 points
+  const int maxIterations = 100;
+
+  double GumbelChi2(const double *t, const double *v, int n, const double *p)
+  {
+    double chi2=0;
+    for(int i=0; i<n; i++)
+    {
+      double z=(t[i]-p[1])/p[2];
+      double r=v[i]-p[0]*exp(-z-exp(-z));
+      chi2+=r*r;
+    }
+    return chi2;
+  }
+
+  //solve the symmetric 3x3 system M*x=b; returns false if M is singular
+  bool Solve3(const double M[3][3], const double b[3], double x[3])
+  {
+    double c00=M[1][1]*M[2][2]-M[1][2]*M[2][1];
+    double c01=M[1][2]*M[2][0]-M[1][0]*M[2][2];
+    double c02=M[1][0]*M[2][1]-M[1][1]*M[2][0];
+    double det=M[0][0]*c00+M[0][1]*c01+M[0][2]*c02;
+    if(det==0 || !std::isfinite(det)) return false;
+    double c11=M[0][0]*M[2][2]-M[0][2]*M[2][0];
+    double c12=M[0][1]*M[2][0]-M[0][0]*M[2][1];
+    double c22=M[0][0]*M[1][1]-M[0][1]*M[1][0];
+    x[0]=(c00*b[0]+c01*b[1]+c02*b[2])/det;
+    x[1]=(c01*b[0]+c11*b[1]+c12*b[2])/det;
+    x[2]=(c02*b[0]+c12*b[1]+c22*b[2])/det;
+    return true;
+  }
+
+  //p holds the start values (A, mu, beta) and returns the fitted values
+  bool FitGumbel(const double *t, const double *v, int n, double *p, double &chi2)
+  {
+    chi2=GumbelChi2(t,v,n,p);
+    if(!std::isfinite(chi2)) return false;
+    double lambda=1e-3;
+    for(int iteration=0; iteration<maxIterations; iteration++)
+    {
+      //normal equations of the linearized problem
+      double JTJ[3][3]={{0,0,0},{0,0,0},{0,0,0}};
+      double JTr[3]={0,0,0};
+      for(int i=0; i<n; i++)
+      {
+        double z=(t[i]-p[1])/p[2];
+        double e=exp(-z);
+        double g=exp(-z-e);
+        double d[3]={g, p[0]*g*(1-e)/p[2], p[0]*g*z*(1-e)/p[2]};
+        double r=v[i]-p[0]*g;
+        for(int j=0; j<3; j++)
+        {
+          JTr[j]+=d[j]*r;
+          for(int k=0; k<3; k++) JTJ[j][k]+=d[j]*d[k];
+        }
+      }
+
+      //stop when the expected decrease of chi2 (estimated distance to the minimum, as in Minuit)
+      //is small compared to the ADC resolution (chi2 is in ADC counts squared)
+      double newton[3];
+      if(Solve3(JTJ,JTr,newton) && 0.5*(JTr[0]*newton[0]+JTr[1]*newton[1]+JTr[2]*newton[2])<1e-6) return true;
+
+      //find a step which reduces chi2, increasing the damping until one does
+      double trial[3], trialChi2=chi2;
+      bool improved=false;
+      for(; lambda<1e10; lambda*=10)
+      {
+        double M[3][3], step[3];
+        for(int j=0; j<3; j++)
+        {
+          for(int k=0; k<3; k++) M[j][k]=JTJ[j][k];
+          M[j][j]*=1+lambda;
+        }
+        if(!Solve3(M,JTr,step)) continue;
+        for(int j=0; j<3; j++) trial[j]=p[j]+step[j];
+        if(trial[2]<=0) continue;
+        trialChi2=GumbelChi2(t,v,n,trial);
+        if(trialChi2<=chi2) {improved=true; break;}
+      }
+      //no step lowers chi2 any more: this is the minimum
+      if(!improved) return true;
+
+      for(int j=0; j<3; j++) p[j]=trial[j];
+      chi2=trialChi2;
+      lambda=std::max(lambda*0.1,1e-12);
+    }
+    return false;
+  }
+
+  //the original fit with ROOT, kept to compare with FitGumbel
+  bool FitGumbelROOT(const double *t, const double *v, int n, double *p, double &chi2)
+  {
+    TGraph g(n,t,v);
+    TF1 f("peakfitter","[0]*(TMath::Exp(-(x-[1])/[2]-TMath::Exp(-(x-[1])/[2])))");
+    for(int j=0; j<3; j++) f.SetParameter(j, p[j]);
+    TFitResultPtr fr = g.Fit(&f,"NQS");
+    if(!fr->IsValid()) return false;
+    for(int j=0; j<3; j++) p[j]=fr->Parameter(j);
+    chi2=fr->Chi2();
+    return true;
+  }
+
+  //the Gumbel shape is at 50% of its maximum on the leading edge at (t-mu)/beta=z,
+  //where z is the negative root of z+exp(-z)=1+ln(2)
+  double LeadingEdgeZ()
+  {
+    double z=-1.0;
+    for(int i=0; i<20; i++) z-=(z+exp(-z)-1-log(2.0))/(1-exp(-z));
+    return z;
+  }
+  const double leadingEdgeZ=LeadingEdgeZ();
+}
 
 namespace mu2eCrv
 {
 
-MakeCrvRecoPulses::MakeCrvRecoPulses()  
+MakeCrvRecoPulses::MakeCrvRecoPulses(bool useROOTFit) : _useROOTFit(useROOTFit)
 {}
 
 void MakeCrvRecoPulses::SetWaveform(const std::vector<unsigned int> &waveform, unsigned int startTDC, double digitizationPeriod, 
@@ -63,29 +184,30 @@ void MakeCrvRecoPulses::SetWaveform(const std::vector<unsigned int> &waveform, u
     double t1=(startTDC+startBin)*digitizationPeriod;
     double t2=(startTDC+endBin)*digitizationPeriod;
 
-    //fill the graph
-    TGraph g;
-    for(int bin=startBin; bin<=endBin; bin++) 
+    //fill the points
+    double t[maxFitPoints], v[maxFitPoints];
+    int n=0;
+    for(int bin=startBin; bin<=endBin && n<maxFitPoints; bin++, n++)
     {
-      double t=(startTDC+bin)*digitizationPeriod;
-      double v=waveform[bin]-pedestal;
-      g.SetPoint(g.GetN(), t, v);
+      t[n]=(startTDC+bin)*digitizationPeriod;
+      v[n]=waveform[bin]-pedestal;
     }
 
-    //set the fit function
-    TF1 f("peakfitter","[0]*(TMath::Exp(-(x-[1])/[2]-TMath::Exp(-(x-[1])/[2])))");
-    f.SetParameter(0, (waveform[maxBin]-pedestal)*TMath::E());
-    f.SetParameter(1, (startTDC+maxBin)*digitizationPeriod);
-    f.SetParameter(2, darkNoise?12.6:19.0);
-    if(peaks[i].second) f.SetParameter(1, (startTDC+maxBin+0.5)*digitizationPeriod);
+    //start values of the fit
+    double fitParams[3];
+    fitParams[0]=(waveform[maxBin]-pedestal)*TMath::E();
+    fitParams[1]=(startTDC+maxBin)*digitizationPeriod;
+    fitParams[2]=darkNoise?12.6:19.0;
+    if(peaks[i].second) fitParams[1]=(startTDC+maxBin+0.5)*digitizationPeriod;
 
     //do the fit
-    TFitResultPtr fr = g.Fit(&f,"NQS");
-    if(!fr->IsValid()) continue;
+    double pulseFitChi2;
+    bool validFit=_useROOTFit?FitGumbelROOT(t,v,n,fitParams,pulseFitChi2):FitGumbel(t,v,n,fitParams,pulseFitChi2);
+    if(!validFit) continue;
 
-    double fitParam0 = fr->Parameter(0);
-    double fitParam1 = fr->Parameter(1);
-    double fitParam2 = fr->Parameter(2);
+    double fitParam0 = fitParams[0];
+    double fitParam1 = fitParams[1];
+    double fitParam2 = fitParams[2];
     if(fitParam0<=0 || fitParam2<=0) continue;
     if(fitParam2>50) continue; //FIXME: need a better way to identify these fake pulse which are caused by electronic noise
     if(fabs(fitParam1-(startTDC+maxBin)*digitizationPeriod)>30) continue; //FIXME
@@ -95,9 +217,8 @@ void MakeCrvRecoPulses::SetWaveform(const std::vector<unsigned int> &waveform, u
     double pulseTime    = fitParam1;
     double pulseHeight  = fitParam0/TMath::E();
     double pulseBeta    = fitParam2;
-    double pulseFitChi2 = fr->Chi2();
 
-    double LEtime=f.GetX(0.5*pulseHeight,pulseTime-50,pulseTime);   //i.e. at 50% of pulse height
+    double LEtime=pulseTime+leadingEdgeZ*pulseBeta;   //i.e. at 50% of pulse height
     int    PEsPulseHeight = lrint(pulseHeight / calibrationFactorPulseHeight);
 
     _pulseTimes.push_back(pulseTime);
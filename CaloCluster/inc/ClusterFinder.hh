@@ -8,56 +8,71 @@
 
 // Mu2e includes
 #include "RecoDataProducts/inc/CaloCrystalHit.hh"
+#include "RecoDataProducts/inc/CaloCrystalHitCollection.hh"
 #include "CalorimeterGeom/inc/Calorimeter.hh"
+#include "CalorimeterGeom/inc/CaloNeighborTable.hh"
 
 
 // C++ includes
 #include <vector>
-#include <queue>
-#include <list>
+#include <limits>
 
 
 
 namespace mu2e {
 
 
+    // The finder is meant to live as long as the module: fill() prepares the hits of an event, then
+    // nextSeed() / formCluster() are called until the seeds run out. The buffers are reused between events.
     class ClusterFinder {
 
 
          public:
-             
-             typedef std::list<CaloCrystalHit const*>    CaloCrystalList;
+
              typedef std::vector<CaloCrystalHit const*>  CaloCrystalVec;
 
 
-             ClusterFinder(Calorimeter const& cal, CaloCrystalHit const* crystalSeed, double deltaTime, double ExpandCut);              
-        
-             
-             ClusterFinder(Calorimeter const& cal, CaloCrystalHit const* crystalSeed, double deltaTime, double ExpandCut, bool isOnline);  
+             ClusterFinder(double deltaTime, double ExpandCut, bool isOnline = false);
+
+	     ~ClusterFinder(){};
+
+             void fill(Calorimeter const& cal, CaloCrystalHitCollection const& hits, double EnoiseCut,
+                       double timeCut = std::numeric_limits<double>::lowest());
 
-	     ~ClusterFinder(){};            
-             
-             CaloCrystalList const& clusterList()  const {return clusterList_;}
-             
-             void formCluster(std::vector<CaloCrystalList>& idHitVec);
+             CaloCrystalHit const* nextSeed();
+             void                  formCluster(CaloCrystalHit const* crystalSeed);
+             void                  filterByTime(std::vector<double> const& clusterTime);
+
+             CaloCrystalVec const& clusterList()  const {return clusterList_;}
 
 
 
          private:
-             
-             Calorimeter const*     cal_;
-             CaloCrystalHit const*  crystalSeed_;
-             double                 seedTime_;
 
-             CaloCrystalList        clusterList_;
-             std::queue<int>        crystalToVisit_;
-             std::vector<bool>      isVisited_; 
+             double                    deltaTime_;
+             double                    ExpandCut_;
+ 	     bool 		       isOnline_;
+
+             CaloNeighborTable const*  neighbors_;
+             CaloCrystalHit const*     hitBase_;
+
+             // hits passing the noise cut, grouped by crystal (hits of crystal i in [crystalOffset_[i],crystalOffset_[i+1]))
+             std::vector<unsigned>     crystalOffset_;
+             std::vector<unsigned>     crystalFill_;
+             CaloCrystalVec            hits_;
+             std::vector<char>         isUsed_;
+             std::vector<int>          slotOfHit_;
 
-             double                 deltaTime_; 
-             double                 ExpandCut_;
+             // seeds sorted by decreasing energy, all seeds before seedCursor_ are used
+             std::vector<unsigned>     seeds_;
+             unsigned                  seedCursor_;
 
- 	     bool 		    isOnline_;
+             // a crystal is visited if its stamp equals the current epoch, so nothing is cleared between clusters
+             std::vector<unsigned>     visitStamp_;
+             unsigned                  epoch_;
+             std::vector<int>          crystalToVisit_;
 
+             CaloCrystalVec            clusterList_;
     };
 
 
@@ -153,6 +153,8 @@ void CaloClusterFast::extractRecoDigi(const art::Handle<CaloDigiCollection>& cal
 	mu2e::GeomHandle<mu2e::Calorimeter> ch;
 	const Calorimeter* cal = ch.get();
 	int nro = cal->caloInfo().nROPerCrystal();
+	const CaloNeighborTable& neighbors  = cal->neighborTable(false);
+	const CaloNeighborTable& expansion  = cal->neighborTable(extendSecond_);
 
 	unsigned offsetT0_ = unsigned(blindTime_/digiSampling_);
 	unsigned nBinTime  = unsigned (mbtime_ - blindTime_ + endTimeBuffer_) / digiSampling_;
@@ -225,7 +227,7 @@ void CaloClusterFast::extractRecoDigi(const art::Handle<CaloDigiCollection>& cal
 		 //seed->val_ = 0;
 
 		 std::queue<int> crystalToVisit;
-		 for (const auto& nid : cal->neighbors(seed->crId_)) crystalToVisit.push(nid);
+		 for (const int* it=neighbors.begin(seed->crId_); it!=neighbors.end(seed->crId_); ++it) crystalToVisit.push(*it);
 
 		 double     hitTime = (seed->index_+offsetT0_)*digiSampling_-timeCorrection_;
 		 if (includeCrystalHits_) {
@@ -249,8 +251,7 @@ void CaloClusterFast::extractRecoDigi(const art::Handle<CaloDigiCollection>& cal
                  			recoCrystalHits.push_back(CaloCrystalHit(hit.crId_, 2, hitTime, 0, hit.val_*adcToEnergy_, 0., caloRecoDigi));
                			}
 			       hit.val_ = 0;
-			       for (const auto& neighbor : cal->neighbors(nid)) crystalToVisit.push(neighbor);
-			       if (extendSecond_) for (const auto& nneighbor : cal->nextNeighbors(nid)) crystalToVisit.push(nneighbor);
+			       for (const int* it=expansion.begin(nid); it!=expansion.end(nid); ++it) crystalToVisit.push(*it);
             		}
 			for (auto& hit : hitList_[seed->index_-1])
 			{
@@ -264,8 +265,7 @@ void CaloClusterFast::extractRecoDigi(const art::Handle<CaloDigiCollection>& cal
                  recoCrystalHits.push_back(CaloCrystalHit(hit.crId_, 2, hitTime, 0, hit.val_*adcToEnergy_, 0., caloRecoDigi));
                			}
 			       hit.val_ = 0;
-			       for (const auto& neighbor : cal->neighbors(nid)) crystalToVisit.push(neighbor);
-			       if (extendSecond_) for (const auto& nneighbor : cal->nextNeighbors(nid)) crystalToVisit.push(nneighbor);
+			       for (const int* it=expansion.begin(nid); it!=expansion.end(nid); ++it) crystalToVisit.push(*it);
            		}
 	    
 			for (auto& hit : hitList_[seed->index_+1])
@@ -280,8 +280,7 @@ void CaloClusterFast::extractRecoDigi(const art::Handle<CaloDigiCollection>& cal
 				 recoCrystalHits.push_back(CaloCrystalHit(hit.crId_, 2, hitTime, 0, hit.val_*adcToEnergy_, 0., caloRecoDigi));
 				}
 			       hit.val_ = 0;
-			       for (const auto& neighbor : cal->neighbors(nid)) crystalToVisit.push(neighbor);
-			       if (extendSecond_) for (const auto& nneighbor : cal->nextNeighbors(nid)) crystalToVisit.push(nneighbor);
+			       for (const int* it=expansion.begin(nid); it!=expansion.end(nid); ++it) crystalToVisit.push(*it);
             		}
 
             		crystalToVisit.pop();
@@ -28,7 +28,6 @@ namespace mu2e {
         public:
 
             typedef std::vector<const CaloCrystalHit*>  CaloCrystalVec;
-            typedef std::list<const CaloCrystalHit*>    CaloCrystalList;
 
 
             explicit CaloClusterOnline(fhicl::ParameterSet const& pset) :
@@ -41,7 +40,8 @@ namespace mu2e {
             timeCut_(pset.get<double>("timeCut")),
             deltaTime_(pset.get<double>("deltaTime")),
             diagLevel_(pset.get<int>("diagLevel",0)),
-            messageCategory_("CLUSTER")
+            messageCategory_("CLUSTER"),
+            finder_(deltaTime_,ExpandCut_,true)
             {
                 produces<CaloClusterCollection>();
             }
@@ -59,11 +59,12 @@ namespace mu2e {
             double            deltaTime_;
             int               diagLevel_;
             const std::string messageCategory_;
+            ClusterFinder     finder_;
 
             void MakeOnlineClusters(CaloClusterCollection& caloClusters,
                        const art::Handle<CaloCrystalHitCollection>& CaloCrystalHitsHandle);
 
-            void FillOnlineCluster(CaloClusterCollection& caloClustersColl, const CaloCrystalList& clusterList,
+            void FillOnlineCluster(CaloClusterCollection& caloClustersColl, const CaloCrystalVec& clusterList,
                  const art::Handle<CaloCrystalHitCollection>& CaloCrystalHitsHandle, const Calorimeter& cal);
     };
 
@@ -98,36 +99,23 @@ namespace mu2e {
         const CaloCrystalHitCollection& CaloCrystalHits(*CaloCrystalHitsHandle);
         if (CaloCrystalHits.empty()) return;
 
-        std::vector<CaloCrystalList>      clusterList, caloIdHitMap(cal.nCrystal());
-        std::list<const CaloCrystalHit*>  seedList;
-        
-        for (const auto& hit : CaloCrystalHits)
-        {
-            if (hit.energyDep() <  EnoiseCut_) continue;
-            caloIdHitMap[hit.id()].push_back(&hit);
-            seedList.push_back(&hit);
-        }
+        std::vector<CaloCrystalVec>  clusterList;
 
-        seedList.sort([](const CaloCrystalHit* a, const CaloCrystalHit* b) {return a->energyDep() > b->energyDep();});
+        finder_.fill(cal, CaloCrystalHits, EnoiseCut_);
 
-        while( !seedList.empty() )
+        while( const CaloCrystalHit* crystalSeed = finder_.nextSeed() )
         {
-            const CaloCrystalHit* crystalSeed = *seedList.begin();
             if (crystalSeed->energyDep() < EminSeed_) break;
 
-            ClusterFinder finder(cal,crystalSeed,deltaTime_, ExpandCut_, true);
-            finder.formCluster(caloIdHitMap);
-	    
-	    clusterList.push_back(finder.clusterList());
-            for (const auto& hit: finder.clusterList()) seedList.remove(hit);
-
+            finder_.formCluster(crystalSeed);
+	    clusterList.push_back(finder_.clusterList());
       }
 
-        for (auto cluster : clusterList)  FillOnlineCluster(recoClusters,
+        for (const auto& cluster : clusterList)  FillOnlineCluster(recoClusters,
 						cluster,CaloCrystalHitsHandle,cal);
   }
 
-  void CaloClusterOnline::FillOnlineCluster(CaloClusterCollection& caloClustersColl, const CaloCrystalList& clusterPtrList, const art::Handle<CaloCrystalHitCollection>& CaloCrystalHitsHandle, const Calorimeter& cal)
+  void CaloClusterOnline::FillOnlineCluster(CaloClusterCollection& caloClustersColl, const CaloCrystalVec& clusterPtrList, const art::Handle<CaloCrystalHitCollection>& CaloCrystalHitsHandle, const Calorimeter& cal)
   {
 
     const CaloCrystalHitCollection& recoCrystalHits(*CaloCrystalHitsHandle);
@@ -61,7 +61,6 @@ namespace mu2e {
   public:
 
     typedef std::vector<const CaloCrystalHit*>  CaloCrystalVec;
-    typedef std::list<const CaloCrystalHit*>    CaloCrystalList;
 
 
     explicit CaloProtoClusterFromCrystalHit(fhicl::ParameterSet const& pset) :
@@ -75,7 +74,8 @@ namespace mu2e {
       timeCut_(pset.get<double>("timeCut")),
       deltaTime_(pset.get<double>("deltaTime")),
       diagLevel_(pset.get<int>("diagLevel",0)),
-      messageCategory_("CLUSTER")
+      messageCategory_("CLUSTER"),
+      finder_(deltaTime_,ExpandCut_)
     {
       produces<CaloProtoClusterCollection>(producerNameMain_);
       produces<CaloProtoClusterCollection>(producerNameSplit_);
@@ -95,20 +95,15 @@ namespace mu2e {
     double            deltaTime_;
     int               diagLevel_;
     const std::string messageCategory_;
+    ClusterFinder     finder_;
 
     void makeProtoClusters(CaloProtoClusterCollection& caloProtoClustersMain,
                            CaloProtoClusterCollection& caloProtoClustersSplit,
                            const art::Handle<CaloCrystalHitCollection>& CaloCrystalHitsHandle);
 
-    void filterByTime(CaloCrystalList& liste,
-                      const std::vector<double>& clusterTime,
-                      std::list<const CaloCrystalHit*> &seedList);
-
-    void fillCluster(CaloProtoClusterCollection& caloProtoClustersColl, const CaloCrystalList& clusterList,
+    void fillCluster(CaloProtoClusterCollection& caloProtoClustersColl, const CaloCrystalVec& clusterList,
                      const art::Handle<CaloCrystalHitCollection>& CaloCrystalHitsHandle);
 
-    void dump(const std::vector<CaloCrystalList>& caloIdHitMap);
-
   };
 
 
@@ -143,62 +138,42 @@ namespace mu2e {
     if (CaloCrystalHits.empty()) return;
 
 
-    //declare and fill the hash map crystal_id -> list of CaloHits
-    std::vector<CaloCrystalList>      mainClusterList, splitClusterList,caloIdHitMap(cal.nCrystal());
-    std::list<const CaloCrystalHit*>  seedList;
+    //fill the finder with the hits grouped by crystal id and the seeds ordered by energy
+    std::vector<CaloCrystalVec>       mainClusterList, splitClusterList;
     std::vector<double>               clusterTime;
 
-
-
-    //fill data structures
-    for (const auto& hit : CaloCrystalHits)
-      {
-        if (hit.energyDep() < EnoiseCut_ || hit.time() < timeCut_) continue;
-        caloIdHitMap[hit.id()].push_back(&hit);
-        seedList.push_back(&hit);
-      }
-
-    seedList.sort([](const CaloCrystalHit* a, const CaloCrystalHit* b) {return a->energyDep() > b->energyDep();});
+    finder_.fill(cal, CaloCrystalHits, EnoiseCut_, timeCut_);
 
 
     //produce main clusters
-    while( !seedList.empty() )
+    while( const CaloCrystalHit* crystalSeed = finder_.nextSeed() )
       {
-        const CaloCrystalHit* crystalSeed = *seedList.begin();
         if (crystalSeed->energyDep() < EminSeed_) break;
 
-        ClusterFinder finder(cal,crystalSeed,deltaTime_, ExpandCut_);
-        finder.formCluster(caloIdHitMap);
+        finder_.formCluster(crystalSeed);
 
-        mainClusterList.push_back(finder.clusterList());
+        mainClusterList.push_back(finder_.clusterList());
         clusterTime.push_back(crystalSeed->time());
-
-        for (const auto& hit: finder.clusterList()) seedList.remove(hit);
       }
 
 
     //filter unneeded hits
-    for (unsigned i=0; i < caloIdHitMap.size(); ++i ) filterByTime(caloIdHitMap[i], clusterTime, seedList);
+    finder_.filterByTime(clusterTime);
 
 
     //produce split-offs clusters
-    while(!seedList.empty())
+    while( const CaloCrystalHit* crystalSeed = finder_.nextSeed() )
       {
-        const CaloCrystalHit* crystalSeed = *seedList.begin();
-        ClusterFinder finder(cal,crystalSeed,deltaTime_, ExpandCut_);
-
-        finder.formCluster(caloIdHitMap);
-        splitClusterList.push_back(finder.clusterList());
-
-        for (const auto& hit: finder.clusterList()) seedList.remove(hit);
+        finder_.formCluster(crystalSeed);
+        splitClusterList.push_back(finder_.clusterList());
       }
 
 
 
 
     //save the main and split clusters
-    for (auto cluster : mainClusterList)  fillCluster(caloProtoClustersMain,cluster,CaloCrystalHitsHandle);
-    for (auto cluster : splitClusterList) fillCluster(caloProtoClustersSplit,cluster,CaloCrystalHitsHandle);
+    for (const auto& cluster : mainClusterList)  fillCluster(caloProtoClustersMain,cluster,CaloCrystalHitsHandle);
+    for (const auto& cluster : splitClusterList) fillCluster(caloProtoClustersSplit,cluster,CaloCrystalHitsHandle);
 
 
 
@@ -213,7 +188,7 @@ namespace mu2e {
 
 
   //----------------------------------------------------------------------------------------------------------
-  void CaloProtoClusterFromCrystalHit::fillCluster(CaloProtoClusterCollection& caloProtoClustersColl, const CaloCrystalList& clusterPtrList,
+  void CaloProtoClusterFromCrystalHit::fillCluster(CaloProtoClusterCollection& caloProtoClustersColl, const CaloCrystalVec& clusterPtrList,
                                                    const art::Handle<CaloCrystalHitCollection>& CaloCrystalHitsHandle)
   {
 
@@ -258,37 +233,6 @@ namespace mu2e {
 
 
 
-  //----------------------------------------------------------------------------------------------------------
-  void CaloProtoClusterFromCrystalHit::filterByTime(CaloCrystalList& liste, const std::vector<double>& clusterTime, std::list<const CaloCrystalHit*> &seedList)
-  {
-    for (auto it = liste.begin(); it != liste.end(); ++it)
-      {
-        const CaloCrystalHit* hit = *it;
-
-        auto itTime = clusterTime.begin();
-        while (itTime != clusterTime.end())
-          {
-            if ( (*itTime - hit->time()) < deltaTime_) break;
-            ++itTime;
-          }
-
-        if (itTime == clusterTime.end() ) {seedList.remove(hit); liste.erase(it); if (it != liste.begin()) --it;}
-      }
-  }
-
-
-
-  //----------------------------------------------------------------------------------------------------------
-  void CaloProtoClusterFromCrystalHit::dump(const std::vector<CaloCrystalList>& caloIdHitMap)
-  {
-    for (unsigned int i=0; i<caloIdHitMap.size(); ++i)
-      {
-        if (caloIdHitMap[i].size()>0) std::cout<<"ProtoCluster crystal "<<i<<" has size "<<caloIdHitMap[i].size()<<std::endl;
-        for (auto j :  caloIdHitMap[i]) std::cout<<i<<" "<<j->id()<<" "<<j->energyDep()<<" "<<j->time()<<std::endl;
-      }
-  }
-
-
 }
 
 DEFINE_ART_MODULE(mu2e::CaloProtoClusterFromCrystalHit);
@@ -1,15 +1,18 @@
 //
 // Class to find cluster of simply connected crystals
-// 
+//
 // Original author B. Echenard
 //
-// Note: there are few places where a continue could be replaced by a break if the crystal are time ordered, but 
+// Note: there are few places where a continue could be replaced by a break if the crystal are time ordered, but
 //       the performance gain is so low that it outweighs the risk of forgeting to time order the crystal hits.
-//       
+//
+//       The hits of an event are copied once in a flat array grouped by crystal, and a hit is removed by flagging it.
+//       The neighbors come from the flat tables of the calorimeter, so no list is copied or erased during clustering.
+//       The clusters and the seed order are the same as with the per-crystal lists used before.
+//
 
 #include "CaloCluster/inc/ClusterFinder.hh"
 #include "CalorimeterGeom/inc/Calorimeter.hh"
-#include "GeometryService/inc/GeomHandle.hh"
 #include "RecoDataProducts/inc/CaloCrystalHitCollection.hh"
 
 #include <iostream>
@@ -20,76 +23,127 @@
 namespace mu2e {
 
 
-	ClusterFinder::ClusterFinder(Calorimeter const& cal, CaloCrystalHit const* crystalSeed, double deltaTime, double ExpandCut) : 
-	  cal_(&cal), crystalSeed_(crystalSeed),seedTime_(crystalSeed->time()), clusterList_(), crystalToVisit_(), isVisited_(cal.nCrystal()),
-	  deltaTime_(deltaTime), ExpandCut_(ExpandCut)
+	ClusterFinder::ClusterFinder(double deltaTime, double ExpandCut, bool isOnline) :
+	  deltaTime_(deltaTime), ExpandCut_(ExpandCut), isOnline_(isOnline), neighbors_(nullptr), hitBase_(nullptr),
+	  crystalOffset_(), crystalFill_(), hits_(), isUsed_(), slotOfHit_(), seeds_(), seedCursor_(0),
+	  visitStamp_(), epoch_(0), crystalToVisit_(), clusterList_()
 	{}
-       
-       
-	ClusterFinder::ClusterFinder(Calorimeter const& cal, CaloCrystalHit const* crystalSeed, double deltaTime, double ExpandCut, bool isOnline) : 
-	  cal_(&cal), crystalSeed_(crystalSeed),seedTime_(crystalSeed->time()), clusterList_(), crystalToVisit_(), isVisited_(cal.nCrystal()),
-	  deltaTime_(deltaTime), ExpandCut_(ExpandCut), isOnline_(isOnline)
-	{}
-       
-
-	void ClusterFinder::formCluster(std::vector<CaloCrystalList>& idHitVec)  
-	{ 
 
-		clusterList_.clear();            
-		clusterList_.push_front(crystalSeed_);
-		crystalToVisit_.push(crystalSeed_->id());  
-		  
-		CaloCrystalList& liste = idHitVec[crystalSeed_->id()];
-		liste.erase(std::find(liste.begin(), liste.end(), crystalSeed_));
 
-
-		while (!crystalToVisit_.empty())
-		{            
-			int visitId         = crystalToVisit_.front();
-			isVisited_[visitId] = 1;
-
-			std::vector<int>  neighborsId = cal_->crystal(visitId).neighbors();
-			if(isOnline_){
-				for (const auto& nneighbor : cal_->nextNeighbors(visitId)) neighborsId.push_back(nneighbor);
-			}
-			for (auto& iId : neighborsId)
-		 	{               
-		    
-				if (isVisited_[iId]) continue;
-				isVisited_[iId]=1;
-				CaloCrystalList& list = idHitVec[iId];
-				auto it=list.begin();
-				while(it != list.end())
+	//--------------------------------------------------------------------------------------------------------------
+	void ClusterFinder::fill(Calorimeter const& cal, CaloCrystalHitCollection const& hits, double EnoiseCut, double timeCut)
+	{
+		neighbors_ = &cal.neighborTable(isOnline_);
+		hitBase_   = hits.empty() ? nullptr : &hits.front();
+
+		unsigned nCrystal = cal.nCrystal();
+		if (visitStamp_.size() != nCrystal) {visitStamp_.assign(nCrystal,0); epoch_=0;}
+
+		crystalOffset_.assign(nCrystal+1,0);
+		for (const auto& hit : hits)
+		{
+			if (hit.energyDep() < EnoiseCut || hit.time() < timeCut) continue;
+			++crystalOffset_[hit.id()+1];
+		}
+		for (unsigned i=0;i<nCrystal;++i) crystalOffset_[i+1] += crystalOffset_[i];
+
+		crystalFill_.assign(crystalOffset_.begin(),crystalOffset_.end()-1);
+		hits_.resize(crystalOffset_.back());
+		isUsed_.assign(crystalOffset_.back(),0);
+		slotOfHit_.assign(hits.size(),-1);
+		seeds_.clear();
+		seedCursor_ = 0;
+
+		// hits keep the collection order inside a crystal, as do the seeds before sorting
+		for (unsigned ihit=0;ihit<hits.size();++ihit)
+		{
+			const CaloCrystalHit& hit = hits[ihit];
+			if (hit.energyDep() < EnoiseCut || hit.time() < timeCut) continue;
+			unsigned slot    = crystalFill_[hit.id()]++;
+			hits_[slot]      = &hit;
+			slotOfHit_[ihit] = slot;
+			seeds_.push_back(slot);
+		}
+
+		std::stable_sort(seeds_.begin(),seeds_.end(),[this](unsigned a, unsigned b) {return hits_[a]->energyDep() > hits_[b]->energyDep();});
+	}
+
+
+	//--------------------------------------------------------------------------------------------------------------
+	CaloCrystalHit const* ClusterFinder::nextSeed()
+	{
+		while (seedCursor_ < seeds_.size() && isUsed_[seeds_[seedCursor_]]) ++seedCursor_;
+		return seedCursor_ < seeds_.size() ? hits_[seeds_[seedCursor_]] : nullptr;
+	}
+
+
+	//--------------------------------------------------------------------------------------------------------------
+	void ClusterFinder::formCluster(CaloCrystalHit const* crystalSeed)
+	{
+		if (++epoch_ == 0) {std::fill(visitStamp_.begin(),visitStamp_.end(),0); epoch_=1;}
+
+		double seedTime = crystalSeed->time();
+
+		clusterList_.clear();
+		clusterList_.push_back(crystalSeed);
+		isUsed_[slotOfHit_[crystalSeed - hitBase_]] = 1;
+
+		crystalToVisit_.clear();
+		crystalToVisit_.push_back(crystalSeed->id());
+		visitStamp_[crystalSeed->id()] = epoch_;
+
+		// a crystal is queued at most once, queuing it again would not add any hit since its neighbors are already visited
+		for (unsigned ivisit=0; ivisit<crystalToVisit_.size(); ++ivisit)
+		{
+			int visitId = crystalToVisit_[ivisit];
+
+			for (const int* it=neighbors_->begin(visitId); it!=neighbors_->end(visitId); ++it)
+		 	{
+				int iId = *it;
+				if (visitStamp_[iId] == epoch_) continue;
+				visitStamp_[iId] = epoch_;
+
+				bool expand(false);
+				for (unsigned slot=crystalOffset_[iId]; slot<crystalOffset_[iId+1]; ++slot)
 				{
-					CaloCrystalHit const* hit = *it;
-				 	if (std::abs(hit->time() - seedTime_) < deltaTime_)
-				 	{ 
-				   
-				    		if (hit->energyDep() > ExpandCut_) crystalToVisit_.push(iId);
-				   
-				    		clusterList_.push_front(hit);
-				    		it = list.erase(it);   
-				 	} 
-				 	else {++it;}
-				} 
-                     
+					if (isUsed_[slot]) continue;
+					CaloCrystalHit const* hit = hits_[slot];
+				 	if (std::abs(hit->time() - seedTime) < deltaTime_)
+				 	{
+				    		if (hit->energyDep() > ExpandCut_) expand = true;
+				    		clusterList_.push_back(hit);
+				    		isUsed_[slot] = 1;
+				 	}
+				}
+				if (expand) crystalToVisit_.push_back(iId);
                  	}
-                                       
-                 	crystalToVisit_.pop();                 
             	}
-            
-		// sort proto-clustres, even if they are sorted in the cluster module, in case somebody 
-		// uses the proto-clusters instead of clusters he will get the same behaviour
-		clusterList_.sort([] (CaloCrystalHit const* lhs, CaloCrystalHit const* rhs) {return lhs->energyDep() > rhs->energyDep();} );
-                        
-       } 
-
-}
-
-
-
-
-
-
 
+		// sort proto-clustres, even if they are sorted in the cluster module, in case somebody
+		// uses the proto-clusters instead of clusters he will get the same behaviour.
+		// Hits used to be added at the front of the list, hence the reverse before the stable sort
+		std::reverse(clusterList_.begin(),clusterList_.end());
+		std::stable_sort(clusterList_.begin(),clusterList_.end(),[] (CaloCrystalHit const* lhs, CaloCrystalHit const* rhs) {return lhs->energyDep() > rhs->energyDep();} );
+       }
+
+
+	//--------------------------------------------------------------------------------------------------------------
+	// remove the hits that can not belong to any of the clusters (based on the cluster times)
+	void ClusterFinder::filterByTime(std::vector<double> const& clusterTime)
+	{
+		for (unsigned slot=0; slot<hits_.size(); ++slot)
+		{
+			if (isUsed_[slot]) continue;
+			double time = hits_[slot]->time();
+
+			auto itTime = clusterTime.begin();
+			while (itTime != clusterTime.end())
+			{
+				if ( (*itTime - time) < deltaTime_) break;
+				++itTime;
+			}
+			if (itTime == clusterTime.end()) isUsed_[slot] = 1;
+		}
+	}
 
+}
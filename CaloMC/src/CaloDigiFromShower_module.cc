@@ -6,6 +6,11 @@
 //
 // The output is split between the different digitization boards
 //
+// With sparseWaveforms set, only the readouts which receive energy are simulated in full. For the other readouts,
+// the samples where pure noise crosses thresholdVoltage are drawn directly (a Bernoulli process with the probability
+// of a Gaussian tail), and noise is then generated only around these samples, conditioned to be above or below
+// the threshold. This has the same statistics as filling every readout with noise, at a fraction of the cost.
+//
 
 #include "art/Framework/Core/EDProducer.h"
 #include "art/Framework/Core/ModuleMacros.h"
@@ -25,10 +30,12 @@
 
 #include "CLHEP/Vector/ThreeVector.h"
 #include "CLHEP/Random/RandGaussQ.h"
+#include "CLHEP/Random/RandFlat.h"
 
 #include "TH2F.h"
 #include "TFile.h"
 
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <cmath>
@@ -62,8 +69,10 @@ namespace mu2e {
       bufferDigi_            (pset.get<int>        ("bufferDigi")),  //# timestamps
       pulseIntegralSteps_    (pset.get<int>        ("pulseIntegralSteps")),         //# integral steps
       diagLevel_             (pset.get<int>        ("diagLevel",0)),
+      sparseWaveforms_       (pset.get<bool>       ("sparseWaveforms",false)), //simulate noise-only readouts around threshold crossings only
       engine_                (createEngine( art::ServiceHandle<SeedService>()->getSeed() ) ),
       randGauss_             (engine_),
+      randFlat_              (engine_),
       pulseShape_(CaloPulseShape(digiSampling_,pulseIntegralSteps_))
     {
       produces<CaloDigiCollection>();
@@ -73,6 +82,9 @@ namespace mu2e {
       mVToADC_      = float(maxADCCounts_)/dynamicRange_;
       nROperCard_   = 40;
       nBinsPeak_    = pset.get<size_t>("nBinsPeak");
+
+      //probability that a pure noise sample is at or above the digitization threshold
+      noiseCrossProb_ = (addNoise_ && noise_ > 0) ? 0.5*std::erfc(thresholdVoltage_/(noise_*std::sqrt(2.0))) : 0.0;
     }
 
   private:
@@ -99,8 +111,10 @@ namespace mu2e {
     int                     pulseIntegralSteps_;
 
     int                     diagLevel_;
+    bool                    sparseWaveforms_;
     CLHEP::HepRandomEngine& engine_;
     CLHEP::RandGaussQ       randGauss_;
+    CLHEP::RandFlat         randFlat_;
     CaloPulseShape          pulseShape_;
 
     int                     maxADCCounts_;
@@ -113,13 +127,28 @@ namespace mu2e {
     std::vector< std::vector<double> > pulseDigitized_;
     std::vector< std::vector<double> > waveforms_;
 
+    //sparse mode: the simulated readouts share one buffer, reused from event to event
+    double                  noiseCrossProb_;
+    unsigned int            waveformSize_;
+    std::vector<double>     waveArena_;        //waveforms of activeROs_, back to back
+    std::vector<int>        waveOffset_;       //offset of each readout in waveArena_, -1 if not simulated
+    std::vector<int>        activeROs_;        //simulated readouts, in increasing order
+    std::vector<char>       hasEnergy_;        //readout receives energy in this event
+    std::vector<std::pair<int,int> > noiseCrossings_; //(readout, sample) of pure noise above threshold
+
 
     void   resetWaveforms();
+    void   resetSparseWaveforms(const CaloShowerStepROCollection& caloShowerStepROs);
+    void   fillNoiseAroundCrossings(double* waveform, std::vector<std::pair<int,int> >::const_iterator first,
+                                    std::vector<std::pair<int,int> >::const_iterator last);
+    double noiseBelowThreshold();
+    double noiseAboveThreshold();
     void   makeDigitization(const CaloShowerStepROCollection& caloShowerStepROs, CaloDigiCollection&);
     void   fillWaveforms(const CaloShowerStepROCollection& caloShowerStepROs);
     void   readoutResponse(int ROID, double energyCorr, double time);
     void   buildOutputDigi(CaloDigiCollection& caloDigiColl);
-    void   diag0(int iRO,std::vector<double>& itWave );
+    void   digitizeWaveform(int iRO, const double* itWave, int waveSize, CaloDigiCollection& caloDigiColl);
+    void   diag0(int iRO, const double* itWave, int waveSize);
     void   diag1(int iRO, double time, std::vector<int>& wf );
   };
 
@@ -157,7 +186,8 @@ namespace mu2e {
     mu2e::GeomHandle<mu2e::Calorimeter> ch;
     calorimeter_ = ch.get();
 
-    resetWaveforms();
+    if (sparseWaveforms_) resetSparseWaveforms(caloShowerStepROs);
+    else                  resetWaveforms();
     fillWaveforms(caloShowerStepROs);
     buildOutputDigi(caloDigiColl);
   }
@@ -189,6 +219,120 @@ namespace mu2e {
   }
 
 
+  //-------------------------------------------------
+  void CaloDigiFromShower::resetSparseWaveforms(const CaloShowerStepROCollection& caloShowerStepROs)
+  {
+    unsigned int nWaveforms = calorimeter_->nCrystal()*calorimeter_->caloInfo().nROPerCrystal();
+    waveformSize_           = (mbtime_ - blindTime_ + endTimeBuffer_) / digiSampling_;
+
+    waveOffset_.assign(nWaveforms,-1);
+    hasEnergy_.assign(nWaveforms,0);
+    activeROs_.clear();
+    noiseCrossings_.clear();
+
+    for (const auto& caloShowerStepRO : caloShowerStepROs)
+      {
+        int ROID = caloShowerStepRO.ROID();
+        if (hasEnergy_.at(ROID)) continue;
+        hasEnergy_[ROID] = 1;
+        activeROs_.push_back(ROID);
+      }
+
+    //positions of the noise samples above threshold in the readouts without energy: the gap between two
+    //such samples in the concatenated waveforms is geometrically distributed
+    if (noiseCrossProb_ > 0)
+      {
+        double totalSamples = double(nWaveforms)*waveformSize_;
+        double logNoCross   = std::log1p(-std::min(noiseCrossProb_,0.999999));
+        double position(-1);
+        while (true)
+          {
+            position += 1.0 + std::floor(std::log(randFlat_.fire())/logNoCross);
+            if (position >= totalSamples) break;
+            int ROID   = int(position/waveformSize_);
+            int sample = int(position - double(ROID)*waveformSize_);
+            if (hasEnergy_[ROID]) continue;
+            if (noiseCrossings_.empty() || noiseCrossings_.back().first != ROID) activeROs_.push_back(ROID);
+            noiseCrossings_.emplace_back(ROID,sample);
+          }
+      }
+
+    std::sort(activeROs_.begin(),activeROs_.end());
+    waveArena_.resize(activeROs_.size()*waveformSize_);
+    for (unsigned int i=0; i<activeROs_.size(); ++i) waveOffset_[activeROs_[i]] = i*waveformSize_;
+
+    //readouts with energy get noise in every sample, as in the dense mode
+    for (int ROID : activeROs_)
+      {
+        if (!hasEnergy_[ROID]) continue;
+        double* waveform = &waveArena_[waveOffset_[ROID]];
+        if (addNoise_) std::generate(waveform,waveform+waveformSize_,[&] {return  std::max(0.0,randGauss_.fire(0.0,noise_)*mVToADC_);});
+        else           std::fill(waveform,waveform+waveformSize_,0);
+      }
+
+    //noise-only readouts
+    auto first = noiseCrossings_.cbegin();
+    while (first != noiseCrossings_.cend())
+      {
+        auto last = first;
+        while (last != noiseCrossings_.cend() && last->first == first->first) ++last;
+        fillNoiseAroundCrossings(&waveArena_[waveOffset_[first->first]],first,last);
+        first = last;
+      }
+  }
+
+
+  //-------------------------------------------------
+  // The digitization only reads samples within bufferDigi_+1 of a sample above threshold (see digitizeWaveform),
+  // so noise is drawn only there, below the threshold except at the crossings. The other samples are left at zero.
+  void CaloDigiFromShower::fillNoiseAroundCrossings(double* waveform, std::vector<std::pair<int,int> >::const_iterator first,
+                                                    std::vector<std::pair<int,int> >::const_iterator last)
+  {
+    int waveSize = waveformSize_;
+    std::fill(waveform,waveform+waveSize,0);
+
+    int filled(-1);
+    for (auto it = first; it != last; ++it)
+      {
+        int start = std::max(it->second - bufferDigi_ - 1, filled+1);
+        int stop  = std::min(it->second + 2*bufferDigi_ + 2, waveSize-1);
+        for (int i=start; i<=stop; ++i) waveform[i] = std::max(0.0,noiseBelowThreshold()*mVToADC_);
+        filled = std::max(filled,stop);
+      }
+    for (auto it = first; it != last; ++it) waveform[it->second] = std::max(0.0,noiseAboveThreshold()*mVToADC_);
+  }
+
+
+  //-------------------------------------------------
+  double CaloDigiFromShower::noiseBelowThreshold()
+  {
+    double value;
+    do {value = randGauss_.fire(0.0,noise_);} while (value >= thresholdVoltage_);
+    return value;
+  }
+
+
+  //-------------------------------------------------
+  // Gaussian tail above the threshold, with the exponential proposal of C.P. Robert, Stat. Comput. 5 (1995) 121
+  double CaloDigiFromShower::noiseAboveThreshold()
+  {
+    double zmin = thresholdVoltage_/noise_;
+    if (zmin < 0)
+      {
+        double value;
+        do {value = randGauss_.fire(0.0,1.0);} while (value < zmin);
+        return value*noise_;
+      }
+
+    double alpha = 0.5*(zmin + std::sqrt(zmin*zmin + 4.0));
+    while (true)
+      {
+        double z = zmin - std::log(randFlat_.fire())/alpha;
+        if (randFlat_.fire() <= std::exp(-0.5*(z-alpha)*(z-alpha))) return z*noise_;
+      }
+  }
+
+
   //----------------------------------------------------------------------------------------------------------
   void CaloDigiFromShower::fillWaveforms(const CaloShowerStepROCollection& caloShowerStepROs)
   {
@@ -212,9 +356,12 @@ namespace mu2e {
     double                     timeCorr       = time - blindTime_;
     int                        startSample    = timeCorr/digiSampling_;
     int                        precisionIndex = (timeCorr/digiSampling_ - int(timeCorr/digiSampling_))*pulseIntegralSteps_;
-    std::vector<double>&       waveform       = waveforms_.at(ROID);
+    double*                    waveform       = sparseWaveforms_ ? &waveArena_[waveOffset_.at(ROID)] : waveforms_.at(ROID).data();
+    size_t                     waveSize       = sparseWaveforms_ ? waveformSize_ : waveforms_[ROID].size();
     const std::vector<double>& pulse          = pulseShape_.pulseDigitized(precisionIndex);
-    int                        stopSample     = std::min(startSample+pulse.size(), waveform.size());
+    int                        stopSample     = std::min(startSample+pulse.size(), waveSize);
+
+    if (startSample < 0) throw cet::exception("CATEGORY")<<"CaloDigiFromShower:: energy deposited before the blind time, readout "<<ROID<<"\n";
 
     for (int timeSample = startSample; timeSample < stopSample; ++timeSample)
       {
@@ -223,8 +370,8 @@ namespace mu2e {
         double  wfAmp     = pulseAmp*funcValue;
         double  ADCCounts = wfAmp*mVToADC_;
 
-        waveform.at(timeSample) += ADCCounts;
-        if ( waveform.at(timeSample) > maxADCCounts_) waveform.at(timeSample) = maxADCCounts_;
+        waveform[timeSample] += ADCCounts;
+        if ( waveform[timeSample] > maxADCCounts_) waveform[timeSample] = maxADCCounts_;
       }
 
   }
@@ -233,86 +380,84 @@ namespace mu2e {
   //----------------------------------------------------------------------------
   void CaloDigiFromShower::buildOutputDigi(CaloDigiCollection& caloDigiColl)
   {
+    if (sparseWaveforms_)
+      for (int iRO : activeROs_) digitizeWaveform(iRO,&waveArena_[waveOffset_[iRO]],waveformSize_,caloDigiColl);
+    else
+      for (unsigned int iRO=0; iRO<waveforms_.size(); ++iRO) digitizeWaveform(iRO,waveforms_[iRO].data(),waveforms_[iRO].size(),caloDigiColl);
+  }
+
+
+  //----------------------------------------------------------------------------
+  void CaloDigiFromShower::digitizeWaveform(int iRO, const double* itWave, int waveSize, CaloDigiCollection& caloDigiColl)
+  {
+    if (diagLevel_ > 5) std::cout<<"wfContent content (timesample: waveContent, funcValue)"<<std::endl;
+    if (diagLevel_ > 4) diag0(iRO,itWave,waveSize);
 
-    for (unsigned int iRO=0; iRO<waveforms_.size(); ++iRO)
+    int timeSample(0);
+    while (timeSample < waveSize)
       {
+        double waveContent = itWave[timeSample];
+        double funcValue   = waveContent*ADCTomV_;
 
-        if (diagLevel_ > 5) std::cout<<"wfContent content (timesample: waveContent, funcValue)"<<std::endl;
-        if (diagLevel_ > 4) diag0(iRO,waveforms_.at(iRO));
+        if (diagLevel_ > 5 && waveContent > 0) printf("wfContent (%4i:  %4i, %9.3f) \n", timeSample, int(waveContent), funcValue);
+        if (funcValue < thresholdVoltage_) {++timeSample; continue;}
 
 
-        std::vector<double>& itWave = waveforms_.at(iRO);
+        // find the starting / stopping point of the peak
+        // the stopping point is the first value below the threshold _and_ the buffer is also below the threshold
 
-        int waveSize = itWave.size();
-        int timeSample(0);
-        while (timeSample < waveSize)
+        int sampleStart = std::max(timeSample - bufferDigi_,0);
+        int sampleStop  = timeSample;
+        for (; sampleStop < waveSize; ++sampleStop)
           {
-            double waveContent = itWave.at(timeSample);
-            double funcValue   = waveContent*ADCTomV_;
+            int sampleCheck = std::min(sampleStop+bufferDigi_+1,waveSize-1);
+            double waveOverBuffer = *std::max_element(itWave+sampleStop,itWave+sampleCheck);
+            if (waveOverBuffer*ADCTomV_ < thresholdVoltage_) break;
+          }
+        sampleStop = std::min(sampleStop + bufferDigi_, waveSize-1);
 
-            if (diagLevel_ > 5 && waveContent > 0) printf("wfContent (%4i:  %4i, %9.3f) \n", timeSample, int(waveContent), funcValue);
-            if (funcValue < thresholdVoltage_) {++timeSample; continue;}
+        timeSample = sampleStop+1;  //forward the scanning time
 
 
-            // find the starting / stopping point of the peak
-            // the stopping point is the first value below the threshold _and_ the buffer is also below the threshold
+        if (sampleStop == sampleStart) continue;  //check if peak is acceptable and digitize
 
-            int sampleStart = std::max(timeSample - bufferDigi_,0);
-            int sampleStop  = timeSample;
-            for (; sampleStop < waveSize; ++sampleStop)
+
+        float wfInt(0);
+        size_t peakP(0);
+        for (size_t i =sampleStart; i<sampleStop-nBinsPeak_;++i)
+          {
+            float sum(0);
+            for (size_t j=0; j< nBinsPeak_;++j) sum+=itWave[i+j];
+            if (sum>wfInt)
               {
-                int sampleCheck = std::min(sampleStop+bufferDigi_+1,waveSize-1);
-                double waveOverBuffer = *std::max_element(&itWave.at(sampleStop),&itWave.at(sampleCheck));
-                if (waveOverBuffer*ADCTomV_ < thresholdVoltage_) break;
+                wfInt = sum;
+                peakP = i+nBinsPeak_/2;
               }
-            sampleStop = std::min(sampleStop + bufferDigi_, waveSize-1);
-
-            timeSample = sampleStop+1;  //forward the scanning time
-
-
-            if (sampleStop == sampleStart) continue;  //check if peak is acceptable and digitize
-
-		
-		float wfInt(0);
-		size_t peakP(0);
-		for(size_t i =sampleStart; i<sampleStop-nBinsPeak_;++i){
-
-			float sum(0);
-			for(size_t j=0; j< nBinsPeak_;++j){
-				sum+=itWave.at(i+j);
-			}
-			if(sum>wfInt){
-				wfInt = sum;
-				peakP = i+nBinsPeak_/2;
-			}
-
+          }
 
-		}
-			
-		double sampleMax = itWave.at(peakP);
-		peakP = peakP - sampleStart;
-            	if (sampleMax*ADCTomV_ < thresholdAmplitude_) continue;
+        double sampleMax = itWave[peakP];
+        peakP = peakP - sampleStart;
+        if (sampleMax*ADCTomV_ < thresholdAmplitude_) continue;
 
 
-            int t0 = int(sampleStart*digiSampling_+ blindTime_);
-            std::vector<int> wf;
-            for (int i=sampleStart; i<=sampleStop; ++i) wf.push_back(int(itWave.at(i)));
+        int t0 = int(sampleStart*digiSampling_+ blindTime_);
+        std::vector<int> wf;
+        for (int i=sampleStart; i<=sampleStop; ++i) wf.push_back(int(itWave[i]));
 
-            caloDigiColl.emplace_back( CaloDigi(iRO,t0,wf, peakP) );
+        caloDigiColl.emplace_back( CaloDigi(iRO,t0,wf, peakP) );
 
-            if (diagLevel_ > 4) diag1(iRO,t0,wf);
-          }
+        if (diagLevel_ > 4) diag1(iRO,t0,wf);
       }
   }
 
 
 
 
-  void CaloDigiFromShower::diag0(int iRO,std::vector<double>& itWave )
+  void CaloDigiFromShower::diag0(int iRO, const double* itWave, int waveSize)
   {
-    if (*std::max_element(itWave.begin(),itWave.end())<1) return;
+    if (*std::max_element(itWave,itWave+waveSize)<1) return;
     std::cout<<"CaloDigiFromShower::fillOutoutRO] Waveform content for readout "<<iRO<<std::endl;
-    for (const auto  &v : itWave) std::cout<<v<<" ";
+    for (int i=0; i<waveSize; ++i) std::cout<<itWave[i]<<" ";
     std::cout<<std::endl;
   }
 
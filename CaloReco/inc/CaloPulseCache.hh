@@ -17,7 +17,8 @@ namespace mu2e {
           ~CaloPulseCache() {};
 
 	  void   initialize();
-          double evaluate(double x);
+          double evaluate(double x) const;
+          double slope(double x)    const;
 
           const std::vector<double>&   cache()      {return cache_;}
           double                       cache(int i) {return cache_.at(i);}
@@ -0,0 +1,91 @@
+#ifndef TemplateFitProcessor_HH
+#define TemplateFitProcessor_HH
+
+
+#include "CaloReco/inc/WaveformProcessor.hh"
+#include "CaloReco/inc/CaloPulseCache.hh"
+#include "fhiclcpp/ParameterSet.h"
+#include <vector>
+#include "TH1.h"
+
+
+namespace mu2e {
+
+
+  class TemplateFitProcessor : public WaveformProcessor {
+
+
+     public:
+
+                    TemplateFitProcessor(fhicl::ParameterSet const& param);
+        virtual    ~TemplateFitProcessor() {};
+
+
+        virtual void   initialize();
+        virtual void   reset();
+        virtual void   extract(std::vector<double> &xInput, std::vector<double> &yInput);
+
+        virtual int    nPeaks()                     const {return nPeaks_;}
+        virtual double chi2()                       const {return chi2_;}
+        virtual int    ndf()                        const {return ndf_;}
+        virtual double amplitude(unsigned int i)    const {return resAmp_.at(i);}
+        virtual double amplitudeErr(unsigned int i) const {return resAmpErr_.at(i);}
+        virtual double time(unsigned int i)         const {return resTime_.at(i);}
+        virtual double timeErr(unsigned int i)      const {return resTimeErr_.at(i);}
+        virtual bool   isPileUp(unsigned int i)     const {return nPeaks_ > 1;}
+
+
+        virtual void   plot(std::string pname);
+
+
+
+    private:
+
+       static constexpr int maxPeaks_ = 4;
+       static constexpr int maxPar_   = 2*maxPeaks_;
+
+       int                 windowPeak_ ;
+       double              minPeakAmplitude_;
+       double              psdThreshold_;
+       unsigned int        pulseLowBuffer_;
+       unsigned int        pulseHighBuffer_;
+       unsigned int        minDiffTime_;
+       double              shiftTime_;
+       int                 maxIterations_;
+       double              edmTolerance_;
+       int                 diagLevel_;
+
+       CaloPulseCache      pulseCache_;
+       int                 nPeaks_;
+       double              chi2_;
+       int                 ndf_;
+       std::vector<unsigned int> xindices_;
+       std::vector<double> xvec_;
+       std::vector<double> yvec_;
+       std::vector<double> res_;
+       std::vector<double> resAmp_;
+       std::vector<double> resAmpErr_;
+       std::vector<double> resTime_;
+       std::vector<double> resTimeErr_;
+
+
+       TH1F* _hTime;
+       TH1F* _hTimeErr;
+       TH1F* _hEner;
+       TH1F* _hEnerErr;
+       TH1F* _hChi2;
+       TH1F* _hNpeak;
+       TH1F* _hNiter;
+
+
+       int    findPeak(double* parInit);
+       void   buildXRange(const std::vector<unsigned int>& peakLoc);
+       int    doFit(double* par, double* errpar, int nPar, double& chi2);
+       double model(double x, const double* par, int nPar) const;
+       double calcChi2(const double* par, int nPar) const;
+       double meanParabol(unsigned int i1, unsigned int i2, unsigned int i3) const;
+
+  };
+
+}
+#endif
@@ -67,13 +67,21 @@ namespace mu2e {
 
    }
    
-   double CaloPulseCache::evaluate(double x)
+   double CaloPulseCache::evaluate(double x) const
    {
        int idx = int( (x+deltaT_)/step_ );
        if (idx < 0 || idx > cacheSize_-2) return 0;     
        return (cache_[idx+1]-cache_[idx])/step_*(x+deltaT_ - idx*step_) + cache_[idx];        
    }
 
+   //derivative of evaluate with respect to x
+   double CaloPulseCache::slope(double x) const
+   {
+       int idx = int( (x+deltaT_)/step_ );
+       if (idx < 0 || idx > cacheSize_-2) return 0;     
+       return (cache_[idx+1]-cache_[idx])/step_;        
+   }
+
    
    
 
@@ -7,6 +7,7 @@
 #include "CaloReco/inc/WaveformProcessor.hh"
 #include "CaloReco/inc/LogNormalProcessor.hh"
 #include "CaloReco/inc/FixedFastProcessor.hh"
+#include "CaloReco/inc/TemplateFitProcessor.hh"
 #include "CaloReco/inc/RawProcessor.hh"
 
 #include "ConditionsService/inc/ConditionsHandle.hh"
@@ -28,7 +29,7 @@ namespace mu2e {
 
   public:
 
-    enum processorStrategy {NoChoice, RawExtract, LogNormalFit, FixedFast};
+    enum processorStrategy {NoChoice, RawExtract, LogNormalFit, FixedFast, TemplateFit};
 
     explicit CaloRecoDigiFromDigi(fhicl::ParameterSet const& pset) :
       art::EDProducer{pset},
@@ -45,6 +46,7 @@ namespace mu2e {
       spmap["RawExtract"]   = RawExtract;
       spmap["LogNormalFit"] = LogNormalFit;
       spmap["FixedFast"]    = FixedFast;
+      spmap["TemplateFit"]  = TemplateFit;
 
       switch (spmap[processorStrategy_])
         {
@@ -69,6 +71,13 @@ namespace mu2e {
             break;
           }
 
+        case TemplateFit:
+          {
+            auto const& param = pset.get<fhicl::ParameterSet>("TemplateFitProcessor", {});
+            waveformProcessor_ = std::make_unique<TemplateFitProcessor>(param);
+            break;
+          }
+
         default:
           {
             throw cet::exception("CATEGORY")<< "Unrecognized processor in CaloHitsFromDigis module";
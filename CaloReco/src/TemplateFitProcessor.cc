@@ -0,0 +1,451 @@
+// Signal extraction by a fit of the pre-calculated pulse shape (CaloPulseCache) to the waveform
+//
+// The peak finding and the selection of the fitted samples are the same as in FixedFastProcessor. The amplitudes
+// and times of all peaks are then fitted together with Levenberg-Marquardt steps on the linearized problem, using
+// the analytic derivatives of the interpolated shape. The chi2 is the same as in FixedFastProcessor, sum (y-f)^2/y.
+//
+// All the fit work is done on fixed-size arrays on the stack and the processor keeps no global state, so several
+// instances can run concurrently, and no memory is allocated per fit.
+
+
+#include "CaloReco/inc/TemplateFitProcessor.hh"
+#include "CaloReco/inc/CaloPulseCache.hh"
+#include "art_root_io/TFileDirectory.h"
+#include "art_root_io/TFileService.h"
+
+
+#include "TH1.h"
+#include "TGraph.h"
+#include "TCanvas.h"
+
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <string>
+#include <iostream>
+#include <vector>
+
+
+
+namespace {
+
+   const int maxFitPar = 8;
+
+   //-----------------------------------------------------------------------------------------
+   //solve a*x = b for the symmetric positive definite n x n matrix a (row length maxFitPar) by Cholesky decomposition
+   bool solveSymmetric(const double a[][maxFitPar], const double* b, double* x, int n)
+   {
+       double l[maxFitPar][maxFitPar];
+       for (int i=0;i<n;++i)
+       {
+           for (int j=0;j<=i;++j)
+           {
+               double sum = a[i][j];
+               for (int k=0;k<j;++k) sum -= l[i][k]*l[j][k];
+               if (i==j)
+               {
+                   if (!(sum > 0)) return false;
+                   l[i][i] = std::sqrt(sum);
+               }
+               else l[i][j] = sum/l[j][j];
+           }
+       }
+
+       for (int i=0;i<n;++i)
+       {
+           double sum = b[i];
+           for (int k=0;k<i;++k) sum -= l[i][k]*x[k];
+           x[i] = sum/l[i][i];
+       }
+       for (int i=n-1;i>=0;--i)
+       {
+           double sum = x[i];
+           for (int k=i+1;k<n;++k) sum -= l[k][i]*x[k];
+           x[i] = sum/l[i][i];
+       }
+       return true;
+   }
+
+}
+
+
+
+
+namespace mu2e {
+
+   //-----------------------------------------------------------------------------
+   TemplateFitProcessor::TemplateFitProcessor(fhicl::ParameterSet const& PSet) :
+
+      WaveformProcessor(PSet),
+      windowPeak_         (PSet.get<int>         ("windowPeak")),
+      minPeakAmplitude_   (PSet.get<double>      ("minPeakAmplitude")),
+      psdThreshold_       (PSet.get<double>      ("psdThreshold")),
+      pulseLowBuffer_     (PSet.get<unsigned int>("pulseLowBuffer")),
+      pulseHighBuffer_    (PSet.get<unsigned int>("pulseHighBuffer")),
+      minDiffTime_        (PSet.get<unsigned int>("minDiffTime")),
+      shiftTime_          (PSet.get<double>      ("shiftTime")),
+      maxIterations_      (PSet.get<int>         ("maxIterations",50)),
+      edmTolerance_       (PSet.get<double>      ("edmTolerance",1e-4)),
+      diagLevel_          (PSet.get<int>         ("diagLevel",0)),
+      pulseCache_(CaloPulseCache()),
+      nPeaks_(0),
+      chi2_(999),
+      ndf_(0),
+      xindices_(),
+      xvec_(),
+      yvec_(),
+      res_(),
+      resAmp_(),
+      resAmpErr_(),
+      resTime_(),
+      resTimeErr_()
+   {
+       static_assert(maxPar_ <= maxFitPar, "TemplateFitProcessor: too many fit parameters for solveSymmetric");
+
+       if (diagLevel_ > 2)
+       {
+          art::ServiceHandle<art::TFileService> tfs;
+          art::TFileDirectory tfdir = tfs->mkdir("TemplateFitDiag");
+          _hTime    = tfdir.make<TH1F>("hTime",    "time",                  100, 0., 2000);
+          _hTimeErr = tfdir.make<TH1F>("hTimeErr", "time error",            100, 0.,   10);
+          _hEner    = tfdir.make<TH1F>("hEner",    "Amplitude",             100, 0., 5000);
+          _hEnerErr = tfdir.make<TH1F>("hEnerErr", "Amplitude error",       100, 0.,  100);
+          _hChi2    = tfdir.make<TH1F>("hChi2",    "Chi2/ndf",              100, 0.,   20);
+          _hNpeak   = tfdir.make<TH1F>("hNpeak",   "Number of peak fitted",  10, 0.,   10);
+          _hNiter   = tfdir.make<TH1F>("hNiter",   "Number of iterations",   50, 0.,   50);
+       }
+   }
+
+
+   //------------------------------------------------------------------------------------------
+   void TemplateFitProcessor::initialize()
+   {
+       pulseCache_.initialize();
+   }
+
+
+   //---------------------------
+   void TemplateFitProcessor::reset()
+   {
+       xvec_.clear();
+       yvec_.clear();
+       xindices_.clear();
+       res_.clear();
+       resAmp_.clear();
+       resAmpErr_.clear();
+       resTime_.clear();
+       resTimeErr_.clear();
+
+       nPeaks_  = 0;
+       chi2_    = 999;
+       ndf_     = 0;
+   }
+
+
+   //------------------------------------------------------------------------------------------
+   void TemplateFitProcessor::extract(std::vector<double> &xInput, std::vector<double> &yInput)
+   {
+       reset();
+       xvec_ = xInput;
+       yvec_ = yInput;
+       for (unsigned int i=0; i<xvec_.size(); ++i) xindices_.push_back(i);
+
+       if (xInput.size() < 2) return;
+
+
+       double par[maxPar_]={0}, errpar[maxPar_]={0}, chi2(999);
+       int nPar  = findPeak(par);
+       int nPeak = nPar/2;
+       if (diagLevel_ > 2) _hNpeak->Fill(nPeak);
+       if (nPeak==0) return;
+
+       int nIter = doFit(par, errpar, nPar, chi2);
+
+
+       //remove too small components or those too close to a larger one, and refit the others (as FixedFastProcessor)
+       if (nPeak > 1)
+       {
+           double keptPar[maxPar_];
+           int nKept(0);
+           std::vector<unsigned int> peakLoc;
+           for (int ip=0;ip<nPeak;++ip)
+           {
+               double minDTime(999);
+               for (int j=0;j<nPeak;++j)
+                  if (j!=ip && par[2*j] > par[2*ip]) minDTime = std::min(minDTime,std::abs(par[2*ip+1]-par[2*j+1]));
+
+               if (par[2*ip] <= minPeakAmplitude_ || minDTime <= minDiffTime_) continue;
+               keptPar[nKept++] = par[2*ip];
+               keptPar[nKept++] = par[2*ip+1];
+               peakLoc.push_back((par[2*ip+1]-xvec_[0])/(xvec_[1]-xvec_[0]));
+           }
+
+           if (nKept < nPar)
+           {
+               nPar = nKept;
+               std::copy(keptPar,keptPar+nKept,par);
+               if (nPar==0) return;
+               buildXRange(peakLoc);
+               nIter += doFit(par, errpar, nPar, chi2);
+           }
+       }
+       if (diagLevel_ > 2) _hNiter->Fill(nIter);
+
+
+       //final results, keep only the good peaks
+       res_.assign(par,par+nPar);
+       chi2_   = chi2;
+       nPeaks_ = 0;
+
+       for (int i=0;i<nPar/2;++i)
+       {
+           if (par[2*i] < 1e-5) continue;
+           ++nPeaks_;
+
+           resAmp_.push_back(par[2*i]);
+           resAmpErr_.push_back(errpar[2*i]);
+           resTime_.push_back(par[2*i+1] - shiftTime_);
+           resTimeErr_.push_back(errpar[2*i+1]);
+
+           if (diagLevel_ > 2)
+           {
+              _hTime->Fill(par[2*i+1]);
+              _hTimeErr->Fill(errpar[2*i+1]);
+              _hEner->Fill(par[2*i]);
+              _hEnerErr->Fill(errpar[2*i]);
+           }
+       }
+
+       //number of bins active in the fit - number of parameters
+       ndf_ = xindices_.size() - 2*nPeaks_;
+       if (diagLevel_ > 2) _hChi2->Fill(chi2/float(ndf_));
+   }
+
+
+   //----------------------------------------------------------------------------------------------------------------------
+   // Same peak search as FixedFastProcessor, limited to maxPeaks_ peaks. Returns the number of parameters.
+   int TemplateFitProcessor::findPeak(double* parInit)
+   {
+        int nPar(0);
+        std::vector<unsigned int> peakLocation;
+
+        //find location of potential peaks: max element in the range i-window; i+window
+        for (unsigned int i=windowPeak_;i<xvec_.size()-windowPeak_ && nPar<maxPar_;++i)
+        {
+             if (std::max_element(&yvec_[i-windowPeak_],&yvec_[i+windowPeak_+1]) != &yvec_[i]) continue;
+             double imin = std::min(std::min(yvec_[i-1],yvec_[i+1]),yvec_[i]);
+             if (imin < minPeakAmplitude_) continue;
+
+             double currentAmplitudeX = model(xvec_[i],parInit,nPar);
+             double loc               = meanParabol(i,i-1,i+1);
+
+             parInit[nPar++] = pulseCache_.factor()*(yvec_[i] - currentAmplitudeX);
+             parInit[nPar++] = loc;
+             peakLocation.push_back(i);
+        }
+
+        if (diagLevel_ > 1) std::cout<<"[TemplateFitProcessor] Peaks init found : "<<peakLocation.size()<<std::endl;
+        if (peakLocation.empty()) return 0;
+
+
+        // find location of secondary peaks from the residuals
+        std::vector<double> residual(xvec_.size(),0);
+        for (unsigned int i=0;i<xvec_.size();++i)
+             if (yvec_[i] > 0) residual[i] = yvec_[i] - model(xvec_[i],parInit,nPar);
+
+        for (unsigned int i=windowPeak_;i<xvec_.size()-windowPeak_ && nPar<maxPar_;++i)
+        {
+             if (std::max_element(&residual[i-windowPeak_],&residual[i+windowPeak_+1]) != &residual[i]) continue;
+             double psd = residual[i]/yvec_[i];
+             if (residual[i] < minPeakAmplitude_ || psd < psdThreshold_) continue;
+
+             double resid = yvec_[i] - model(xvec_[i],parInit,nPar);
+             parInit[nPar++] = pulseCache_.factor()*resid;
+             parInit[nPar++] = xvec_[i];
+             peakLocation.push_back(i);
+        }
+
+        buildXRange(peakLocation);
+        return nPar;
+   }
+
+
+   //----------------------------------------------------------------------------------------------------------------------
+   // Levenberg-Marquardt minimization of sum (y-f)^2/y over the samples in xindices_. The amplitudes are kept
+   // positive and the times within 15 ns of their start values, like the limits of the Minuit fit.
+   // The errors are from the inverse of the curvature matrix. Returns the number of iterations.
+   int TemplateFitProcessor::doFit(double* par, double* errpar, int nPar, double& chi2)
+   {
+        double timeInit[maxPeaks_];
+        for (int ip=0;ip<nPar/2;++ip) timeInit[ip] = par[2*ip+1];
+
+        double alpha[maxFitPar][maxFitPar], beta[maxFitPar];
+        auto linearize = [&](const double* p)
+        {
+            for (int j=0;j<nPar;++j) {beta[j]=0; for (int k=0;k<nPar;++k) alpha[j][k]=0;}
+            for (unsigned int i : xindices_)
+            {
+                double y = yvec_[i];
+                if (y < 1e-5) continue;
+                double deriv[maxFitPar];
+                double val(0);
+                for (int ip=0;ip<nPar/2;++ip)
+                {
+                    double dx     = xvec_[i]-p[2*ip+1];
+                    double shape  = pulseCache_.evaluate(dx);
+                    val          += p[2*ip]*shape;
+                    deriv[2*ip]   = shape;
+                    deriv[2*ip+1] = -p[2*ip]*pulseCache_.slope(dx);
+                }
+                double w = 1.0/y;
+                double r = y-val;
+                for (int j=0;j<nPar;++j)
+                {
+                    beta[j] += w*r*deriv[j];
+                    for (int k=0;k<=j;++k) alpha[j][k] += w*deriv[j]*deriv[k];
+                }
+            }
+            for (int j=0;j<nPar;++j) for (int k=0;k<j;++k) alpha[k][j] = alpha[j][k];
+        };
+
+        chi2 = calcChi2(par,nPar);
+        double lambda(1e-3);
+        int nIter(0);
+        for (;nIter<maxIterations_;++nIter)
+        {
+            linearize(par);
+
+            //stop when the estimated distance to the minimum is small
+            double step[maxFitPar];
+            if (solveSymmetric(alpha,beta,step,nPar))
+            {
+                double edm(0);
+                for (int j=0;j<nPar;++j) edm += beta[j]*step[j];
+                if (edm < edmTolerance_) break;
+            }
+
+            //find a step which lowers the chi2, increasing the damping until one does
+            bool improved(false);
+            double trial[maxPar_], trialChi2(chi2);
+            for (;lambda<1e10;lambda*=10)
+            {
+                double damped[maxFitPar][maxFitPar];
+                for (int j=0;j<nPar;++j)
+                {
+                    for (int k=0;k<nPar;++k) damped[j][k] = alpha[j][k];
+                    damped[j][j] *= 1.0+lambda;
+                }
+                if (!solveSymmetric(damped,beta,step,nPar)) continue;
+
+                for (int ip=0;ip<nPar/2;++ip)
+                {
+                    trial[2*ip]   = std::min(std::max(par[2*ip]+step[2*ip],0.0),1e6);
+                    trial[2*ip+1] = std::min(std::max(par[2*ip+1]+step[2*ip+1],timeInit[ip]-15),timeInit[ip]+15);
+                }
+                trialChi2 = calcChi2(trial,nPar);
+                if (trialChi2 < chi2) {improved = true; break;}
+            }
+            if (!improved) break;
+
+            std::copy(trial,trial+nPar,par);
+            chi2   = trialChi2;
+            lambda = std::max(0.1*lambda,1e-9);
+        }
+
+
+        //errors from the diagonal of the inverse curvature matrix at the minimum
+        linearize(par);
+        for (int j=0;j<nPar;++j)
+        {
+            double unit[maxFitPar]={0}, column[maxFitPar];
+            unit[j] = 1;
+            errpar[j] = solveSymmetric(alpha,unit,column,nPar) ? std::sqrt(std::abs(column[j])) : par[j];
+        }
+
+        return nIter;
+   }
+
+
+   //--------------------------------------------
+   double TemplateFitProcessor::model(double x, const double* par, int nPar) const
+   {
+       double result(0);
+       for (int i=0;i<nPar;i+=2) result += par[i]*pulseCache_.evaluate(x-par[i+1]);
+       return result;
+   }
+
+
+   //--------------------------------------------
+   double TemplateFitProcessor::calcChi2(const double* par, int nPar) const
+   {
+       double chi2(0);
+       for (unsigned int i : xindices_)
+       {
+           double y = yvec_[i];
+           if (y < 1e-5) continue;
+           double r = y-model(xvec_[i],par,nPar);
+           chi2 += r*r/y;
+       }
+       return chi2;
+   }
+
+
+   //-------------------------------------------------------------
+   void TemplateFitProcessor::buildXRange(const std::vector<unsigned int>& peakLoc)
+   {
+        std::set<unsigned int> tempX;
+        for (unsigned int ipeak : peakLoc)
+        {
+             unsigned int is = (ipeak > pulseLowBuffer_) ? ipeak-pulseLowBuffer_ : 0;
+             unsigned int ie = (ipeak+pulseHighBuffer_ < xvec_.size()) ? ipeak+pulseHighBuffer_ :  xvec_.size();
+             for (unsigned int ip=is; ip<ie; ++ip) tempX.insert(ip);
+        }
+
+        xindices_.clear();
+        for (auto i : tempX) xindices_.push_back(i);
+   }
+
+
+   //------------------------------------------------------------
+   double TemplateFitProcessor::meanParabol(unsigned int i1, unsigned int i2, unsigned int i3) const
+   {
+       if (i1==0 || i3 == xvec_.size()) return xvec_[i1];
+       double x1 = xvec_[i1];
+       double x2 = xvec_[i2];
+       double x3 = xvec_[i3];
+       double y1 = yvec_[i1];
+       double y2 = yvec_[i2];
+       double y3 = yvec_[i3];
+
+       double a = ((y1-y2)/(x1-x2)-(y1-y3)/(x1-x3))/(x2-x3);
+       double b = (y1-y2)/(x1-x2) - a*(x1+x2);
+       if (std::abs(a) < 1e-6) return (x1+x2+x3)/3.0;
+
+       return -b/2.0/a;
+   }
+
+
+   //---------------------------------------
+   void TemplateFitProcessor::plot(std::string pname)
+   {
+       if (xvec_.size() < 2) return;
+       double dx = xvec_[1]-xvec_[0];
+
+       TH1F h("test","Amplitude vs time",xvec_.size(),xvec_.front()-0.5*dx,xvec_.back()+0.5*dx);
+       h.GetXaxis()->SetTitle("Time (ns)");
+       h.GetYaxis()->SetTitle("Amplitude");
+       for (unsigned int i=0;i<xvec_.size();++i) h.SetBinContent(i+1,yvec_[i]);
+
+       TGraph g;
+       for (double x=xvec_.front(); x<=xvec_.back(); x+=0.1*dx) g.SetPoint(g.GetN(),x,model(x,res_.data(),res_.size()));
+
+       TCanvas c1("c1","c1");
+       h.Draw();
+       g.Draw("L same");
+       std::cout<<"Save file as "<<pname<<std::endl;
+
+       c1.SaveAs(pname.c_str());
+   }
+
+
+}
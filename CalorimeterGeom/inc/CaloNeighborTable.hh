@@ -0,0 +1,53 @@
+//
+// Flat (compressed sparse row) table of crystal neighbors
+//
+// The neighbors of crystal i are ids()[offset(i)] ... ids()[offset(i+1)-1], in the same order as
+// the per-crystal lists. It is built once with the geometry, so the clustering loops read one
+// contiguous array instead of following a vector per crystal.
+//
+
+#ifndef CalorimeterGeom_CaloNeighborTable_hh
+#define CalorimeterGeom_CaloNeighborTable_hh
+
+#include <vector>
+
+namespace mu2e {
+
+     class CaloNeighborTable {
+
+	  public:
+
+             CaloNeighborTable() : offsets_(1,0), ids_() {}
+
+
+             unsigned    nCrystal()             const {return offsets_.size()-1;}
+             const int*  begin(int crystalId)   const {return ids_.data() + offsets_[crystalId];}
+             const int*  end(int crystalId)     const {return ids_.data() + offsets_[crystalId+1];}
+             unsigned    size(int crystalId)    const {return offsets_[crystalId+1] - offsets_[crystalId];}
+
+             const std::vector<unsigned>& offsets() const {return offsets_;}
+             const std::vector<int>&      ids()     const {return ids_;}
+
+
+             // add the neighbors of the next crystal id, lists are concatenated if several are given
+             void addCrystal(const std::vector<int>& list)
+             {
+                 ids_.insert(ids_.end(), list.begin(), list.end());
+                 offsets_.push_back(ids_.size());
+             }
+             void appendToLast(const std::vector<int>& list)
+             {
+                 ids_.insert(ids_.end(), list.begin(), list.end());
+                 offsets_.back() = ids_.size();
+             }
+
+
+	 private:
+
+	     std::vector<unsigned>  offsets_;
+	     std::vector<int>       ids_;
+     };
+
+}
+
+#endif
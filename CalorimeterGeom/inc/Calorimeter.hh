@@ -11,6 +11,7 @@
 #include "CalorimeterGeom/inc/CaloGeomUtil.hh"
 #include "CalorimeterGeom/inc/Disk.hh"
 #include "CalorimeterGeom/inc/Crystal.hh"
+#include "CalorimeterGeom/inc/CaloNeighborTable.hh"
 
 #include "CLHEP/Vector/ThreeVector.h"
 #include <vector>
@@ -46,6 +47,7 @@ namespace mu2e {
            virtual const std::vector<int>&  neighbors(int crystalId, bool rawMap=false)                     const = 0;
            virtual const std::vector<int>&  nextNeighbors(int crystalId, bool rawMap=false)                 const = 0;
            virtual       std::vector<int>   neighborsByLevel(int crystalId, int level, bool rawMap = false) const = 0; 
+           virtual const CaloNeighborTable& neighborTable(bool withNextNeighbors=false)                 const = 0;
            virtual int                      crystalIdxFromPosition(const CLHEP::Hep3Vector& pos)            const = 0;
            virtual int                      nearestIdxFromPosition(const CLHEP::Hep3Vector& pos)            const = 0;
 
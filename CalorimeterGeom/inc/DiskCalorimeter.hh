@@ -13,6 +13,7 @@
 #include "CalorimeterGeom/inc/CaloGeomUtil.hh"
 #include "CalorimeterGeom/inc/Disk.hh"
 #include "CalorimeterGeom/inc/Crystal.hh"
+#include "CalorimeterGeom/inc/CaloNeighborTable.hh"
 
 #include "CLHEP/Vector/ThreeVector.h"
 
@@ -59,6 +60,7 @@ namespace mu2e {
             virtual const std::vector<int>&  neighbors(int crystalId, bool rawMap)     const  {return fullCrystalList_.at(crystalId)->neighbors(rawMap);}	  
             virtual const std::vector<int>&  nextNeighbors(int crystalId, bool rawMap) const  {return fullCrystalList_.at(crystalId)->nextNeighbors(rawMap);} 
             virtual       std::vector<int>   neighborsByLevel(int crystalId, int level, bool rawMap) const; 
+            virtual const CaloNeighborTable& neighborTable(bool withNextNeighbors)     const  {return withNextNeighbors ? nextNeighborTable_ : neighborTable_;}
             virtual int                      crystalIdxFromPosition(const CLHEP::Hep3Vector& pos) const;
             virtual int                      nearestIdxFromPosition(const CLHEP::Hep3Vector& pos) const; 
 
@@ -81,6 +83,8 @@ namespace mu2e {
 	    std::vector<DiskPtr>          disks_;
             
 	    std::vector<const Crystal*>   fullCrystalList_; //non-owning crystal pointers
+	    CaloNeighborTable             neighborTable_;     //flat copy of the (non-raw) neighbors
+	    CaloNeighborTable             nextNeighborTable_; //neighbors followed by next neighbors
             CaloInfo                      caloInfo_;
 	    CaloGeomUtil                  geomUtil_;
      };
@@ -14,6 +14,8 @@ namespace mu2e {
     DiskCalorimeter::DiskCalorimeter() : 
       disks_(),
       fullCrystalList_(),  
+      neighborTable_(),
+      nextNeighborTable_(),
       caloInfo_(),
       geomUtil_(disks_, fullCrystalList_)
     {}
@@ -3,6 +3,7 @@
 
 #include <shared_mutex>
 #include <chrono>
+#include <future>
 
 #include "DbService/inc/DbReader.hh"
 #include "DbTables/inc/DbId.hh"
@@ -12,6 +13,7 @@
 #include "DbTables/inc/DbCache.hh"
 #include "DbTables/inc/DbValCache.hh"
 #include "DbTables/inc/DbLiveTable.hh"
+#include "DbTables/inc/DbIoVIndex.hh"
 
 
 namespace mu2e {
@@ -19,7 +21,8 @@ namespace mu2e {
   public:
 
     DbEngine():_verbose(0),_initialized(false),
-	       _lockWaitTime(0),_lockTime(0) {}
+	       _prefetch(false),_prefetchMinRun(0),_prefetchMaxRun(0),
+	       _lockWaitTime(0),_lockTime(0),_fetchTime(0) {}
     // the big read of the IOV structure is done in beginJob
     int beginJob();
     int endJob();
@@ -31,6 +34,9 @@ namespace mu2e {
     // add tables directly - optionally set before beginJob
     void addOverride(DbTableCollection const& coll);
     void setVerbose(int verbose = 0) { _verbose = verbose; }
+    // read all tables valid in this run range in beginJob
+    void setPrefetch(uint32_t minRun, uint32_t maxRun) {
+      _prefetch = true; _prefetchMinRun = minRun; _prefetchMaxRun = maxRun; }
     // these should only be called in single-threaded startup
     std::shared_ptr<DbValCache>& valCache() {return _vcache;}
     std::vector<int> gids() { return _gids; }
@@ -58,6 +64,8 @@ namespace mu2e {
     void lazyBeginJob();
     // find a table cid in the fast lookup structure
     Row findTable(int tid, uint32_t run, uint32_t subrun);
+    // read the tables of the prefetch run range into the cache
+    void prefetch();
 
 
     DbId _id;
@@ -70,16 +78,26 @@ namespace mu2e {
     bool _initialized;
     // a join of relevant tables, int is tid, Row is above
     std::map<int,std::vector<Row>> _lookup;
+    // interval trees over the Rows of _lookup, by tid
+    std::map<int,DbIoVIndex> _index;
     DbTableCollection _last;
     std::vector<int> _gids;
     std::map<std::string,int> _overrideTids;
+    bool _prefetch;
+    uint32_t _prefetchMinRun;
+    uint32_t _prefetchMaxRun;
+    // tables being read by some thread, the lock is not held
+    // during the read, so only threads needing the same cid wait
+    std::map<int,std::shared_future<DbTable::cptr_t>> _inFlight;
 
     // lock for threaded access
     mutable std::shared_mutex _mutex;
     // count the time locked
     std::chrono::microseconds _lockWaitTime;
     std::chrono::microseconds _lockTime;
-    
+    // time reading tables outside of the lock, summed over threads
+    std::chrono::microseconds _fetchTime;
+
   };
 }
 #endif
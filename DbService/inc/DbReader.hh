@@ -11,7 +11,20 @@
 // this code will retry up to the timeout, then abort
 // if you want to handle the failure, set setAbortOnFail(false)
 //
+// If a snapshot directory is set, every table read is also written
+// there, as the csv returned by the server, and later reads of the same
+// cid are taken from the file.  A cid is never reused for different
+// content, so the files never need to be invalidated and the directory
+// can be shared by the jobs on a node.  Files are written to a temporary
+// name and renamed, so readers never see a partial file.  Tables with
+// a binary form (see DbTables/inc/DbBinary.hh) are also saved in it,
+// and read from it in preference to the csv.  In offline
+// mode only the snapshot is read, including the val tables, so a
+// populated directory can stand in for the web server.
+//
 #include <string>
+#include <vector>
+#include <utility>
 #include <chrono>
 #include <curl/curl.h>
 #include "DbTables/inc/DbId.hh"
@@ -45,6 +58,8 @@ namespace mu2e {
     int multiQuery(std::vector<QueryForm>& qfv);
 
     int fillTableByCid(DbTable::ptr_t ptr, int cid);
+    // fill many tables, missing snapshots are read over one connection
+    int fillTablesByCid(std::vector<std::pair<DbTable::ptr_t,int>>& tables);
     int fillValTables(DbValCache& vcache);
 
     std::string& lastError() { return _lastError; }
@@ -63,6 +78,12 @@ namespace mu2e {
     void setCacheLifetime(int clt=0) { _cacheLifetime = clt; }
     void setVerbose(int verbose) { _verbose = verbose; }
     void setTimeVerbose(int timeVerbose) { _timeVerbose = timeVerbose; }
+    // directory of table snapshots, empty means no snapshots
+    void setSnapshotDir(std::string const& dir) { _snapshotDir = dir; }
+    // read only from the snapshot directory, never from the web server
+    void setOffline(bool offline=true) { _offline = offline; }
+    // keep the csv text in the tables filled, see DbTable::fill
+    void setSaveCsv(bool saveCsv=true) { _saveCsv = saveCsv; }
 
   private:
 
@@ -78,6 +99,16 @@ namespace mu2e {
 	      const std::string& table, const std::string& where="",
 	      const std::string& order="");
 
+    // the snapshot file of a table, cid<0 for the val tables
+    std::string snapshotPath(const std::string& table, int cid,
+			     const char* ext) const;
+    bool fillFromSnapshot(DbTable::ptr_t ptr, int cid);
+    void saveSnapshot(DbTable const& table, int cid, 
+		      const std::string& csv) const;
+    bool readSnapshot(std::string& csv, const std::string& path) const;
+    void writeSnapshot(const std::string& csv, const std::string& path) const;
+    int missingSnapshot(const std::string& table, int cid);
+
     DbId _id;
     CURL *_curl_handle;
     CURLcode _curl_ret;
@@ -92,6 +123,9 @@ namespace mu2e {
     int _cacheLifetime;
     int _verbose;
     int _timeVerbose;
+    std::string _snapshotDir;
+    bool _offline;
+    bool _saveCsv;
   };
 }
 #endif
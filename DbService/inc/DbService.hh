@@ -37,6 +37,12 @@ namespace mu2e {
 	  Comment("read the DB immedatiately, not on first use")};
       fhicl::OptionalAtom<int> cacheLifetime{Name("cacheLifetime"), 
 	  Comment("if >0, read IoV from cache, but renew each lifetime s")};
+      fhicl::OptionalAtom<std::string> snapshotDir{Name("snapshotDir"), 
+	  Comment("directory of table snapshots, read before the DB, may be shared by jobs")};
+      fhicl::OptionalAtom<bool> offline{Name("offline"), 
+	  Comment("read tables only from snapshotDir, never contact the DB")};
+      fhicl::OptionalSequence<int> prefetchRuns{Name("prefetchRuns"), 
+	  Comment("first and last run, read all their tables at beginJob")};
     };
 
     // this line is required by art to allow the command line help print
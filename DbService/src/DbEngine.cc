@@ -1,5 +1,6 @@
 #include <iostream>
 #include <chrono>
+#include <set>
 #include "cetlib_except/exception.h"
 #include "DbService/inc/DbEngine.hh"
 #include "DbTables/inc/DbTableFactory.hh"
@@ -17,6 +18,8 @@ int mu2e::DbEngine::beginJob() {
   _reader.setDbId(_id);
   _reader.setVerbose(_verbose);
   _reader.setTimeVerbose(_verbose);
+  // tables are used through their rows, don't keep the text
+  _reader.setSaveCsv(false);
 
 
   // this is used to assign nominal tid's and cid's to tables that
@@ -209,6 +212,15 @@ int mu2e::DbEngine::beginJob() {
     }
   }
 
+  // index the intervals of each table, in the order of _lookup,
+  // so findTable returns the same Row as a search of the list
+  _index.clear();
+  for(auto const& p : _lookup) {
+    auto& index = _index[p.first];
+    for(size_t i=0; i<p.second.size(); i++) index.add(p.second[i].iov(),i);
+    index.build();
+  }
+
   // if file-based override tables were loaded, 
   // fill tid now.  If the table is known to the database,
   // then use that tid, but if it is not, we need to assign
@@ -255,6 +267,8 @@ int mu2e::DbEngine::beginJob() {
   // this will be the current list of active, filled tables
   _last.clear();
 
+  if(_prefetch) prefetch();
+
   if( _verbose>0 ) {
     std::cout << "DbEngine confirmed purpose and version " 
 	      << _version.purpose() << " " << _version.major() 
@@ -330,46 +344,86 @@ mu2e::DbLiveTable mu2e::DbEngine::update(int tid, uint32_t run,
 
   // if it wasn't found in cache, try to read from database
   if(! ptr ) {
-    auto stime = std::chrono::high_resolution_clock::now();
-    std::unique_lock lock(_mutex); // write lock
-    auto mtime = std::chrono::high_resolution_clock::now();
-    auto dt = std::chrono::duration_cast<std::chrono::microseconds>
+    // the first thread needing this cid reads it, without holding
+    // the lock, others needing the same cid wait on its future
+    std::promise<DbTable::cptr_t> promise;
+    std::shared_future<DbTable::cptr_t> future;
+    bool reading = false;
+    DbReader reader;
+    {
+      auto stime = std::chrono::high_resolution_clock::now();
+      std::unique_lock lock(_mutex); // write lock
+      auto mtime = std::chrono::high_resolution_clock::now();
+      _lockWaitTime += std::chrono::duration_cast<std::chrono::microseconds>
                                                ( mtime - stime );
-    _lockWaitTime += dt;
     
-    // have to check if some other thread loaded it 
-    // since the above read attempt
-    if(_cache.hasTable(cid)) {
-      ptr = _cache.get(cid);
-    } else {
-      auto const& tabledef = _vcache->valTables().row(tid);
-      // this makes the memory
-      auto ncptr = DbTableFactory::newTable(tabledef.name());
-      // the actual http read
-      int rc = _reader.fillTableByCid(ncptr,cid);
-
-      // reader does not abort, so do it here
-      if(rc!=0) {
-	auto const& tabledef = _vcache->valTables().row(tid);
-	throw cet::exception("DBENGINE_UPDATE_FAILED") 
-	  << " DbEngine::update failed to find table " << tabledef.name() 
-	  << " for run:subrun "<<run<<":"<<subrun
-	  <<", cid ="<< cid 
-	  <<", rc ="<< rc << "\n";
+      // have to check if some other thread loaded it 
+      // since the above read attempt
+      if(_cache.hasTable(cid)) {
+	ptr = _cache.get(cid);
+      } else {
+	auto iter = _inFlight.find(cid);
+	if(iter!=_inFlight.end()) {
+	  future = iter->second;
+	} else {
+	  future = promise.get_future().share();
+	  _inFlight[cid] = future;
+	  // the reader is not thread safe, use a copy for this read
+	  reader = _reader;
+	  reading = true;
+	}
       }
 
-      // make it const
-      ptr = std::const_pointer_cast<const mu2e::DbTable,mu2e::DbTable>(ncptr);
-      // push to cache
-      _cache.add(cid,ptr);
-    }
-
-    auto etime = std::chrono::high_resolution_clock::now();
-    dt = std::chrono::duration_cast<std::chrono::microseconds>
+      auto etime = std::chrono::high_resolution_clock::now();
+      _lockTime += std::chrono::duration_cast<std::chrono::microseconds>
                                           ( etime - mtime );
-    _lockTime += dt;
+    } // write lock goes out of scope
+
+    if(reading) {
+      auto stime = std::chrono::high_resolution_clock::now();
+      try {
+	auto const& tabledef = _vcache->valTables().row(tid);
+	// this makes the memory
+	auto ncptr = DbTableFactory::newTable(tabledef.name());
+	// the actual http read, or snapshot read
+	int rc = reader.fillTableByCid(ncptr,cid);
+
+	// reader does not abort, so do it here
+	if(rc!=0) {
+	  throw cet::exception("DBENGINE_UPDATE_FAILED") 
+	    << " DbEngine::update failed to find table " << tabledef.name() 
+	    << " for run:subrun "<<run<<":"<<subrun
+	    <<", cid ="<< cid 
+	    <<", rc ="<< rc << "\n";
+	}
+
+	// make it const
+	ptr = std::const_pointer_cast<const mu2e::DbTable,mu2e::DbTable>(ncptr);
+      } catch (...) {
+	// waiting threads get the same exception, later calls try again
+	{
+	  std::unique_lock lock(_mutex);
+	  _inFlight.erase(cid);
+	}
+	promise.set_exception(std::current_exception());
+	throw;
+      }
+      auto etime = std::chrono::high_resolution_clock::now();
+
+      {
+	std::unique_lock lock(_mutex); // write lock
+	// push to cache
+	_cache.add(cid,ptr);
+	_inFlight.erase(cid);
+	_fetchTime += std::chrono::duration_cast<std::chrono::microseconds>
+                                          ( etime - stime );
+      }
+      promise.set_value(ptr);
+    } else if(! ptr) {
+      ptr = future.get(); // rethrows if the reading thread failed
+    }
 
-  } // write lock goes out of scope
+  }
 
 
   // this code handles the case where an override takes effect
@@ -393,17 +447,51 @@ mu2e::DbEngine::Row mu2e::DbEngine::findTable(
 			    int tid, uint32_t run, uint32_t subrun) {
   auto iter = _lookup.find(tid);
   if(iter!=_lookup.end()) { // if the IOV structure includes this tid
-    for(auto const& r : iter->second) { // find which iov is appropriate
-      if(r.iov().inInterval(run,subrun)) {
-	return r; // return iov and cid in a Row
-      }
-    } // loop over Rows for table type
+    // find which iov is appropriate
+    int i = _index.find(tid)->second.find(run,subrun);
+    if(i>=0) return iter->second[i]; // return iov and cid in a Row
   }  
   return DbEngine::Row(DbIoV(),-1); // not found
 }
 
 
 
+// read all tables valid in the prefetch run range, so that
+// update finds them in the cache. Called in beginJob.
+void mu2e::DbEngine::prefetch() {
+
+  std::vector<std::pair<DbTable::ptr_t,int>> tables;
+  std::set<int> cids;
+  for(auto const& p : _lookup) {
+    auto const& tabledef = _vcache->valTables().row(p.first);
+    for(auto const& r : p.second) {
+      if(r.iov().startRun()>_prefetchMaxRun || 
+	 r.iov().endRun()<_prefetchMinRun) continue;
+      if(_cache.hasTable(r.cid()) || !cids.insert(r.cid()).second) continue;
+      tables.emplace_back(DbTableFactory::newTable(tabledef.name()),r.cid());
+    }
+  }
+
+  int rc = _reader.fillTablesByCid(tables);
+  if(rc!=0) {
+    throw cet::exception("DBENGINE_PREFETCH_FAILED") 
+      << " DbEngine::prefetch failed to read tables for runs "
+      << _prefetchMinRun << "-" << _prefetchMaxRun
+      << ", rc =" << rc << "\n";
+  }
+
+  for(auto const& t : tables) {
+    _cache.add(t.second,
+	       std::const_pointer_cast<const mu2e::DbTable,mu2e::DbTable>(t.first));
+  }
+
+  if(_verbose>0) {
+    std::cout << "DbEngine prefetched " << tables.size() 
+	      << " tables for runs " << _prefetchMinRun 
+	      << "-" << _prefetchMaxRun << std::endl;
+  }
+}
+
 int mu2e::DbEngine::tidByName(std::string const& name) {
 
   lazyBeginJob(); // initialize if needed
@@ -485,6 +573,9 @@ int mu2e::DbEngine::endJob() {
     std::cout << "DbEngine::endJob" << std::endl;
     std::cout << "    Total time in reading DB: "<< _reader.totalTime() 
 	      <<" s" << std::endl;
+    std::cout << "    Total time in reading tables outside locks: "
+	      << _fetchTime.count()*1.0e-6
+	      <<" s" << std::endl;
     std::cout << "    Total time waiting for locks: "
 	      << _lockWaitTime.count()*1.0e-6
 	      <<" s" << std::endl;
@@ -1,6 +1,13 @@
 #include <unistd.h>
+#include <sys/stat.h>
+#include <cstdio>
+#include <cerrno>
 #include <iostream>
 #include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <mutex>
+#include <thread>
 #include "cetlib_except/exception.h"
 #include "DbService/inc/DbReader.hh"
 #include "DbService/inc/DbCurl.hh"
@@ -12,15 +19,16 @@ using namespace std;
 mu2e::DbReader::DbReader(const DbId& id):_id(id),_curl_handle(nullptr),
 		_timeout(3600),_totalTime(0),_removeHeader(true),
 	        _abortOnFail(true),_useCache(true),_cacheLifetime(0),
-		_verbose(0),_timeVerbose(0) {
+		_verbose(0),_timeVerbose(0),_offline(false),_saveCsv(true) {
 
-  // allocates memory for curl
-  curl_global_init(CURL_GLOBAL_ALL);
+  // allocates memory for curl.  This is not thread safe and the
+  // DbEngine makes a reader for each concurrent read, so do it
+  // once for the process and let the memory be freed at exit
+  static std::once_flag curlInit;
+  std::call_once(curlInit, [](){ curl_global_init(CURL_GLOBAL_ALL); });
 }
 
 mu2e::DbReader::~DbReader() {
-  // free memory
-  curl_global_cleanup();
 }
 
 int mu2e::DbReader::query(std::string& csv, 
@@ -71,11 +79,55 @@ int mu2e::DbReader::multiQuery(std::vector<QueryForm>& qfv) {
 
 
 int mu2e::DbReader::fillTableByCid(DbTable::ptr_t ptr, int cid) {
+  if(fillFromSnapshot(ptr,cid)) return 0;
+  if(_offline) return missingSnapshot(ptr->dbname(),cid);
+
   std::string csv;
   std::string where="cid:eq:"+std::to_string(cid);
   int rc = query(csv,ptr->query(),ptr->dbname(),where);
   if(rc!=0) return rc;
-  ptr->fill(csv);
+  ptr->fill(csv,_saveCsv);
+  saveSnapshot(*ptr,cid,csv);
+  return 0;
+}
+
+int mu2e::DbReader::fillTablesByCid(
+		  std::vector<std::pair<DbTable::ptr_t,int>>& tables) {
+
+  // tables found in the snapshot are filled now, the rest are
+  // collected for one multiQuery
+  std::vector<QueryForm> qfv;
+  std::vector<size_t> indices;
+  for(size_t i=0; i<tables.size(); i++) {
+    auto& ptr = tables[i].first;
+    int cid = tables[i].second;
+    if(fillFromSnapshot(ptr,cid)) continue;
+    if(_offline) return missingSnapshot(ptr->dbname(),cid);
+    QueryForm qf;
+    qf.select = ptr->query();
+    qf.table = ptr->dbname();
+    qf.where = "cid:eq:"+std::to_string(cid);
+    qfv.emplace_back(qf);
+    indices.push_back(i);
+  }
+
+  if(_verbose>1) {
+    std::cout << "DbReader::fillTablesByCid " << tables.size()-qfv.size()
+	      << " tables from snapshot, " << qfv.size()
+	      << " from the database" << std::endl;
+  }
+
+  if(qfv.empty()) return 0;
+
+  int rc = multiQuery(qfv);
+  if(rc!=0) return rc;
+
+  for(size_t j=0; j<qfv.size(); j++) {
+    auto& tab = tables[indices[j]];
+    tab.first->fill(qfv[j].csv,_saveCsv);
+    saveSnapshot(*tab.first,tab.second,qfv[j].csv);
+  }
+
   return 0;
 }
 
@@ -126,7 +178,24 @@ int mu2e::DbReader::fillValTables(DbValCache& vcache) {
   qfv[10].select = extensionlists.query();
   qfv[10].table = extensionlists.dbname();
 
-  rc = multiQuery(qfv);
+  // the val tables change as calibrations are added, so they are
+  // only read from the snapshot when offline, but always saved
+  rc = 0;
+  if(_offline) {
+    for(auto& qf : qfv) {
+      if(!readSnapshot(qf.csv,snapshotPath(qf.table,-1,".csv"))) {
+	rc = missingSnapshot(qf.table,-1);
+	break;
+      }
+    }
+  } else {
+    rc = multiQuery(qfv);
+    if(rc==0 && !_snapshotDir.empty()) {
+      for(auto const& qf : qfv) {
+	writeSnapshot(qf.csv,snapshotPath(qf.table,-1,".csv"));
+      }
+    }
+  }
   if(rc!=0) return rc;
 
   tables.fill(qfv[0].csv);
@@ -370,3 +439,96 @@ int mu2e::DbReader::closeHandle() {
 
   return 0;
 }
+
+std::string mu2e::DbReader::snapshotPath(const std::string& table,
+					 int cid, const char* ext) const {
+  // cid's are unique within one database
+  std::string path = _snapshotDir + "/" + _id.name() + "/" + table;
+  if(cid>=0) path += "/" + std::to_string(cid);
+  path += ext;
+  return path;
+}
+
+bool mu2e::DbReader::fillFromSnapshot(DbTable::ptr_t ptr, int cid) {
+  if(_snapshotDir.empty()) return false;
+  std::string text;
+  // the binary form is refused if it was written by another
+  // version of the table, then the csv is used
+  if(readSnapshot(text,snapshotPath(ptr->dbname(),cid,".bin")) &&
+     ptr->fillBinary(text)==0) return true;
+  if(readSnapshot(text,snapshotPath(ptr->dbname(),cid,".csv"))) {
+    ptr->fill(text,_saveCsv);
+    return true;
+  }
+  return false;
+}
+
+void mu2e::DbReader::saveSnapshot(DbTable const& table, int cid,
+				  const std::string& csv) const {
+  if(_snapshotDir.empty()) return;
+  // the csv is kept as the reference, readable by any release
+  writeSnapshot(csv,snapshotPath(table.dbname(),cid,".csv"));
+  std::string bin;
+  if(table.toBinary(bin)==0) {
+    writeSnapshot(bin,snapshotPath(table.dbname(),cid,".bin"));
+  }
+}
+
+bool mu2e::DbReader::readSnapshot(std::string& csv, 
+				  const std::string& path) const {
+  if(_snapshotDir.empty()) return false;
+  std::ifstream in(path, std::ios::binary);
+  if(!in) return false;
+  std::ostringstream ss;
+  ss << in.rdbuf();
+  csv = ss.str();
+  if(_verbose>3) std::cout << "DbReader read snapshot " << path << std::endl;
+  return true;
+}
+
+void mu2e::DbReader::writeSnapshot(const std::string& csv,
+				   const std::string& path) const {
+
+  // make the directories, each may have been made by another job
+  for(auto pos = path.find('/',1); pos!=std::string::npos; 
+      pos = path.find('/',pos+1)) {
+    std::string dir = path.substr(0,pos);
+    if(mkdir(dir.c_str(),0775)!=0 && errno!=EEXIST) {
+      if(_verbose>0) std::cout << "DbReader could not make snapshot directory "
+			       << dir << std::endl;
+      return;
+    }
+  }
+
+  // write to a name unique to this thread, then rename, which 
+  // replaces any file written by another job in one step
+  std::ostringstream tmp;
+  tmp << path << ".tmp." << getpid() << "."
+      << std::hash<std::thread::id>()(std::this_thread::get_id());
+  {
+    std::ofstream out(tmp.str(), std::ios::binary);
+    out << csv;
+    if(!out) {
+      if(_verbose>0) std::cout << "DbReader could not write snapshot "
+			       << tmp.str() << std::endl;
+      std::remove(tmp.str().c_str());
+      return;
+    }
+  }
+  if(std::rename(tmp.str().c_str(),path.c_str())!=0) {
+    std::remove(tmp.str().c_str());
+    return;
+  }
+  if(_verbose>3) std::cout << "DbReader wrote snapshot " << path << std::endl;
+}
+
+int mu2e::DbReader::missingSnapshot(const std::string& table, int cid) {
+  _lastError = "no snapshot for table " + table;
+  if(cid>=0) _lastError += " cid " + std::to_string(cid);
+  if(_abortOnFail) {
+    throw cet::exception("DBREADER_NO_SNAPSHOT") << 
+      "DbReader offline, " << _lastError << " in " << _snapshotDir << "\n";
+  }
+  if(_verbose>0) std::cout << "DbReader offline, " << _lastError << std::endl;
+  return 1;
+}
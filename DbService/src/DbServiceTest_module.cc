@@ -6,6 +6,7 @@
 #include <iostream>
 #include <stdexcept>
 #include <string>
+#include <sstream>
 
 // Framework includes
 #include "art/Framework/Core/EDAnalyzer.h"
@@ -51,7 +52,13 @@ namespace mu2e {
     std::cout << "DbServiceTest::analyze" << std::endl;
 
     auto const& myTable = _testCalib1.get(event.id());
-    std::cout << myTable.csv();
+    // the service does not keep the csv text, make it from the rows
+    std::ostringstream ss;
+    for(std::size_t i=0; i<myTable.nrow(); i++) {
+      myTable.rowToCsv(ss,i);
+      ss << "\n";
+    }
+    std::cout << ss.str();
   };
 };
 
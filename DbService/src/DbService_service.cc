@@ -63,6 +63,30 @@ namespace mu2e {
     _config.cacheLifetime(cacheLifetime);
     _engine.reader().setCacheLifetime(cacheLifetime);
 
+    // tables read are saved in the snapshot directory and read 
+    // from it in later jobs, offline requires all tables be there
+    std::string snapshotDir;
+    if(_config.snapshotDir(snapshotDir)) {
+      _engine.reader().setSnapshotDir(snapshotDir);
+    }
+    bool offline = false;
+    _config.offline(offline);
+    if(offline && snapshotDir.empty()) {
+      throw cet::exception("DBSERVICE_BAD_CONFIG") 
+	<< " DbService offline requires a snapshotDir\n";
+    }
+    _engine.reader().setOffline(offline);
+
+    std::vector<int> prefetchRuns;
+    if(_config.prefetchRuns(prefetchRuns)) {
+      if(prefetchRuns.size()!=2 || prefetchRuns[0]<0 || 
+	 prefetchRuns[1]<prefetchRuns[0]) {
+	throw cet::exception("DBSERVICE_BAD_CONFIG") 
+	  << " DbService prefetchRuns must be the first and last run\n";
+      }
+      _engine.setPrefetch(prefetchRuns[0],prefetchRuns[1]);
+    }
+
     // service will start calling the database at the first event,
     // so the service can exist without the DB being contacted.  
     // fastStart overrides this and starts reading the DB imediately.
@@ -0,0 +1,175 @@
+//
+// Test of DbEngine reading only from a snapshot directory (offline mode).
+//
+// A snapshot of a small database is written into a new directory: the
+// val tables, one TstCalib1 cid as csv and one as binary.  A DbEngine
+// is then run offline on it and the test checks, for several run:subrun,
+// the cid and interval of validity that update returns and the content
+// of the table.  A run outside every IoV and a cid without a snapshot
+// must fail without going to the web server.
+//
+// Usage: dbSnapshotTest [directory]
+//   the snapshot is written in a new directory under the given one
+//   (default /tmp) and removed at the end
+//
+
+#include <unistd.h>
+#include <sys/stat.h>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "cetlib_except/exception.h"
+#include "DbService/inc/DbEngine.hh"
+#include "DbTables/inc/TstCalib1.hh"
+
+namespace {
+
+  const char* dbName = "mu2e_conditions_dev";
+
+  std::vector<std::string> made; // files and directories, to clean up
+  int nfail = 0;
+
+  void check(bool ok, std::string const& what) {
+    std::cout << (ok ? "OK     " : "FAILED ") << what << std::endl;
+    if(!ok) nfail++;
+  }
+
+  void writeFile(std::string const& path, std::string const& text) {
+    for(auto pos = path.find('/',1); pos!=std::string::npos;
+	pos = path.find('/',pos+1)) {
+      std::string dir = path.substr(0,pos);
+      if(mkdir(dir.c_str(),0775)==0) made.push_back(dir);
+    }
+    std::ofstream out(path, std::ios::binary);
+    out << text;
+    if(!out) {
+      throw cet::exception("DBSNAPSHOTTEST") << "could not write "
+					     << path << "\n";
+    }
+    made.push_back(path);
+  }
+
+  // the snapshot of a database with one purpose and version, and
+  // TstCalib1 valid for runs 1000 subruns 0-99 (cid 11, csv), runs
+  // 1001-1005 (cid 12, binary) and run 1010 (cid 13, no snapshot)
+  void writeSnapshot(std::string const& top) {
+    std::string dir = top + "/" + dbName + "/";
+    std::string const tu = "2020-01-01 00:00:00-06:00,mu2e";
+
+    writeFile(dir+"val.tables.csv","1,TstCalib1,tst.calib1,"+tu+"\n");
+    writeFile(dir+"val.calibrations.csv",
+	      "11,1,"+tu+"\n12,1,"+tu+"\n13,1,"+tu+"\n");
+    writeFile(dir+"val.iovs.csv",
+	      "1,11,1000,0,1000,99,"+tu+"\n"
+	      "2,12,1001,0,1005,999999,"+tu+"\n"
+	      "3,13,1010,0,1010,999999,"+tu+"\n");
+    writeFile(dir+"val.groups.csv","1,"+tu+"\n2,"+tu+"\n3,"+tu+"\n");
+    writeFile(dir+"val.grouplists.csv","1,1\n2,2\n3,3\n");
+    writeFile(dir+"val.purposes.csv","1,TEST,snapshot test,"+tu+"\n");
+    writeFile(dir+"val.lists.csv","1,TESTLIST,snapshot test,"+tu+"\n");
+    writeFile(dir+"val.tablelists.csv","1,1\n");
+    writeFile(dir+"val.versions.csv","1,1,1,1,0,snapshot test,"+tu+"\n");
+    writeFile(dir+"val.extensions.csv","1,1,0,"+tu+"\n");
+    writeFile(dir+"val.extensionlists.csv","1,1\n1,2\n1,3\n");
+
+    writeFile(dir+"tst.calib1/11.csv","0,1,1.100\n1,0,1.200\n2,1,1.300\n");
+
+    mu2e::TstCalib1 table;
+    table.fill("0,2,2.100\n1,3,2.200\n2,4,2.300\n");
+    std::string bin;
+    if(table.toBinary(bin)!=0) {
+      throw cet::exception("DBSNAPSHOTTEST") << "TstCalib1 has no binary form\n";
+    }
+    writeFile(dir+"tst.calib1/12.bin",bin);
+  }
+
+  void checkTable(mu2e::DbEngine& engine, int tid,
+		  uint32_t run, uint32_t subrun, int cid,
+		  mu2e::DbIoV const& iov, int flag, float dtoe) {
+    std::string where = "run " + std::to_string(run) + ":"
+      + std::to_string(subrun);
+    auto lt = engine.update(tid,run,subrun);
+    check(lt.cid()==cid, where + " cid " + std::to_string(lt.cid())
+	  + ", expected " + std::to_string(cid));
+    check(lt.iov().startRun()==iov.startRun() &&
+	  lt.iov().startSubrun()==iov.startSubrun() &&
+	  lt.iov().endRun()==iov.endRun() &&
+	  lt.iov().endSubrun()==iov.endSubrun(),
+	  where + " IoV " + lt.iov().to_string()
+	  + ", expected " + iov.to_string());
+    auto const& table = dynamic_cast<mu2e::TstCalib1 const&>(lt.table());
+    check(table.nrow()==3 && table.row(1).flag()==flag &&
+	  table.row(1).dToE()==dtoe, where + " content of channel 1");
+  }
+
+  template<class F>
+  void checkThrows(F f, std::string const& category, std::string const& what) {
+    std::string caught = "nothing";
+    try {
+      f();
+    } catch (cet::exception& e) {
+      caught = e.category();
+    }
+    check(caught==category, what + " throws " + caught
+	  + ", expected " + category);
+  }
+
+}
+
+int main(int argc, char** argv) {
+
+  std::string top = argc>1 ? argv[1] : "/tmp";
+  std::string templ = top + "/dbSnapshotTest.XXXXXX";
+  std::vector<char> buf(templ.begin(),templ.end());
+  buf.push_back('\0');
+  if(mkdtemp(buf.data())==nullptr) {
+    std::cerr << "dbSnapshotTest: could not make a directory in "
+	      << top << std::endl;
+    return 2;
+  }
+  std::string dir(buf.data());
+  made.push_back(dir);
+
+  try {
+    writeSnapshot(dir);
+
+    mu2e::DbEngine engine;
+    engine.setDbId(mu2e::DbId(dbName));
+    engine.setVersion(mu2e::DbVersion("TEST",1,0,-1));
+    engine.reader().setSnapshotDir(dir);
+    engine.reader().setOffline(true);
+    engine.beginJob();
+
+    int tid = engine.tidByName("TstCalib1");
+    check(tid==1, "tid of TstCalib1 " + std::to_string(tid));
+
+    // the csv snapshot, at both ends of its IoV
+    checkTable(engine,tid,1000,0,11,mu2e::DbIoV(1000,0,1000,99),0,1.2f);
+    checkTable(engine,tid,1000,99,11,mu2e::DbIoV(1000,0,1000,99),0,1.2f);
+    // the binary snapshot
+    checkTable(engine,tid,1001,0,12,mu2e::DbIoV(1001,0,1005,999999),3,2.2f);
+    checkTable(engine,tid,1005,17,12,mu2e::DbIoV(1001,0,1005,999999),3,2.2f);
+    // back to the first interval, now from the cache
+    checkTable(engine,tid,1000,50,11,mu2e::DbIoV(1000,0,1000,99),0,1.2f);
+
+    checkThrows([&](){ engine.update(tid,1000,100); },
+		"DBENGINE_UPDATE_FAILED","run 1000:100, outside every IoV,");
+    checkThrows([&](){ engine.update(tid,1010,0); },
+		"DBREADER_NO_SNAPSHOT","run 1010:0, cid without snapshot,");
+
+  } catch (cet::exception& e) {
+    std::cerr << e.what() << std::endl;
+    nfail++;
+  }
+
+  for(auto it = made.rbegin(); it!=made.rend(); ++it) {
+    std::remove(it->c_str());
+  }
+
+  std::cout << "dbSnapshotTest: " << (nfail==0 ? "passed" : "FAILED")
+	    << std::endl;
+  return nfail==0 ? 0 : 1;
+}
@@ -0,0 +1,176 @@
+#ifndef DbTables_DbBinary_hh
+#define DbTables_DbBinary_hh
+//
+// A compact columnar binary form for DbTable rows.  A table lists
+// its columns once, as the Row accessors in db column order,
+// which must also be the order of the Row constructor arguments:
+//
+//   static auto columns() { return std::make_tuple(&Row::index,&Row::delay); }
+//
+// and the row data is written as one array per column.  Reading
+// copies the arrays back and constructs the rows, so no text is
+// split or converted.  The table name and the column types are
+// written in a header and checked on read, so a binary written by
+// a different version of the table is refused, not misread.  The
+// binary is for local snapshots and uses the native byte order.
+//
+
+#include <string>
+#include <vector>
+#include <tuple>
+#include <cstring>
+#include <cstdint>
+#include <utility>
+#include <iterator>
+#include <type_traits>
+
+namespace mu2e {
+
+  namespace DbBinary {
+
+    const char magic[] = "MU2EDBB1";
+    const std::size_t magicSize = 8;
+
+    // column type codes
+    template<class T> struct TypeCode;
+    template<> struct TypeCode<int>         { static constexpr uint8_t value = 1; };
+    template<> struct TypeCode<float>       { static constexpr uint8_t value = 2; };
+    template<> struct TypeCode<double>      { static constexpr uint8_t value = 3; };
+    template<> struct TypeCode<std::string> { static constexpr uint8_t value = 4; };
+
+    // the type of a column from its accessor, which may return by reference
+    template<class G> struct ColumnOf;
+    template<class Row, class R> struct ColumnOf<R (Row::*)() const> {
+      typedef typename std::decay<R>::type type;
+    };
+
+    template<class T>
+    void append(std::string& bin, T const& value) {
+      bin.append(reinterpret_cast<const char*>(&value),sizeof(T));
+    }
+
+    // sequential reads with a bounds check, false when past the end
+    class Cursor {
+    public:
+      Cursor(std::string const& bin):_p(bin.data()),_end(bin.data()+bin.size()) {}
+      bool get(void* dest, std::size_t n) {
+	if(std::size_t(_end-_p)<n) return false;
+	std::memcpy(dest,_p,n);
+	_p += n;
+	return true;
+      }
+      template<class T> bool get(T& value) { return get(&value,sizeof(T)); }
+      bool atEnd() const { return _p==_end; }
+    private:
+      const char* _p;
+      const char* _end;
+    };
+
+    template<class T>
+    void writeColumn(std::string& bin, std::vector<T> const& col) {
+      static_assert(std::is_arithmetic<T>::value,"unsupported DbBinary column type");
+      bin.append(reinterpret_cast<const char*>(col.data()),col.size()*sizeof(T));
+    }
+    inline void writeColumn(std::string& bin, std::vector<std::string> const& col) {
+      for(auto const& s : col) {
+	append(bin,uint32_t(s.size()));
+	bin.append(s);
+      }
+    }
+
+    template<class T>
+    bool readColumn(Cursor& cur, std::vector<T>& col) {
+      return cur.get(col.data(),col.size()*sizeof(T));
+    }
+    inline bool readColumn(Cursor& cur, std::vector<std::string>& col) {
+      for(auto& s : col) {
+	uint32_t n;
+	if(!cur.get(n)) return false;
+	s.resize(n);
+	if(!cur.get(&s[0],n)) return false;
+      }
+      return true;
+    }
+
+    template<class Row, class Getters, std::size_t... I>
+    void writeImpl(std::string& bin, std::vector<Row> const& rows,
+		   Getters const& getters, std::index_sequence<I...>) {
+      auto writeOne = [&](auto getter) {
+	typedef typename ColumnOf<decltype(getter)>::type T;
+	append(bin,TypeCode<T>::value);
+	std::vector<T> col;
+	col.reserve(rows.size());
+	for(auto const& r : rows) col.emplace_back((r.*getter)());
+	writeColumn(bin,col);
+      };
+      (writeOne(std::get<I>(getters)), ...);
+    }
+
+    template<class Row, class Getters, std::size_t... I>
+    bool readImpl(Cursor& cur, std::vector<Row>& rows, std::size_t nrow,
+		  Getters const&, std::index_sequence<I...>) {
+      std::tuple<std::vector<typename ColumnOf<
+	typename std::tuple_element<I,Getters>::type>::type>...> cols;
+      bool ok = true;
+      auto readOne = [&](auto& col) {
+	typedef typename std::decay<decltype(col)>::type::value_type T;
+	uint8_t code = 0;
+	if(!ok || !cur.get(code) || code!=TypeCode<T>::value) {
+	  ok = false;
+	  return;
+	}
+	col.resize(nrow);
+	ok = readColumn(cur,col);
+      };
+      (readOne(std::get<I>(cols)), ...);
+      if(!ok || !cur.atEnd()) return false;
+      rows.reserve(rows.size()+nrow);
+      for(std::size_t i=0; i<nrow; i++) {
+	rows.emplace_back(std::get<I>(cols)[i]...);
+      }
+      return true;
+    }
+
+    // append the binary form of rows to bin
+    template<class Row, class... G>
+    int write(std::string& bin, std::string const& name,
+	      std::vector<Row> const& rows, std::tuple<G...> const& getters) {
+      bin.append(magic,magicSize);
+      append(bin,uint32_t(name.size()));
+      bin.append(name);
+      append(bin,uint32_t(sizeof...(G)));
+      append(bin,uint64_t(rows.size()));
+      writeImpl(bin,rows,getters,std::index_sequence_for<G...>());
+      return 0;
+    }
+
+    // add the rows in bin to rows, return non-zero if bin is not
+    // a binary of this table, then rows is unchanged
+    template<class Row, class... G>
+    int read(std::string const& bin, std::string const& name,
+	     std::vector<Row>& rows, std::tuple<G...> const& getters) {
+      Cursor cur(bin);
+      char m[magicSize];
+      uint32_t nname = 0, ncol = 0;
+      uint64_t nrow = 0;
+      if(!cur.get(m,magicSize) || std::memcmp(m,magic,magicSize)!=0) return 1;
+      if(!cur.get(nname) || nname!=name.size()) return 1;
+      std::string bname(nname,' ');
+      if(!cur.get(&bname[0],nname) || bname!=name) return 1;
+      if(!cur.get(ncol) || ncol!=sizeof...(G)) return 1;
+      if(!cur.get(nrow) || nrow>bin.size()) return 1;
+      std::vector<Row> newRows;
+      if(!readImpl(cur,newRows,nrow,getters,std::index_sequence_for<G...>())) return 1;
+      if(rows.empty()) {
+	rows.swap(newRows);
+      } else {
+	rows.insert(rows.end(),std::make_move_iterator(newRows.begin()),
+		    std::make_move_iterator(newRows.end()));
+      }
+      return 0;
+    }
+
+  }
+
+}
+#endif
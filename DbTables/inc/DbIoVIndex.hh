@@ -0,0 +1,55 @@
+#ifndef DbTables_DbIoVIndex_hh
+#define DbTables_DbIoVIndex_hh
+//
+// An interval tree for the intervals of validity of one table.
+// The intervals are sorted by start and the sorted array is used as
+// an implicit balanced tree (the root of a range is its middle), with
+// the maximum end in each subtree, so a lookup only descends into
+// subtrees which can contain the point, O(log n + matches).
+// When intervals overlap, the first one added wins, as in a linear
+// search of the list in the order it was added.
+//
+
+#include <vector>
+#include <cstdint>
+#include "DbTables/inc/DbIoV.hh"
+
+namespace mu2e {
+
+  class DbIoVIndex {
+  public:
+
+    // add an interval, pos is returned by find, typically the
+    // position of the interval in the caller's list
+    void add(DbIoV const& iov, int pos);
+    // must be called after the last add, before find
+    void build();
+    // pos of the first interval added which contains run:subrun,
+    // -1 if none does
+    int find(uint32_t run, uint32_t subrun) const;
+
+    std::size_t size() const { return _entries.size(); }
+    void clear() { _entries.clear(); _maxEnd.clear(); }
+
+  private:
+
+    static uint64_t key(uint32_t run, uint32_t subrun) {
+      return (uint64_t(run)<<32) | subrun;
+    }
+
+    struct Entry {
+      uint64_t start;
+      uint64_t end;
+      int pos;
+    };
+
+    // fill _maxEnd for the subtree of range [lo,hi), return its max
+    uint64_t buildNode(std::size_t lo, std::size_t hi);
+    void findNode(std::size_t lo, std::size_t hi, uint64_t k, int& best) const;
+
+    std::vector<Entry> _entries; // sorted by start
+    std::vector<uint64_t> _maxEnd; // max end of the subtree at i
+  };
+
+}
+#endif
@@ -42,6 +42,12 @@ namespace mu2e {
     int fill(const std::string& csv, bool saveCsv=true);
     // in case table was filled with binary values, convert to csv
     int toCsv();
+    // the compact binary form (see DbBinary.hh), non-zero return 
+    // if this table does not provide one
+    virtual int toBinary(std::string& bin) const { return 1; }
+    // fill from the binary form, non-zero return if the table does not
+    // provide one or bin was written for another table definition
+    int fillBinary(const std::string& bin);
 
     // part of building content, convert list of strings to binary row
     virtual void addRow(const std::vector<std::string>& columns) =0;
@@ -51,6 +57,9 @@ namespace mu2e {
     virtual void clear() {}
 
   protected:
+    // part of fillBinary, add the rows in bin
+    virtual int addBinary(const std::string& bin) { return 1; }
+
     std::string _name;
     std::string _dbname;
     std::string _query;
@@ -7,6 +7,7 @@
 #include <sstream>
 #include <map>
 #include "DbTables/inc/DbTable.hh"
+#include "DbTables/inc/DbBinary.hh"
 
 namespace mu2e {
 
@@ -55,7 +56,16 @@ namespace mu2e {
 
     virtual void clear() { _csv.clear(); _rows.clear(); }
 
+    // columns in db order, for the binary form
+    static auto columns() {
+      return std::make_tuple(&Row::index,&Row::thresholdHv,
+			     &Row::thresholdCal); }
+    int toBinary(std::string& bin) const {
+      return DbBinary::write(bin,name(),_rows,columns()); }
+
   private:
+    int addBinary(const std::string& bin) {
+      return DbBinary::read(bin,name(),_rows,columns()); }
     std::vector<Row> _rows;
   };
   
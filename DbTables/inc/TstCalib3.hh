@@ -7,6 +7,7 @@
 #include <sstream>
 #include <map>
 #include "DbTables/inc/DbTable.hh"
+#include "DbTables/inc/DbBinary.hh"
 
 namespace mu2e {
 
@@ -89,7 +90,21 @@ namespace mu2e {
 
     virtual void clear() { _csv.clear(); _rows.clear(); _chanIndex.clear();}
 
+    // columns in db order, for the binary form
+    static auto columns() {
+      return std::make_tuple(&Row::channel,&Row::v0,&Row::v1,&Row::v2,
+			     &Row::v3,&Row::v4,&Row::v5,&Row::v6,
+			     &Row::v7,&Row::v8,&Row::v9); }
+    int toBinary(std::string& bin) const {
+      return DbBinary::write(bin,name(),_rows,columns()); }
+
   private:
+    int addBinary(const std::string& bin) {
+      int rc = DbBinary::read(bin,name(),_rows,columns());
+      if(rc!=0) return rc;
+      for(std::size_t i=0; i<_rows.size(); i++) _chanIndex[_rows[i].channel()] = i;
+      return 0;
+    }
     std::vector<Row> _rows;
     std::map<int,std::size_t> _chanIndex;
   };
@@ -0,0 +1,44 @@
+#include <algorithm>
+#include "DbTables/inc/DbIoVIndex.hh"
+
+void mu2e::DbIoVIndex::add(DbIoV const& iov, int pos) {
+  _entries.push_back({key(iov.startRun(),iov.startSubrun()),
+	key(iov.endRun(),iov.endSubrun()), pos});
+}
+
+void mu2e::DbIoVIndex::build() {
+  std::stable_sort(_entries.begin(), _entries.end(),
+		   [](Entry const& a, Entry const& b) { return a.start<b.start; });
+  _maxEnd.assign(_entries.size(),0);
+  buildNode(0,_entries.size());
+}
+
+uint64_t mu2e::DbIoVIndex::buildNode(std::size_t lo, std::size_t hi) {
+  if(lo>=hi) return 0;
+  std::size_t mid = lo + (hi-lo)/2;
+  uint64_t maxEnd = _entries[mid].end;
+  maxEnd = std::max(maxEnd,buildNode(lo,mid));
+  maxEnd = std::max(maxEnd,buildNode(mid+1,hi));
+  _maxEnd[mid] = maxEnd;
+  return maxEnd;
+}
+
+int mu2e::DbIoVIndex::find(uint32_t run, uint32_t subrun) const {
+  int best = -1;
+  findNode(0,_entries.size(),key(run,subrun),best);
+  return best;
+}
+
+void mu2e::DbIoVIndex::findNode(std::size_t lo, std::size_t hi, 
+				uint64_t k, int& best) const {
+  if(lo>=hi) return;
+  std::size_t mid = lo + (hi-lo)/2;
+  // nothing in this subtree reaches the point
+  if(_maxEnd[mid]<k) return;
+  findNode(lo,mid,k,best);
+  // this and the right subtree start after the point
+  if(_entries[mid].start>k) return;
+  auto const& e = _entries[mid];
+  if(e.end>=k && (best<0 || e.pos<best)) best = e.pos;
+  findNode(mid+1,hi,k,best);
+}
@@ -39,10 +39,31 @@ int mu2e::DbTable::fill(const std::string& csv, bool saveCsv) {
   return 0;
 }
 
+int mu2e::DbTable::fillBinary(const std::string& bin) {
+  int rc = addBinary(bin);
+  if(rc!=0) return rc;
+
+  if(nrowFix()>0 && nrow()!=nrowFix()) {
+    throw cet::exception("DBTABLE_BAD_ROW_COUNT") 
+      << "DbTable::fillBinary row count is "
+      << std::to_string(nrow()) << " but "
+      << std::to_string(nrowFix()) << " is required while filling "
+      << name();
+  }
+
+  // there is no text, toCsv will make it if needed
+  _csv.clear();
+
+  return 0;
+}
+
 int mu2e::DbTable::toCsv() {
   if(!_csv.empty()) return 0;
   std::ostringstream ss;
-  for(std::size_t i=0; i< nrow(); i++) rowToCsv(ss,i);
+  for(std::size_t i=0; i< nrow(); i++) {
+    rowToCsv(ss,i);
+    ss << "\n";
+  }
   _csv = ss.str();
   return 0;
 }
@@ -137,7 +137,10 @@ void mu2e::DbUtil::writeFile(std::string const& fn,
       myfile << tt.csv();
     } else {
       std::ostringstream ss;
-      for(std::size_t i=0; i< tt.nrow(); i++) tt.rowToCsv(ss,i);
+      for(std::size_t i=0; i< tt.nrow(); i++) {
+	tt.rowToCsv(ss,i);
+	ss << "\n";
+      }
       myfile << ss.str();
   //      DbTable ttnc = tt; // we get this as const..
   //  ttnc.toCsv();
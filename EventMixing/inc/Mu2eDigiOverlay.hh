@@ -0,0 +1,164 @@
+// Overlays a pre-digitized background frame onto the digis of a
+// signal event.  The frames are made once, by running the background
+// mixing and the digitizers without a primary (see
+// JobConfig/mixing/NoPrimary.fcl), and are then reused for any number
+// of signal events, so the cost of mixing does not depend on the
+// number of background steps.
+//
+// Digis from the same channel that overlap in time are merged the way
+// the electronics would have seen them:
+//
+//   StrawDigi: a digi starting within the dead time of an earlier one
+//     on the same straw is absorbed by it.  Each end keeps the earliest
+//     TDC, the TOT extends to the latest end of the two pulses, and the
+//     ADC waveforms are added above the pedestal.
+//
+//   CaloDigi: overlapping waveforms on the same readout are added
+//     sample by sample into a single digi covering both windows.
+//
+//   CrvDigi: a digi starting inside the sample window of an earlier
+//     one on the same SiPM is added above the pedestal into it.
+//
+// The MC collections (StrawDigiMC, CrvDigiMC) stay parallel to the
+// digis.  A merged digi keeps the MC of the earliest contribution;
+// the Ptrs of frame MC are remapped into the products mixed from the
+// frame by Mu2eProductMixer, which must therefore be configured for
+// the StrawGasSteps, StepPointMCs and SimParticles they point to.
+//
+// The digi mix operations must be declared before the MC ones, as the
+// MC mixing uses the decisions taken for the digis.
+
+#ifndef EventMixing_inc_Mu2eDigiOverlay_hh
+#define EventMixing_inc_Mu2eDigiOverlay_hh
+
+#include <string>
+#include <vector>
+
+#include "fhiclcpp/types/Atom.h"
+#include "fhiclcpp/types/OptionalTable.h"
+#include "fhiclcpp/types/Table.h"
+#include "canvas/Utilities/InputTag.h"
+
+#include "art/Framework/IO/ProductMix/MixHelper.h"
+
+#include "RecoDataProducts/inc/StrawDigiCollection.hh"
+#include "RecoDataProducts/inc/CaloDigiCollection.hh"
+#include "RecoDataProducts/inc/CrvDigiCollection.hh"
+#include "MCDataProducts/inc/StrawDigiMCCollection.hh"
+#include "MCDataProducts/inc/CrvDigiMCCollection.hh"
+
+namespace art { class Event; }
+
+//================================================================
+namespace mu2e {
+
+  class StrawElectronics;
+
+  class Mu2eDigiOverlay {
+  public:
+
+    // Configuration for overlaying one type of data products.
+    struct OverlayConfig {
+      fhicl::Atom<art::InputTag> frameTag { fhicl::Name("frameTag"),
+          fhicl::Comment("The collection in the background frame file.") };
+      fhicl::Atom<art::InputTag> signalTag { fhicl::Name("signalTag"),
+          fhicl::Comment("The collection in the signal event.") };
+      fhicl::Atom<std::string> outInstance { fhicl::Name("outInstance"),
+          fhicl::Comment("Instance name of the overlaid collection."), "" };
+    };
+
+    struct Config {
+      fhicl::OptionalTable<OverlayConfig> strawDigis { fhicl::Name("strawDigis") };
+      fhicl::OptionalTable<OverlayConfig> strawDigiMCs { fhicl::Name("strawDigiMCs") };
+      fhicl::OptionalTable<OverlayConfig> caloDigis { fhicl::Name("caloDigis") };
+      fhicl::OptionalTable<OverlayConfig> crvDigis { fhicl::Name("crvDigis") };
+      fhicl::OptionalTable<OverlayConfig> crvDigiMCs { fhicl::Name("crvDigiMCs") };
+
+      fhicl::Atom<double> caloDigiSampling { fhicl::Name("caloDigiSampling"),
+          fhicl::Comment("Calorimeter digitizer sampling period (ns), as in CaloDigiFromShower."), 5.0 };
+      fhicl::Atom<int> caloNBits { fhicl::Name("caloNBits"),
+          fhicl::Comment("Number of calorimeter digitizer bits, as in CaloDigiFromShower."), 12 };
+      fhicl::Atom<int> crvPedestal { fhicl::Name("crvPedestal"),
+          fhicl::Comment("CRV ADC pedestal, as in CrvDigitizer."), 100 };
+      fhicl::Atom<int> crvNBits { fhicl::Name("crvNBits"),
+          fhicl::Comment("Number of CRV digitizer bits; overlaid samples saturate at the largest ADC count."), 12 };
+    };
+
+    Mu2eDigiOverlay(const Config& conf, art::MixHelper& helper);
+
+    // Read the signal collections; to be called at the start of each event.
+    void startEvent(const art::Event& event, const StrawElectronics* strawele);
+
+    // The merging itself, exposed for use outside of a MixFilter.
+    // The source of output digi i is recorded in sources[i].
+    struct Source {
+      bool fromFrame;
+      size_t index;
+    };
+    typedef std::vector<Source> Sources;
+
+    static void overlayStrawDigis(const StrawDigiCollection& signal, const StrawDigiCollection& frame,
+                                  const StrawElectronics& strawele,
+                                  StrawDigiCollection& out, Sources& sources);
+
+    static void overlayCaloDigis(const CaloDigiCollection& signal, const CaloDigiCollection& frame,
+                                 double digiSampling, int maxADC,
+                                 CaloDigiCollection& out);
+
+    // merged[i] lists the inputs absorbed into output digi i, after sources[i]
+    static void overlayCrvDigis(const CrvDigiCollection& signal, const CrvDigiCollection& frame,
+                                int pedestal, unsigned maxADC,
+                                CrvDigiCollection& out, Sources& sources, std::vector<Sources>& merged);
+
+  private:
+
+    bool mixStrawDigis(std::vector<StrawDigiCollection const*> const& in,
+                       StrawDigiCollection& out,
+                       art::PtrRemapper const& remap);
+
+    bool mixStrawDigiMCs(std::vector<StrawDigiMCCollection const*> const& in,
+                         StrawDigiMCCollection& out,
+                         art::PtrRemapper const& remap);
+
+    bool mixCaloDigis(std::vector<CaloDigiCollection const*> const& in,
+                      CaloDigiCollection& out,
+                      art::PtrRemapper const& remap);
+
+    bool mixCrvDigis(std::vector<CrvDigiCollection const*> const& in,
+                     CrvDigiCollection& out,
+                     art::PtrRemapper const& remap);
+
+    bool mixCrvDigiMCs(std::vector<CrvDigiMCCollection const*> const& in,
+                       CrvDigiMCCollection& out,
+                       art::PtrRemapper const& remap);
+
+    // exactly one frame is overlaid on each signal event
+    template<class COLL> static COLL const& theFrame(std::vector<COLL const*> const& in);
+
+    art::InputTag strawDigiSignalTag_;
+    art::InputTag strawDigiMCSignalTag_;
+    art::InputTag caloDigiSignalTag_;
+    art::InputTag crvDigiSignalTag_;
+    art::InputTag crvDigiMCSignalTag_;
+
+    double caloDigiSampling_;
+    int caloMaxADC_;
+    int crvPedestal_;
+    unsigned crvMaxADC_;
+
+    // signal collections of the current event
+    const StrawDigiCollection* strawDigis_;
+    const StrawDigiMCCollection* strawDigiMCs_;
+    const CaloDigiCollection* caloDigis_;
+    const CrvDigiCollection* crvDigis_;
+    const CrvDigiMCCollection* crvDigiMCs_;
+    const StrawElectronics* strawele_;
+
+    Sources strawSources_;
+    Sources crvSources_;
+    std::vector<Sources> crvMerged_;
+  };
+
+}
+
+#endif/*EventMixing_inc_Mu2eDigiOverlay_hh*/
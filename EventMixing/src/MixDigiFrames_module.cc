@@ -0,0 +1,92 @@
+// This module overlays pre-digitized background frames, made without
+// a primary by the MixBackgroundFrames + digitization chain, onto the
+// digis of signal events.  One frame is read for each signal event;
+// use the art readMode parameter to pick the frames at random from
+// the frame files.  The digi merging is done by Mu2eDigiOverlay, the
+// compact MC truth stored with the frames is mixed by Mu2eProductMixer.
+//
+// Unlike MixBackgroundFrames, the cost per event does not depend on the
+// number of background steps, as the digitizers do not run again.
+
+#include <iostream>
+
+#include "art/Framework/Principal/Event.h"
+#include "art/Framework/Core/ModuleMacros.h"
+#include "art/Framework/IO/ProductMix/MixHelper.h"
+#include "art/Framework/Modules/MixFilter.h"
+#include "art_root_io/RootIOPolicy.h"
+
+#include "fhiclcpp/types/Atom.h"
+#include "fhiclcpp/types/Table.h"
+
+#include "EventMixing/inc/Mu2eProductMixer.hh"
+#include "EventMixing/inc/Mu2eDigiOverlay.hh"
+#include "ProditionsService/inc/ProditionsHandle.hh"
+#include "TrackerConditions/inc/StrawElectronics.hh"
+
+//================================================================
+namespace mu2e {
+
+  //----------------------------------------------------------------
+  // Our "detail" class for art/Framework/Modules/MixFilter.h
+  class MixDigiFramesDetail {
+    Mu2eProductMixer spm_;
+    Mu2eDigiOverlay overlay_;
+    const int debugLevel_;
+
+    ProditionsHandle<StrawElectronics> strawele_h_;
+
+  public:
+
+    struct Mu2eConfig {
+      using Name = fhicl::Name;
+      using Comment = fhicl::Comment;
+
+      fhicl::Table<Mu2eProductMixer::Config> products { Name("products"),
+          Comment("The MC truth products stored with the frames, mixed as in MixBackgroundFrames.\n"
+                  "The products pointed to by the StrawDigiMCs and CrvDigiMCs of the frames must be mixed here.")
+          };
+
+      fhicl::Table<Mu2eDigiOverlay::Config> digis { Name("digis"),
+          Comment("The digi collections to overlay, each with the tag of the collection in the frame\n"
+                  "and in the signal event.")
+          };
+
+      fhicl::Atom<int> debugLevel { Name("debugLevel"),
+          Comment("control the level of debug output"),
+          0
+          };
+    };
+
+    struct Config {
+      fhicl::Table<Mu2eConfig> mu2e { fhicl::Name("mu2e") };
+    };
+
+    using Parameters = art::MixFilterTable<Config>;
+    explicit MixDigiFramesDetail(const Parameters& pars, art::MixHelper& helper);
+
+    void startEvent(const art::Event& event);
+
+    size_t nSecondaries() { return 1; }
+
+  };
+
+  //================================================================
+  MixDigiFramesDetail::MixDigiFramesDetail(const Parameters& pars, art::MixHelper& helper)
+    : spm_{ pars().mu2e().products(), helper }
+    , overlay_{ pars().mu2e().digis(), helper }
+    , debugLevel_{ pars().mu2e().debugLevel() }
+  {}
+
+  //================================================================
+  void MixDigiFramesDetail::startEvent(const art::Event& event) {
+    overlay_.startEvent(event, &strawele_h_.get(event.id()));
+    if(debugLevel_ > 0) std::cout << " Overlaying a background frame on event " << event.id() << std::endl;
+  }
+
+  //================================================================
+  // This is the module class.
+  typedef art::MixFilter<MixDigiFramesDetail,art::RootIOPolicy> MixDigiFrames;
+}
+
+DEFINE_ART_MODULE(mu2e::MixDigiFrames);
@@ -0,0 +1,356 @@
+// Overlay of pre-digitized background frames onto signal digis.
+
+#include "EventMixing/inc/Mu2eDigiOverlay.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <tuple>
+
+#include "cetlib_except/exception.h"
+
+#include "art/Framework/Principal/Event.h"
+#include "art/Framework/Core/PtrRemapper.h"
+
+#include "TrackerConditions/inc/StrawElectronics.hh"
+
+//================================================================
+namespace mu2e {
+
+  //----------------------------------------------------------------
+  namespace {
+
+    // the earliest of the TDC values of the two ends
+    unsigned startTDC(const StrawDigi& digi) {
+      return std::min(digi.TDC()[StrawEnd::cal], digi.TDC()[StrawEnd::hv]);
+    }
+
+    template<class T>
+    art::Ptr<T> remapPtr(art::PtrRemapper const& remap, const art::Ptr<T>& ptr) {
+      return ptr.isNonnull() ? remap(ptr, 0) : ptr;
+    }
+
+    // An input digi, either from the signal event or from the frame
+    template<class DIGI>
+    struct Entry {
+      const DIGI* digi;
+      Mu2eDigiOverlay::Source src;
+    };
+
+    template<class DIGI, class LESS>
+    std::vector<Entry<DIGI> > sortedEntries(const std::vector<DIGI>& signal, const std::vector<DIGI>& frame, LESS less) {
+      std::vector<Entry<DIGI> > entries;
+      entries.reserve(signal.size() + frame.size());
+      for(size_t i=0; i<signal.size(); ++i) entries.push_back(Entry<DIGI>{&signal[i], {false, i}});
+      for(size_t i=0; i<frame.size(); ++i) entries.push_back(Entry<DIGI>{&frame[i], {true, i}});
+      std::stable_sort(entries.begin(), entries.end(),
+                       [&less](const Entry<DIGI>& a, const Entry<DIGI>& b) { return less(*a.digi, *b.digi); });
+      return entries;
+    }
+  }
+
+  //----------------------------------------------------------------
+  Mu2eDigiOverlay::Mu2eDigiOverlay(const Config& conf, art::MixHelper& helper)
+    : caloDigiSampling_(conf.caloDigiSampling())
+    , caloMaxADC_(1 << conf.caloNBits())
+    , crvPedestal_(conf.crvPedestal())
+    , crvMaxADC_((1u << conf.crvNBits()) - 1)
+    , strawDigis_(nullptr)
+    , strawDigiMCs_(nullptr)
+    , caloDigis_(nullptr)
+    , crvDigis_(nullptr)
+    , crvDigiMCs_(nullptr)
+    , strawele_(nullptr)
+  {
+    OverlayConfig oc;
+
+    // The MC mix operations use the decisions taken when mixing the digis, declare them last
+    if(conf.strawDigis(oc)) {
+      strawDigiSignalTag_ = oc.signalTag();
+      helper.declareMixOp(oc.frameTag(), oc.outInstance(), &Mu2eDigiOverlay::mixStrawDigis, *this);
+    }
+
+    if(conf.caloDigis(oc)) {
+      caloDigiSignalTag_ = oc.signalTag();
+      helper.declareMixOp(oc.frameTag(), oc.outInstance(), &Mu2eDigiOverlay::mixCaloDigis, *this);
+    }
+
+    if(conf.crvDigis(oc)) {
+      crvDigiSignalTag_ = oc.signalTag();
+      helper.declareMixOp(oc.frameTag(), oc.outInstance(), &Mu2eDigiOverlay::mixCrvDigis, *this);
+    }
+
+    if(conf.strawDigiMCs(oc)) {
+      if(strawDigiSignalTag_.empty()) {
+        throw cet::exception("CONFIG")<<"Mu2eDigiOverlay: strawDigiMCs can not be overlaid without strawDigis\n";
+      }
+      strawDigiMCSignalTag_ = oc.signalTag();
+      helper.declareMixOp(oc.frameTag(), oc.outInstance(), &Mu2eDigiOverlay::mixStrawDigiMCs, *this);
+    }
+
+    if(conf.crvDigiMCs(oc)) {
+      if(crvDigiSignalTag_.empty()) {
+        throw cet::exception("CONFIG")<<"Mu2eDigiOverlay: crvDigiMCs can not be overlaid without crvDigis\n";
+      }
+      crvDigiMCSignalTag_ = oc.signalTag();
+      helper.declareMixOp(oc.frameTag(), oc.outInstance(), &Mu2eDigiOverlay::mixCrvDigiMCs, *this);
+    }
+  }
+
+  //----------------------------------------------------------------
+  void Mu2eDigiOverlay::startEvent(const art::Event& event, const StrawElectronics* strawele) {
+    strawele_ = strawele;
+    strawDigis_ = strawDigiSignalTag_.empty() ? nullptr : event.getValidHandle<StrawDigiCollection>(strawDigiSignalTag_).product();
+    strawDigiMCs_ = strawDigiMCSignalTag_.empty() ? nullptr : event.getValidHandle<StrawDigiMCCollection>(strawDigiMCSignalTag_).product();
+    caloDigis_ = caloDigiSignalTag_.empty() ? nullptr : event.getValidHandle<CaloDigiCollection>(caloDigiSignalTag_).product();
+    crvDigis_ = crvDigiSignalTag_.empty() ? nullptr : event.getValidHandle<CrvDigiCollection>(crvDigiSignalTag_).product();
+    crvDigiMCs_ = crvDigiMCSignalTag_.empty() ? nullptr : event.getValidHandle<CrvDigiMCCollection>(crvDigiMCSignalTag_).product();
+
+    if(strawDigiMCs_ && strawDigiMCs_->size() != strawDigis_->size()) {
+      throw cet::exception("BADINPUT")<<"Mu2eDigiOverlay: signal StrawDigiMCs are not parallel to the StrawDigis\n";
+    }
+    if(crvDigiMCs_ && crvDigiMCs_->size() != crvDigis_->size()) {
+      throw cet::exception("BADINPUT")<<"Mu2eDigiOverlay: signal CrvDigiMCs are not parallel to the CrvDigis\n";
+    }
+  }
+
+  //----------------------------------------------------------------
+  template<class COLL>
+  COLL const& Mu2eDigiOverlay::theFrame(std::vector<COLL const*> const& in) {
+    if(in.size() != 1 || !in.front()) {
+      throw cet::exception("BADINPUT")<<"Mu2eDigiOverlay: expected one background frame per event, got "
+                                      <<in.size()<<"\n";
+    }
+    return *in.front();
+  }
+
+  //----------------------------------------------------------------
+  void Mu2eDigiOverlay::overlayStrawDigis(const StrawDigiCollection& signal, const StrawDigiCollection& frame,
+                                          const StrawElectronics& strawele,
+                                          StrawDigiCollection& out, Sources& sources)
+  {
+    auto entries = sortedEntries(signal, frame, [](const StrawDigi& a, const StrawDigi& b) {
+        return std::make_tuple(a.strawId().asUint16(), startTDC(a)) < std::make_tuple(b.strawId().asUint16(), startTDC(b));
+      });
+
+    const double tdcLSB = strawele.tdcLSB();
+    const double totLSB = strawele.totLSB();
+    const double deadTDC = std::max(strawele.deadTimeAnalog(), strawele.deadTimeDigital())/tdcLSB;
+
+    out.clear();
+    sources.clear();
+    out.reserve(entries.size());
+    sources.reserve(entries.size());
+
+    size_t i = 0;
+    while(i < entries.size()) {
+      const StrawDigi& first = *entries[i].digi;
+      const StrawId sid = first.strawId();
+      const int ped = strawele.ADCPedestal(sid);
+
+      TrkTypes::TDCValues tdc = first.TDC();
+      TrkTypes::TOTValues tot = first.TOT();
+      TrkTypes::ADCWaveform adc = first.adcWaveform();
+      StrawDigiFlag flag = first.digiFlag();
+
+      // the ADC is sampled relative to the cal end crossing of the first digi
+      const int refTDC = first.TDC()[StrawEnd::cal];
+
+      size_t j = i+1;
+      for(; j < entries.size() && entries[j].digi->strawId() == sid &&
+            startTDC(*entries[j].digi) < startTDC(first) + deadTDC; ++j) {
+        const StrawDigi& late = *entries[j].digi;
+
+        for(size_t iend=0; iend<StrawEnd::nends; ++iend) {
+          const double endTime = std::max(tdc[iend]*tdcLSB + tot[iend]*totLSB,
+                                          late.TDC()[iend]*tdcLSB + late.TOT()[iend]*totLSB);
+          tdc[iend] = std::min(tdc[iend], late.TDC()[iend]);
+          const long newTot = std::lround((endTime - tdc[iend]*tdcLSB)/totLSB);
+          tot[iend] = std::min<long>(newTot, strawele.maxTOT());
+        }
+
+        const long shift = std::lround((int(late.TDC()[StrawEnd::cal]) - refTDC)*tdcLSB/strawele.adcPeriod());
+        for(long isamp=0; isamp<long(adc.size()); ++isamp) {
+          const long isrc = isamp - shift;
+          if(isrc < 0 || isrc >= long(adc.size())) continue;
+          const long sum = long(adc[isamp]) + long(late.adcWaveform()[isrc]) - ped;
+          adc[isamp] = std::min<long>(std::max<long>(sum, 0), strawele.maxADC());
+        }
+
+        flag.merge(late.digiFlag());
+      }
+
+      out.emplace_back(sid, tdc, tot, adc);
+      out.back().digiFlag().merge(flag);
+      sources.push_back(entries[i].src);
+      i = j;
+    }
+  }
+
+  //----------------------------------------------------------------
+  void Mu2eDigiOverlay::overlayCaloDigis(const CaloDigiCollection& signal, const CaloDigiCollection& frame,
+                                         double digiSampling, int maxADC,
+                                         CaloDigiCollection& out)
+  {
+    auto entries = sortedEntries(signal, frame, [](const CaloDigi& a, const CaloDigi& b) {
+        return std::make_pair(a.roId(), a.t0()) < std::make_pair(b.roId(), b.t0());
+      });
+
+    out.clear();
+    out.reserve(entries.size());
+
+    size_t i = 0;
+    while(i < entries.size()) {
+      const CaloDigi& first = *entries[i].digi;
+      std::vector<int> waveform = first.waveform();
+      size_t peakpos = first.peakpos();
+      bool merged = false;
+
+      size_t j = i+1;
+      for(; j < entries.size() && entries[j].digi->roId() == first.roId() &&
+            entries[j].digi->t0() < first.t0() + waveform.size()*digiSampling; ++j) {
+        const CaloDigi& late = *entries[j].digi;
+        const size_t shift = std::lround((late.t0() - first.t0())/digiSampling);
+        if(waveform.size() < shift + late.waveform().size()) waveform.resize(shift + late.waveform().size(), 0);
+        for(size_t isamp=0; isamp<late.waveform().size(); ++isamp) {
+          waveform[shift+isamp] = std::min(waveform[shift+isamp] + late.waveform()[isamp], maxADC);
+        }
+        merged = true;
+      }
+
+      if(merged) {
+        peakpos = std::distance(waveform.begin(), std::max_element(waveform.begin(), waveform.end()));
+      }
+      out.emplace_back(first.roId(), first.t0(), waveform, peakpos);
+      i = j;
+    }
+  }
+
+  //----------------------------------------------------------------
+  void Mu2eDigiOverlay::overlayCrvDigis(const CrvDigiCollection& signal, const CrvDigiCollection& frame,
+                                        int pedestal, unsigned maxADC,
+                                        CrvDigiCollection& out, Sources& sources, std::vector<Sources>& merged)
+  {
+    auto entries = sortedEntries(signal, frame, [](const CrvDigi& a, const CrvDigi& b) {
+        return std::make_tuple(a.GetScintillatorBarIndex().asUint(), a.GetSiPMNumber(), a.GetStartTDC())
+          < std::make_tuple(b.GetScintillatorBarIndex().asUint(), b.GetSiPMNumber(), b.GetStartTDC());
+      });
+
+    out.clear();
+    sources.clear();
+    merged.clear();
+
+    size_t i = 0;
+    while(i < entries.size()) {
+      const CrvDigi& first = *entries[i].digi;
+      std::array<unsigned int, CrvDigi::NSamples> ADCs = first.GetADCs();
+      Sources absorbed;
+
+      // the samples of a later pulse after the end of the first window are lost, as in the readout
+      size_t j = i+1;
+      for(; j < entries.size() &&
+            entries[j].digi->GetScintillatorBarIndex() == first.GetScintillatorBarIndex() &&
+            entries[j].digi->GetSiPMNumber() == first.GetSiPMNumber() &&
+            entries[j].digi->GetStartTDC() < first.GetStartTDC() + CrvDigi::NSamples; ++j) {
+        const CrvDigi& late = *entries[j].digi;
+        const size_t shift = late.GetStartTDC() - first.GetStartTDC();
+        for(size_t isamp=0; isamp+shift<CrvDigi::NSamples; ++isamp) {
+          const int signalADC = int(late.GetADCs()[isamp]) - pedestal;
+          if(signalADC > 0) ADCs[isamp+shift] = std::min(ADCs[isamp+shift] + signalADC, maxADC);
+        }
+        absorbed.push_back(entries[j].src);
+      }
+
+      out.emplace_back(ADCs, first.GetStartTDC(), first.GetScintillatorBarIndex(), first.GetSiPMNumber());
+      sources.push_back(entries[i].src);
+      merged.push_back(absorbed);
+      i = j;
+    }
+  }
+
+  //----------------------------------------------------------------
+  bool Mu2eDigiOverlay::mixStrawDigis(std::vector<StrawDigiCollection const*> const& in,
+                                      StrawDigiCollection& out,
+                                      art::PtrRemapper const&)
+  {
+    overlayStrawDigis(*strawDigis_, theFrame(in), *strawele_, out, strawSources_);
+    return true;
+  }
+
+  //----------------------------------------------------------------
+  bool Mu2eDigiOverlay::mixStrawDigiMCs(std::vector<StrawDigiMCCollection const*> const& in,
+                                        StrawDigiMCCollection& out,
+                                        art::PtrRemapper const& remap)
+  {
+    const StrawDigiMCCollection& frame = theFrame(in);
+
+    out.reserve(strawSources_.size());
+    for(const auto& src : strawSources_) {
+      if(!src.fromFrame) {
+        out.push_back(strawDigiMCs_->at(src.index));
+      } else {
+        const StrawDigiMC& mc = frame.at(src.index);
+        StrawDigiMC::SGSPA sgspa;
+        for(size_t iend=0; iend<StrawEnd::nends; ++iend) {
+          sgspa[iend] = remapPtr(remap, mc.strawGasSteps()[iend]);
+        }
+        out.emplace_back(mc, sgspa);
+      }
+    }
+    return true;
+  }
+
+  //----------------------------------------------------------------
+  bool Mu2eDigiOverlay::mixCaloDigis(std::vector<CaloDigiCollection const*> const& in,
+                                     CaloDigiCollection& out,
+                                     art::PtrRemapper const&)
+  {
+    overlayCaloDigis(*caloDigis_, theFrame(in), caloDigiSampling_, caloMaxADC_, out);
+    return true;
+  }
+
+  //----------------------------------------------------------------
+  bool Mu2eDigiOverlay::mixCrvDigis(std::vector<CrvDigiCollection const*> const& in,
+                                    CrvDigiCollection& out,
+                                    art::PtrRemapper const&)
+  {
+    overlayCrvDigis(*crvDigis_, theFrame(in), crvPedestal_, crvMaxADC_, out, crvSources_, crvMerged_);
+    return true;
+  }
+
+  //----------------------------------------------------------------
+  bool Mu2eDigiOverlay::mixCrvDigiMCs(std::vector<CrvDigiMCCollection const*> const& in,
+                                      CrvDigiMCCollection& out,
+                                      art::PtrRemapper const& remap)
+  {
+    const CrvDigiMCCollection& frame = theFrame(in);
+
+    auto stepsOf = [&](const Source& src, std::vector<art::Ptr<StepPointMC> >& steps) {
+      if(!src.fromFrame) {
+        const auto& orig = crvDigiMCs_->at(src.index).GetStepPoints();
+        steps.insert(steps.end(), orig.begin(), orig.end());
+      } else {
+        for(const auto& step : frame.at(src.index).GetStepPoints()) steps.push_back(remapPtr(remap, step));
+      }
+    };
+
+    out.reserve(crvSources_.size());
+    for(size_t i=0; i<crvSources_.size(); ++i) {
+      const Source& src = crvSources_[i];
+      const CrvDigiMC& mc = src.fromFrame ? frame.at(src.index) : crvDigiMCs_->at(src.index);
+
+      std::vector<art::Ptr<StepPointMC> > steps;
+      stepsOf(src, steps);
+      for(const auto& absorbed : crvMerged_[i]) stepsOf(absorbed, steps);
+
+      art::Ptr<SimParticle> sim = src.fromFrame ? remapPtr(remap, mc.GetSimParticle()) : mc.GetSimParticle();
+
+      out.emplace_back(mc.GetVoltages(), steps, sim, mc.GetStartTime(),
+                       mc.GetScintillatorBarIndex(), mc.GetSiPMNumber());
+    }
+    return true;
+  }
+
+  //----------------------------------------------------------------
+
+}
+//================================================================
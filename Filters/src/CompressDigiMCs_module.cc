@@ -41,6 +41,7 @@
 #include "MCDataProducts/inc/SimParticleTimeMap.hh"
 #include "MCDataProducts/inc/SimParticleRemapping.hh"
 #include "DataProducts/inc/IndexMap.hh"
+#include "GeneralUtilities/inc/OpenHashMap.hh"
 #include "MCDataProducts/inc/CaloClusterMC.hh"
 #include "MCDataProducts/inc/CrvCoincidenceClusterMCCollection.hh"
 #include "MCDataProducts/inc/PrimaryParticle.hh"
@@ -49,39 +50,45 @@
 namespace mu2e {
   class CompressDigiMCs;
 
-  typedef std::set<art::Ptr<SimParticle> > SimParticleSet;
+  // art::Ptrs are identified by ProductID and key, as in std::map<art::Ptr<T>,...>
+  struct PtrHash {
+    template<class T> std::size_t operator()(const art::Ptr<T>& ptr) const {
+      return (std::size_t(ptr.id().value()) << 40) ^ ptr.key();
+    }
+  };
+  struct PtrEqual {
+    template<class T> bool operator()(const art::Ptr<T>& a, const art::Ptr<T>& b) const {
+      return a.id() == b.id() && a.key() == b.key();
+    }
+  };
+  struct KeyHash {
+    std::size_t operator()(const cet::map_vector_key& key) const { return key.asUint(); }
+  };
+
+  // The SimParticles to keep, mapped to their Ptrs in the new collection once that
+  // has been made.  A SimParticle is only ever added together with all its parents.
+  typedef OpenHashMap<art::Ptr<SimParticle>, art::Ptr<SimParticle>, PtrHash, PtrEqual> SimParticleRemap;
 
   class SimParticleSelector {
   public:
-    SimParticleSelector(const SimParticleSet& simPartSet) {
-      for (const auto& i_simPart : simPartSet) {
-        cet::map_vector_key key = cet::map_vector_key(i_simPart.key());
-        m_keys.insert(key);
-      }
+    SimParticleSelector(const SimParticleRemap& simPartsToKeep, const art::ProductID& productID) :
+      m_simPartsToKeep(simPartsToKeep), m_productID(productID) {
     }
 
     bool operator[]( cet::map_vector_key key ) const {
-      return m_keys.find(key) != m_keys.end();
-    }
-
-    const std::set<cet::map_vector_key>& keys() const {
-      return m_keys;
-    }
-
-    void clear() {
-      m_keys.clear();
+      return m_simPartsToKeep.find(art::Ptr<SimParticle>(m_productID, key.asUint(), nullptr)) != nullptr;
     }
 
   private:
-    std::set<cet::map_vector_key> m_keys;
+    const SimParticleRemap& m_simPartsToKeep;
+    art::ProductID m_productID;
 
   };
 
-  typedef std::map<art::Ptr<mu2e::CaloShowerStep>, art::Ptr<mu2e::CaloShowerStep> > CaloShowerStepRemap;
+  typedef OpenHashMap<art::Ptr<mu2e::CaloShowerStep>, art::Ptr<mu2e::CaloShowerStep>, PtrHash, PtrEqual> CaloShowerStepRemap;
   typedef std::string InstanceLabel;
-  typedef std::map<cet::map_vector_key, cet::map_vector_key> KeyRemap;
-  typedef std::map<art::Ptr<mu2e::StepPointMC>, art::Ptr<mu2e::StepPointMC> > StepPointMCRemap;
-  typedef std::map<art::Ptr<mu2e::StrawGasStep>, art::Ptr<mu2e::StrawGasStep> > StrawGasStepRemap;
+  typedef OpenHashMap<cet::map_vector_key, cet::map_vector_key, KeyHash> SimParticleKeyRemap;
+  typedef OpenHashMap<art::Ptr<mu2e::StepPointMC>, art::Ptr<mu2e::StepPointMC>, PtrHash, PtrEqual> StepPointMCRemap;
 }
 
 
@@ -160,7 +167,9 @@ private:
   std::map<art::ProductID, const art::EDProductGetter*> _oldCaloShowerStepGetter;
 
   // record the SimParticles that we are keeping so we can use compressSimParticleCollection to do all the work for us
-  std::map<art::ProductID, SimParticleSet> _simParticlesToKeep;
+  SimParticleRemap _simParticlesToKeep;
+  SimParticleKeyRemap _keyRemap;
+  CaloShowerStepRemap _caloShowerStepRemap;
 
   InstanceLabel _crvOutputInstanceLabel;
   std::vector<InstanceLabel> _newStepPointMCInstances;
@@ -189,9 +198,8 @@ private:
 
   // For CrvDigiMCs, there's a chance that the same StepPointMC will go into multiple CrvDigiMCs
   // This module didn't take this into account initially and so the same StepPointMC was being written out multiple times
-  // This std::set is used to make sure that this doesn't happen
-  std::set<art::Ptr<StepPointMC> > _crvStepPointMCsSeen;
-  std::map<art::Ptr<StepPointMC>, art::Ptr<StepPointMC> > _crvStepPointMCsMap;
+  // This map from the old to the new StepPointMCs is used to make sure that this doesn't happen
+  StepPointMCRemap _crvStepPointMCsMap;
 };
 
 
@@ -286,13 +294,12 @@ void mu2e::CompressDigiMCs::produce(art::Event & event)
   // Create all the new collections, ProductIDs and product getters for the SimParticles and GenParticles
   // There is one for each background frame plus one for the primary event
   unsigned int n_gen_particles_to_keep = 0;
+  _simParticlesToKeep.clear();
   for (std::vector<art::InputTag>::const_iterator i_tag = _simParticleTags.begin(); i_tag != _simParticleTags.end(); ++i_tag) {
     const auto& oldSimParticles = event.getValidHandle<SimParticleCollection>(*i_tag);
     art::ProductID i_product_id = oldSimParticles.id();
     const art::EDProductGetter* i_product_getter = event.productGetter(i_product_id);
 
-    _simParticlesToKeep[i_product_id].clear();
-
     if (_keepAllGenParticles) {
       // Add all the SimParticles that are also GenParticles
       for (const auto& i_oldSimParticle : *oldSimParticles) {
@@ -378,7 +385,6 @@ void mu2e::CompressDigiMCs::produce(art::Event & event)
 
 
   if (_crvDigiMCTag != "") {
-    _crvStepPointMCsSeen.clear();
     _crvStepPointMCsMap.clear();
 
     event.getByLabel(_crvDigiMCTag, _crvDigiMCsHandle);
@@ -404,7 +410,8 @@ void mu2e::CompressDigiMCs::produce(art::Event & event)
   // Two possible compressions for calorimeter
   // The first just takes the CaloShowerSteps, CaloShowerSims and CaloShowerStepROs and reassigns Ptrs (i.e. no actual compression....)
   if (_caloClusterMCTag == "") {
-    CaloShowerStepRemap caloShowerStepRemap;
+    CaloShowerStepRemap& caloShowerStepRemap = _caloShowerStepRemap;
+    caloShowerStepRemap.clear();
     _newCaloShowerSteps = std::unique_ptr<CaloShowerStepCollection>(new CaloShowerStepCollection);
     _newCaloShowerStepsPID = event.getProductID<CaloShowerStepCollection>();
     _newCaloShowerStepGetter = event.productGetter(_newCaloShowerStepsPID);
@@ -416,7 +423,7 @@ void mu2e::CompressDigiMCs::produce(art::Event & event)
       for (CaloShowerStepCollection::const_iterator i_caloShowerStep = oldCaloShowerSteps->begin(); i_caloShowerStep != oldCaloShowerSteps->end(); ++i_caloShowerStep) {
         art::Ptr<mu2e::CaloShowerStep> oldShowerStepPtr(i_product_id,  i_caloShowerStep - oldCaloShowerSteps->begin(), _oldCaloShowerStepGetter[i_product_id]);
         art::Ptr<mu2e::CaloShowerStep> newShowerStepPtr = copyCaloShowerStep(*i_caloShowerStep);
-        caloShowerStepRemap[oldShowerStepPtr] = newShowerStepPtr;
+        caloShowerStepRemap.insert(std::make_pair(oldShowerStepPtr, newShowerStepPtr)).first->second = newShowerStepPtr;
       }
     }
 
@@ -460,49 +467,47 @@ void mu2e::CompressDigiMCs::produce(art::Event & event)
   for (std::vector<art::InputTag>::const_iterator i_tag = _extraStepPointMCTags.begin(); i_tag != _extraStepPointMCTags.end(); ++i_tag) {
     const auto& stepPointMCs = event.getValidHandle<StepPointMCCollection>(*i_tag);
     for (const auto& stepPointMC : *stepPointMCs) {
-      for (const auto& simPartsToKeep : _simParticlesToKeep) {
-        const art::ProductID& oldProdID = simPartsToKeep.first;
-        if (stepPointMC.simParticle().id() != oldProdID) {
-          continue;
-        }
-        const SimParticleSet& alreadyKeptSimParts = simPartsToKeep.second;
-        for (const auto& alreadyKeptSimPart : alreadyKeptSimParts) {
-          if (stepPointMC.simParticle() == alreadyKeptSimPart) {
-            copyStepPointMC(stepPointMC, (*i_tag).instance() );
-          }
-        }
+      if (_simParticlesToKeep.find(stepPointMC.simParticle())) {
+        copyStepPointMC(stepPointMC, (*i_tag).instance() );
       }
     }
   }
 
   // Now compress the SimParticleCollections into their new collections
-  KeyRemap* keyRemap = new KeyRemap;
-  SimParticleRemapping remap;
+  // and fill in the new Ptrs of the kept SimParticles
+  SimParticleRemap& remap = _simParticlesToKeep;
   unsigned int keep_size = 0;
   for (std::vector<art::InputTag>::const_iterator i_tag = _simParticleTags.begin(); i_tag != _simParticleTags.end(); ++i_tag) {
-    keyRemap->clear();
+    _keyRemap.clear();
     const auto& oldSimParticles = event.getValidHandle<SimParticleCollection>(*i_tag);
     art::ProductID i_product_id = oldSimParticles.id();
-    SimParticleSelector simPartSelector(_simParticlesToKeep[i_product_id]);
-    keep_size += _simParticlesToKeep[i_product_id].size();
+    SimParticleSelector simPartSelector(_simParticlesToKeep, i_product_id);
     if (_rekeySimParticleCollection) {
       compressSimParticleCollection(_newSimParticlesPID, _newSimParticleGetter, *oldSimParticles,
-                                    simPartSelector, *_newSimParticles, keyRemap);
+                                    simPartSelector, *_newSimParticles, &_keyRemap);
     }
     else {
       compressSimParticleCollection(_newSimParticlesPID, _newSimParticleGetter, *oldSimParticles,
                                     simPartSelector, *_newSimParticles);
     }
 
-    // Fill out the SimParticleRemapping
-    for (const auto& i_keptSimPart : _simParticlesToKeep[i_product_id]) {
-      cet::map_vector_key oldKey = cet::map_vector_key(i_keptSimPart.key());
-      cet::map_vector_key newKey = oldKey;
-      if (_rekeySimParticleCollection) {
-        newKey = keyRemap->at(oldKey);
-      }
-      remap[i_keptSimPart] = art::Ptr<SimParticle>(_newSimParticlesPID, newKey.asUint(), _newSimParticleGetter);
-    }
+    // Fill out the SimParticle remapping
+    remap.forEach([&](SimParticleRemap::value_type& i_keptSimPart) {
+        if (i_keptSimPart.first.id() != i_product_id) {
+          return;
+        }
+        ++keep_size;
+        cet::map_vector_key oldKey = cet::map_vector_key(i_keptSimPart.first.key());
+        cet::map_vector_key newKey = oldKey;
+        if (_rekeySimParticleCollection) {
+          newKey = _keyRemap.at(oldKey);
+        }
+        i_keptSimPart.second = art::Ptr<SimParticle>(_newSimParticlesPID, newKey.asUint(), _newSimParticleGetter);
+      });
+  }
+  if (keep_size != remap.size()) {
+    throw cet::exception("CompressDigiMCs") << "Some of the SimParticles we wanted to keep are not in the simParticleTags collections ("
+                                            << remap.size() - keep_size << " SimParticles)" << std::endl;
   }
   if (keep_size != _newSimParticles->size()) {
     throw cet::exception("CompressDigiMCs") << "Number of SimParticles in output collection ("
@@ -535,8 +540,8 @@ void mu2e::CompressDigiMCs::produce(art::Event & event)
     SimParticleTimeMap& i_newTimeMap = *_newSimParticleTimeMaps.at(i_element);
     for (const auto& timeMapPair : i_oldTimeMap) {
       art::Ptr<SimParticle> oldSimPtr = timeMapPair.first;
-      const auto& newSimPtrIter = remap.find(oldSimPtr);
-      if (newSimPtrIter != remap.end()) {
+      const auto newSimPtrIter = remap.find(oldSimPtr);
+      if (newSimPtrIter) {
         art::Ptr<SimParticle> newSimPtr = newSimPtrIter->second;
         i_newTimeMap[newSimPtr] = timeMapPair.second;
       }
@@ -615,8 +620,9 @@ void mu2e::CompressDigiMCs::produce(art::Event & event)
   if (_mcTrajectoryTag != "") {
     for (const auto& i_mcTrajectory : *_mcTrajectoriesHandle) {
       art::Ptr<SimParticle> oldSimPtr = i_mcTrajectory.first;
-      if (remap.find(oldSimPtr) != remap.end()) {
-        _newMCTrajectories->insert(std::pair<art::Ptr<SimParticle>, mu2e::MCTrajectory>(remap.at(oldSimPtr), i_mcTrajectory.second));
+      const auto newSimPtrIter = remap.find(oldSimPtr);
+      if (newSimPtrIter) {
+        _newMCTrajectories->insert(std::pair<art::Ptr<SimParticle>, mu2e::MCTrajectory>(newSimPtrIter->second, i_mcTrajectory.second));
       }
     }
   }
@@ -664,25 +670,26 @@ void mu2e::CompressDigiMCs::produce(art::Event & event)
 
 void mu2e::CompressDigiMCs::copyStrawDigiMC(const mu2e::StrawDigiMC& old_straw_digi_mc) {
 
-  StrawGasStepRemap step_remap;
-
   // Need to update the Ptrs for the StepPointMCs
+  // The ends usually share a StrawGasStep, which is copied only once
   StrawDigiMC::SGSPA newTriggerStepPtr;
   for(int i_end=0;i_end<StrawEnd::nends;++i_end){
     StrawEnd::End end = static_cast<StrawEnd::End>(i_end);
 
     const auto& old_step_point = old_straw_digi_mc.strawGasStep(end);
-    const auto& newStepPtrIter = step_remap.find(old_step_point);
-    if (newStepPtrIter == step_remap.end()) {
-      if (old_step_point.isAvailable()) {
-	step_remap[old_step_point] = copyStrawGasStep( *old_step_point);
-      }
-      else { // this is a null Ptr but it should be added anyway to keep consistency (not expected for StrawDigis)
-	step_remap[old_step_point] = old_step_point;
-      }
+    int j_end = 0;
+    while (j_end < i_end && !PtrEqual()(old_straw_digi_mc.strawGasStep(static_cast<StrawEnd::End>(j_end)), old_step_point)) {
+      ++j_end;
+    }
+    if (j_end < i_end) {
+      newTriggerStepPtr[i_end] = newTriggerStepPtr[j_end];
+    }
+    else if (old_step_point.isAvailable()) {
+      newTriggerStepPtr[i_end] = copyStrawGasStep( *old_step_point);
+    }
+    else { // this is a null Ptr but it should be added anyway to keep consistency (not expected for StrawDigis)
+      newTriggerStepPtr[i_end] = old_step_point;
     }
-    art::Ptr<StrawGasStep> new_step_point = step_remap.at(old_step_point);
-    newTriggerStepPtr[i_end] = new_step_point;
   }
   StrawDigiMC new_straw_digi_mc(old_straw_digi_mc, newTriggerStepPtr); // copy everything except the Ptrs from the old StrawDigiMC
   _newStrawDigiMCs->push_back(new_straw_digi_mc);
@@ -694,14 +701,11 @@ void mu2e::CompressDigiMCs::copyCrvDigiMC(const mu2e::CrvDigiMC& old_crv_digi_mc
   std::vector<art::Ptr<StepPointMC> > newStepPtrs;
   for (const auto& i_step_mc : old_crv_digi_mc.GetStepPoints()) {
     if (i_step_mc.isAvailable()) {
-      if (_crvStepPointMCsSeen.insert(i_step_mc).second == true) { // if we have inserted this StepPointMCPtrs (i.e. it hasn't already been seen)
-        art::Ptr<StepPointMC> newStepPtr = copyStepPointMC(*i_step_mc, _crvOutputInstanceLabel);
-        newStepPtrs.push_back(newStepPtr);
-        _crvStepPointMCsMap[i_step_mc] = newStepPtr;
-      }
-      else {
-        newStepPtrs.push_back(_crvStepPointMCsMap.at(i_step_mc));
+      auto inserted = _crvStepPointMCsMap.insert(std::make_pair(i_step_mc, art::Ptr<StepPointMC>()));
+      if (inserted.second == true) { // if we have inserted this StepPointMCPtrs (i.e. it hasn't already been seen)
+        inserted.first->second = copyStepPointMC(*i_step_mc, _crvOutputInstanceLabel);
       }
+      newStepPtrs.push_back(inserted.first->second);
     }
     else { // this is a null Ptr but it should be added anyway to keep consistency (expected for CrvDigis)
       newStepPtrs.push_back(i_step_mc);
@@ -813,14 +817,15 @@ art::Ptr<mu2e::StrawGasStep> mu2e::CompressDigiMCs::copyStrawGasStep(const mu2e:
 
 void mu2e::CompressDigiMCs::keepSimParticle(const art::Ptr<SimParticle>& sim_ptr) {
 
-  // Also need to add all the parents too
-  _simParticlesToKeep[sim_ptr.id()].insert(sim_ptr);
-  art::Ptr<SimParticle> childPtr = sim_ptr;
-  art::Ptr<SimParticle> parentPtr = childPtr->parent();
+  // Also need to add all the parents too. A SimParticle that is already
+  // kept was added with all its parents, so we can stop at the first one.
+  // The new Ptrs are filled in after the compression.
+  if (!_simParticlesToKeep.insert(std::make_pair(sim_ptr, art::Ptr<SimParticle>())).second) {
+    return;
+  }
+  art::Ptr<SimParticle> parentPtr = sim_ptr->parent();
 
-  while (parentPtr) {
-    _simParticlesToKeep[sim_ptr.id()].insert(parentPtr);
-    childPtr = parentPtr;
+  while (parentPtr && _simParticlesToKeep.insert(std::make_pair(parentPtr, art::Ptr<SimParticle>())).second) {
     parentPtr = parentPtr->parent();
   }
 }
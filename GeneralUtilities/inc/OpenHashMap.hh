@@ -0,0 +1,142 @@
+//
+// A hash map with open addressing and linear probing, for the tables
+// that are filled and thrown away in every event, such as the remaps of
+// the compression modules.  All entries live in one array, so inserts
+// and lookups do not allocate; clear() keeps the array for the next
+// event.  There is no erase.
+//
+// The interface follows the parts of std::map that such code uses,
+// except that find() returns a pointer to the entry, or nullptr:
+//
+//   OpenHashMap<Key,Value,Hash,Equal> remap;
+//   auto res = remap.insert(std::make_pair(oldKey,newKey));  // res.first->second, res.second
+//   if (auto entry = remap.find(oldKey)) ...
+//
+// The result of Hash is mixed before use, so it can be as simple as
+// returning an integer key.  Key and Value must be default
+// constructible.  Pointers to entries are invalidated by an insert
+// that grows the table.
+//
+#ifndef GeneralUtilities_OpenHashMap_hh
+#define GeneralUtilities_OpenHashMap_hh
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace mu2e {
+
+  template<class Key, class Value, class Hash = std::hash<Key>, class Equal = std::equal_to<Key> >
+  class OpenHashMap {
+  public:
+    typedef std::pair<Key,Value> value_type;
+
+    explicit OpenHashMap(std::size_t capacity = 64) : _size(0) { rehash(capacity); }
+
+    // insert if the key is not there yet; as std::map::insert
+    std::pair<value_type*,bool> insert(const value_type& value) {
+      std::size_t i = slot(value.first);
+      if (_used[i]) return std::make_pair(&_entries[i],false);
+      if (2*(_size+1) > _entries.size()) {
+        rehash(2*_entries.size());
+        i = slot(value.first);
+      }
+      _entries[i] = value;
+      _used[i] = 1;
+      ++_size;
+      return std::make_pair(&_entries[i],true);
+    }
+
+    value_type* find(const Key& key) {
+      std::size_t i = slot(key);
+      return _used[i] ? &_entries[i] : nullptr;
+    }
+    const value_type* find(const Key& key) const {
+      std::size_t i = slot(key);
+      return _used[i] ? &_entries[i] : nullptr;
+    }
+
+    // as std::map::at, throws std::out_of_range
+    Value& at(const Key& key) {
+      value_type* entry = find(key);
+      if (!entry) throw std::out_of_range("OpenHashMap::at");
+      return entry->second;
+    }
+    const Value& at(const Key& key) const {
+      const value_type* entry = find(key);
+      if (!entry) throw std::out_of_range("OpenHashMap::at");
+      return entry->second;
+    }
+
+    // call f(value_type&) for every entry, in no particular order
+    template<class F> void forEach(F f) {
+      for (std::size_t i = 0; i < _entries.size(); ++i) {
+        if (_used[i]) f(_entries[i]);
+      }
+    }
+    template<class F> void forEach(F f) const {
+      for (std::size_t i = 0; i < _entries.size(); ++i) {
+        if (_used[i]) f(_entries[i]);
+      }
+    }
+
+    std::size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+
+    // remove all entries, keeping the memory
+    void clear() {
+      if (_size == 0) return;
+      std::fill(_used.begin(),_used.end(),0);
+      _size = 0;
+    }
+
+  private:
+    std::vector<value_type> _entries;
+    std::vector<unsigned char> _used;
+    std::size_t _size;
+    std::size_t _mask;
+    Hash _hash;
+    Equal _equal;
+
+    // the slot that holds key, or the empty slot where it would go
+    std::size_t slot(const Key& key) const {
+      std::size_t i = mix(_hash(key)) & _mask;
+      while (_used[i] && !_equal(_entries[i].first,key)) i = (i+1) & _mask;
+      return i;
+    }
+
+    // finalizer of splitmix64, so that consecutive keys spread over the table
+    static std::size_t mix(std::uint64_t h) {
+      h ^= h >> 30;
+      h *= 0xbf58476d1ce4e5b9ULL;
+      h ^= h >> 27;
+      h *= 0x94d049bb133111ebULL;
+      h ^= h >> 31;
+      return h;
+    }
+
+    // capacity is rounded up to a power of two
+    void rehash(std::size_t capacity) {
+      std::size_t n = 8;
+      while (n < capacity) n *= 2;
+      std::vector<value_type> entries(n);
+      std::vector<unsigned char> used(n,0);
+      entries.swap(_entries);
+      used.swap(_used);
+      _mask = n-1;
+      for (std::size_t i = 0; i < entries.size(); ++i) {
+        if (used[i]) {
+          std::size_t j = slot(entries[i].first);
+          _entries[j] = std::move(entries[i]);
+          _used[j] = 1;
+        }
+      }
+    }
+  };
+
+}
+#endif
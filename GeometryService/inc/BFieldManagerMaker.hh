@@ -44,6 +44,9 @@ namespace mu2e {
         // Hold the object while we are creating it. The GeometryService will take ownership.
         std::unique_ptr<BFieldManager> _bfmgr;
 
+        // Verify the checksum of .bfmap files when opening them.
+        bool _verifyMapChecksum;
+
         // Hold the types of the inner and outer maps (if they differ)
         std::vector<BFMapType> _innerTypes;
         std::vector<BFMapType> _outerTypes;
@@ -93,6 +96,9 @@ namespace mu2e {
         // Write an existing BFMap in binary format.
         void writeG4BLBinary(const BFGridMap& bf, const std::string& outputfile);
 
+        // Write an existing BFMap in the mmap-able format described in BFMapFile.hh.
+        void writeMappedMap(const BFGridMap& bf, const std::string& outputfile);
+
         // Compute the size of the array needed to hold the raw data of the field map.
         int computeArraySize(int fd, const std::string& filename);
 
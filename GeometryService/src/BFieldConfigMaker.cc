@@ -43,6 +43,13 @@ namespace mu2e {
     BFieldConfigMaker::BFieldConfigMaker(const SimpleConfig& config, const Beamline& beamg)
         : bfconf_(new BFieldConfig()) {
         bfconf_->writeBinaries_ = config.getBool("bfield.writeG4BLBinaries", false);
+        bfconf_->writeMappedMaps_ = config.getBool("bfield.writeMappedMaps", false);
+        bfconf_->verifyMapChecksum_ = config.getBool("bfield.verifyMapChecksum", false);
+        bfconf_->tabulateParamMaps_ = config.getBool("bfield.tabulateParamMaps", false);
+        bfconf_->paramTableSpacing_ = config.getDouble("bfield.paramTableSpacing", 50.);
+        bfconf_->paramTableMaxError_ = config.getDouble("bfield.paramTableMaxError", 1.e-3);
+        bfconf_->paramTableMaxLevels_ = config.getInt("bfield.paramTableMaxLevels", 3);
+        bfconf_->paramTableMaxRadius_ = config.getDouble("bfield.paramTableMaxRadius", 800.);
         bfconf_->verbosityLevel_ = config.getInt("bfield.verbosityLevel");
         bfconf_->flipBFieldMaps_ = config.getBool("bfield.flipMaps", false);
 
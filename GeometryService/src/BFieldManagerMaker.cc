@@ -33,6 +33,7 @@
 
 // Includes from Mu2e
 #include "BFieldGeom/inc/BFInterpolationStyle.hh"
+#include "BFieldGeom/inc/BFMapFile.hh"
 #include "BFieldGeom/inc/BFieldConfig.hh"
 #include "BFieldGeom/inc/BFieldManager.hh"
 #include "BFieldGeom/inc/DiskRecord.hh"
@@ -84,7 +85,9 @@ namespace mu2e {
     }
 
     BFieldManagerMaker::BFieldManagerMaker(const BFieldConfig& config)
-        : _resolveFullPath(), _bfmgr(new BFieldManager()) {
+        : _resolveFullPath(),
+          _bfmgr(new BFieldManager()),
+          _verifyMapChecksum(config.verifyMapChecksum()) {
         bfieldVerbosityLevel = config.verbosityLevel();
 
         // break potential mapTypeList into two vectors... kind of ugly right now.
@@ -153,6 +156,45 @@ namespace mu2e {
             }
         }
 
+        if (config.writeMappedMaps()) {
+            for (auto maps : {&_bfmgr->innerMaps_, &_bfmgr->outerMaps_}) {
+                for (auto const& m : *maps) {
+                    // Only grid maps have a mapped form; parametric maps are skipped.
+                    if (auto gm = std::dynamic_pointer_cast<const BFGridMap>(m)) {
+                        writeMappedMap(*gm, m->getKey() + ".bfmap");
+                    }
+                }
+            }
+        }
+
+        if (config.tabulateParamMaps()) {
+            for (auto maps : {&_bfmgr->innerMaps_, &_bfmgr->outerMaps_}) {
+                for (auto const& m : *maps) {
+                    if (auto pm = std::dynamic_pointer_cast<BFParamMap>(m)) {
+                        pm->tabulate(config.paramTableSpacing(), config.paramTableMaxError(),
+                                     config.paramTableMaxLevels(), config.paramTableMaxRadius());
+                        if (bfieldVerbosityLevel > 0) {
+                            cout << "Tabulated parametric map " << pm->getKey() << ": "
+                                 << pm->tabulationSize() << " grid points, largest error "
+                                 << pm->tabulationError() << " T, "
+                                 << pm->untabulatedBlocks() << " blocks use the fit" << endl;
+                        }
+                    }
+                }
+            }
+        }
+
+        // Build the structure-of-arrays copies used for batch evaluation.  This releases
+        // the original copy of the field, so it must come after any code above that
+        // modifies or writes the field values.
+        for (auto maps : {&_bfmgr->innerMaps_, &_bfmgr->outerMaps_}) {
+            for (auto const& m : *maps) {
+                if (auto gm = std::dynamic_pointer_cast<BFGridMap>(m)) {
+                    gm->fillBatchStore();
+                }
+            }
+        }
+
         // For debug purposes: print the field in the target region
         if (bfieldVerbosityLevel > 0) {
             CLHEP::Hep3Vector b = _bfmgr->getBField(CLHEP::Hep3Vector(3900.0, 0.0, -6550.0));
@@ -407,6 +449,15 @@ namespace mu2e {
                                       const std::string& resolvedFileName,
                                       double scaleFactor,
                                       BFInterpolationStyle interpStyle) {
+        // Maps in the mmap-able format carry their own grid description.
+        if (resolvedFileName.size() > 6 &&
+            resolvedFileName.compare(resolvedFileName.size() - 6, 6, ".bfmap") == 0) {
+            auto file = std::make_shared<const BFMapFile>(resolvedFileName, _verifyMapChecksum);
+            _bfmgr->addBFGridMap(mapContainer, key, file, BFMapType::G4BL, scaleFactor,
+                                 interpStyle);
+            return;
+        }
+
         // Extract information from the header.
         vector<double> X0;
         vector<int> dim;
@@ -674,6 +725,10 @@ namespace mu2e {
                 << cbuf << "\n";
         }
 
+        // Every grid point was read exactly once, so the validity grid is not needed.
+        bfmap._allDefined = true;
+        bfmap._isDefined.cleart();
+
         return;
     }
 
@@ -787,14 +842,9 @@ namespace mu2e {
                 << "Status: " << s2 << "  errno: " << errsave << " " << errmsg << "\n";
         }
 
-        // These maps fill the full box so mark all grid points as valid.
-        for (int ix = 0; ix < bf.nx(); ++ix) {
-            for (int iy = 0; iy < bf.ny(); ++iy) {
-                for (int iz = 0; iz < bf.nz(); ++iz) {
-                    bf._isDefined.set(ix, iy, iz, true);
-                }
-            }
-        }
+        // These maps fill the full box so all grid points are valid.
+        bf._allDefined = true;
+        bf._isDefined.cleart();
 
         close(fd);
 
@@ -870,6 +920,11 @@ namespace mu2e {
     }  // namespace mu2e
 
     void BFieldManagerMaker::writeG4BLBinary(const BFGridMap& bf, const std::string& outputfile) {
+        if (bf.isMapped()) {
+            throw cet::exception("GEOM") << "BFieldManagerMaker:writeG4BLBinary: map "
+                                         << bf.getKey() << " was read from a mapped file.\n";
+        }
+
         // Number of points in the big array.
         int nPoints = bf.nx() * bf.ny() * bf.nz();
 
@@ -926,6 +981,48 @@ namespace mu2e {
 
     }  // end BFieldManagerMaker::writeG4BLBinary
 
+    void BFieldManagerMaker::writeMappedMap(const BFGridMap& bf, const std::string& outputfile) {
+        if (bf.isMapped()) {
+            throw cet::exception("GEOM") << "BFieldManagerMaker:writeMappedMap: map " << bf.getKey()
+                                         << " was itself read from a mapped file.\n";
+        }
+        if (!bf._allDefined) {
+            throw cet::exception("GEOM")
+                << "BFieldManagerMaker:writeMappedMap: map " << bf.getKey()
+                << " is not defined at every grid point and cannot be written as a mapped file.\n";
+        }
+
+        cout << "Writing magnetic field map in mapped format to file: " << outputfile << endl;
+
+        // Split the field into its components.
+        const std::size_t nPoints = std::size_t(bf.nx()) * bf.ny() * bf.nz();
+        CLHEP::Hep3Vector const* fieldAddr = &bf._field.get(0, 0, 0);
+        std::vector<double> bx(nPoints), by(nPoints), bz(nPoints);
+        for (std::size_t i = 0; i < nPoints; ++i) {
+            bx[i] = fieldAddr[i].x();
+            by[i] = fieldAddr[i].y();
+            bz[i] = fieldAddr[i].z();
+        }
+
+        BFMapFile::Header h;
+        memset(&h, 0, sizeof(h));
+        h.flags = bf._flipy ? BFMapFile::flipY : 0;
+        h.nx = bf.nx();
+        h.ny = bf.ny();
+        h.nz = bf.nz();
+        h.xmin = bf.xmin();
+        h.ymin = bf.ymin();
+        h.zmin = bf.zmin();
+        h.dx = bf.dx();
+        h.dy = bf.dy();
+        h.dz = bf.dz();
+        strncpy(h.source, bf.getKey().c_str(), sizeof(h.source) - 1);
+
+        BFMapFile::write(outputfile, h, bx.data(), by.data(), bz.data());
+
+        cout << "Writing complete for file: " << outputfile << endl;
+    }
+
     // Compute the size of the array needed to hold the raw data of the field map.
     int BFieldManagerMaker::computeArraySize(int fd, const string& filename) {
         // Get the file size, in bytes, ( info.st_size ).
@@ -955,6 +1052,13 @@ namespace mu2e {
 
     void BFieldManagerMaker::flipMap(BFGridMap& bf) {
         std::cout << "Flipping B field vector in map " << bf.getKey() << std::endl;
+
+        // A mapped file is read-only; flipping the scale factor gives bit-identical results.
+        if (bf.isMapped()) {
+            bf._scaleFactor = -bf._scaleFactor;
+            return;
+        }
+
         for (int ix = 0; ix < bf.nx(); ++ix) {
             for (int iy = 0; iy < bf.ny(); ++iy) {
                 for (int iz = 0; iz < bf.nz(); ++iz) {
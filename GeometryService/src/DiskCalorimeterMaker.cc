@@ -345,6 +345,14 @@ namespace mu2e {
             }
         }
 
+        //flat neighbor tables for the clustering, in the same order as the per-crystal lists
+        for (const Crystal* crystal : calo_->fullCrystalList_)
+        {
+            calo_->neighborTable_.addCrystal(crystal->neighbors(false));
+            calo_->nextNeighborTable_.addCrystal(crystal->neighbors(false));
+            calo_->nextNeighborTable_.appendToLast(crystal->nextNeighbors(false));
+        }
+
 
 
     }
@@ -52,6 +52,8 @@ namespace mu2e {
       fhicl::Sequence<int> trackList {Name("trackList"), std::vector<int>()};
       fhicl::Sequence<int> trackingActionEventList {Name("trackingActionEventList"), std::vector<int>()};
       fhicl::Atom<bool> printTrackTiming {Name("printTrackTiming")};
+      fhicl::Atom<bool> printStepTiming {Name("printStepTiming"),
+          Comment("Print at the end of the run the time spent in the Mu2e stepping action per step"), false};
 
     };
 
@@ -200,6 +202,18 @@ namespace mu2e {
       fhicl::Atom<std::string> generatorModuleLabel {Name("generatorModuleLabel"), ""};
 
       fhicl::Atom<bool> G4InteralFiltering {Name("G4InteralFiltering"), false};
+
+      fhicl::Atom<unsigned> maxPrimariesPerSubEvent {Name("maxPrimariesPerSubEvent"),
+          Comment("Mu2eG4MT only: an event with more primaries is tracked as several sub-events\n"
+                  "of at most this many primaries, in parallel.  0 tracks every event as a whole."),
+          0};
+      fhicl::Atom<unsigned> subEventParticleNumberStride {Name("subEventParticleNumberStride"),
+          Comment("SimParticle numbers of sub-event i start at simParticleNumberOffset + i*subEventParticleNumberStride"),
+          1000000};
+      fhicl::Atom<bool> checkSubEventSeeds {Name("checkSubEventSeeds"),
+          Comment("Mu2eG4MT only: track the primaries of the first sub-event a second time with another\n"
+                  "sub-event index, and throw if both produce the same steps.  Doubles the work of that sub-event."),
+          false};
 //      fhicl::Atom<long> initialSeed {Name("initialSeed"),
 //         Comment("Only used by Mu2eG4MTRunManager when running in MT mode"),
 //          8 };
@@ -25,6 +25,7 @@
 
 //C++ includes
 #include <iostream>
+#include <limits>
 
 //art includes
 #include "art/Framework/Principal/Event.h"
@@ -68,6 +69,13 @@ namespace mu2e {
 
     }
 
+    // restrict the G4 event to the primaries [first_primary, last_primary) of the art event,
+    // counting the GenParticles first and then the genInputHits
+    void setPrimaryRange(unsigned first_primary, unsigned last_primary) {
+      firstPrimary = first_primary;
+      lastPrimary = last_primary;
+    }
+
     /////////////////////////////////////////////////////////////
     /////////////////////////////////////////////////////////////
     // functions to get the event data from the EventAction
@@ -196,6 +204,8 @@ namespace mu2e {
       genInputHits = nullptr;
       gensHandle.clear();
       generatorModuleLabel = "";
+      firstPrimary = 0;
+      lastPrimary = std::numeric_limits<unsigned>::max();
 
       statG4 = nullptr;
       simPartCollection = nullptr;
@@ -222,6 +232,8 @@ namespace mu2e {
     const HitHandles* genInputHits = nullptr;
     art::Handle<GenParticleCollection> gensHandle;
     art::InputTag generatorModuleLabel;
+    unsigned firstPrimary = 0;
+    unsigned lastPrimary = std::numeric_limits<unsigned>::max();
 
     std::unique_ptr<StatusG4> statG4 = nullptr;
     std::unique_ptr<SimParticleCollection> simPartCollection = nullptr;
@@ -7,6 +7,7 @@
 //
 #include <vector>
 #include <string>
+#include <chrono>
 
 // Mu2e includes
 #include "Mu2eG4/inc/EventNumberList.hh"
@@ -49,6 +50,8 @@ namespace mu2e {
 
     void BeginOfEvent(StepPointMCCollection& outputHits, const SimParticleHelper& spHelper);
 
+    void EndOfEvent();
+
     void BeginOfTrack();
     void EndOfTrack();
 
@@ -61,6 +64,9 @@ namespace mu2e {
     // G4 has initialized itself.
     void finishConstruction();
 
+    // Print the step timing summary, if enabled.
+    void endRun();
+
     std::vector<MCTrajectoryPoint> const&  trajectory();
 
     // Give away ownership of the trajectory information ( to the data product ).
@@ -93,11 +99,15 @@ namespace mu2e {
     std::vector<double> tvd_time_;
     StepPointMCCollection* tvd_collection_;
     bool tvd_warning_printed_;
+    // earliest and latest of tvd_time_, a step that does not overlap them is not checked
+    double tvd_tmin_;
+    double tvd_tmax_;
 
     // MCTrajectory point filtering cuts
     const Mu2eG4TrajectoryControl* trajectoryControl_;
-    typedef std::map<const G4VPhysicalVolume*, double> VolumeCutMap;
-    VolumeCutMap mcTrajectoryVolumePtDistances_;
+    // cut for each physical volume, indexed by G4VPhysicalVolume::GetInstanceID()
+    std::vector<double> mcTrajectoryVolumePtDistances_;
+    double mcTrajectoryDefaultPtDistance_;
     // Store trajectory parameters at each G4Step; cleared at beginOfTrack time.
     std::vector<MCTrajectoryPoint> _trajectory;
 
@@ -115,6 +125,16 @@ namespace mu2e {
     // Origin of Mu2e Coordinate system in the G4 world system.
     CLHEP::Hep3Vector _mu2eOrigin;
 
+    // Time spent in this stepping action, compared to the time of the G4 events, summed over the run.
+    typedef std::chrono::steady_clock StepClock;
+    bool printStepTiming_;
+    unsigned long long nTimedSteps_;
+    unsigned long long nTimedEvents_;
+    StepClock::duration stepActionTime_;
+    StepClock::duration stepCutsTime_;
+    StepClock::duration eventTime_;
+    StepClock::time_point eventStart_;
+
     // Functions to decide whether or not to kill tracks.
     bool killTooManySteps ( const G4Track* const);
 
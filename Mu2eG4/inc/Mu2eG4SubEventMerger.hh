@@ -0,0 +1,74 @@
+#ifndef Mu2eG4_SubEventMerger_hh
+#define Mu2eG4_SubEventMerger_hh
+//
+// Collects the data products of the sub-events of one art event, when Mu2eG4MT
+// tracks the primaries of a large event in several G4 events, and merges them
+// in sub-event order so the result does not depend on the thread scheduling.
+//
+// The SimParticles of sub-event i are numbered from simParticleNumberOffset + i*stride,
+// so the keys are unique and the StepPointMC, MCTrajectory and daughter Ptrs stay valid
+// after the merge. SimParticles copied from a previous stage appear in every sub-event;
+// they are merged by key and their daughter lists are concatenated.
+//
+
+//Mu2e includes
+#include "MCDataProducts/inc/StatusG4.hh"
+#include "MCDataProducts/inc/SimParticleCollection.hh"
+#include "MCDataProducts/inc/StepPointMCCollection.hh"
+#include "MCDataProducts/inc/MCTrajectoryCollection.hh"
+#include "MCDataProducts/inc/SimParticleRemapping.hh"
+#include "MCDataProducts/inc/ExtMonFNALSimHitCollection.hh"
+
+//C++ includes
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace art { class Event; class EDProductGetter; }
+
+namespace mu2e {
+
+  struct Mu2eG4PerThreadStorage;
+
+  class Mu2eG4SubEventMerger {
+
+  public:
+
+    Mu2eG4SubEventMerger(unsigned nSubEvents, unsigned particleNumberStride);
+
+    // Move the products of one sub-event out of the per-thread storage of the worker that tracked it.
+    // Different sub-events can be collected concurrently.
+    void collect(unsigned subEventIndex, Mu2eG4PerThreadStorage& store);
+
+    // Merge the sub-events and put the products into the event; returns false if
+    // a sub-event was rejected by the G4 internal filtering, in which case nothing is put.
+    bool put(art::Event& event, art::EDProductGetter const* simProductGetter);
+
+    // True if sub-event i of this merger and sub-event j of other produced the same,
+    // non-empty, steps in every StepPointMC collection.  The SimParticle Ptrs are not
+    // compared, since the two sub-events number their particles from different offsets.
+    bool identicalSteps(unsigned i, Mu2eG4SubEventMerger const& other, unsigned j) const;
+
+  private:
+
+    struct SubEvent {
+      std::unique_ptr<StatusG4> status;
+      std::unique_ptr<SimParticleCollection> sims;
+      std::map<std::string, std::unique_ptr<StepPointMCCollection> > steps;
+      std::string tvdName;
+      std::unique_ptr<StepPointMCCollection> tvdHits;
+      std::unique_ptr<MCTrajectoryCollection> trajectories;
+      std::unique_ptr<SimParticleRemapping> simsRemap;
+      std::unique_ptr<ExtMonFNALSimHitCollection> extMonFNALHits;
+    };
+
+    unsigned particleNumberStride_;
+    std::vector<SubEvent> subEvents_;
+
+    static void fixSimParticlePtrs(StepPointMCCollection& steps, art::EDProductGetter const* simProductGetter);
+  };
+
+} // end namespace mu2e
+
+#endif /* Mu2eG4_SubEventMerger_hh */
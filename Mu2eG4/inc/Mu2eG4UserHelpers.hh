@@ -30,6 +30,7 @@
 
 class G4Track;
 class G4Step;
+class G4VProcess;
 
 namespace mu2e {
 
@@ -50,6 +51,8 @@ namespace mu2e {
                         bool isEnd=false, bool printTimers=true);
 
     G4String findStepStoppingProcessName(G4Step const* const aStep);
+    // The process itself, or nullptr if it is not specified; for PhysicsProcessInfo::findAndCount.
+    G4VProcess const* findStepStoppingProcess(G4Step const* const aStep);
     void printKilledTrackInfo(G4Track const* const trk);
     bool isTrackKilledByFieldPropagator(G4Track const* const trk, int trVerbosity);
     G4String findTrackStoppingProcessName(G4Track const* const trk);
@@ -51,6 +51,13 @@ namespace mu2e {
     void initializeUserActions(const G4ThreeVector& origin_in_world);
     void initializeRun(art::Event* art_event);
     void processEvent(art::Event*);
+    // Track one sub-event (a subset of the primaries of the art event). Its random numbers come
+    // from the seeds (s1,s2) of the art event mixed with the sub-event index.
+    void processSubEvent(art::Event*, unsigned subEventIndex, long s1, long s2);
+
+    // The seeds of a sub-event, zero terminated as for G4Random::setTheSeeds. The engines
+    // use only the first two seeds, so the index is hashed into both of them.
+    static void subEventSeeds(long s1, long s2, unsigned subEventIndex, long seeds[3]);
     G4Event* generateEvt(G4int i_event);
 
     inline bool workerRMInitialized() const { return m_managerInitialized; }
@@ -64,6 +71,8 @@ namespace mu2e {
     Mu2eG4Config::Top conf_;
 
     bool m_managerInitialized;
+    bool m_subEventSeeded;
+    long m_subEventSeeds[3];
     bool m_steppingVerbose;
     bool m_mtDebugOutput;
     int rmvlevel_;
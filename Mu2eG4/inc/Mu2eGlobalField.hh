@@ -13,8 +13,6 @@
 
 #include <string>
 
-#include "BFieldGeom/inc/BFCacheManager.hh"
-
 #include "G4MagneticField.hh"
 #include "G4Types.hh"
 #include "G4ThreeVector.hh"
@@ -45,11 +43,9 @@ namespace mu2e {
     G4ThreeVector _mapOrigin;
 
     // Non-owning pointer to the field map object (it is owned by the geometry service).
+    // Its map lookup is thread safe, so all worker threads can share it.
     const BFieldManager* _map;
 
-    // A copy of the bfield cache manager - must be thread local.
-    BFCacheManager _cm;
-
   };
 }
 #endif /* Mu2eG4_Mu2eGlobalField_hh */
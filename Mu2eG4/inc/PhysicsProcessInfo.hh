@@ -14,11 +14,14 @@
 #include <set>
 #include <map>
 #include <string>
+#include <unordered_map>
 
 #include "MCDataProducts/inc/ProcessCode.hh"
 
 #include "G4String.hh"
 
+class G4VProcess;
+
 namespace mu2e {
 
   class PhysicsProcessInfo {
@@ -38,7 +41,11 @@ namespace mu2e {
     // Locate a process by its name, return the corresponding process code and
     // increment the counter.
     ProcessCode findAndCount( G4String const& name );
-      
+
+    // Same, for the process that defined a step; a null process is counted as NotSpecified.
+    // The processes known at beginRun are looked up by pointer, without comparing names.
+    ProcessCode findAndCount( G4VProcess const* process );
+
     void printAll ( std::ostream& os) const;
     void printSummary ( std::ostream& os) const;
 
@@ -64,9 +71,15 @@ namespace mu2e {
     typedef std::map<G4String,ProcInfo> map_type;
     map_type _allProcesses;
 
+    // Entries of _allProcesses for each process instance; the map nodes do not move.
+    std::unordered_map<G4VProcess const*, ProcInfo*> _byProcess;
+    ProcInfo* _notSpecified;
+
     // The length of the longest name; for formatting printed output.
     size_t _longestName;
 
+    static ProcessCode increment( ProcInfo& info );
+
   };
 
 } // end namespace mu2e
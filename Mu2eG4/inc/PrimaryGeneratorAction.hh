@@ -70,6 +70,8 @@ namespace mu2e {
     const GenParticleCollection* genParticles_;
     const HitHandles* hitInputs_;
     SimParticlePrimaryHelper* parentMapping_;
+    unsigned firstPrimary_;
+    unsigned lastPrimary_;
 
     int verbosityLevel_;
 
@@ -39,7 +39,7 @@ namespace mu2e {
       }
 
 
-    ProcessCode endCode(_processInfo->findAndCount(Mu2eG4UserHelpers::findStepStoppingProcessName(aStep)));
+    ProcessCode endCode(_processInfo->findAndCount(Mu2eG4UserHelpers::findStepStoppingProcess(aStep)));
 
     const G4TouchableHandle & touchableHandle = aStep->GetPreStepPoint()->GetTouchableHandle();
     int idro = touchableHandle->GetCopyNumber(1);
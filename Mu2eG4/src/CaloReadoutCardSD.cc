@@ -44,7 +44,7 @@ namespace mu2e {
         return false;
       }
 
-    ProcessCode endCode(_processInfo->findAndCount(Mu2eG4UserHelpers::findStepStoppingProcessName(aStep)));
+    ProcessCode endCode(_processInfo->findAndCount(Mu2eG4UserHelpers::findStepStoppingProcess(aStep)));
 
     const G4TouchableHandle & touchableHandle = aStep->GetPreStepPoint()->GetTouchableHandle();
     //the idro is always Number(0) + _nro*number(X), make sure X is right
@@ -17,6 +17,7 @@
 #include "G4Track.hh"
 #include "G4Step.hh"
 #include "G4VProcess.hh"
+#include "G4VPhysicalVolume.hh"
 
 #include "Mu2eG4/inc/IMu2eG4Cut.hh"
 #include "Mu2eG4/inc/Mu2eG4ResourceLimits.hh"
@@ -444,9 +445,8 @@ namespace mu2e {
       std::vector<std::string> volnames_;
       bool negate_;
 
-      // cached pointers to physical volumes on the list
-      typedef std::set<const G4VPhysicalVolume*> KillerVolumesCache;
-      KillerVolumesCache killerVolumes_;
+      // flags for the physical volumes on the list, indexed by G4VPhysicalVolume::GetInstanceID()
+      std::vector<char> killerVolumes_;
 
       bool cut_impl(const G4Track* trk);
     };
@@ -460,13 +460,16 @@ namespace mu2e {
     void VolumeCut::finishConstruction(const CLHEP::Hep3Vector& mu2eOriginInWorld) {
       IOHelper::finishConstruction(mu2eOriginInWorld);
       for(const auto& vol: volnames_) {
-        killerVolumes_.insert(getPhysicalVolumeOrThrow(vol));
+        const unsigned id = getPhysicalVolumeOrThrow(vol)->GetInstanceID();
+        if(killerVolumes_.size() <= id) killerVolumes_.resize(id+1, 0);
+        killerVolumes_[id] = 1;
       }
     }
 
     bool VolumeCut::cut_impl(const G4Track* trk) {
-      KillerVolumesCache::const_iterator p = killerVolumes_.find(trk->GetVolume());
-      bool result = ( p != killerVolumes_.end() );
+      const G4VPhysicalVolume* vol = trk->GetVolume();
+      const unsigned id = vol ? vol->GetInstanceID() : killerVolumes_.size();
+      bool result = ( id < killerVolumes_.size() && killerVolumes_[id] );
       if(negate_) result = !result;
       return result;
     }
@@ -153,6 +153,7 @@ namespace mu2e {
   {
     // Run self consistency checks if enabled.
     _trackingAction->endEvent(*simParticles);
+    _steppingAction->EndOfEvent();
 
     _timer->Stop();
 
@@ -3,6 +3,10 @@
 // Original author Rob Kutschke
 //
 // Notes:
+//
+// Events are processed in parallel by one Mu2eG4WorkerRunManager per thread.  If
+// maxPrimariesPerSubEvent is set, an event with more primaries is split into sub-events
+// that are tracked concurrently (see Mu2eG4SubEventMerger for how the products are merged).
 
 
 
@@ -25,6 +29,7 @@
 #include "Mu2eG4/inc/SimParticleHelper.hh"
 #include "Mu2eG4/inc/SimParticlePrimaryHelper.hh"
 #include "Mu2eG4/inc/Mu2eG4Config.hh"
+#include "Mu2eG4/inc/Mu2eG4SubEventMerger.hh"
 
 // Data products that will be produced by this module.
 #include "MCDataProducts/inc/GenParticleCollection.hh"
@@ -46,11 +51,15 @@
 
 // Geant4 includes
 #include "G4Run.hh"
+#include "G4Event.hh"
 
 // C++ includes.
+#include <algorithm>
+#include <cstdint>
 #include <cstdlib>
 #include <iomanip>
 #include <iostream>
+#include <limits>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -60,6 +69,7 @@
 
 // TBB includes
 #include "tbb/concurrent_hash_map.h"
+#include "tbb/task_arena.h"
 #include "tbb/task_group.h"
 
 using namespace std;
@@ -141,6 +151,15 @@ namespace mu2e {
     // Do the G4 initialization that must be done only once per job, not once per run
     void initializeG4( GeometryService& geom, art::Run const& run );
 
+    // The worker run manager of the calling thread, created and initialized on first use
+    Mu2eG4WorkerRunManager* workerRunManager(art::Event& event);
+
+    // Track the primaries of the event in sub-events of at most maxPrimariesPerSubEvent_
+    void produceSubEvents(art::Event& event,
+                          art::Handle<GenParticleCollection> const& gensHandle,
+                          HitHandles& genInputHits,
+                          unsigned nPrimaries);
+
     const bool standardMu2eDetector_;
     G4ThreeVector originInWorld;
 
@@ -153,6 +172,10 @@ namespace mu2e {
 
     typedef tbb::concurrent_hash_map< std::thread::id, std::unique_ptr<Mu2eG4WorkerRunManager> > WorkerRMMap;
     WorkerRMMap myworkerRunManagerMap;
+
+    unsigned const maxPrimariesPerSubEvent_;
+    unsigned const subEventParticleNumberStride_;
+    bool const checkSubEventSeeds_;
   }; // end G4 header
 
 
@@ -183,13 +206,22 @@ namespace mu2e {
     timeVD_enabled_(pars().SDConfig().TimeVD().enabled()),
     physVolHelper_(),
     sensitiveDetectorHelper_(pars().SDConfig()),
-    standardMu2eDetector_((art::ServiceHandle<GeometryService>())->isStandardMu2eDetector())
+    standardMu2eDetector_((art::ServiceHandle<GeometryService>())->isStandardMu2eDetector()),
+    maxPrimariesPerSubEvent_(pars().maxPrimariesPerSubEvent()),
+    subEventParticleNumberStride_(pars().subEventParticleNumberStride()),
+    checkSubEventSeeds_(pars().checkSubEventSeeds())
     {
       if((_generatorModuleLabel == art::InputTag()) && multiStagePars_.genInputHits().empty()) {
         throw cet::exception("CONFIG")
           << "Error: both generatorModuleLabel and genInputHits are empty - nothing to do!\n";
       }
 
+      // the filter decision needs the hits of the whole event, which no single sub-event has
+      if(maxPrimariesPerSubEvent_ > 0 && pars().G4InteralFiltering()) {
+        throw cet::exception("CONFIG")
+          << "Error: maxPrimariesPerSubEvent can not be used together with G4InteralFiltering\n";
+      }
+
       // This statement requires that the external libraries the module uses are thread-safe,
       // and that the data member members are used in a thread-safe manner
       async<art::InEvent>();
@@ -334,42 +366,26 @@ namespace mu2e {
     art::ProductID simPartId(event.getProductID<SimParticleCollection>());
     art::EDProductGetter const* simProductGetter = event.productGetter(simPartId);
 
-    SimParticleHelper spHelper(multiStagePars_.simParticleNumberOffset(), simPartId, &event, simProductGetter);
-    SimParticlePrimaryHelper parentHelper(&event, simPartId, gensHandle, simProductGetter);
+    if(maxPrimariesPerSubEvent_ > 0) {
+      unsigned nPrimaries = gensHandle.isValid() ? gensHandle->size() : 0;
+      for(const auto& hits : genInputHits) nPrimaries += hits->size();
 
-
-    int schedID = std::stoi(std::to_string(procFrame.scheduleID().id()));
-    auto const tid = std::this_thread::get_id();
-
-    WorkerRMMap::accessor access_workerMap;
-
-    if (!myworkerRunManagerMap.find(access_workerMap, tid)){
-      if (_mtDebugOutput){
-        G4cout << "FOR TID: " << tid << ", NO WORKER.  We are making one.\n";
+      if(nPrimaries > maxPrimariesPerSubEvent_) {
+        produceSubEvents(event, gensHandle, genInputHits, nPrimaries);
+        return;
       }
-      myworkerRunManagerMap.insert(access_workerMap, tid);
-      //std::ostringstream oss;
-      //oss << tid;
-      //std::string workerID = oss.str();
-      access_workerMap->second = std::make_unique<Mu2eG4WorkerRunManager>(conf_, tid);
     }
 
-    if (event.id().event() == 1) {
-      G4cout << "Our RMmap has " << myworkerRunManagerMap.size() << " members\n";
-    }
+    SimParticleHelper spHelper(multiStagePars_.simParticleNumberOffset(), simPartId, &event, simProductGetter);
+    SimParticlePrimaryHelper parentHelper(&event, simPartId, gensHandle, simProductGetter);
 
-    myworkerRunManagerMap.find(access_workerMap, tid);
-    Mu2eG4WorkerRunManager* scheduleWorkerRM = (access_workerMap->second).get();
-    access_workerMap.release();
 
-    if (_mtDebugOutput){
-      G4cout << "FOR SchedID: " << schedID << ", TID=" << tid << ", workerRunManagers[schedID].get() is:" << scheduleWorkerRM << "\n";
-    }
+    int schedID = std::stoi(std::to_string(procFrame.scheduleID().id()));
+    Mu2eG4WorkerRunManager* scheduleWorkerRM = workerRunManager(event);
 
-    //if this is the first time the thread is being used, it should be initialized
-    if (!scheduleWorkerRM->workerRMInitialized()){
-      scheduleWorkerRM->initializeThread(masterThread->masterRunManagerPtr(), originInWorld);
-      scheduleWorkerRM->initializeRun(&event);
+    if (_mtDebugOutput){
+      G4cout << "FOR SchedID: " << schedID << ", TID=" << std::this_thread::get_id()
+             << ", workerRunManagers[schedID].get() is:" << scheduleWorkerRM << "\n";
     }
 
     Mu2eG4PerThreadStorage* perThreadStore = scheduleWorkerRM->getMu2eG4PerThreadStorage();
@@ -416,6 +432,122 @@ namespace mu2e {
   }//end Mu2eG4MT::produce
 
 
+  Mu2eG4WorkerRunManager* Mu2eG4MT::workerRunManager(art::Event& event) {
+
+    auto const tid = std::this_thread::get_id();
+    WorkerRMMap::accessor access_workerMap;
+
+    if (!myworkerRunManagerMap.find(access_workerMap, tid)){
+      if (_mtDebugOutput){
+        G4cout << "FOR TID: " << tid << ", NO WORKER.  We are making one.\n";
+      }
+      myworkerRunManagerMap.insert(access_workerMap, tid);
+      access_workerMap->second = std::make_unique<Mu2eG4WorkerRunManager>(conf_, tid);
+    }
+
+    if (event.id().event() == 1) {
+      G4cout << "Our RMmap has " << myworkerRunManagerMap.size() << " members\n";
+    }
+
+    Mu2eG4WorkerRunManager* workerRM = (access_workerMap->second).get();
+    access_workerMap.release();
+
+    //if this is the first time the thread is being used, it should be initialized
+    if (!workerRM->workerRMInitialized()){
+      workerRM->initializeThread(masterThread->masterRunManagerPtr(), originInWorld);
+      workerRM->initializeRun(&event);
+    }
+
+    return workerRM;
+  }
+
+
+  // Split the primaries of a large event into sub-events and track them concurrently.
+  // Each sub-event is a separate G4 event on whichever worker thread picks it up; its
+  // SimParticles are numbered from their own offset and its random numbers come from
+  // the seeds of the art event plus the sub-event index, so the merged products do not
+  // depend on the scheduling.
+  void Mu2eG4MT::produceSubEvents(art::Event& event,
+                                  art::Handle<GenParticleCollection> const& gensHandle,
+                                  HitHandles& genInputHits,
+                                  unsigned nPrimaries) {
+
+    unsigned const nSubEvents = (nPrimaries + maxPrimariesPerSubEvent_ - 1)/maxPrimariesPerSubEvent_;
+    unsigned const offset = multiStagePars_.simParticleNumberOffset();
+
+    if (offset + uint64_t(nSubEvents)*subEventParticleNumberStride_ > std::numeric_limits<unsigned>::max()) {
+      throw cet::exception("CONFIG")
+        << "Error: " << nSubEvents << " sub-events of subEventParticleNumberStride = "
+        << subEventParticleNumberStride_ << " overflow the SimParticle numbers\n";
+    }
+
+    art::ProductID simPartId(event.getProductID<SimParticleCollection>());
+    art::EDProductGetter const* simProductGetter = event.productGetter(simPartId);
+
+    // draw the seeds once for the art event, as for an event tracked as a whole
+    long s1(0), s2(0), s3(0);
+    G4Event seedEvent(event.id().event());
+    if (!masterThread->masterRunManagerPtr()->SetUpAnEvent(&seedEvent, s1, s2, s3, true)) {
+      // as for an event tracked as a whole, nothing is tracked and no products are put
+      numExcludedEvents++;
+      return;
+    }
+
+    Mu2eG4SubEventMerger merger(nSubEvents, subEventParticleNumberStride_);
+
+    // The waiting thread must only pick up sub-events of this event: a task of another
+    // event would reuse the worker run manager of this thread in the middle of it.
+    // Track the primaries of sub-event i with the random numbers of sub-event seedIndex
+    // and collect the products into sub-event collectIndex of the given merger.
+    auto trackSubEvent = [&](unsigned i, unsigned seedIndex, Mu2eG4SubEventMerger& into, unsigned collectIndex) {
+      unsigned const first = i*maxPrimariesPerSubEvent_;
+      unsigned const last = std::min(first + maxPrimariesPerSubEvent_, nPrimaries);
+
+      SimParticleHelper spHelper(offset + i*subEventParticleNumberStride_, simPartId, &event, simProductGetter);
+      SimParticlePrimaryHelper parentHelper(&event, simPartId, gensHandle, simProductGetter);
+
+      Mu2eG4WorkerRunManager* workerRM = workerRunManager(event);
+      Mu2eG4PerThreadStorage* perThreadStore = workerRM->getMu2eG4PerThreadStorage();
+      perThreadStore->initializeEventInfo(&event, &spHelper, &parentHelper, &genInputHits, _generatorModuleLabel);
+      perThreadStore->setPrimaryRange(first, last);
+
+      workerRM->processSubEvent(&event, seedIndex, s1, s2);
+
+      into.collect(collectIndex, *perThreadStore);
+      perThreadStore->clearData();
+      workerRM->TerminateOneEvent();
+    };
+
+    tbb::this_task_arena::isolate([&] {
+        tbb::task_group g;
+        for (unsigned i = 0; i < nSubEvents; ++i) {
+          g.run([&, i] { trackSubEvent(i, i, merger, i); });
+        }
+        g.wait();
+      });
+
+    // The same primaries tracked with the seeds of another sub-event must not give the
+    // same steps; if they do, the sub-events are not independent.
+    if (checkSubEventSeeds_) {
+      Mu2eG4SubEventMerger check(1, subEventParticleNumberStride_);
+      trackSubEvent(0, nSubEvents, check, 0);
+      if (merger.identicalSteps(0, check, 0)) {
+        throw cet::exception("SIM")
+          << "Mu2eG4MT: the primaries of sub-event 0 of event " << event.id()
+          << " produced identical steps with the random numbers of sub-event " << nSubEvents << "\n";
+      }
+    }
+
+    if (_mtDebugOutput){
+      G4cout << "Event " << event.id().event() << " tracked in " << nSubEvents << " sub-events\n";
+    }
+
+    if (!merger.put(event, simProductGetter)) {
+      numExcludedEvents++;
+    }
+  }
+
+
   // Tell G4 that this run is over.
   void Mu2eG4MT::endRun(art::Run & run, art::ProcessingFrame const& procFrame) {
 
@@ -436,7 +568,8 @@ namespace mu2e {
         }
         access_workerMap.release();
         --threads_left;
-        while (threads_left != 0) {}
+        // keep this thread busy until every worker is destroyed, so that each task runs on its own thread
+        while (threads_left != 0) { std::this_thread::yield(); }
         return;
       };
       g.run(destroy_worker);
@@ -84,6 +84,7 @@ namespace mu2e {
 
   void Mu2eG4RunAction::EndOfRunAction(const G4Run* aRun)
   {
+    _steppingAction->endRun();
     _processInfo->endRun();
   }
 
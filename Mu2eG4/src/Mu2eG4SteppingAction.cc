@@ -6,12 +6,15 @@
 // C++ includes
 #include <cstdio>
 #include <cmath>
+#include <algorithm>
 
 // Framework includes
 #include "messagefacility/MessageLogger/MessageLogger.h"
 
 #include "G4Step.hh"
 #include "G4Threading.hh"
+#include "G4PhysicalVolumeStore.hh"
+#include "G4VPhysicalVolume.hh"
 
 // Mu2e includes
 #include "Mu2eG4/inc/Mu2eG4SteppingAction.hh"
@@ -48,14 +51,26 @@ namespace mu2e {
     tvd_time_(timeVDtimes),
     tvd_collection_(nullptr),
     tvd_warning_printed_(false),
+    tvd_tmin_(tvd_time_.empty() ? 0. : *std::min_element(tvd_time_.begin(), tvd_time_.end())),
+    tvd_tmax_(tvd_time_.empty() ? 0. : *std::max_element(tvd_time_.begin(), tvd_time_.end())),
 
     trajectoryControl_(&trajectoryControl),
+    mcTrajectoryVolumePtDistances_(),
+    mcTrajectoryDefaultPtDistance_(trajectoryControl.defaultMinPointDistance()),
 
   // Default values for parameters that are optional in the run time configuration.
     _debugEventList(debug.eventList()),
     _debugTrackList(debug.trackList()),
 
-    _spHelper()
+    _spHelper(),
+
+    printStepTiming_(debug.printStepTiming()),
+    nTimedSteps_(0),
+    nTimedEvents_(0),
+    stepActionTime_(StepClock::duration::zero()),
+    stepCutsTime_(StepClock::duration::zero()),
+    eventTime_(StepClock::duration::zero()),
+    eventStart_()
   {
     if( (!tvd_time_.empty()) && (G4Threading::G4GetThreadId() <= 0) ) {
       G4cout << "Time virtual detector is enabled. Particles are recorded at";
@@ -92,12 +107,41 @@ namespace mu2e {
   void Mu2eG4SteppingAction::finishConstruction() {
 
     // We have to wait until G4 geometry is constructed
-    // to get phys volume pointers that are used in the
-    // volume to cut value map.
+    // to get the phys volumes that are used in the
+    // volume to cut value table.
+    G4int maxId = -1;
+    for(const auto* vol: *G4PhysicalVolumeStore::GetInstance()) {
+      maxId = std::max(maxId, vol->GetInstanceID());
+    }
+    mcTrajectoryVolumePtDistances_.assign(maxId+1, mcTrajectoryDefaultPtDistance_);
+
     for(const auto& spec: trajectoryControl_->perVolumeMinDistance()) {
       auto vol = getPhysicalVolumeOrThrow(spec.first);
-      mcTrajectoryVolumePtDistances_[vol] = spec.second;
+      mcTrajectoryVolumePtDistances_[vol->GetInstanceID()] = spec.second;
     }
+
+    nTimedSteps_ = 0;
+    nTimedEvents_ = 0;
+    stepActionTime_ = stepCutsTime_ = eventTime_ = StepClock::duration::zero();
+  }
+
+  void Mu2eG4SteppingAction::endRun() {
+
+    if(!printStepTiming_ || nTimedSteps_ == 0) return;
+
+    using ms = std::chrono::duration<double, std::milli>;
+    using ns = std::chrono::duration<double, std::nano>;
+    const double eventMs  = ms(eventTime_).count();
+    const double actionMs = ms(stepActionTime_).count();
+
+    G4cout << "Mu2eG4SteppingAction step timing, thread " << G4Threading::G4GetThreadId() << ": "
+           << nTimedEvents_ << " events, " << nTimedSteps_ << " steps, "
+           << eventMs << " ms in G4 events, "
+           << actionMs << " ms in the stepping action ("
+           << (eventMs > 0. ? 100.*actionMs/eventMs : 0.) << "%), "
+           << ns(stepActionTime_).count()/nTimedSteps_ << " ns/step of which "
+           << ns(stepCutsTime_).count()/nTimedSteps_ << " ns/step in the cuts"
+           << G4endl;
   }
 
   void Mu2eG4SteppingAction::BeginOfTrack() {
@@ -117,11 +161,21 @@ namespace mu2e {
     tvd_collection_  = &outputHits;
     tvd_warning_printed_ = false;
     _spHelper    = &spHelper;
+    if(printStepTiming_) eventStart_ = StepClock::now();
+  }
+
+  void Mu2eG4SteppingAction::EndOfEvent() {
+    if(printStepTiming_) {
+      eventTime_ += StepClock::now() - eventStart_;
+      ++nTimedEvents_;
+    }
   }
 
 
   void Mu2eG4SteppingAction::UserSteppingAction(const G4Step* step){
 
+    const StepClock::time_point stepStart = printStepTiming_ ? StepClock::now() : StepClock::time_point();
+
     numTrackSteps_++;
 
     G4Track* track = step->GetTrack();
@@ -149,12 +203,17 @@ namespace mu2e {
     }
 
     // Save hits in time virtual detector
-    for( unsigned int i=0; i<tvd_time_.size(); ++i ) {
-      if( prept->GetGlobalTime()<=tvd_time_[i] && postpt->GetGlobalTime()>tvd_time_[i] ) {
-        addTimeVDHit(step,i+1);
+    if( !tvd_time_.empty() &&
+        prept->GetGlobalTime()<=tvd_tmax_ && postpt->GetGlobalTime()>tvd_tmin_ ) {
+      for( unsigned int i=0; i<tvd_time_.size(); ++i ) {
+        if( prept->GetGlobalTime()<=tvd_time_[i] && postpt->GetGlobalTime()>tvd_time_[i] ) {
+          addTimeVDHit(step,i+1);
+        }
       }
     }
 
+    const StepClock::time_point cutsStart = printStepTiming_ ? StepClock::now() : StepClock::time_point();
+
     if(steppingCuts_->steppingActionCut(step)) {
       killTrack(track, ProcessCode::mu2eKillerVolume, fStopAndKill);
     } else if(commonCuts_->steppingActionCut(step)) {
@@ -163,6 +222,13 @@ namespace mu2e {
       killTrack( track, ProcessCode::mu2eMaxSteps, fStopAndKill);
     }
 
+    if(printStepTiming_) {
+      const auto stepEnd = StepClock::now();
+      stepActionTime_ += stepEnd - stepStart;
+      stepCutsTime_ += stepEnd - cutsStart;
+      ++nTimedSteps_;
+    }
+
     //----------------------------------------------------------------
     // Do we want to do make debug printout for this event?
     if ( !_debugEventList.inList() ) return;
@@ -284,7 +350,7 @@ namespace mu2e {
 
     // Which process caused this step to end?
     ProcessCode endCode(_processInfo->
-                        findAndCount(Mu2eG4UserHelpers::findStepStoppingProcessName(aStep)));
+                        findAndCount(Mu2eG4UserHelpers::findStepStoppingProcess(aStep)));
 
     // The point's coordinates are saved in the mu2e coordinate system.
     tvd_collection_->
@@ -316,9 +382,10 @@ namespace mu2e {
 
   double Mu2eG4SteppingAction::mcTrajectoryMinDistanceCut(const G4VPhysicalVolume* vol) const {
 
-    const auto it = mcTrajectoryVolumePtDistances_.find(vol);
-    return (it != mcTrajectoryVolumePtDistances_.end()) ?
-      it->second : trajectoryControl_->defaultMinPointDistance();
+    // volumes created after finishConstruction() get the default
+    const unsigned id = vol ? vol->GetInstanceID() : mcTrajectoryVolumePtDistances_.size();
+    return (id < mcTrajectoryVolumePtDistances_.size()) ?
+      mcTrajectoryVolumePtDistances_[id] : mcTrajectoryDefaultPtDistance_;
   }
 
 } // end namespace mu2e
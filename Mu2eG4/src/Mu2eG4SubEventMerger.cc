@@ -0,0 +1,188 @@
+//
+// Merge the data products of the sub-events of one art event.
+//
+
+//Mu2e includes
+#include "Mu2eG4/inc/Mu2eG4SubEventMerger.hh"
+#include "Mu2eG4/inc/Mu2eG4PerThreadStorage.hh"
+
+//art includes
+#include "art/Framework/Principal/Event.h"
+#include "cetlib_except/exception.h"
+
+//C++ includes
+#include <algorithm>
+
+namespace mu2e {
+
+  Mu2eG4SubEventMerger::Mu2eG4SubEventMerger(unsigned nSubEvents,
+                                             unsigned particleNumberStride)
+    : particleNumberStride_(particleNumberStride)
+    , subEvents_(nSubEvents)
+  {}
+
+
+  void Mu2eG4SubEventMerger::collect(unsigned subEventIndex, Mu2eG4PerThreadStorage& store) {
+
+    SubEvent& sub = subEvents_.at(subEventIndex);
+
+    sub.status = store.getG4Status();
+    sub.sims = store.getSimPartCollection();
+
+    // a sub-event that tracked more particles than the stride would reuse the keys of the next one
+    if (sub.status && unsigned(sub.status->nG4Tracks()) >= particleNumberStride_) {
+      throw cet::exception("SIM")
+        << "Mu2eG4SubEventMerger: sub-event " << subEventIndex << " produced "
+        << sub.status->nG4Tracks() << " G4 tracks, more than subEventParticleNumberStride = "
+        << particleNumberStride_ << "; use smaller sub-events or a larger stride\n";
+    }
+
+    for (auto& i : store.sensitiveDetectorSteps) {
+      sub.steps[i.first] = std::move(i.second);
+    }
+    for (auto& i : store.cutsSteps) {
+      sub.steps[i.first] = std::move(i.second);
+    }
+    store.sensitiveDetectorSteps.clear();
+    store.cutsSteps.clear();
+
+    sub.tvdName = store.getTVDName();
+    sub.tvdHits = store.getTVDHits();
+    sub.trajectories = store.getMCTrajCollection();
+    sub.simsRemap = store.getSimParticleRemap();
+    sub.extMonFNALHits = store.getExtMonFNALSimHitCollection();
+  }
+
+  bool Mu2eG4SubEventMerger::identicalSteps(unsigned i, Mu2eG4SubEventMerger const& other, unsigned j) const {
+
+    auto const& a = subEvents_.at(i).steps;
+    auto const& b = other.subEvents_.at(j).steps;
+    if (a.size() != b.size()) return false;
+
+    std::size_t nSteps(0);
+    for (auto ia = a.begin(), ib = b.begin(); ia != a.end(); ++ia, ++ib) {
+      if (ia->first != ib->first) return false;
+      if (!ia->second || !ib->second) {
+        if (ia->second || ib->second) return false;
+        continue;
+      }
+      StepPointMCCollection const& sa = *ia->second;
+      StepPointMCCollection const& sb = *ib->second;
+      if (sa.size() != sb.size()) return false;
+      for (std::size_t k = 0; k < sa.size(); ++k) {
+        if (sa[k].volumeId() != sb[k].volumeId() ||
+            sa[k].position() != sb[k].position() ||
+            sa[k].momentum() != sb[k].momentum() ||
+            sa[k].time() != sb[k].time() ||
+            sa[k].totalEDep() != sb[k].totalEDep()) return false;
+      }
+      nSteps += sa.size();
+    }
+    return nSteps > 0;
+  }
+
+
+  bool Mu2eG4SubEventMerger::put(art::Event& event, art::EDProductGetter const* simProductGetter) {
+
+    for (const auto& sub : subEvents_) {
+      if (!sub.sims) return false;
+    }
+
+    int status(0), nG4Tracks(0), nKilledStepLimit(0), nKilledByFieldPropagator(0);
+    bool overflowSimParticles(false);
+    float cpuTime(0), realTime(0);
+
+    std::map<SimParticleCollection::key_type, SimParticle> sims;
+    std::map<std::string, std::unique_ptr<StepPointMCCollection> > steps;
+    std::unique_ptr<StepPointMCCollection> tvdHits;
+    std::unique_ptr<MCTrajectoryCollection> trajectories;
+    std::unique_ptr<SimParticleRemapping> simsRemap;
+    std::unique_ptr<ExtMonFNALSimHitCollection> extMonFNALHits;
+
+    for (auto& sub : subEvents_) {
+
+      status = std::max(status, sub.status->status());
+      nG4Tracks += sub.status->nG4Tracks();
+      overflowSimParticles = overflowSimParticles || sub.status->overflowSimParticles();
+      nKilledStepLimit += sub.status->nKilledStepLimit();
+      nKilledByFieldPropagator += sub.status->nKilledByFieldPropagator();
+      cpuTime += sub.status->cpuTime();
+      realTime = std::max(realTime, sub.status->realTime());
+
+      // the particles copied from the previous stage are in every sub-event: their daughter lists
+      // start with the daughters from the previous stage, followed by those created in the sub-event
+      for (auto& i : *sub.sims) {
+        auto found = sims.find(i.first);
+        if (found == sims.end()) {
+          sims.emplace(i.first, std::move(i.second));
+        } else {
+          const auto& merged = found->second.daughters();
+          const auto& added = i.second.daughters();
+          auto first = std::mismatch(added.begin(), added.end(), merged.begin(), merged.end()).first;
+          for (; first != added.end(); ++first) found->second.addDaughter(*first);
+        }
+      }
+
+      for (auto& i : sub.steps) {
+        auto& merged = steps[i.first];
+        if (!merged) {
+          merged = std::move(i.second);
+        } else {
+          merged->insert(merged->end(), i.second->begin(), i.second->end());
+        }
+      }
+
+      if (sub.tvdHits) {
+        if (!tvdHits) tvdHits = std::move(sub.tvdHits);
+        else tvdHits->insert(tvdHits->end(), sub.tvdHits->begin(), sub.tvdHits->end());
+      }
+
+      // map::insert keeps the first copy of the trajectories of the previous stage
+      if (sub.trajectories) {
+        if (!trajectories) trajectories = std::move(sub.trajectories);
+        else trajectories->insert(sub.trajectories->begin(), sub.trajectories->end());
+      }
+
+      if (sub.simsRemap) {
+        if (!simsRemap) simsRemap = std::move(sub.simsRemap);
+        else simsRemap->insert(sub.simsRemap->begin(), sub.simsRemap->end());
+      }
+
+      if (sub.extMonFNALHits) {
+        if (!extMonFNALHits) extMonFNALHits = std::move(sub.extMonFNALHits);
+        else extMonFNALHits->insert(extMonFNALHits->end(), sub.extMonFNALHits->begin(), sub.extMonFNALHits->end());
+      }
+    }
+
+    event.put(std::make_unique<StatusG4>(status, nG4Tracks, overflowSimParticles, nKilledStepLimit,
+                                         nKilledByFieldPropagator, cpuTime, realTime));
+    auto simParticles = std::make_unique<SimParticleCollection>();
+    simParticles->insert(sims.begin(), sims.end());
+    event.put(std::move(simParticles));
+
+    for (auto& i : steps) {
+      fixSimParticlePtrs(*i.second, simProductGetter);
+      event.put(std::move(i.second), i.first);
+    }
+
+    if (tvdHits) event.put(std::move(tvdHits), subEvents_.front().tvdName);
+    if (trajectories) event.put(std::move(trajectories));
+    if (simsRemap) event.put(std::move(simsRemap));
+    if (extMonFNALHits) event.put(std::move(extMonFNALHits));
+
+    return true;
+  }
+
+
+  void Mu2eG4SubEventMerger::fixSimParticlePtrs(StepPointMCCollection& steps,
+                                                art::EDProductGetter const* simProductGetter) {
+    for (auto& step : steps) {
+      if (step.simParticle().isNonnull()) {
+        step.simParticle() = art::Ptr<SimParticle>(step.simParticle().id(),
+                                                   step.simParticle().key(),
+                                                   simProductGetter);
+      }
+    }
+  }
+
+} // end namespace mu2e
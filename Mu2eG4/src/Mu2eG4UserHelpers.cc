@@ -202,13 +202,18 @@ namespace mu2e {
     // G4String const & findStepStoppingProcessName(G4Step const* const aStep){
     G4String findStepStoppingProcessName(G4Step const* const aStep){
 
-      G4VProcess const* process = aStep->GetPostStepPoint()->GetProcessDefinedStep();
+      G4VProcess const* process = findStepStoppingProcess(aStep);
 
-      if (process) {
+      return process ? process->GetProcessName() : G4String("NotSpecified");
 
-        return process->GetProcessName();
+    }
 
-      } else {
+    // Find the process that defined the step
+    G4VProcess const* findStepStoppingProcess(G4Step const* const aStep){
+
+      G4VProcess const* process = aStep->GetPostStepPoint()->GetProcessDefinedStep();
+
+      if (!process) {
         static bool printItOnce = true;
         if (printItOnce) {
           printItOnce = false;
@@ -219,11 +224,10 @@ namespace mu2e {
           printItOnce2 = false;
           cout << __func__ << " The above message will not be repeated " << endl;
         }
-        //        static const G4String pname = G4String("NotSpecified");
-        return G4String("NotSpecified");
-
       }
 
+      return process;
+
     }
 
     void printProcessNotSpecifiedWarning(G4Track const * const trk) {
@@ -42,6 +42,7 @@
 //Other includes
 #include "CLHEP/Random/JamesRandom.h"
 #include <tbb/atomic.h>
+#include <cstdint>
 
 
 using namespace std;
@@ -55,6 +56,16 @@ namespace {
 
   int getThreadIndex() { return s_thread_index; }
 
+  // finalizer of splitmix64
+  uint64_t mixBits(uint64_t h) {
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    return h;
+  }
+
 
 }
 
@@ -67,6 +78,8 @@ namespace mu2e {
     G4WorkerRunManager(),
     conf_(conf),
     m_managerInitialized(false),
+    m_subEventSeeded(false),
+    m_subEventSeeds{0,0,0},
     m_steppingVerbose(true),
     m_mtDebugOutput(conf.debug().mtDebugOutput()),
     rmvlevel_(conf.debug().diagLevel()),
@@ -275,6 +288,29 @@ namespace mu2e {
   }
 
 
+  void Mu2eG4WorkerRunManager::processSubEvent(art::Event* event, unsigned subEventIndex, long s1, long s2){
+
+    m_subEventSeeded = true;
+    subEventSeeds(s1, s2, subEventIndex, m_subEventSeeds);
+
+    processEvent(event);
+    m_subEventSeeded = false;
+  }
+
+
+  // Each seed is a hash of (s1, s2, index), kept positive and non-zero like the
+  // seeds drawn by the master, so that every sub-event has its own stream.
+  void Mu2eG4WorkerRunManager::subEventSeeds(long s1, long s2, unsigned subEventIndex, long seeds[3]){
+
+    uint64_t h = mixBits(uint64_t(s1) ^ mixBits(uint64_t(s2) ^ mixBits(uint64_t(subEventIndex) + 1)));
+    for (int i = 0; i < 2; ++i) {
+      h = mixBits(h + i);
+      seeds[i] = long(h % 0x7ffffffeULL) + 1;
+    }
+    seeds[2] = 0;
+  }
+
+
   void Mu2eG4WorkerRunManager::processEvent(art::Event* event){
 
     numberOfEventToBeProcessed = 1;
@@ -302,7 +338,17 @@ namespace mu2e {
     long s3 = 0;
     G4bool eventHasToBeSeeded = true;
     
-    eventLoopOnGoing = G4MTRunManager::GetMasterRunManager()->SetUpAnEvent(anEvent,s1,s2,s3,eventHasToBeSeeded);
+    // the seeds of a sub-event were already drawn once for the whole art event
+    if(m_subEventSeeded) {
+      eventHasToBeSeeded = false;
+      eventLoopOnGoing = true;
+      s1 = m_subEventSeeds[0];
+      s2 = m_subEventSeeds[1];
+      G4Random::setTheSeeds(m_subEventSeeds,-1);
+    }
+    else {
+      eventLoopOnGoing = G4MTRunManager::GetMasterRunManager()->SetUpAnEvent(anEvent,s1,s2,s3,eventHasToBeSeeded);
+    }
     runIsSeeded = true;
     
     if(!eventLoopOnGoing)
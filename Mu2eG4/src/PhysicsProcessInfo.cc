@@ -31,6 +31,7 @@
 // G4 includes
 #include "G4ParticleTable.hh"
 #include "G4ProcessManager.hh"
+#include "G4VProcess.hh"
 
 using namespace std;
 
@@ -39,12 +40,16 @@ namespace mu2e{
 
   PhysicsProcessInfo::PhysicsProcessInfo():
     _allProcesses(),
+    _byProcess(),
+    _notSpecified(nullptr),
     _longestName(0){
   }
     
   void PhysicsProcessInfo::beginRun(){
       
     _allProcesses.clear();
+    _byProcess.clear();
+    _notSpecified = nullptr;
 
     // Number of processes that are not known to the ProcessCode enum.
     int nUnknownProcesses(0);
@@ -97,6 +102,8 @@ namespace mu2e{
           jj = result.first;
 
         }
+        _byProcess[proc] = &jj->second;
+
         // we will artificially attach "FieldPropagator" to all particles
         // fixme : do it only for charged particles; factorize the code
 
@@ -147,6 +154,7 @@ namespace mu2e{
     // Add Unspecified to the particleNames vector
     ProcInfo& pinfo = resultFirst ->second;
     pinfo.particleNames.push_back(G4String("Unspecified"));
+    _notSpecified = &pinfo;
 
     if (nUnknownProcesses > 0 ){
       throw cet::exception("RANGE")
@@ -173,7 +181,7 @@ namespace mu2e{
     // printAll(cout);
   }
 
-  // This can possibly be sped up considerably by checking frequently occuring names first.
+  // The stepping code uses the G4VProcess* overload, which avoids the string comparisons.
   ProcessCode PhysicsProcessInfo::findAndCount( G4String const& name ){
       
     map_type::iterator i = _allProcesses.find(name);
@@ -184,12 +192,41 @@ namespace mu2e{
         << "\n";
     }
 
+    return increment(i->second);
+  }
+
+  ProcessCode PhysicsProcessInfo::findAndCount( G4VProcess const* process ){
+
+    if ( !process ){
+      return increment(*_notSpecified);
+    }
+
+    auto i = _byProcess.find(process);
+    if ( i != _byProcess.end() ){
+      return increment(*i->second);
+    }
+
+    // A process created after beginRun; look it up by name once.
+    map_type::iterator j = _allProcesses.find(process->GetProcessName());
+    if ( j == _allProcesses.end() ){
+      throw cet::exception("RANGE")
+        << "Could not find physics process in PhysicsProcessInfo.  : "
+        << process->GetProcessName()
+        << "\n";
+    }
+    _byProcess[process] = &j->second;
+
+    return increment(j->second);
+  }
+
+  ProcessCode PhysicsProcessInfo::increment( ProcInfo& info ){
+
     // Protect against overflowing the counters on very long jobs.
-    if(i->second.count < std::numeric_limits<size_t>::max()) {
-      ++i->second.count;
+    if(info.count < std::numeric_limits<size_t>::max()) {
+      ++info.count;
     }
 
-    return i->second.code;
+    return info.code;
   }
 
   void PhysicsProcessInfo::printAll ( std::ostream& os) const{
@@ -75,6 +75,9 @@ namespace mu2e {
 
     hitInputs_ = perThreadObjects_->genInputHits;
 
+    firstPrimary_ = perThreadObjects_->firstPrimary;
+    lastPrimary_ = perThreadObjects_->lastPrimary;
+
     parentMapping_ = perThreadObjects_->simParticlePrimaryHelper;
 
   }
@@ -106,9 +109,14 @@ namespace mu2e {
       (!_config.getBool("mu2e.standardDetector",true) || !(geom->isStandardMu2eDetector()))
       ?  G4ThreeVector(0.0,0.0,0.0) : (GeomHandle<WorldG4>())->mu2eOriginInWorld();
 
+    // Index of the primary among all the inputs, only those in [firstPrimary_, lastPrimary_) are
+    // added; this is how Mu2eG4MT splits a large event into sub-events.
+    unsigned iPrimary = 0;
+
     // For each generated particle, add it to the event.
     if(genParticles_) {
-      for (unsigned i=0; i < genParticles_->size(); ++i) {
+      for (unsigned i=0; i < genParticles_->size(); ++i, ++iPrimary) {
+        if(iPrimary < firstPrimary_ || iPrimary >= lastPrimary_) continue;
         const GenParticle& genpart = (*genParticles_)[i];
         addG4Particle(event,
                       genpart.pdgId(),
@@ -140,6 +148,8 @@ namespace mu2e {
     for(const auto& hitcoll : *hitInputs_) {
 
       for(const auto& hit : *hitcoll) {
+        const unsigned index = iPrimary++;
+        if(index < firstPrimary_ || index >= lastPrimary_) continue;
         addG4Particle(event,
                       hit.simParticle()->pdgId(),
                       // Transform into G4 world coordinate system
@@ -238,7 +238,7 @@ namespace mu2e {
 
     // Which process caused this step to end?
     ProcessCode endCode(_processInfo->
-                        findAndCount(Mu2eG4UserHelpers::findStepStoppingProcessName(aStep)));
+                        findAndCount(Mu2eG4UserHelpers::findStepStoppingProcess(aStep)));
 
 
     _collection->push_back( StepPointMC(_spHelper->particlePtr(aStep->GetTrack()),
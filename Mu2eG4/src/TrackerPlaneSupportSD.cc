@@ -65,7 +65,7 @@ namespace mu2e {
 
     // Which process caused this step to end?
     ProcessCode endCode(_processInfo->
-                        findAndCount(Mu2eG4UserHelpers::findStepStoppingProcessName(aStep)));
+                        findAndCount(Mu2eG4UserHelpers::findStepStoppingProcess(aStep)));
 
     G4int sdcn = 0;
 
@@ -65,7 +65,7 @@ namespace mu2e {
 
     // Which process caused this step to end?
     ProcessCode endCode(_processInfo->
-                        findAndCount(Mu2eG4UserHelpers::findStepStoppingProcessName(aStep)));
+                        findAndCount(Mu2eG4UserHelpers::findStepStoppingProcess(aStep)));
 
     // Add the hit to the framework collection.
     // The point's coordinates are saved in the mu2e coordinate system.
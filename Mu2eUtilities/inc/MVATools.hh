@@ -26,14 +26,41 @@ namespace mu2e
        explicit MVATools(fhicl::ParameterSet const&);
        explicit MVATools(const Config& conf);
 
+       // Scratch memory for the evaluation, owned by the caller so that
+       // evaluations in different threads do not share buffers
+       struct Scratch
+       {
+          std::vector<float> x;
+          std::vector<float> y;
+       };
+
        virtual ~MVATools();
        void     initMVA();
        float    evalMVA(const std::vector<float>&,  const MVAMask& vmask=0xffffffff) const;
        float    evalMVA(const std::vector<double>&, const MVAMask& vmask=0xffffffff) const;
+
+       // Evaluate nrow input vectors at once: row r starts at in + r*stride and its
+       // result is written to out[r]. The results are identical to evalMVA of each row.
+       void     evalMVA(const float*  in, size_t nrow, size_t stride, float* out,
+                        Scratch& scratch, const MVAMask& vmask=0xffffffff) const;
+       void     evalMVA(const double* in, size_t nrow, size_t stride, float* out,
+                        Scratch& scratch, const MVAMask& vmask=0xffffffff) const;
        void     showMVA() const;
        
+       unsigned nVars() const { return title_.size();}
+       float    varMin(unsigned i) const { return voffset_.at(i);}
+       float    varMax(unsigned i) const { return voffset_.at(i)+2.0/vscale_.at(i);}
        const std::vector<std::string>& titles() const { return title_;}     
        const std::vector<std::string>& labels() const { return label_;}     
+
+       // The network itself, for checks of the evaluation
+       const std::vector<unsigned>&    layers() const { return links_;}
+       const std::vector<float>&       weights() const { return wgts_;}
+       const std::vector<float>&       normOffsets() const { return voffset_;}
+       const std::vector<float>&       normScales() const { return vscale_;}
+       const std::string&              activationType() const { return activationTypeString_;}
+       bool     isNormalized() const { return isNorm_;}
+       bool     isOldMVA() const { return oldMVA_;}
  
  
     private:       
@@ -44,10 +71,11 @@ namespace mu2e
        void   getNorm(xercesc::DOMDocument* xmlDoc);
        void   getWgts(xercesc::DOMDocument* xmlDoc);
        float  activation(float arg) const;
+       void   activation(float* v, size_t n) const;
+       template<class T> float evalOne(const T* v, Scratch& scratch, const MVAMask& mask) const;
+       template<class T> void evalBatch(const T* in, size_t nrow, size_t stride, float* out,
+                                        Scratch& scratch, const MVAMask& mask) const;
 
-       mutable std::vector<float> x_;
-       mutable std::vector<float> y_;
-       mutable std::vector<float> fv_;       
        std::vector<float>         wgts_;
        std::vector<unsigned>      links_;
        unsigned                   maxNeurons_;
@@ -0,0 +1,130 @@
+// A bump allocator for the temporary containers that reconstruction
+// modules build and throw away in every event: hit lists by panel,
+// time buckets, sets of candidate straws.  Memory is taken from a few
+// large blocks and released all at once when the outermost Scope
+// ends, normally at the end of produce().  The blocks are kept for the
+// next event, so once the arena has grown to the size of a busy event
+// there are no more calls to malloc.
+//
+// Typical use in a module:
+//
+//   ScratchArena arena_{"StrawHitReco", printLevel > 0};
+//   ...
+//   void produce(art::Event& event) {
+//     ScratchArena::Scope scope(arena_);
+//     ScratchVector<size_t> hits(arena_.allocator<size_t>());
+//     ...
+//   }
+//
+// Memory is never given back before the Scope ends: a container that
+// grows leaves its old buffer behind, so reserve() when the size is
+// known.  Containers must not outlive the Scope they were made in.
+//
+// An arena is not thread-safe.  It is meant to be a member of a module
+// (or of an algorithm object owned by one), so that each module, and
+// each copy of a replicated module, has its own.  The usage statistics
+// are therefore per module; they are printed by the destructor when
+// requested at construction.
+
+#ifndef Mu2eUtilities_ScratchArena_hh
+#define Mu2eUtilities_ScratchArena_hh
+
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace mu2e {
+
+  template<class T> class ScratchAllocator;
+
+  class ScratchArena {
+  public:
+
+    struct Stats {
+      size_t peakBytes = 0;    // largest number of bytes in use at once
+      size_t nAllocations = 0; // allocations served by the arena
+      size_t nBlocks = 0;      // blocks obtained from the heap
+      size_t nScopes = 0;      // outermost scopes, normally events
+    };
+
+    // Rewinds the arena when it goes out of scope. Scopes can be nested;
+    // the memory is released to the blocks when the outermost one ends.
+    class Scope {
+    public:
+      explicit Scope(ScratchArena& arena);
+      ~Scope();
+      Scope(const Scope&) = delete;
+      Scope& operator=(const Scope&) = delete;
+    private:
+      ScratchArena& arena_;
+      size_t block_;
+      size_t offset_;
+      size_t used_;
+    };
+
+    explicit ScratchArena(const std::string& name, bool printStats = false,
+                          size_t blockSize = 64*1024);
+    ~ScratchArena();
+    ScratchArena(const ScratchArena&) = delete;
+    ScratchArena& operator=(const ScratchArena&) = delete;
+
+    void* allocate(size_t bytes, size_t align);
+
+    template<class T> ScratchAllocator<T> allocator() { return ScratchAllocator<T>(*this); }
+
+    size_t bytesInUse() const { return used_; }
+    const Stats& stats() const { return stats_; }
+    const std::string& name() const { return name_; }
+    void print(std::ostream& os) const;
+
+  private:
+
+    struct Block {
+      std::unique_ptr<char[]> data;
+      size_t size;
+    };
+
+    void newBlock(size_t minSize);
+    void release();
+
+    std::string name_;
+    bool printStats_;
+    size_t blockSize_;
+    std::vector<Block> blocks_;
+    size_t block_;  // current block
+    size_t offset_; // first free byte in the current block
+    size_t used_;
+    int depth_;
+    Stats stats_;
+  };
+
+  // STL allocator on a ScratchArena; deallocate does nothing
+  template<class T>
+  class ScratchAllocator {
+  public:
+    typedef T value_type;
+
+    explicit ScratchAllocator(ScratchArena& arena) : arena_(&arena) {}
+    template<class U> ScratchAllocator(const ScratchAllocator<U>& other) : arena_(other.arena()) {}
+
+    T* allocate(size_t n) { return static_cast<T*>(arena_->allocate(n*sizeof(T), alignof(T))); }
+    void deallocate(T*, size_t) {}
+
+    ScratchArena* arena() const { return arena_; }
+
+  private:
+    ScratchArena* arena_;
+  };
+
+  template<class T, class U>
+  bool operator==(const ScratchAllocator<T>& a, const ScratchAllocator<U>& b) { return a.arena() == b.arena(); }
+  template<class T, class U>
+  bool operator!=(const ScratchAllocator<T>& a, const ScratchAllocator<U>& b) { return a.arena() != b.arena(); }
+
+  template<class T> using ScratchVector = std::vector<T, ScratchAllocator<T> >;
+
+}
+
+#endif /* Mu2eUtilities_ScratchArena_hh */
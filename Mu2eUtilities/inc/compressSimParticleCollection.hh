@@ -28,6 +28,8 @@
 //    3 - the input collection
 //    4 - the object that knows whether to keep or delete each item - see note 7.
 //    5 - the output collection.
+//    6 - optional, a map from the old to the new keys; if given, the kept particles get
+//        new consecutive keys, following those already in the output collection.
 //
 // 6) The code will throw if you try to save a secondary particle without also saving its mother.
 //
@@ -58,28 +60,21 @@ namespace mu2e {
   typedef std::map<cet::map_vector_key, cet::map_vector_key> KeyRemap;
 
   // Pass in the old key to check if it's already added to keyRemap, if it hasn't been then use nextNewKey for the next key
-  cet::map_vector_key getNewKey(const cet::map_vector_key& oldKey, KeyRemap* keyRemap, const unsigned int& nextNewKey) {
-    cet::map_vector_key nextKey;
-
-    if ( keyRemap->find(oldKey) == keyRemap->end() ) { // might have already added the key since parents have a position reserved before they are added to the output
-      nextKey = cet::map_vector_key(nextNewKey);
-      keyRemap->insert( std::make_pair(oldKey, nextKey) ); // update the map
-    }
-    else {
-      nextKey = keyRemap->at(oldKey);
-    }
-
-    return nextKey;
+  // KEYREMAP can be KeyRemap or any map whose insert(pair), like std::map's, does not replace an existing entry
+  template<typename KEYREMAP>
+  cet::map_vector_key getNewKey(const cet::map_vector_key& oldKey, KEYREMAP* keyRemap, const unsigned int& nextNewKey) {
+    // might have already added the key since parents have a position reserved before they are added to the output
+    return keyRemap->insert( std::make_pair(oldKey, cet::map_vector_key(nextNewKey)) ).first->second;
   }
 
 
-  template<typename SELECTOR, typename OUTCOLL>
+  template<typename SELECTOR, typename OUTCOLL, typename KEYREMAP = KeyRemap>
   void compressSimParticleCollection ( art::ProductID         const& newProductID,
                                        art::EDProductGetter   const* productGetter,
                                        SimParticleCollection  const& in,
                                        SELECTOR               const& keep,
                                        OUTCOLL&        out,
-				       KeyRemap* keyRemap = NULL){
+				       KEYREMAP* keyRemap = NULL){
 
     unsigned int initial_out_size = out.size();
     for ( SimParticleCollection::const_iterator i=in.begin(), e=in.end(); i!=e; ++i ){
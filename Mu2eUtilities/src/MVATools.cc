@@ -14,6 +14,9 @@
 #include <vector>
 #include <sstream>
 #include <limits>
+#include <algorithm>
+#include <utility>
+#include <cmath>
 
 using namespace xercesc;
 
@@ -21,9 +24,6 @@ namespace mu2e
 {
 
   MVATools::MVATools(const Config& config) : 
-    x_(),
-    y_(),
-    fv_(),
     wgts_(), 
     maxNeurons_(0), 
     activeType_(aType::null),
@@ -42,9 +42,6 @@ namespace mu2e
   }
 
   MVATools::MVATools(fhicl::ParameterSet const& pset) : 
-    x_(),
-    y_(),
-    fv_(),
     wgts_(), 
     maxNeurons_(0), 
     activeType_(aType::null),
@@ -322,8 +319,6 @@ namespace mu2e
       }
 
       maxNeurons_ = *std::max_element(links_.begin(),links_.end());
-      x_ = std::vector<float>(maxNeurons_,0.0f);
-      y_ = std::vector<float>(maxNeurons_,0.0f);
 
       XMLString::release(&ATT_INDEX);
       XMLString::release(&ATT_NSYNAPSES);    
@@ -334,12 +329,38 @@ namespace mu2e
 
   float MVATools::evalMVA(const std::vector<double >& v, const MVAMask& mask) const 
   {
-     for (size_t i=0;i<v.size();++i)  fv_[i] = static_cast<float>(v[i]);   
-     return evalMVA(fv_,mask);
+     static thread_local Scratch scratch;
+     return evalOne(v.data(),scratch,mask);
   }
 
   float MVATools::evalMVA(const std::vector<float>& v, const MVAMask& mask) const 
   {
+     static thread_local Scratch scratch;
+     return evalOne(v.data(),scratch,mask);
+  }
+
+  void MVATools::evalMVA(const float* in, size_t nrow, size_t stride, float* out,
+                         Scratch& scratch, const MVAMask& mask) const 
+  {
+     evalBatch(in,nrow,stride,out,scratch,mask);
+  }
+
+  void MVATools::evalMVA(const double* in, size_t nrow, size_t stride, float* out,
+                         Scratch& scratch, const MVAMask& mask) const 
+  {
+     evalBatch(in,nrow,stride,out,scratch,mask);
+  }
+
+
+  // One vector at a time, with the neuron values in registers rather than in rows
+  // of length one; the sums and the activation are those of evalBatch.
+  template<class T>
+  float MVATools::evalOne(const T* v, Scratch& scratch, const MVAMask& mask) const 
+  {
+      scratch.x.resize(maxNeurons_);
+      scratch.y.resize(maxNeurons_);
+      float* x = scratch.x.data();
+      float* y = scratch.y.data();
 
       // Normalize the input data and add the bias node, skip masked values
       size_t ival(0);
@@ -347,41 +368,143 @@ namespace mu2e
       {
          if ( mask & (1<<ivar) )
          {
-	    x_[ival]= isNorm_ ? (v[ivar]-voffset_[ival])*vscale_[ival] - 1.0 : v[ivar];
+            float vi = static_cast<float>(v[ivar]);
+	    x[ival]= isNorm_ ? (vi-voffset_[ival])*vscale_[ival] - 1.0 : vi;
 	    ++ival;
          }
       }
-      x_[ival] = 1.0;
+      x[ival] = 1.0f;
 
       if (ival != links_[0]-1)
           throw cet::exception("RECO")<<"mu2e::MVATools: mismatch input dimension and network architecture" << std::endl;
 
-
       //perform feed forward calculation up to the last hidden layer
       unsigned idxWeight(0);
       for (unsigned k=0;k<links_.size()-1;++k)
       {          
-          //the number of synpases is given by the number of neurons in the next layer -1 (do not count bias neuron!)
-          for (unsigned j=0;j<links_[k+1]-1;++j)
+          const unsigned nOut = links_[k+1]-1;
+          for (unsigned j=0;j<nOut;++j)
           {
-	     y_[j]=0.0f;
-	     for (unsigned i=0;i<links_[k];++i) y_[j] += wgts_[i+idxWeight]*x_[i];
-             y_[j] = activation(y_[j]);
+             float yj(0.0f);
+	     for (unsigned i=0;i<links_[k];++i) yj += wgts_[i+idxWeight]*x[i];
+             y[j] = activation(yj);
              idxWeight += links_[k];
           }      
-          x_.swap(y_); 
-          x_[links_[k+1]-1] = 1.0f; //add bias neuron
+          std::swap(x,y); 
+          x[nOut] = 1.0f; //add bias neuron
       }   
 
       //calculate output neuron value
-      float yf(0.0);
-      for (unsigned i=0;i<links_.back();++i) yf += wgts_[i+idxWeight]*x_[i];
+      float yf(0.0f);
+      for (unsigned i=0;i<links_.back();++i) yf += wgts_[i+idxWeight]*x[i];
 
       if (oldMVA_) return yf;
       return  1.0/(1.0+expf(-yf));
   }
 
 
+  // The layers are evaluated for all rows at once, as a matrix product. The neuron values
+  // are stored neuron-major, x[i*nrow+r] is neuron i of row r, so the innermost loops run
+  // over contiguous rows and vectorize. Each row still sums its inputs in the same order
+  // as a single evaluation, so the results do not depend on the batch size.
+  template<class T>
+  void MVATools::evalBatch(const T* in, size_t nrow, size_t stride, float* out,
+                           Scratch& scratch, const MVAMask& mask) const 
+  {
+      if (nrow==0) return;
+      if (nrow==1) 
+      {
+         out[0] = evalOne(in,scratch,mask);
+         return;
+      }
+      scratch.x.resize(maxNeurons_*nrow);
+      scratch.y.resize(maxNeurons_*nrow);
+      float* x = scratch.x.data();
+      float* y = scratch.y.data();
+
+      // Normalize the input data and add the bias node, skip masked values
+      size_t ival(0);
+      for (size_t ivar=0; ivar < voffset_.size(); ivar++)
+      {
+         if ( mask & (1<<ivar) )
+         {
+            float* xi = x + ival*nrow;
+            for (size_t r=0;r<nrow;++r)
+            {
+               float v = static_cast<float>(in[r*stride+ivar]);
+	       xi[r] = isNorm_ ? (v-voffset_[ival])*vscale_[ival] - 1.0 : v;
+            }
+	    ++ival;
+         }
+      }
+
+      if (ival != links_[0]-1)
+          throw cet::exception("RECO")<<"mu2e::MVATools: mismatch input dimension and network architecture" << std::endl;
+
+      std::fill(x+ival*nrow,x+(ival+1)*nrow,1.0f);
+
+      //perform feed forward calculation up to the last hidden layer
+      unsigned idxWeight(0);
+      for (unsigned k=0;k<links_.size()-1;++k)
+      {          
+          //the number of synpases is given by the number of neurons in the next layer -1 (do not count bias neuron!)
+          const unsigned nOut = links_[k+1]-1;
+          for (unsigned j=0;j<nOut;++j)
+          {
+             float* yj = y + j*nrow;
+             std::fill(yj,yj+nrow,0.0f);
+	     for (unsigned i=0;i<links_[k];++i) 
+             {
+                const float w = wgts_[i+idxWeight];
+                const float* xi = x + i*nrow;
+                for (size_t r=0;r<nrow;++r) yj[r] += w*xi[r];
+             }
+             activation(yj,nrow);
+             idxWeight += links_[k];
+          }      
+          std::swap(x,y); 
+          std::fill(x+nOut*nrow,x+(nOut+1)*nrow,1.0f); //add bias neuron
+      }   
+
+      //calculate output neuron value
+      std::fill(out,out+nrow,0.0f);
+      for (unsigned i=0;i<links_.back();++i) 
+      {
+         const float w = wgts_[i+idxWeight];
+         const float* xi = x + i*nrow;
+         for (size_t r=0;r<nrow;++r) out[r] += w*xi[r];
+      }
+
+      if (oldMVA_) return;
+      for (size_t r=0;r<nrow;++r) out[r] = 1.0/(1.0+expf(-out[r]));
+  }
+
+
+  // the same values as activation(float) for each element; the tanh approximation 
+  // is computed for all elements and the saturated ones replaced, so the loop vectorizes
+  void MVATools::activation(float* v, size_t n) const
+  {
+     if (activeType_== aType::tanh && !oldMVA_)
+     {
+       // 4.97f compares as 4.97 does, no float lies between them
+       for (size_t i=0;i<n;++i)
+       {
+          float arg = v[i];
+          float arg2 = arg * arg;
+          float a = arg * (135135.0f + arg2 * (17325.0f + arg2 * (378.0f + arg2)));
+          float b = 135135.0f + arg2 * (62370.0f + arg2 * (3150.0f + arg2 * 28.0f));
+          float t = a/b;
+          v[i] = arg > 4.97f ? 1.0f : (arg < -4.97f ? -1.0f : t);
+       }
+       return;
+     }
+     if (activeType_== aType::relu)
+     {
+       for (size_t i=0;i<n;++i) v[i] = std::max(0.0f,v[i]);
+       return;
+     }
+     for (size_t i=0;i<n;++i) v[i] = activation(v[i]);
+  }
 
 
   float MVATools::activation(float arg) const
@@ -0,0 +1,95 @@
+#include "Mu2eUtilities/inc/ScratchArena.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+
+namespace mu2e {
+
+  ScratchArena::Scope::Scope(ScratchArena& arena)
+    : arena_(arena), block_(arena.block_), offset_(arena.offset_), used_(arena.used_)
+  {
+    ++arena_.depth_;
+  }
+
+  ScratchArena::Scope::~Scope() {
+    if (--arena_.depth_ == 0) {
+      arena_.release();
+    } else {
+      arena_.block_ = block_;
+      arena_.offset_ = offset_;
+      arena_.used_ = used_;
+    }
+  }
+
+  ScratchArena::ScratchArena(const std::string& name, bool printStats, size_t blockSize)
+    : name_(name), printStats_(printStats), blockSize_(blockSize),
+      block_(0), offset_(0), used_(0), depth_(0)
+  {}
+
+  ScratchArena::~ScratchArena() {
+    if (printStats_) print(std::cout);
+  }
+
+  void* ScratchArena::allocate(size_t bytes, size_t align) {
+    ++stats_.nAllocations;
+    while (true) {
+      if (block_ < blocks_.size()) {
+        Block& b = blocks_[block_];
+        uintptr_t base = reinterpret_cast<uintptr_t>(b.data.get());
+        size_t start = ((base + offset_ + align - 1) & ~uintptr_t(align - 1)) - base;
+        if (start + bytes <= b.size) {
+          used_ += start + bytes - offset_;
+          stats_.peakBytes = std::max(stats_.peakBytes, used_);
+          offset_ = start + bytes;
+          return b.data.get() + start;
+        }
+        // the blocks after the current one are free: use them before a new one
+        if (block_ + 1 < blocks_.size()) {
+          ++block_;
+          offset_ = 0;
+          continue;
+        }
+      }
+      newBlock(bytes + align);
+    }
+  }
+
+  // each new block is at least as large as all the previous ones together,
+  // so the number of blocks grows as the log of the memory used
+  void ScratchArena::newBlock(size_t minSize) {
+    size_t total(0);
+    for (const auto& b : blocks_) total += b.size;
+    Block b;
+    b.size = std::max({blockSize_, minSize, total});
+    b.data.reset(new char[b.size]);
+    blocks_.push_back(std::move(b));
+    block_ = blocks_.size() - 1;
+    offset_ = 0;
+    ++stats_.nBlocks;
+  }
+
+  // end of the outermost scope. When the event needed several blocks,
+  // replace them by one large enough for all, so the next event has no
+  // block boundaries to skip and no more heap allocations.
+  void ScratchArena::release() {
+    ++stats_.nScopes;
+    if (blocks_.size() > 1) {
+      size_t total(0);
+      for (const auto& b : blocks_) total += b.size;
+      blocks_.clear();
+      blockSize_ = std::max(blockSize_, total);
+      newBlock(total);
+    }
+    block_ = 0;
+    offset_ = 0;
+    used_ = 0;
+  }
+
+  void ScratchArena::print(std::ostream& os) const {
+    os << "ScratchArena " << name_ << ": peak " << stats_.peakBytes << " bytes, "
+       << stats_.nAllocations << " allocations in " << stats_.nScopes << " scopes, "
+       << stats_.nBlocks << " heap blocks" << std::endl;
+  }
+
+}
@@ -0,0 +1,273 @@
+//
+// Standalone benchmark of the MLP evaluation in MVATools.
+//
+// For each weight file, random input vectors are drawn uniformly over the
+// normalization range of each variable, widened by 30% on either side so that
+// the saturated regions of the activation are exercised, and evaluated
+//
+//   reference one vector at a time with a copy of the scalar loop that
+//             evalMVA used before the batched evaluation;
+//   single    one vector at a time with evalMVA(std::vector<float>), as the
+//             modules do today;
+//   batch N   N vectors at a time with the batched evalMVA, for several N.
+//
+// It prints the time per vector for each and checks that the single and
+// batched results are bit-identical to the reference ones.  Without arguments, the MLP weight
+// files used by the production configurations are benchmarked; the files are
+// found through MU2E_SEARCH_PATH.
+//
+// Usage: mvaBench [options] [weightFile ...]
+//
+
+// C++ includes
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Framework includes
+#include "cetlib_except/exception.h"
+#include "fhiclcpp/ParameterSet.h"
+
+// Mu2e includes
+#include "Mu2eUtilities/inc/MVATools.hh"
+
+using namespace std;
+
+namespace {
+
+    struct Options {
+        vector<string> files;
+        size_t nVectors = 100000;
+        int nRepeat = 5;
+        unsigned seed = 12345;
+    };
+
+    const vector<string> productionFiles = {
+        "TrkHitReco/data/BkgMVAPanel.weights.xml",
+        "TrkHitReco/test/StereoMVA.weights.xml",
+        "TrkPatRec/test/HelixStereoHitMVA.weights.xml",
+        "TrkPatRec/test/HelixNonStereoHitMVA.weights.xml",
+        "TrkPatRec/test/TimeCluster.weights.xml",
+        "TrkPatRec/test/TimeClusterCalo.weights.xml",
+        "TrkDiag/test/TrkQual.weights.xml",
+        "TrkDiag/test/TrkQualPos.weights.xml",
+        "TrkDiag/test/TrkCaloHitPID.weights.xml"
+    };
+
+    const vector<size_t> batchSizes = { 1, 16, 256, 4096 };
+
+    // The evaluation of MVATools before the batched kernel, one vector at a
+    // time; kept unchanged as the reference the kernel must reproduce.
+    class ReferenceMLP {
+    public:
+        explicit ReferenceMLP(const mu2e::MVATools& mva)
+            : wgts_(mva.weights()),
+              links_(mva.layers()),
+              oldMVA_(mva.isOldMVA()),
+              isNorm_(mva.isNormalized()),
+              voffset_(mva.normOffsets()),
+              vscale_(mva.normScales()) {
+            const string& type = mva.activationType();
+            if (type.find("tanh") != string::npos) activeType_ = tanh;
+            if (type.find("sigmoid") != string::npos) activeType_ = sigmoid;
+            if (type.find("ReLU") != string::npos) activeType_ = relu;
+            unsigned maxNeurons = *max_element(links_.begin(), links_.end());
+            x_ = vector<float>(maxNeurons, 0.0f);
+            y_ = vector<float>(maxNeurons, 0.0f);
+        }
+
+        float eval(const vector<float>& v) const {
+            // Normalize the input data and add the bias node
+            size_t ival(0);
+            for (size_t ivar = 0; ivar < voffset_.size(); ivar++) {
+                x_[ival] = isNorm_ ? (v[ivar] - voffset_[ival]) * vscale_[ival] - 1.0 : v[ivar];
+                ++ival;
+            }
+            x_[ival] = 1.0;
+
+            // feed forward up to the last hidden layer
+            unsigned idxWeight(0);
+            for (unsigned k = 0; k < links_.size() - 1; ++k) {
+                for (unsigned j = 0; j < links_[k + 1] - 1; ++j) {
+                    y_[j] = 0.0f;
+                    for (unsigned i = 0; i < links_[k]; ++i) y_[j] += wgts_[i + idxWeight] * x_[i];
+                    y_[j] = activation(y_[j]);
+                    idxWeight += links_[k];
+                }
+                x_.swap(y_);
+                x_[links_[k + 1] - 1] = 1.0f;
+            }
+
+            // output neuron
+            float yf(0.0);
+            for (unsigned i = 0; i < links_.back(); ++i) yf += wgts_[i + idxWeight] * x_[i];
+
+            if (oldMVA_) return yf;
+            return 1.0 / (1.0 + expf(-yf));
+        }
+
+    private:
+        enum aType { null, tanh, sigmoid, relu };
+
+        float activation(float arg) const {
+            if (activeType_ == aType::tanh) {
+                if (oldMVA_) return std::tanh(arg);
+                if (arg > 4.97) return 1.0;
+                if (arg < -4.97) return -1.0;
+                float arg2 = arg * arg;
+                float a = arg * (135135.0f + arg2 * (17325.0f + arg2 * (378.0f + arg2)));
+                float b = 135135.0f + arg2 * (62370.0f + arg2 * (3150.0f + arg2 * 28.0f));
+                return a / b;
+            }
+            if (activeType_ == aType::sigmoid) return 1.0 / (1.0 + expf(-arg));
+            if (activeType_ == aType::relu) return std::max(0.0f, arg);
+            return -999.0;
+        }
+
+        const vector<float>& wgts_;
+        const vector<unsigned>& links_;
+        aType activeType_ = null;
+        bool oldMVA_;
+        bool isNorm_;
+        const vector<float>& voffset_;
+        const vector<float>& vscale_;
+        mutable vector<float> x_;
+        mutable vector<float> y_;
+    };
+
+    size_t countDiffs(const vector<float>& a, const vector<float>& b) {
+        size_t nDiff(0);
+        for (size_t r = 0; r < a.size(); ++r) {
+            if (memcmp(&a[r], &b[r], sizeof(float)) != 0) ++nDiff;
+        }
+        return nDiff;
+    }
+
+    void usage(const char* prog) {
+        cerr << "Usage: " << prog << " [options] [weightFile ...]\n"
+             << "  -n N      input vectors per file (default 100000)\n"
+             << "  -r N      times the vectors are evaluated for timing (default 5)\n"
+             << "  -S seed   random number seed (default 12345)\n";
+    }
+
+    double nsPerVector(chrono::steady_clock::time_point t0, chrono::steady_clock::time_point t1,
+                       size_t n) {
+        return chrono::duration<double, nano>(t1 - t0).count() / n;
+    }
+
+    bool benchmark(const string& file, const Options& opt) {
+        fhicl::ParameterSet pset;
+        pset.put<string>("MVAWeights", file);
+        mu2e::MVATools mva(pset);
+        mva.initMVA();
+
+        const size_t nv = mva.nVars();
+        const size_t n = opt.nVectors;
+        mt19937_64 engine(opt.seed);
+        uniform_real_distribution<float> flat(-0.3, 1.3);
+        vector<float> inputs(n * nv);
+        for (size_t r = 0; r < n; ++r) {
+            for (size_t i = 0; i < nv; ++i) {
+                inputs[r * nv + i] = mva.varMin(i) + (mva.varMax(i) - mva.varMin(i)) * flat(engine);
+            }
+        }
+
+        // the scalar loop of the evaluation before the batched kernel
+        ReferenceMLP ref(mva);
+        vector<float> reference(n);
+        vector<float> v(nv);
+        auto t0 = chrono::steady_clock::now();
+        for (int irep = 0; irep < opt.nRepeat; ++irep) {
+            for (size_t r = 0; r < n; ++r) {
+                copy(inputs.begin() + r * nv, inputs.begin() + (r + 1) * nv, v.begin());
+                reference[r] = ref.eval(v);
+            }
+        }
+        auto t1 = chrono::steady_clock::now();
+
+        cout << file << ": " << nv << " variables\n";
+        cout << "  reference   " << fixed << setprecision(1) << setw(8)
+             << nsPerVector(t0, t1, n * opt.nRepeat) << " ns/vector\n";
+
+        // single evaluations, as in the modules
+        vector<float> single(n);
+        t0 = chrono::steady_clock::now();
+        for (int irep = 0; irep < opt.nRepeat; ++irep) {
+            for (size_t r = 0; r < n; ++r) {
+                copy(inputs.begin() + r * nv, inputs.begin() + (r + 1) * nv, v.begin());
+                single[r] = mva.evalMVA(v);
+            }
+        }
+        t1 = chrono::steady_clock::now();
+
+        size_t nDiff = countDiffs(single, reference);
+        bool identical = nDiff == 0;
+        cout << "  single      " << setw(8) << nsPerVector(t0, t1, n * opt.nRepeat) << " ns/vector";
+        if (nDiff > 0) cout << "  " << nDiff << " results differ from reference";
+        cout << "\n";
+
+        mu2e::MVATools::Scratch scratch;
+        vector<float> batch(n);
+        for (size_t nb : batchSizes) {
+            t0 = chrono::steady_clock::now();
+            for (int irep = 0; irep < opt.nRepeat; ++irep) {
+                for (size_t r = 0; r < n; r += nb) {
+                    mva.evalMVA(inputs.data() + r * nv, min(nb, n - r), nv, batch.data() + r, scratch);
+                }
+            }
+            t1 = chrono::steady_clock::now();
+            nDiff = countDiffs(batch, reference);
+            identical = identical && nDiff == 0;
+            cout << "  batch " << setw(5) << nb << " " << setw(8)
+                 << nsPerVector(t0, t1, n * opt.nRepeat) << " ns/vector";
+            if (nDiff > 0) cout << "  " << nDiff << " results differ from reference";
+            cout << "\n";
+        }
+        return identical;
+    }
+
+} // end anonymous namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    int c;
+    while ((c = getopt(argc, argv, "n:r:S:h")) != -1) {
+        switch (c) {
+            case 'n':
+                opt.nVectors = strtoul(optarg, nullptr, 10);
+                break;
+            case 'r':
+                opt.nRepeat = atoi(optarg);
+                break;
+            case 'S':
+                opt.seed = strtoul(optarg, nullptr, 10);
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+    if (opt.nVectors < 1 || opt.nRepeat < 1) {
+        usage(argv[0]);
+        return 1;
+    }
+    for (int i = optind; i < argc; ++i) opt.files.push_back(argv[i]);
+    if (opt.files.empty()) opt.files = productionFiles;
+
+    bool identical = true;
+    try {
+        for (const auto& file : opt.files) identical = benchmark(file, opt) && identical;
+    } catch (cet::exception& e) {
+        cerr << e.what() << endl;
+        return 2;
+    }
+    return identical ? 0 : 3;
+}
@@ -16,6 +16,7 @@
 #include "TrackerConditions/inc/AlignedTrackerCache.hh"
 #include "TrackerConditions/inc/Mu2eMaterialCache.hh"
 #include "TrackerConditions/inc/Mu2eDetectorCache.hh"
+#include "TrackerConditions/inc/StrawGeometryCache.hh"
 
 using namespace std;
 
@@ -48,6 +49,8 @@ namespace mu2e {
     _caches[mmc->name()] = mmc;
     auto mdc = std::make_shared<mu2e::Mu2eDetectorCache>(_config.mu2eDetector());
     _caches[mdc->name()] = mdc;
+    auto sgc = std::make_shared<mu2e::StrawGeometryCache>(_config.strawGeometry());
+    _caches[sgc->name()] = sgc;
 
     if( _config.verbose()>0) {
       cout << "Proditions built caches:" << endl;
@@ -11,6 +11,7 @@
 #include <iostream>
 #include <vector>
 #include <string>
+#include <cstdint>
 #include "DataProducts/inc/TrkTypes.hh"
 #include "Mu2eInterfaces/inc/ProditionsEntity.hh"
 
@@ -34,10 +35,7 @@ namespace mu2e {
     StrawDrift():_name("StrawDrift") {}
     StrawDrift( std::vector<D2Tinfo> D2Tinfos, std::vector<float> distances,
                 std::vector<float> instantSpeeds, std::vector<float> averageSpeeds,
-		int phiBins ) : _name("StrawDrift"),
-      _D2Tinfos(D2Tinfos),  _distances(distances), 
-      _instantSpeeds(instantSpeeds), _averageSpeeds(averageSpeeds),
-      _phiBins(phiBins) {}
+		int phiBins );
 
     virtual ~StrawDrift() {}
 
@@ -50,6 +48,14 @@ namespace mu2e {
     double GetEffectiveSpeed(double dist, double phi) const; 
     double D2T(double dist, double phi) const;
     double T2D(double time, double phi) const;
+    // the same for n hits at once
+    void D2T(const double* dist, const double* phi, double* time, size_t n) const;
+    void T2D(const double* time, const double* phi, double* dist, size_t n) const;
+
+    // compare the lookups with a linear search of the tables at and around
+    // every table point.  Returns the largest difference; throws if it
+    // exceeds tolerance
+    double checkLookup(double tolerance) const;
 
     void print(std::ostream& os) const;
     std::string const& name() const { return _name; }
@@ -57,12 +63,48 @@ namespace mu2e {
   private:
     std::string _name;
 
+    // Finds the first bin of a non-increasing table whose value is <= x,
+    // which is what the drift lookups need, without scanning the table: a
+    // uniform grid over the value range gives a starting bin, and a short
+    // scan moves to the exact one.  Leading bins out of order are scanned.
+    class BinFinder {
+    public:
+      BinFinder() : _first(0), _invWidth(0.0) {}
+      explicit BinFinder(std::vector<float> const& values);
+      // values.size() if x is below all the values
+      size_t find(double x) const;
+      // the linear search, for reference
+      size_t scan(double x) const;
+      std::vector<float> const& values() const { return _values; }
+    private:
+      std::vector<float> _values;
+      size_t _first; // first bin of the ordered part
+      double _invWidth; // cells per unit of value
+      std::vector<uint32_t> _start; // first bin that can match in each cell
+    };
+
+    // interpolation between the phi bins
+    struct PhiWeights {
+      int lower, upper;
+      float lowerWeight, upperWeight;
+    };
+    PhiWeights phiWeights(float reducedPhi) const;
+
     // fold into first quadrant assuming the function
     // has x-z and y-z plane symmetry
     double ConstrainAngle(double phi) const;
+    // the phi folding of T2D and GetEffectiveSpeed
+    float reducePhi(double phi) const;
     // find distance bin
     size_t lowerDistanceBin(double dist) const;
 
+    // the lookups for a given distance or time bin ibin, as found by the
+    // BinFinders; ibin past the end means no bin was found
+    double gammaAt(size_t ibin, PhiWeights const& pw) const;
+    double effectiveSpeedAt(size_t ibin, PhiWeights const& pw) const;
+    double timeAt(size_t ibin, PhiWeights const& pw) const;
+    double distanceAt(size_t ibin, PhiWeights const& pw) const;
+
     // 2-D array in distance and phi 
     std::vector<D2Tinfo> _D2Tinfos;
     
@@ -72,6 +114,9 @@ namespace mu2e {
     std::vector<float> _averageSpeeds; // the average "nominal" speed
     
     size_t _phiBins;
+
+    BinFinder _distanceFinder; // on _distances
+    std::vector<BinFinder> _timeFinders; // on the times, for each phi bin
     
   };
 }
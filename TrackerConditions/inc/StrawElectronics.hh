@@ -46,6 +46,17 @@ namespace mu2e {
         _sigma(sigma), _t0(t0) {};
     };
 
+    // the parts of the linear response to a charge that do not change with time.  Computing
+    // these once per charge leaves only the table lookups for each time sampled
+    struct ChargeResponse {
+      std::array<double const*,npaths+1> _table0, _table1; // response tables of the wire distance points bracketing the charge, by path; the last is for saturation
+      double _distFrac; // interpolation weight of _table0
+      double _reflectionTime; // delay of the pulse reflected from the far end
+      double _reflectionScale; // relative size of the reflected pulse
+      double _charge;
+      std::array<double,npaths> _dVdI;
+    };
+
     typedef std::shared_ptr<StrawElectronics> ptr_t;
     typedef std::shared_ptr<const StrawElectronics> cptr_t;
 
@@ -114,6 +125,16 @@ namespace mu2e {
     // linear response to a charge pulse.  This does NOT include saturation effects,
     // since those are cumulative and cannot be computed for individual charges
     double linearResponse(Straw const& straw, Path ipath, double time, double charge, double distance, bool forsaturation=false) const; // mvolts per pCoulomb
+    // the same, split into a time-independent part and the lookup at a given time.  The results are identical
+    ChargeResponse chargeResponse(Straw const& straw, double charge, double distance) const;
+    double linearResponse(ChargeResponse const& cresp, Path ipath, double time, bool forsaturation=false) const;
+    // add the linear response to a charge arriving at tcharge to the voltages at each of the given times
+    // later than tstart.  Saturation is not supported
+    void addLinearResponse(ChargeResponse const& cresp, Path ipath, double tcharge, double tstart,
+	TrkTypes::ADCTimes const& times, double* volts) const;
+    // time after a charge pulse beyond which its linear response no longer changes: both the
+    // direct and the reflected pulse are past the end of the response tables
+    double constantResponseTime(Straw const& straw) const;
     double adcImpulseResponse(StrawId sid, double time, double charge) const;
     // Given a (linear) total voltage, compute the saturated voltage
     double saturatedResponse(double lineearresponse) const;
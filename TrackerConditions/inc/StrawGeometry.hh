@@ -0,0 +1,92 @@
+#ifndef TrackerConditions_StrawGeometry_hh
+#define TrackerConditions_StrawGeometry_hh
+//
+// A compact, read-only copy of the aligned straw geometry for the
+// hit loops of reconstruction.  The midpoints, wire directions,
+// lengths and radii of all straws are held as arrays of floats,
+// indexed by StrawId::uniqueStraw(), so a loop over hits reads
+// contiguous memory instead of following Plane/Panel/Straw pointers
+// and a loop over the straws of a panel can be vectorized.  The
+// neighbours of a straw are held as a mask of the straws of its panel.
+// Derived from the aligned Tracker, initialized with StrawGeometryMaker
+//
+
+// Mu2e includes
+#include "DataProducts/inc/StrawId.hh"
+#include "DataProducts/inc/XYZVec.hh"
+#include "Mu2eInterfaces/inc/ProditionsEntity.hh"
+
+// C++ includes
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace mu2e {
+
+  class StrawGeometry : public ProditionsEntity {
+
+  public:
+
+    typedef std::shared_ptr<StrawGeometry> ptr_t;
+    typedef std::shared_ptr<const StrawGeometry> cptr_t;
+    // one bit for each straw of a panel, by StrawId::straw()
+    typedef std::array<uint64_t,2> StrawMask;
+    friend class StrawGeometryMaker;
+
+    StrawGeometry();
+    virtual ~StrawGeometry() {}
+
+    // position of a straw in the arrays
+    static size_t index(StrawId const& id) { return id.uniqueStraw(); }
+    size_t nStraws() const { return _halfLength.size(); }
+
+    XYZVec midPoint(StrawId const& id) const { size_t i = index(id);
+      return XYZVec(_midX[i],_midY[i],_midZ[i]); }
+    XYZVec direction(StrawId const& id) const { size_t i = index(id);
+      return XYZVec(_dirX[i],_dirY[i],_dirZ[i]); }
+    float halfLength(StrawId const& id) const { return _halfLength[index(id)]; }
+    float activeHalfLength(StrawId const& id) const { return _activeHalfLength[index(id)]; }
+    float radius(StrawId const& id) const { return _radius[index(id)]; }
+
+    // the arrays, for loops over many straws
+    float const* midX() const { return _midX.data(); }
+    float const* midY() const { return _midY.data(); }
+    float const* midZ() const { return _midZ.data(); }
+    float const* dirX() const { return _dirX.data(); }
+    float const* dirY() const { return _dirY.data(); }
+    float const* dirZ() const { return _dirZ.data(); }
+    float const* halfLengths() const { return _halfLength.data(); }
+    float const* activeHalfLengths() const { return _activeHalfLength.data(); }
+    float const* radii() const { return _radius.data(); }
+
+    // the neighbours of a straw in its panel, as in Straw
+    StrawMask const& nearestNeighbours(StrawId const& id) const { return _nearest[index(id)]; }
+    StrawMask const& preampNeighbours(StrawId const& id) const { return _preamp[index(id)]; }
+    bool areNearestNeighbours(StrawId const& id, StrawId const& other) const {
+      return id.samePanel(other) && inMask(_nearest[index(id)],other);
+    }
+    bool arePreampNeighbours(StrawId const& id, StrawId const& other) const {
+      return id.samePanel(other) && inMask(_preamp[index(id)],other);
+    }
+    static bool inMask(StrawMask const& mask, StrawId const& id) {
+      return (mask[id.straw()>>6] >> (id.straw()&63)) & 1;
+    }
+
+    std::string const& name() const { return _name; }
+    void print( std::ostream& ) const;
+
+  private:
+    std::string _name;
+
+    std::vector<float> _midX, _midY, _midZ;
+    std::vector<float> _dirX, _dirY, _dirZ;
+    std::vector<float> _halfLength, _activeHalfLength, _radius;
+    std::vector<StrawMask> _nearest, _preamp;
+
+  };
+
+} // namespace mu2e
+
+#endif /* TrackerConditions_StrawGeometry_hh */
@@ -0,0 +1,53 @@
+#ifndef TrackerConditions_StrawGeometryCache_hh
+#define TrackerConditions_StrawGeometryCache_hh
+
+//
+// hold a set of run-dependent conditions objects
+// and update them when needed
+//
+
+#include "Mu2eInterfaces/inc/ProditionsCache.hh"
+#include "TrackerGeom/inc/Tracker.hh"
+#include "TrackerConditions/inc/StrawGeometryMaker.hh"
+#include "ProditionsService/inc/ProditionsHandle.hh"
+
+namespace mu2e {
+  class StrawGeometryCache : public ProditionsCache {
+  public: 
+    StrawGeometryCache(StrawGeometryConfig const& config):
+      ProditionsCache("StrawGeometry",config.verbose()),
+      _useDb(config.useDb()),_maker(config) {}
+
+
+    void initialize() {
+      _alignedTracker_p = std::make_unique<ProditionsHandle<Tracker> >();
+    }
+
+    set_t makeSet(art::EventID const& eid) {
+      auto tr = _alignedTracker_p->getPtr(eid);
+      // this is the set of DB cid's it depends on
+      return tr->getCids();
+    }
+
+    DbIoV makeIov(art::EventID const& eid) {
+      _alignedTracker_p->get(eid); // check up to date
+      return _alignedTracker_p->iov();
+    }
+
+    ProditionsEntity::ptr makeEntity(art::EventID const& eid) {
+      auto tr = _alignedTracker_p->getPtr(eid);
+      return _maker.fromFcl(tr);
+    }
+
+  private:
+    bool _useDb;
+    StrawGeometryMaker _maker;
+
+    // this handle is not default constructed
+    // so to not create a dependency loop on construction
+    std::unique_ptr<ProditionsHandle<Tracker> > _alignedTracker_p;
+
+  };
+};
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef TrackerConditions_StrawGeometryMaker_hh
+#define TrackerConditions_StrawGeometryMaker_hh
+//
+// Make StrawGeometry from the aligned Tracker
+//
+
+#include "TrackerGeom/inc/Tracker.hh"
+#include "TrackerConditions/inc/StrawGeometry.hh"
+#include "TrackerConfig/inc/StrawGeometryConfig.hh"
+
+namespace mu2e {
+
+  class StrawGeometryMaker {
+
+  public:
+    StrawGeometryMaker(StrawGeometryConfig const& config):_config(config) {}
+    StrawGeometry::ptr_t fromFcl(Tracker::cptr_t tracker);
+
+  private:
+
+    // this object needs to be thread safe, 
+    // _config should only be initialized once
+    const StrawGeometryConfig _config;
+  };
+
+
+} // namespace mu2e
+
+#endif /* TrackerConditions_StrawGeometryMaker_hh */
@@ -67,6 +67,9 @@ namespace mu2e {
 
     bool wireDistance(Straw const& straw, double edep, double dt, 
 		    double& wdist, double& wderr, double& halfpv) const;
+    // same, from the half length of the straw
+    bool wireDistance(double halfLength, double edep, double dt, 
+		    double& wdist, double& wderr, double& halfpv) const;
     bool useDriftError() const { return _usederr; } 
     bool useNonLinearDrift() const { return _usenonlindrift; }
     double Mint0doca() const { return _mint0doca;}
@@ -94,8 +97,10 @@ namespace mu2e {
     // removes channel to channel delays and overall electronics time delay
     void calibrateTimes(TrkTypes::TDCValues const& tdc, TrkTypes::TDCTimes &times, const StrawId &id) const;
     // approximate drift distatnce from ToT value
-    double driftTime(Straw const& straw, double tot, double edep) const;
-    double pathLength(Straw const& straw, double tot) const;
+    double driftTime(Straw const& straw, double tot, double edep) const { return driftTime(straw.id(),tot,edep); }
+    double driftTime(StrawId strawId, double tot, double edep) const;
+    double pathLength(Straw const& straw, double tot) const { return pathLength(straw.id(),tot); }
+    double pathLength(StrawId strawId, double tot) const;
     //      double pathLength(StrawHit const& strawhit, double theta) const;
 
     void print(std::ostream& os) const;
@@ -117,9 +122,13 @@ namespace mu2e {
     std::string _name;
 
     // helper functions
-    double wpRes(double kedep, double wdist) const;
+    double wpRes(double kedep, int iedep, double wdist) const;
     static double PieceLine(std::vector<double> const& xvals, 
 			    std::vector<double> const& yvals, double xval);
+    // the same in two steps, for tables sharing xvals
+    static int PieceLineBin(std::vector<double> const& xvals, double xval);
+    static double PieceLine(std::vector<double> const& xvals, 
+			    std::vector<double> const& yvals, int ibin, double xval);
 
     StrawDrift::cptr_t _strawDrift;
     StrawElectronics::cptr_t _strawElectronics;
@@ -16,14 +16,94 @@ using namespace std;
 
 namespace mu2e {
   
+  StrawDrift::StrawDrift( std::vector<D2Tinfo> D2Tinfos, std::vector<float> distances,
+			  std::vector<float> instantSpeeds, std::vector<float> averageSpeeds,
+			  int phiBins ) : _name("StrawDrift"),
+    _D2Tinfos(D2Tinfos),  _distances(distances), 
+    _instantSpeeds(instantSpeeds), _averageSpeeds(averageSpeeds),
+    _phiBins(phiBins) {
+    // the lookups consider the distance bins before the last one
+    size_t nbins = _distances.size() > 0 ? _distances.size() - 1 : 0;
+    _distanceFinder = BinFinder(std::vector<float>(_distances.begin(),_distances.begin()+nbins));
+    std::vector<float> times(nbins);
+    for (size_t p=0; p < _phiBins; p++) {
+      for (size_t k=0; k < nbins; k++) times[k] = _D2Tinfos[k*_phiBins+p].time;
+      _timeFinders.emplace_back(times);
+    }
+  }
 
+  // The grid covers the ordered part of the table, after any unordered
+  // leading bins: in the tables of StrawDriftMaker the times of the first
+  // distance bin are computed without the Lorentz correction.  About 2
+  // cells per bin: the drift tables are dense near the wire, where a cell
+  // still spans a few bins, and sparse further out.
+  StrawDrift::BinFinder::BinFinder(std::vector<float> const& values) :
+    _values(values), _first(values.size()), _invWidth(0.0) {
+    if (_values.empty()) return;
+    _first = _values.size()-1;
+    while (_first > 0 && _values[_first-1] >= _values[_first]) _first--;
+    double top = _values[_first];
+    double range = top - _values.back();
+    // with a single value, find never needs the grid
+    if (!(range > 0.0)) return;
+    size_t ncells = 2*(_values.size()-_first);
+    _invWidth = ncells/range;
+    _start.resize(ncells);
+    size_t k = _first;
+    for (size_t c=0; c < ncells; c++) {
+      // the largest value in the cell
+      double ctop = top - c/_invWidth;
+      while (k+1 < _values.size() && _values[k] > ctop) k++;
+      _start[c] = k;
+    }
+  }
 
-    //step through and find distance larger than what is specified
-  size_t StrawDrift::lowerDistanceBin(double dist) const {
-    for (size_t i=0; i < (_distances.size() - 1); i++) {
-      if(dist >= _distances[i]) return i;
+  size_t StrawDrift::BinFinder::find(double x) const {
+    if (_values.empty()) return 0;
+    for (size_t k=0; k < _first; k++) {
+      if (x >= _values[k]) return k;
+    }
+    // this also sends NaN past the end, as the scan does
+    if (!(x >= _values.back())) return _values.size();
+    if (x >= _values[_first]) return _first;
+    size_t c = std::min(size_t((_values[_first] - x)*_invWidth), _start.size() - 1);
+    size_t k = _start[c];
+    while (k > _first && x >= _values[k-1]) k--;
+    while (!(x >= _values[k])) k++;
+    return k;
+  }
+
+  size_t StrawDrift::BinFinder::scan(double x) const {
+    for (size_t k=0; k < _values.size(); k++) {
+      if (x >= _values[k]) return k;
     }
-    return 0;
+    return _values.size();
+  }
+
+  StrawDrift::PhiWeights StrawDrift::phiWeights(float reducedPhi) const {
+    float phiSliceWidth = (TMath::Pi()/2.0)/float(_phiBins-1);
+    PhiWeights pw;
+    //for interpolation, define a high and a low index
+    pw.upper = ceil(reducedPhi/phiSliceWidth); //rounds the index up to the nearest integer
+    pw.lower = floor(reducedPhi/phiSliceWidth); //rounds down
+    //need the weighting factors
+    pw.lowerWeight = pw.upper - reducedPhi/phiSliceWidth; //a measure of how far the lowerPhiIndex is
+    pw.upperWeight = 1.0 - pw.lowerWeight;
+    return pw;
+  }
+
+  float StrawDrift::reducePhi(double phi) const {
+    float reducedPhi = fmod(phi,TMath::Pi()/2.0);
+    if (reducedPhi < 0){
+      reducedPhi += TMath::Pi()/2.0;
+    };
+    return reducedPhi;
+  }
+
+  //find the first distance bin below the distance specified
+  size_t StrawDrift::lowerDistanceBin(double dist) const {
+    size_t ibin = _distanceFinder.find(dist);
+    return ibin < _distanceFinder.values().size() ? ibin : 0;
   }
 
   //look up and return the average speed from vectors
@@ -37,166 +117,157 @@ namespace mu2e {
   
   double StrawDrift::GetInstantSpeedFromT(double time) const
   {
-    int lowerIndex = 0;
-    //step through and find time larger than what is specified
-    for (size_t i=0; i < (_distances.size() - 1); i++) {
-      int fullIndex = i*(_phiBins) + 0; //map from a 2D index to a 1D index (at phi=0)
-      if(time >= _D2Tinfos[fullIndex].time){
-        lowerIndex = i;
-        break;
-      }
+    //find the first time bin below the time specified (at phi=0)
+    size_t lowerIndex = _timeFinders[0].find(time);
+    if (lowerIndex == _timeFinders[0].values().size()) lowerIndex = 0;
+    return _instantSpeeds[lowerIndex];
+  }
+
+  // the tables are interpolated in phi; a time or distance below the
+  // tables gives 0
+  double StrawDrift::gammaAt(size_t ibin, PhiWeights const& pw) const {
+    if (ibin >= _distanceFinder.values().size()) return 0.0;
+    float upperGamma = _D2Tinfos[ibin*_phiBins+pw.upper].gamma;
+    float lowerGamma = _D2Tinfos[ibin*_phiBins+pw.lower].gamma;
+    return lowerGamma*pw.lowerWeight + upperGamma*pw.upperWeight;
+  }
+
+  double StrawDrift::effectiveSpeedAt(size_t ibin, PhiWeights const& pw) const {
+    float effectiveSpeed = 0;
+    if (ibin < _distanceFinder.values().size()) {
+      float upperSpeed = _D2Tinfos[ibin*_phiBins+pw.upper].effectiveSpeed;
+      float lowerSpeed = _D2Tinfos[ibin*_phiBins+pw.lower].effectiveSpeed;
+      effectiveSpeed = lowerSpeed*pw.lowerWeight + upperSpeed*pw.upperWeight;
     }
+    return effectiveSpeed;
+  }
 
-    return _instantSpeeds[lowerIndex];
+  double StrawDrift::timeAt(size_t ibin, PhiWeights const& pw) const {
+    float time = 0;
+    if (ibin < _distanceFinder.values().size()) {
+      float upperTime = _D2Tinfos[ibin*_phiBins+pw.upper].time;
+      float lowerTime = _D2Tinfos[ibin*_phiBins+pw.lower].time;
+      time = lowerTime*pw.lowerWeight + upperTime*pw.upperWeight;
+    }
+    return time;
+  }
+
+  double StrawDrift::distanceAt(size_t ibin, PhiWeights const& pw) const {
+    float distance = 0;
+    if (ibin < _distanceFinder.values().size()) {
+      float upperDist = _D2Tinfos[ibin*_phiBins+pw.upper].distance;
+      float lowerDist = _D2Tinfos[ibin*_phiBins+pw.lower].distance;
+      distance = lowerDist*pw.lowerWeight + upperDist*pw.upperWeight;
+    }
+    return distance;
   }
   
   double StrawDrift::GetGammaFromD(double distance, double phi) const 
   {
-    float phiSliceWidth = (TMath::Pi()/2.0)/float(_phiBins-1);
     //For the purposes of lorentz corrections, 
     // the phi values can be contracted to between 0-90
-    float reducedPhi = ConstrainAngle(phi);
-    //for interpolation, define a high and a low index
-    int upperPhiIndex = ceil(reducedPhi/phiSliceWidth);
-    int lowerPhiIndex = floor(reducedPhi/phiSliceWidth);
-    //need the weighting factors
-    float lowerPhiWeight = upperPhiIndex - reducedPhi/phiSliceWidth; //a measure of how far the lowerPhiIndex is
-    float upperPhiWeight = 1.0 - lowerPhiWeight;
-    int fullIndex = 0;
-    float upperGamma = 0;
-    float lowerGamma = 0;
-    for (size_t k=0; k < (_distances.size() - 1); k++) { //loop through only some of the large vector of structs
-      fullIndex = k*(_phiBins)+upperPhiIndex;//mapping from a 2D to a 1D index
-      if (distance >= _D2Tinfos[fullIndex].distance){
-        upperGamma = _D2Tinfos[fullIndex].gamma;//set the gamma associated with the higher index
-        fullIndex = k*(_phiBins)+lowerPhiIndex; //mapping from a 2D to a 1D index
-        lowerGamma = _D2Tinfos[fullIndex].gamma;//set the gamma associated with the lower index
-        break;
-      }
-    }
-    double Gamma = lowerGamma*lowerPhiWeight + upperGamma*upperPhiWeight;//compute the final gamma
-    return Gamma;
+    PhiWeights pw = phiWeights(ConstrainAngle(phi));
+    return gammaAt(_distanceFinder.find(distance),pw);
   }
   
   double StrawDrift::GetGammaFromT(double time, double phi) const 
   {
-    float phiSliceWidth = (TMath::Pi()/2.0)/float(_phiBins-1);
     //For the purposes of lorentz corrections, the phi values can be contracted to between 0-90
-    float reducedPhi = ConstrainAngle(phi);
-    //for interpolation, define a high and a low index
-    int upperPhiIndex = ceil(reducedPhi/phiSliceWidth); //rounds the index up to the nearest integer
-    int lowerPhiIndex = floor(reducedPhi/phiSliceWidth); //rounds down
-    //need the weighting factors
-    float lowerPhiWeight = upperPhiIndex - reducedPhi/phiSliceWidth; //a measure of how far the lowerPhiIndex is
-    float upperPhiWeight = 1.0 - lowerPhiWeight;
-    int fullIndex = 0;
-    float upperGamma = 0;
-    float lowerGamma = 0;
-    for (size_t k=0; k < (_distances.size() - 1); k++) { //loop through only some of the large vector of structs
-      fullIndex = k*(_phiBins)+upperPhiIndex;//mapping from a 2D to a 1D index
-      if (time >= _D2Tinfos[fullIndex].time){
-        upperGamma = _D2Tinfos[fullIndex].gamma;//set the gamma associated with the higher index
-        fullIndex = k*(_phiBins)+lowerPhiIndex; //mapping from a 2D to a 1D index
-        lowerGamma = _D2Tinfos[fullIndex].gamma;//set the gamma associated with the lower index
-        break;
-      }
-    }
-    double Gamma = lowerGamma*lowerPhiWeight + upperGamma*upperPhiWeight;//compute the final gamma
-    return Gamma;
+    PhiWeights pw = phiWeights(ConstrainAngle(phi));
+    return gammaAt(_timeFinders[pw.upper].find(time),pw);
   }
   
   //look up and return the lorentz corrected r componenent of the average velocity
   double StrawDrift::GetEffectiveSpeed(double dist, double phi) const {
-    float phiSliceWidth = (TMath::Pi()/2.0)/float(_phiBins-1);
-    //For the purposes of lorentz corrections, the phi values can be contracted to between 0-90
-    float reducedPhi = fmod(phi,TMath::Pi()/2.0);
-    if (reducedPhi < 0){
-      reducedPhi += TMath::Pi()/2.0;
-    };
-    //for interpolation, define a high and a low index
-    int upperPhiIndex = ceil(reducedPhi/phiSliceWidth); //rounds the index up to the nearest integer
-    int lowerPhiIndex = floor(reducedPhi/phiSliceWidth); //rounds down
-    //need the weighting factors
-    float lowerPhiWeight = upperPhiIndex - reducedPhi/phiSliceWidth; //a measure of how far the lowerPhiIndex is
-    float upperPhiWeight = 1.0 - lowerPhiWeight;
-    int fullIndex = 0;
-    float upperSpeed = 0;
-    float lowerSpeed = 0;
-    float effectiveSpeed = 0;
-    
-    for (size_t k=0; k < (_distances.size() - 1); k++) { //loop through only some of the large vector of structs
-      fullIndex = k*(_phiBins)+upperPhiIndex;
-      if (dist >= _D2Tinfos[fullIndex].distance){
-        upperSpeed = _D2Tinfos[fullIndex].effectiveSpeed; //set the higher speed
-        fullIndex = k*(_phiBins)+lowerPhiIndex; // reduce the index by one
-        lowerSpeed = _D2Tinfos[fullIndex].effectiveSpeed; // set the lower speed
-        break;
-      }
-    }
-    effectiveSpeed = lowerSpeed*lowerPhiWeight + upperSpeed*upperPhiWeight;
-    return effectiveSpeed;
+    PhiWeights pw = phiWeights(reducePhi(phi));
+    return effectiveSpeedAt(_distanceFinder.find(dist),pw);
   }
   
   //D2T for sims
   double StrawDrift::D2T(double distance, double phi) const {
-    float phiSliceWidth = (TMath::Pi()/2.0)/float(_phiBins-1);
-    //For the purposes of lorentz corrections, the phi values can be contracted to between 0-90
-    float reducedPhi = ConstrainAngle(phi);
-    //for interpolation, define a high and a low index
-    int upperPhiIndex = ceil(reducedPhi/phiSliceWidth); //rounds the index up to the nearest integer
-    int lowerPhiIndex = floor(reducedPhi/phiSliceWidth); //rounds down
-    //need the weighting factors
-    float lowerPhiWeight = upperPhiIndex - reducedPhi/phiSliceWidth; //a measure of how far the lowerPhiIndex is
-    float upperPhiWeight = 1.0 - lowerPhiWeight;
-    int fullIndex = 0;
-    float upperTime = 0;
-    float lowerTime = 0;
-    float time = 0;
-    float gammaTest = 0.;
-    for (size_t k=0; k < (_distances.size() - 1); k++) { //loop through only some of the large vector of structs
-      fullIndex = k*(_phiBins)+upperPhiIndex;
-      if (distance >= _D2Tinfos[fullIndex].distance){
-        upperTime = _D2Tinfos[fullIndex].time;//set the higher time
-        fullIndex = k*(_phiBins)+lowerPhiIndex; // reduce the index by one
-        lowerTime = _D2Tinfos[fullIndex].time;// set the lower time
-        gammaTest = _D2Tinfos[fullIndex].gamma;//just another test
-        break;
-      }
-    }
-    time = lowerTime*lowerPhiWeight + upperTime*upperPhiWeight;//compute the final time
-    gammaTest = 1.0*gammaTest;
-    return time;
+    PhiWeights pw = phiWeights(ConstrainAngle(phi));
+    return timeAt(_distanceFinder.find(distance),pw);
   }
   
   //T2D for reco
   double StrawDrift::T2D(double time, double phi) const {
-    float phiSliceWidth = (TMath::Pi()/2.0)/float(_phiBins-1);
-    //For the purposes of lorentz corrections, the phi values can be contracted to between 0-90
-    float reducedPhi = fmod(phi,TMath::Pi()/2.0);
-    if (reducedPhi < 0){
-      reducedPhi += TMath::Pi()/2.0;
+    PhiWeights pw = phiWeights(reducePhi(phi));
+    return distanceAt(_timeFinders[pw.upper].find(time),pw);
+  }
+
+  void StrawDrift::D2T(const double* dist, const double* phi, double* time, size_t n) const {
+    for (size_t i=0; i < n; i++) {
+      PhiWeights pw = phiWeights(ConstrainAngle(phi[i]));
+      time[i] = timeAt(_distanceFinder.find(dist[i]),pw);
+    }
+  }
+
+  void StrawDrift::T2D(const double* time, const double* phi, double* dist, size_t n) const {
+    for (size_t i=0; i < n; i++) {
+      PhiWeights pw = phiWeights(reducePhi(phi[i]));
+      dist[i] = distanceAt(_timeFinders[pw.upper].find(time[i]),pw);
+    }
+  }
+
+  double StrawDrift::checkLookup(double tolerance) const {
+    // every table value, the values next to it and the midpoints between
+    // them, and values outside the tables
+    auto testValues = [](std::vector<float> const& values) {
+      std::vector<double> xs;
+      for (size_t k=0; k < values.size(); k++) {
+        float v = values[k];
+        xs.push_back(v);
+        xs.push_back(std::nextafter(v,-INFINITY));
+        xs.push_back(std::nextafter(v,INFINITY));
+        if (k+1 < values.size()) xs.push_back(0.5*(double(v)+values[k+1]));
+      }
+      if (values.size() > 0) {
+        xs.push_back(values.front()*2.0+1.0);
+        xs.push_back(values.back()*0.5-1.0);
+      }
+      return xs;
     };
-    //for interpolation, define a high and a low index
-    int upperPhiIndex = ceil(reducedPhi/phiSliceWidth); //rounds the index up to the nearest integer
-    int lowerPhiIndex = floor(reducedPhi/phiSliceWidth); //rounds down
-    //need the weighting factors
-    float lowerPhiWeight = upperPhiIndex - reducedPhi/phiSliceWidth; //a measure of how far the lowerPhiIndex is
-    float upperPhiWeight = 1.0 - lowerPhiWeight;
-    int fullIndex = 0;
-    float upperDist = 0;
-    float lowerDist = 0;
-    float distance = 0;
-    for (size_t k=0; k < (_distances.size() - 1); k++) { //loop through only some of the large vector of structs
-      fullIndex = k*(_phiBins)+upperPhiIndex;
-      if (time >= _D2Tinfos[fullIndex].time){
-        upperDist = _D2Tinfos[fullIndex].distance; //set the higher distance
-        fullIndex = k*(_phiBins)+lowerPhiIndex; // reduce the index by one
-        lowerDist = _D2Tinfos[fullIndex].distance;//set the lower distance
-        break;
+    std::vector<double> phis;
+    for (size_t p=0; p < 4*_phiBins; p++) phis.push_back(-M_PI + p*(2.5*M_PI)/(4*_phiBins));
+
+    double maxdiff(0.0);
+    auto compare = [&](double found, double scanned, char const* what, double x, double phi) {
+      double diff = fabs(found-scanned);
+      maxdiff = std::max(maxdiff,diff);
+      if (diff > tolerance) {
+        throw cet::exception("STRAW_DRIFT_BADLOOKUP")
+          << "StrawDrift " << what << "(" << x << "," << phi << ") = " << found
+          << " differs from the table search result " << scanned << "\n";
+      }
+    };
+    for (double x : testValues(_distanceFinder.values())) {
+      size_t ibin = _distanceFinder.scan(x);
+      size_t lbin = ibin < _distanceFinder.values().size() ? ibin : 0;
+      compare(GetAverageSpeed(x),_averageSpeeds[lbin],"GetAverageSpeed",x,0.0);
+      compare(GetInstantSpeedFromD(x),_instantSpeeds[lbin],"GetInstantSpeedFromD",x,0.0);
+      for (double phi : phis) {
+        PhiWeights pw = phiWeights(ConstrainAngle(phi));
+        compare(D2T(x,phi),timeAt(ibin,pw),"D2T",x,phi);
+        compare(GetGammaFromD(x,phi),gammaAt(ibin,pw),"GetGammaFromD",x,phi);
+        PhiWeights rpw = phiWeights(reducePhi(phi));
+        compare(GetEffectiveSpeed(x,phi),effectiveSpeedAt(ibin,rpw),"GetEffectiveSpeed",x,phi);
       }
     }
-    distance = lowerDist*lowerPhiWeight + upperDist*upperPhiWeight;//compute the final distance
-    return distance;
+    for (auto const& finder : _timeFinders) {
+      for (double t : testValues(finder.values())) {
+        size_t ibin0 = _timeFinders[0].scan(t);
+        compare(GetInstantSpeedFromT(t),
+                _instantSpeeds[ibin0 < _timeFinders[0].values().size() ? ibin0 : 0],
+                "GetInstantSpeedFromT",t,0.0);
+        for (double phi : phis) {
+          PhiWeights pw = phiWeights(ConstrainAngle(phi));
+          compare(GetGammaFromT(t,phi),gammaAt(_timeFinders[pw.upper].scan(t),pw),"GetGammaFromT",t,phi);
+          PhiWeights rpw = phiWeights(reducePhi(phi));
+          compare(T2D(t,phi),distanceAt(_timeFinders[rpw.upper].scan(t),rpw),"T2D",t,phi);
+        }
+      }
+    }
+    return maxdiff;
   }
   
   double StrawDrift::ConstrainAngle(double phi) const {
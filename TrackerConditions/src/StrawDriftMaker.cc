@@ -147,6 +147,12 @@ namespace mu2e {
 
     auto ptr = std::make_shared<StrawDrift>(D2Tinfos,distances,
 					    instantSpeeds,averageSpeeds,phiBins);
+
+    if (_config.lookupTolerance() >= 0.0) {
+      double maxdiff = ptr->checkLookup(_config.lookupTolerance());
+      if (_config.verbose() > 0) cout << "StrawDrift lookup check: largest difference " 
+				      << maxdiff << endl;
+    }
     
     return ptr;
 
@@ -110,6 +110,69 @@ namespace mu2e {
     return charge * ( p0 * distFrac + p1 * (1 - distFrac)) * _dVdI[ipath][straw.id().getStraw()];
   }
 
+  StrawElectronics::ChargeResponse StrawElectronics::chargeResponse(Straw const& straw, double charge, double distance) const {
+    ChargeResponse cresp;
+    double straw_length = 2*straw.halfLength();
+    cresp._reflectionTime = _reflectionTimeShift + (2*straw_length-2*distance)/_reflectionVelocity;
+    cresp._reflectionScale = _reflectionFrac * exp(-(2*straw_length-2*distance)/_reflectionALength);
+
+    int  distIndex = 0;
+    for (size_t i=1;i<_wPoints.size()-1;i++){
+      if (distance < _wPoints[i]._distance)
+        break;
+      distIndex = i;
+    }
+    cresp._distFrac = 1 - (distance - _wPoints[distIndex]._distance)/(_wPoints[distIndex+1]._distance - _wPoints[distIndex]._distance);
+    WireDistancePoint const& wp0 = _wPoints[distIndex];
+    WireDistancePoint const& wp1 = _wPoints[distIndex+1];
+    cresp._table0 = {wp0._preampResponse.data(), wp0._adcResponse.data(), wp0._preampToAdc1Response.data()};
+    cresp._table1 = {wp1._preampResponse.data(), wp1._adcResponse.data(), wp1._preampToAdc1Response.data()};
+    cresp._charge = charge;
+    for (int ipath=0;ipath<npaths;ipath++)
+      cresp._dVdI[ipath] = _dVdI[ipath][straw.id().getStraw()];
+    return cresp;
+  }
+
+  double StrawElectronics::linearResponse(ChargeResponse const& cresp, Path ipath, double time, bool forsaturation) const {
+    int index = time*_sampleRate + _responseBins/2.;
+    index = std::min(std::max(index,0),_responseBins-1);
+    int index_refl = (time - cresp._reflectionTime)*_sampleRate + _responseBins/2.;
+    index_refl = std::min(std::max(index_refl,0),_responseBins-1);
+    // only the threshold path has a separate response for saturation
+    int itable = (ipath == thresh && forsaturation) ? npaths : ipath;
+    double p0 = cresp._table0[itable][index] + cresp._table0[itable][index_refl]*cresp._reflectionScale;
+    double p1 = cresp._table1[itable][index] + cresp._table1[itable][index_refl]*cresp._reflectionScale;
+    return cresp._charge * ( p0 * cresp._distFrac + p1 * (1 - cresp._distFrac)) * cresp._dVdI[ipath];
+  }
+
+  void StrawElectronics::addLinearResponse(ChargeResponse const& cresp, Path ipath, double tcharge, double tstart,
+      ADCTimes const& times, double* volts) const {
+    // this is linearResponse written without branches, so that the loop over times vectorizes
+    double const* table0 = cresp._table0[ipath];
+    double const* table1 = cresp._table1[ipath];
+    float const* ftimes = times.data();
+    double offset = _responseBins/2.;
+    int maxindex = _responseBins-1;
+    size_t ntimes = times.size();
+    for (size_t i=0;i<ntimes;i++){
+      double time = ftimes[i] - tcharge;
+      int index = std::min(std::max(int(time*_sampleRate + offset),0),maxindex);
+      int index_refl = std::min(std::max(int((time - cresp._reflectionTime)*_sampleRate + offset),0),maxindex);
+      double p0 = table0[index] + table0[index_refl]*cresp._reflectionScale;
+      double p1 = table1[index] + table1[index_refl]*cresp._reflectionScale;
+      double resp = cresp._charge * ( p0 * cresp._distFrac + p1 * (1 - cresp._distFrac)) * cresp._dVdI[ipath];
+      volts[i] += ftimes[i] > tstart ? resp : 0.0;
+    }
+  }
+
+  double StrawElectronics::constantResponseTime(Straw const& straw) const {
+    // the reflection arrives latest for charge deposited at the far end of the straw.
+    // Pad by a few bins to stay clear of the index rounding in linearResponse
+    double straw_length = 2*straw.halfLength();
+    double reflection_time = _reflectionTimeShift + 2*straw_length/_reflectionVelocity;
+    return (0.5*_responseBins + 10)/_sampleRate + std::max(reflection_time,0.0);
+  }
+
   double StrawElectronics::adcImpulseResponse(StrawId sid, double time, double charge) const {
     int index = time*_sampleRate + _responseBins/2.;
     if ( index >= _responseBins)
@@ -0,0 +1,15 @@
+#include <iostream>
+
+#include "TrackerConditions/inc/StrawGeometry.hh"
+
+using namespace std;
+
+namespace mu2e {
+
+  StrawGeometry::StrawGeometry() : _name("StrawGeometry") {}
+
+  void StrawGeometry::print( ostream& out) const{
+    out << "StrawGeometry has " << nStraws() << " straws" << endl;
+  }
+
+} // namespace mu2e
@@ -0,0 +1,60 @@
+
+#include <iostream>
+
+#include "TrackerGeom/inc/Tracker.hh"
+#include "TrackerConditions/inc/StrawGeometry.hh"
+#include "TrackerConditions/inc/StrawGeometryMaker.hh"
+
+using namespace std;
+
+namespace mu2e {
+
+  namespace {
+    void addToMask(StrawGeometry::StrawMask& mask, StrawId const& id, StrawId const& other) {
+      if(id.samePanel(other))
+	mask[other.straw()>>6] |= uint64_t(1) << (other.straw()&63);
+    }
+  }
+
+  StrawGeometry::ptr_t StrawGeometryMaker::fromFcl(Tracker::cptr_t trk_p) {
+
+    StrawGeometry::ptr_t ptr = make_shared<StrawGeometry>();
+    StrawGeometry& sg = *ptr;
+
+    Tracker const& tracker = *trk_p;
+    size_t nstraws = StrawId::_nustraws;
+    for(auto vec : {&sg._midX,&sg._midY,&sg._midZ,&sg._dirX,&sg._dirY,&sg._dirZ,
+	  &sg._halfLength,&sg._activeHalfLength,&sg._radius})
+      vec->resize(nstraws,0.0);
+    sg._nearest.resize(nstraws,StrawGeometry::StrawMask{{0,0}});
+    sg._preamp.resize(nstraws,StrawGeometry::StrawMask{{0,0}});
+
+    for(auto const& straw : tracker.getStraws()) {
+      StrawId const& id = straw.id();
+      size_t i = StrawGeometry::index(id);
+      auto const& mid = straw.getMidPoint();
+      auto const& dir = straw.getDirection();
+      sg._midX[i] = mid.x();
+      sg._midY[i] = mid.y();
+      sg._midZ[i] = mid.z();
+      sg._dirX[i] = dir.x();
+      sg._dirY[i] = dir.y();
+      sg._dirZ[i] = dir.z();
+      sg._halfLength[i] = straw.halfLength();
+      sg._activeHalfLength[i] = straw.activeHalfLength();
+      sg._radius[i] = straw.getRadius();
+      for(auto const& nid : straw.nearestNeighboursById())
+	addToMask(sg._nearest[i],id,nid);
+      for(auto const& nid : straw.preampNeighboursById())
+	addToMask(sg._preamp[i],id,nid);
+    }
+
+    if ( _config.verbose() > 0 ) {
+      cout << "StrawGeometryMaker::fromFcl made StrawGeometry with nStraws = "
+	   << sg.nStraws() << endl;
+    }
+
+    return ptr;
+  }
+
+} // namespace mu2e
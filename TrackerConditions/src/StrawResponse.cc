@@ -10,8 +10,11 @@ namespace mu2e {
 
   // simple line interpolation, this should be a utility function, FIXME!
   double StrawResponse::PieceLine(std::vector<double> const& xvals, std::vector<double> const& yvals, double xval){
-    double yval;
-    if(xvals.size() != yvals.size() || xvals.size() < 2)
+    return PieceLine(xvals,yvals,PieceLineBin(xvals,xval),xval);
+  }
+
+  int StrawResponse::PieceLineBin(std::vector<double> const& xvals, double xval){
+    if(xvals.size() < 2)
       std::cout << "size error " << std::endl;
     int imax = int(xvals.size()-1);
     // approximate constant binning to get initial guess
@@ -22,6 +25,14 @@ namespace mu2e {
       --ibin;
     while(ibin < imax && xval > xvals[ibin])
       ++ibin;
+    return ibin;
+  }
+
+  double StrawResponse::PieceLine(std::vector<double> const& xvals, std::vector<double> const& yvals, int ibin, double xval){
+    double yval;
+    if(xvals.size() != yvals.size() || xvals.size() < 2)
+      std::cout << "size error " << std::endl;
+    int imax = int(xvals.size()-1);
     // interpolate
     double slope(0.0);
     if(ibin >= 0 && ibin < imax){
@@ -94,13 +105,19 @@ namespace mu2e {
 
   bool StrawResponse::wireDistance(Straw const& straw, double edep, 
 	   double dt, double& wdist, double& wderr, double &halfpv) const {
+    return wireDistance(straw.halfLength(),edep,dt,wdist,wderr,halfpv);
+  }
+
+  bool StrawResponse::wireDistance(double slen, double edep, 
+	   double dt, double& wdist, double& wderr, double &halfpv) const {
     bool retval(true);
-    double slen = straw.halfLength();
     // convert edep from Mev to KeV (should be standardized, FIXME!)
     double kedep = 1000.0*edep;
-    halfpv = halfPropV(straw.id(),kedep);
+    // the edep tables share their bins: find the bin once
+    int iedep = PieceLineBin(_edep,kedep);
+    halfpv = PieceLine(_edep,_halfvp,iedep,kedep);
     wdist = halfpv*(dt);
-    wderr = wpRes(kedep,fabs(wdist));
+    wderr = wpRes(kedep,iedep,fabs(wdist));
     // truncate positions that exceed the length of the straw (with a buffer): these come from missing a cluster on one end
     if(fabs(wdist) > slen+_wbuf*wderr){
     // move the position to the correct half of the straw
@@ -116,13 +133,13 @@ namespace mu2e {
     return PieceLine(_edep,_halfvp,kedep);
   }
 
-  double StrawResponse::wpRes(double kedep,double wlen) const {
+  double StrawResponse::wpRes(double kedep,int iedep,double wlen) const {
   // central resolution depends on edep
-    double tdres = PieceLine(_edep,_centres,kedep);
+    double tdres = PieceLine(_edep,_centres,iedep,kedep);
     if( wlen > _central){
     // outside the central region the resolution depends linearly on the distance
     // along the wire.  The slope of that also depends on edep
-      double wslope = PieceLine(_edep,_resslope,kedep);
+      double wslope = PieceLine(_edep,_resslope,iedep,kedep);
       tdres += (wlen-_central)*wslope;
     }
     return tdres;
@@ -147,7 +164,7 @@ namespace mu2e {
       return _vsat;
   }
 
-  double StrawResponse::driftTime(Straw const& straw, 
+  double StrawResponse::driftTime(StrawId strawId, 
 			      double tot, double edep) const {
     // straw is present in case of eventual calibration
     size_t totbin = (size_t) (tot/4.);
@@ -159,7 +176,7 @@ namespace mu2e {
     return _totdtime[totbin*10+ebin];
   }
 
-  double StrawResponse::pathLength(Straw const& straw, double tot) const {
+  double StrawResponse::pathLength(StrawId strawId, double tot) const {
   // needs to be implemented, FIXME!!
     return 5.0;
   }
@@ -27,6 +27,10 @@ namespace mu2e {
       Name("kVcm"), Comment("drift model field in KV/cm") };
     fhicl::Sequence<double> cmus{
       Name("cmus"), Comment("drift model speed in cm/us") };
+    fhicl::Atom<double> lookupTolerance{
+      Name("lookupTolerance"), 
+	Comment("if >= 0, check the drift lookups against a search of the tables and fail on a larger difference"),
+	-1.0};
   };
 
 }
@@ -0,0 +1,23 @@
+#ifndef TrackerConditions_StrawGeometryConfig_hh
+#define TrackerConditions_StrawGeometryConfig_hh
+//
+// Initialize StrawGeometry from fcl
+//
+#include <string>
+#include "fhiclcpp/types/Atom.h"
+#include "fhiclcpp/types/Sequence.h"
+
+namespace mu2e {
+
+  struct StrawGeometryConfig {
+    using Name=fhicl::Name;
+    using Comment=fhicl::Comment;
+    fhicl::Atom<int> verbose{
+      Name("verbose"), Comment("verbosity: 0,1,2")};
+    fhicl::Atom<bool> useDb{
+      Name("useDb"), Comment("use database or fcl")}; 
+  };
+
+}
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef TrackerMC_StrawClusterArena_hh
+#define TrackerMC_StrawClusterArena_hh
+//
+// StrawClusterArena holds all the StrawClusters of an event in one contiguous block.
+// Clusters are appended in any order, then sorted once by straw, end and time; after
+// that each straw end is a contiguous, time-ordered range which is handed out as a
+// StrawClusterSequence.  The storage is kept between events to avoid reallocation.
+//
+
+// C++ includes
+#include <vector>
+// Mu2e includes
+#include "TrackerMC/inc/StrawClusterSequence.hh"
+
+namespace mu2e {
+  namespace TrackerMC {
+    class StrawClusterArena {
+      public:
+	StrawClusterArena() : _sorted(true) {}
+	// remove all clusts, keeping the storage
+	void clear() { _clusts.clear(); _sorted = true; }
+	void reserve(size_t nclust) { _clusts.reserve(nclust); }
+	// add a clust; sequences are invalid until sort is called
+	void insert(StrawCluster const& clust);
+	// order the clusts by straw, end and time.  Clusts with equal times keep the order
+	// the list-based sequences gave them (latest inserted first)
+	void sort();
+	// the time-ordered clusts of one straw end; this is empty if there are none
+	StrawClusterSequence sequence(StrawId const& sid, StrawEnd end) const;
+	size_t size() const { return _clusts.size(); }
+	bool empty() const { return _clusts.empty(); }
+      private:
+	std::vector<StrawCluster> _clusts;
+	bool _sorted;
+    };
+  }
+}
+#endif
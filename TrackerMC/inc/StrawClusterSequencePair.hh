@@ -4,19 +4,16 @@
 //
 // Original author David Brown, LBNL
 #include "TrackerMC/inc/StrawClusterSequence.hh"
-#include <utility>
 namespace mu2e {
   namespace TrackerMC {
     class StrawClusterSequencePair{
       public:
-	typedef StrawCluster StrawClusterPair[2];
 	StrawClusterSequencePair();
 	StrawClusterSequencePair(StrawId sid);
-	StrawClusterSequencePair(StrawClusterSequencePair const& other);
-	StrawClusterSequencePair& operator =(StrawClusterSequencePair const& other);
+	StrawClusterSequencePair(StrawClusterSequence const& calseq, StrawClusterSequence const& hvseq);
+	// use compiler version of copy, assignment
 	StrawClusterSequence& clustSequence(StrawEnd end) { return _scseq[end]; }
 	StrawClusterSequence const& clustSequence(StrawEnd end) const { return _scseq[end]; }
-	void insert(StrawClusterPair const& hpair);
 	StrawId strawId() const { return _scseq[0].strawId(); }
       private:
 	StrawClusterSequence _scseq[2];
@@ -41,7 +41,7 @@ namespace mu2e {
     class StrawWaveform{
       public:
 	// construct from a clust sequence and response object.  Scale affects the voltage
-	StrawWaveform(Straw const& straw, StrawClusterSequence const& hseqq, XTalk const& xtalk);
+	StrawWaveform(StrawElectronics const& strawele, Straw const& straw, StrawClusterSequence const& hseqq, XTalk const& xtalk);
 	// disallow copy and assignment
 	StrawWaveform() = delete; // don't allow default constructor, references can't be assigned empty
 	StrawWaveform(StrawWaveform const& other);
@@ -51,6 +51,10 @@ namespace mu2e {
       bool crossesThreshold(StrawElectronics const& strawele, double threshold,WFX& wfx) const;
 	// sample the waveform at a given time, no saturation included.  Return value is in units of volts
 	double sampleWaveform(StrawElectronics const& strawele,StrawElectronics::Path ipath,double time) const;
+	// the same, computing the response of every clust directly.  This is slow, and only used to validate sampleWaveform
+	double referenceWaveform(StrawElectronics const& strawele,StrawElectronics::Path ipath,double time) const;
+	// could the preamp saturate?  If so, sampleADCWaveform includes saturation
+	bool saturates(StrawElectronics const& strawele) const;
 	// sample the waveform at a series of points allowing saturation to occur after preamp stage
         // FIXME no cross talk yet
 	void sampleADCWaveform(StrawElectronics const& strawele,TrkTypes::ADCTimes const& times,TrkTypes::ADCVoltages& volts) const;
@@ -65,7 +69,15 @@ namespace mu2e {
 	StrawClusterSequence const& _cseq;
 	XTalk _xtalk; // X-talk applied to all voltages
         Straw const& _straw;
+	// clusts older than this no longer change their response.  The cumulative sums of those
+	// constant responses, in time order, for each path and for the saturation calculation
+	double _tconst;
+	std::vector<StrawElectronics::ChargeResponse> _cresp; // time-independent response of each clust
+	std::array<std::vector<double>,StrawElectronics::npaths> _tailsum;
+	std::vector<double> _sattailsum;
 	// helper functions
+	double linearResponse(StrawElectronics const& strawele,StrawElectronics::Path ipath,bool forsaturation,
+	    double time,StrawClusterList::const_iterator ifirst) const;
 	void returnCrossing(StrawElectronics const& strawele, double threshold, WFX& wfx) const;
 	bool roughCrossing(StrawElectronics const& strawele, double threshold, WFX& wfx) const;
 	bool fineCrossing(StrawElectronics const& strawele, double threshold, double vmax, WFX& wfx) const;
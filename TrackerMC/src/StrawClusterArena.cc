@@ -0,0 +1,64 @@
+//
+// StrawClusterArena holds all the StrawClusters of an event in one contiguous block
+//
+// mu2e includes
+#include "TrackerMC/inc/StrawClusterArena.hh"
+#include "cetlib_except/exception.h"
+// C++ includes
+#include <algorithm>
+
+using namespace std;
+
+namespace mu2e {
+  namespace TrackerMC {
+    namespace {
+      // order by straw, then end, then time
+      struct ClusterLess {
+	bool operator()(StrawCluster const& a, StrawCluster const& b) const {
+	  if(a.strawId() != b.strawId()) return a.strawId() < b.strawId();
+	  if(a.strawEnd() != b.strawEnd()) return a.strawEnd() < b.strawEnd();
+	  return a.time() < b.time();
+	}
+      };
+      // order by straw and end only, to find the range of one sequence
+      struct SequenceLess {
+	bool operator()(StrawCluster const& a, StrawCluster const& b) const {
+	  if(a.strawId() != b.strawId()) return a.strawId() < b.strawId();
+	  return a.strawEnd() < b.strawEnd();
+	}
+      };
+    }
+
+    void StrawClusterArena::insert(StrawCluster const& clust) {
+      if(clust.type() == StrawCluster::unknown){
+	throw cet::exception("SIM")
+	  << "mu2e::StrawClusterArena: tried to add unknown clust type"
+	  << endl;
+      }
+      _clusts.push_back(clust);
+      _sorted = false;
+    }
+
+    void StrawClusterArena::sort() {
+      // reversing first makes the stable sort put equal-time clusts latest-first,
+      // as inserting each clust before the first one not earlier than it did
+      std::reverse(_clusts.begin(),_clusts.end());
+      std::stable_sort(_clusts.begin(),_clusts.end(),ClusterLess());
+      _sorted = true;
+    }
+
+    StrawClusterSequence StrawClusterArena::sequence(StrawId const& sid, StrawEnd end) const {
+      if(!_sorted){
+	throw cet::exception("SIM")
+	  << "mu2e::StrawClusterArena: sequence requested before sorting"
+	  << endl;
+      }
+      // find the range with a dummy clust carrying only the straw and end
+      StrawCluster key(StrawCluster::primary,sid,end,0.0,0.0,0.0,StrawPosition(),0.0,0.0,art::Ptr<StrawGasStep>(),0.0);
+      auto range = std::equal_range(_clusts.begin(),_clusts.end(),key,SequenceLess());
+      StrawClusterList clist(_clusts.data() + (range.first - _clusts.begin()),
+	  _clusts.data() + (range.second - _clusts.begin()));
+      return StrawClusterSequence(sid,end,clist);
+    }
+  }
+}
@@ -40,6 +40,7 @@
 #include "MCDataProducts/inc/StrawDigiMC.hh"
 // temporary MC structures
 #include "TrackerMC/inc/StrawClusterSequencePair.hh"
+#include "TrackerMC/inc/StrawClusterArena.hh"
 #include "TrackerMC/inc/StrawWaveform.hh"
 #include "TrackerMC/inc/IonCluster.hh"
 #include "TrackerMC/inc/StrawPosition.hh"
@@ -48,6 +49,10 @@
 #include "CLHEP/Random/RandFlat.h"
 #include "CLHEP/Random/RandExponential.h"
 #include "CLHEP/Random/RandPoisson.h"
+#include "CLHEP/Random/MixMaxRng.h"
+// TBB
+#include "tbb/parallel_for.h"
+#include "tbb/blocked_range.h"
 #include "CLHEP/Vector/LorentzVector.h"
 // root
 #include "TMath.h"
@@ -113,6 +118,9 @@ namespace mu2e {
 	  fhicl::Atom<string> spinstance { Name("StrawGasStepInstance"), Comment("StrawGasStep Instance name"),""};
 	  fhicl::Atom<string> spmodule { Name("StrawGasStepModule"), Comment("StrawGasStep Module name"),""};
 	  fhicl::Sequence<art::InputTag> SPTO { Name("TimeOffsets"), Comment("Sim Particle Time Offset Maps")};
+	  fhicl::Atom<bool> parallel{ Name("ParallelDigitization"), Comment("Digitize panels in parallel tasks, each with a random stream seeded from the event and panel.  Results do not depend on the number of threads, but differ from serial digitization"),false };
+	  fhicl::Atom<bool> validateResponse{ Name("ValidateResponse"), Comment("Compare the sampled waveforms to the direct clust-by-clust calculation, and histogram the differences"),false };
+	  fhicl::Atom<float> responseTolerance{ Name("ResponseTolerance"), Comment("Largest difference (mVolts) accepted when validating the sampled waveforms"),1.0e-4 };
 
 	};
 
@@ -133,6 +141,7 @@ namespace mu2e {
 
 	void beginJob() override;
 	void beginRun(art::Run& run) override;
+	void endJob() override;
 	void produce(art::Event& e) override;
 
 	// Diagnostics
@@ -158,12 +167,16 @@ namespace mu2e {
 	std::vector<uint16_t> _allPlanes;
 	unsigned _maxnclu;
 	StrawElectronics::Path _diagpath; 
+	bool _parallel;
+	bool _validateResponse;
+	double _responseTolerance;
 	// Random number distributions
 	art::RandomNumberGenerator::base_engine_t& _engine;
 	CLHEP::RandGaussQ _randgauss;
 	CLHEP::RandFlat _randflat;
 	CLHEP::RandExponential _randexp;
 	CLHEP::RandPoisson _randP;
+	SeedService::seed_t _seed; // base of the per-panel seeds in parallel digitization
 	// A category for the error logger.
 	const string _messageCategory;
 	// Give some informationation messages only on the first event.
@@ -204,6 +217,11 @@ namespace mu2e {
 	Float_t _steplen, _stepE, _qsum, _esum, _eesum, _qe, _partP, _steptime;
 	Int_t _nclust, _netot, _partPDG, _stype;
 	vector<IonCluster> _clusters;
+	StrawClusterArena _arena; // storage for all clusts of the event
+	// response validation
+	TH1F* _hrespdiff[StrawElectronics::npaths];
+	unsigned long _nrespcheck, _nrespfail;
+	double _maxrespdiff;
 	Float_t _ewMarkerOffset;
 	array<Float_t, StrawId::_nupanels> _ewMarkerROCdt;
 
@@ -214,8 +232,7 @@ namespace mu2e {
 	void addStep(StrawPhysics const& strawphys,
 	    StrawElectronics const& strawele,
 	    Straw const& straw,
-	    SGSPtr const& sgsptr,
-	    StrawClusterSequencePair& shsp);
+	    SGSPtr const& sgsptr);
 	void divideStep(StrawPhysics const& strawphys,
 	    StrawElectronics const& strawele,
 	    Straw const& straw,
@@ -226,33 +243,46 @@ namespace mu2e {
 	void propagateCharge(StrawPhysics const& strawphys, Straw const& straw,
 	    WireCharge const& wireq, StrawEnd end, WireEndCharge& weq);
 	double microbunchTime(StrawElectronics const& strawele, double globaltime) const;
-	void addGhosts(StrawElectronics const& strawele, StrawCluster const& clust,StrawClusterSequence& shs);
+	void addGhosts(StrawElectronics const& strawele, StrawCluster const& clust);
 	void addNoise(StrawClusterMap& hmap);
-	void findThresholdCrossings(StrawElectronics const& strawele, SWFP const& swfp, WFXPList& xings);
+	void findThresholdCrossings(StrawElectronics const& strawele, SWFP const& swfp, CLHEP::RandGaussQ& randgauss, WFXPList& xings);
+	void digitizeStraw(StrawPhysics const& strawphys,
+	    StrawElectronics const& strawele,
+	    Tracker const& tracker,
+	    StrawClusterSequencePair const& hsp,
+	    CLHEP::RandGaussQ& randgauss,
+	    StrawDigiCollection* digis, StrawDigiMCCollection* mcdigis);
 	void createDigis(StrawPhysics const& strawphys,
 	    StrawElectronics const& strawele,
 	    Tracker const& tracker,
             Straw const& straw,
 	    StrawClusterSequencePair const& hsp,
 	    XTalk const& xtalk,
+	    CLHEP::RandGaussQ& randgauss,
 	    StrawDigiCollection* digis, StrawDigiMCCollection* mcdigis);
 	void fillDigis(StrawPhysics const& strawphys,
 	    StrawElectronics const& strawele,
 	    Tracker const& tracker,
 	    WFXPList const& xings,SWFP const& swfp , StrawId sid,
+	    CLHEP::RandGaussQ& randgauss,
 	    StrawDigiCollection* digis, StrawDigiMCCollection* mcdigis);
-	bool createDigi(StrawElectronics const& strawele,WFXP const& xpair, SWFP const& wf, StrawId sid, StrawDigiCollection* digis);
+	bool createDigi(StrawElectronics const& strawele,WFXP const& xpair, SWFP const& wf, StrawId sid,
+	    CLHEP::RandGaussQ& randgauss, StrawDigiCollection* digis);
 	void findCrossTalkStraws(Straw const& straw,vector<XTalk>& xtalk);
 	void fillClusterNe(StrawPhysics const& strawphys,std::vector<unsigned>& me);
 	void fillClusterPositions(StrawGasStep const& step, Straw const& straw, std::vector<StrawPosition>& cpos);
 	void fillClusterMinion(StrawPhysics const& strawphys, StrawGasStep const& step, std::vector<unsigned>& me, std::vector<float>& cen);
 	bool readAll(StrawId const& sid) const;
+	long panelSeed(art::EventID const& eid, uint16_t upanel) const;
 	// diagnostic functions
 	void waveformHist(StrawElectronics const& strawele,
 	    SWFP const& wf, WFXPList const& xings);
 	void waveformDiag(StrawElectronics const& strawele,
 	    SWFP const& wf, WFXPList const& xings);
 	void digiDiag(StrawPhysics const& strawphys, SWFP const& wf, WFXP const& xpair, StrawDigi const& digi,StrawDigiMC const& mcdigi);
+	void validateResponse(StrawElectronics const& strawele, StrawWaveform const& wf, WFX const& wfx,
+	    ADCTimes const& adctimes, ADCVoltages const& volts);
+	void checkResponse(StrawElectronics::Path ipath, double sampled, double direct);
 	void stepDiag(StrawPhysics const& strawphys, StrawElectronics const& strawele, StrawGasStep const& sgs);
 	StrawPosition strawPosition( XYZVec const& cpos,Straw const& straw) const;
 	XYZVec strawPosition( StrawPosition const& cpos, Straw const& straw) const;
@@ -284,18 +314,27 @@ namespace mu2e {
       _allPlanes(config().allPlanes()),
       _maxnclu(config().maxnclu()),
       _diagpath(static_cast<StrawElectronics::Path>(config().diagpath())),
+      _parallel(config().parallel()),
+      _validateResponse(config().validateResponse()),
+      _responseTolerance(config().responseTolerance()),
       // Random number distributions
       _engine(createEngine( art::ServiceHandle<SeedService>()->getSeed())),
       _randgauss( _engine ),
       _randflat( _engine ),
       _randexp( _engine),
       _randP( _engine),
+      _seed(art::ServiceHandle<SeedService>()->getSeed()),
       _messageCategory("HITS"),
       _firstEvent(true),      // Control some information messages.
       // This selector will select only data products with the given instance name.
       _selector{ art::ProductInstanceNameSelector(config().spinstance())},
-      _toff(config().SPTO())
+      _toff(config().SPTO()),
+      _nrespcheck(0), _nrespfail(0), _maxrespdiff(0.0)
       {
+        if (_parallel && (_diag > 0 || _validateResponse)){
+	  throw cet::exception("SIM")
+	    << "mu2e::StrawDigisFromStrawGasSteps: diagnostics and response validation are not available with ParallelDigitization" << endl;
+        }
         if (config().spmodule() != ""){
           _selector = _selector && art::ModuleLabelSelector(config().spmodule());
         }
@@ -309,6 +348,12 @@ namespace mu2e {
 
     void StrawDigisFromStrawGasSteps::beginJob(){
 
+      if(_validateResponse){
+	art::ServiceHandle<art::TFileService> tfs;
+	_hrespdiff[StrawElectronics::thresh] = tfs->make<TH1F>("hthreshdiff","log10(|sampled - direct|) threshold response at crossing;log10(mVolts)",140,-16.0,-2.0);
+	_hrespdiff[StrawElectronics::adc] = tfs->make<TH1F>("hadcdiff","log10(|sampled - direct|) ADC response;log10(mVolts)",140,-16.0,-2.0);
+      }
+
       if(_diag > 0){
 
 	art::ServiceHandle<art::TFileService> tfs;
@@ -404,6 +449,18 @@ namespace mu2e {
       }
     }
 
+    void StrawDigisFromStrawGasSteps::endJob(){
+      if(_validateResponse){
+	if(_nrespfail > 0)
+	  mf::LogWarning(_messageCategory) << "StrawDigisFromStrawGasSteps: " << _nrespfail << " of " << _nrespcheck
+	    << " sampled voltages differ from the direct calculation by more than " << _responseTolerance
+	    << " mVolts; largest difference " << _maxrespdiff << endl;
+	else
+	  mf::LogInfo(_messageCategory) << "StrawDigisFromStrawGasSteps: " << _nrespcheck
+	    << " sampled voltages agree with the direct calculation; largest difference " << _maxrespdiff << " mVolts" << endl;
+      }
+    }
+
     void StrawDigisFromStrawGasSteps::beginRun( art::Run& run ){
       if ( _printLevel > 0 ) {
 	auto const& strawphys = _strawphys_h.get(run.id());
@@ -442,28 +499,37 @@ namespace mu2e {
       fillClusterMap(strawphys,strawele,tracker,event,hmap);
       // add noise clusts
       if(_addNoise)addNoise(hmap);
-      // loop over the clust sequences
-      for(auto ihsp=hmap.begin();ihsp!= hmap.end();++ihsp){
-	StrawClusterSequencePair const& hsp = ihsp->second;
-	Straw const& straw = tracker.getStraw(hsp.strawId());
-	// create primary digis from this clust sequence
-	XTalk self(hsp.strawId()); // this object represents the straws coupling to itself, ie 100%
-	createDigis(strawphys,strawele,tracker,straw,hsp,self,digis.get(),mcdigis.get());
-	// if we're applying x-talk, look for nearby coupled straws
-	if(_addXtalk) {
-	  // only apply if the charge is above a threshold
-	  double totalCharge = 0;
-	  for(auto ih=hsp.clustSequence(StrawEnd::cal).clustList().begin();ih!= hsp.clustSequence(StrawEnd::cal).clustList().end();++ih){
-	    totalCharge += ih->charge();
-	  }
-	  if( totalCharge > _ctMinCharge){
-	    vector<XTalk> xtalk;
-	    findCrossTalkStraws(straw,xtalk);
-	    for(auto ixtalk=xtalk.begin();ixtalk!=xtalk.end();++ixtalk){
-	      createDigis(strawphys,strawele,tracker,straw,hsp,*ixtalk,digis.get(),mcdigis.get());
+      if(_parallel){
+	// panels are digitized independently, each with its own random stream.  The map is
+	// ordered by StrawId, so the straws of each panel are a contiguous range
+	vector<StrawClusterMap::const_iterator> panels;
+	for(auto ihsp=hmap.cbegin();ihsp!= hmap.cend();++ihsp){
+	  if(panels.empty() || ihsp->first.uniquePanel() != panels.back()->first.uniquePanel())
+	    panels.push_back(ihsp);
+	}
+	size_t npanels = panels.size();
+	panels.push_back(hmap.cend());
+	vector<StrawDigiCollection> pdigis(npanels);
+	vector<StrawDigiMCCollection> pmcdigis(npanels);
+	art::EventID const& eid = event.id();
+	tbb::parallel_for(tbb::blocked_range<size_t>(0,npanels),
+	    [&](tbb::blocked_range<size_t> const& range){
+	    for(size_t ipanel=range.begin();ipanel!=range.end();++ipanel){
+	      CLHEP::MixMaxRng engine(panelSeed(eid,panels[ipanel]->first.uniquePanel()));
+	      CLHEP::RandGaussQ randgauss(engine);
+	      for(auto ihsp=panels[ipanel];ihsp!=panels[ipanel+1];++ihsp)
+		digitizeStraw(strawphys,strawele,tracker,ihsp->second,randgauss,&pdigis[ipanel],&pmcdigis[ipanel]);
 	    }
-	  }
+	  });
+	// merge in panel order, so the output does not depend on the scheduling
+	for(size_t ipanel=0;ipanel<npanels;++ipanel){
+	  digis->insert(digis->end(),pdigis[ipanel].begin(),pdigis[ipanel].end());
+	  mcdigis->insert(mcdigis->end(),pmcdigis[ipanel].begin(),pmcdigis[ipanel].end());
 	}
+      } else {
+	// loop over the clust sequences
+	for(auto ihsp=hmap.begin();ihsp!= hmap.end();++ihsp)
+	  digitizeStraw(strawphys,strawele,tracker,ihsp->second,_randgauss,digis.get(),mcdigis.get());
       }
       // store the digis in the event
       event.put(move(digis));
@@ -475,6 +541,49 @@ namespace mu2e {
 
     } // end produce
 
+    void StrawDigisFromStrawGasSteps::digitizeStraw(
+	StrawPhysics const& strawphys,
+	StrawElectronics const& strawele,
+	Tracker const& tracker,
+	StrawClusterSequencePair const& hsp,
+	CLHEP::RandGaussQ& randgauss,
+	StrawDigiCollection* digis, StrawDigiMCCollection* mcdigis) {
+      Straw const& straw = tracker.getStraw(hsp.strawId());
+      // create primary digis from this clust sequence
+      XTalk self(hsp.strawId()); // this object represents the straws coupling to itself, ie 100%
+      createDigis(strawphys,strawele,tracker,straw,hsp,self,randgauss,digis,mcdigis);
+      // if we're applying x-talk, look for nearby coupled straws
+      if(_addXtalk) {
+	// only apply if the charge is above a threshold
+	double totalCharge = 0;
+	for(auto ih=hsp.clustSequence(StrawEnd::cal).clustList().begin();ih!= hsp.clustSequence(StrawEnd::cal).clustList().end();++ih){
+	  totalCharge += ih->charge();
+	}
+	if( totalCharge > _ctMinCharge){
+	  vector<XTalk> xtalk;
+	  findCrossTalkStraws(straw,xtalk);
+	  for(auto ixtalk=xtalk.begin();ixtalk!=xtalk.end();++ixtalk){
+	    createDigis(strawphys,strawele,tracker,straw,hsp,*ixtalk,randgauss,digis,mcdigis);
+	  }
+	}
+      }
+    }
+
+    long StrawDigisFromStrawGasSteps::panelSeed(art::EventID const& eid, uint16_t upanel) const {
+      // counter-based seed: hash the module seed, event and panel with the splitmix64 finalizer,
+      // so each panel's stream is fixed by its key and not by the order panels are processed
+      uint64_t key[5] = {static_cast<uint64_t>(_seed),eid.run(),eid.subRun(),eid.event(),upanel};
+      uint64_t seed(0);
+      for(auto k : key){
+	seed += k + 0x9e3779b97f4a7c15ULL;
+	seed = (seed ^ (seed >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	seed = (seed ^ (seed >> 27)) * 0x94d049bb133111ebULL;
+	seed = seed ^ (seed >> 31);
+      }
+      // engines take a positive long
+      return static_cast<long>(seed >> 1);
+    }
+
     void StrawDigisFromStrawGasSteps::createDigis(
 	StrawPhysics const& strawphys,
 	StrawElectronics const& strawele,
@@ -482,16 +591,17 @@ namespace mu2e {
         Straw const& straw,
 	StrawClusterSequencePair const& hsp,
 	XTalk const& xtalk,
+	CLHEP::RandGaussQ& randgauss,
 	StrawDigiCollection* digis, StrawDigiMCCollection* mcdigis) {
       // instantiate waveforms for both ends of this straw
-      SWFP waveforms  ={ StrawWaveform(straw,hsp.clustSequence(StrawEnd::cal),xtalk),
-	StrawWaveform(straw,hsp.clustSequence(StrawEnd::hv),xtalk) };
+      SWFP waveforms  ={ StrawWaveform(strawele,straw,hsp.clustSequence(StrawEnd::cal),xtalk),
+	StrawWaveform(strawele,straw,hsp.clustSequence(StrawEnd::hv),xtalk) };
       // find the threshold crossing points for these waveforms
       WFXPList xings;
       // find the threshold crossings
-      findThresholdCrossings(strawele,waveforms,xings);
+      findThresholdCrossings(strawele,waveforms,randgauss,xings);
       // convert the crossing points into digis, and add them to the event data
-      fillDigis(strawphys,strawele,tracker,xings,waveforms,xtalk._dest,digis,mcdigis);
+      fillDigis(strawphys,strawele,tracker,xings,waveforms,xtalk._dest,randgauss,digis,mcdigis);
     }
 
     void StrawDigisFromStrawGasSteps::fillClusterMap(StrawPhysics const& strawphys,
@@ -515,6 +625,7 @@ namespace mu2e {
       if(stepsHandles.empty()){
 	throw cet::exception("SIM")<<"mu2e::StrawDigisFromStrawGasSteps: No StrawGasStep collections found for tracker" << endl;
       }
+      _arena.clear();
 
       // Loop over StrawGasStep collections
       for ( auto const& sgsch : stepsHandles) {
@@ -527,18 +638,24 @@ namespace mu2e {
 	  Straw const& straw = tracker.getStraw(sid);
 	  if(sgs.ionizingEdep() > _minstepE){
 	    auto sgsptr = SGSPtr(sgsch,isgs);
-	    // create a clust from this step, and add it to the clust map
-	    addStep(strawphys,strawele,straw,sgsptr,hmap[sid]);
+	    // every straw with a step gets an entry, even if none of its clusts are in the window
+	    hmap.emplace(sid,StrawClusterSequencePair(sid));
+	    // create clusts from this step, and add them to the arena
+	    addStep(strawphys,strawele,straw,sgsptr);
 	  }
 	}
       }
+      // time-order the clusts and point each straw's sequences at them
+      _arena.sort();
+      for(auto& ihsp : hmap)
+	ihsp.second = StrawClusterSequencePair(_arena.sequence(ihsp.first,StrawEnd::cal),
+	    _arena.sequence(ihsp.first,StrawEnd::hv));
     }
 
     void StrawDigisFromStrawGasSteps::addStep(StrawPhysics const& strawphys,
 	StrawElectronics const& strawele,
 	Straw const& straw,
-	SGSPtr const& sgsptr,
-	StrawClusterSequencePair& shsp) {
+	SGSPtr const& sgsptr) {
       auto const& sgs = *sgsptr;
       StrawId sid = sgs.strawId();
       // apply time offsets, and take module with MB
@@ -565,10 +682,10 @@ namespace mu2e {
 	    double gtime = ctime + wireq._time + weq._time;
 	    // create the clust
 	    StrawCluster clust(StrawCluster::primary,sid,end,(float)gtime,weq._charge,weq._wdist,wireq._pos,(float)wireq._time,(float)weq._time,sgsptr,(float)ctime);
-	    // add the clusts to the appropriate sequence.
-	    shsp.clustSequence(end).insert(clust);
+	    // add the clust to the arena; it is sorted into its sequence later
+	    _arena.insert(clust);
 	    // if required, add a 'ghost' copy of this clust
-	    addGhosts(strawele,clust,shsp.clustSequence(end));
+	    addGhosts(strawele,clust);
 	  }
 	}
 	if(_diag > 0) stepDiag(strawphys, strawele, sgs);
@@ -675,21 +792,21 @@ namespace mu2e {
       return mbtime;
     }
 
-    void StrawDigisFromStrawGasSteps::addGhosts(StrawElectronics const& strawele,StrawCluster const& clust,StrawClusterSequence& shs) {
+    void StrawDigisFromStrawGasSteps::addGhosts(StrawElectronics const& strawele,StrawCluster const& clust) {
       // add enough buffer to cover both the flash blanking and the ADC waveform
       if(clust.time() < strawele.flashStart() - _mbtime + _mbbuffer)
-	shs.insert(StrawCluster(clust,_mbtime));
-      if(clust.time() > _mbtime - _mbbuffer) shs.insert(StrawCluster(clust,-_mbtime));
+	_arena.insert(StrawCluster(clust,_mbtime));
+      if(clust.time() > _mbtime - _mbbuffer) _arena.insert(StrawCluster(clust,-_mbtime));
     }
 
-    void StrawDigisFromStrawGasSteps::findThresholdCrossings(StrawElectronics const& strawele, SWFP const& swfp, WFXPList& xings){
+    void StrawDigisFromStrawGasSteps::findThresholdCrossings(StrawElectronics const& strawele, SWFP const& swfp, CLHEP::RandGaussQ& randgauss, WFXPList& xings){
       //randomize the threshold to account for electronics noise; this includes parts that are coherent
       // for both ends (coming from the straw itself)
       // Keep track of crossings on each end to keep them in sequence
-      double strawnoise = _randgauss.fire(0,strawele.strawNoise());
+      double strawnoise = randgauss.fire(0,strawele.strawNoise());
       // add specifics for each end
-      double thresh[2] = {_randgauss.fire(strawele.threshold(swfp[0].straw().id(),static_cast<StrawEnd::End>(0))+strawnoise,strawele.analogNoise(StrawElectronics::thresh)),
-	_randgauss.fire(strawele.threshold(swfp[0].straw().id(),static_cast<StrawEnd::End>(1))+strawnoise,strawele.analogNoise(StrawElectronics::thresh))};
+      double thresh[2] = {randgauss.fire(strawele.threshold(swfp[0].straw().id(),static_cast<StrawEnd::End>(0))+strawnoise,strawele.analogNoise(StrawElectronics::thresh)),
+	randgauss.fire(strawele.threshold(swfp[0].straw().id(),static_cast<StrawEnd::End>(1))+strawnoise,strawele.analogNoise(StrawElectronics::thresh))};
       // Initialize search when the electronics becomes enabled:
       double tstart =strawele.flashEnd() - _flashbuffer; 
       // for reading all hits, make sure we start looking for clusters at the minimum possible cluster time
@@ -712,14 +829,14 @@ namespace mu2e {
 	  if(std::min(wfx[0]._time,wfx[1]._time) > 0.0 )xings.push_back(wfx);
 	  // search for next crossing:
 	  // update threshold for straw noise
-	  strawnoise = _randgauss.fire(0,strawele.strawNoise());
+	  strawnoise = randgauss.fire(0,strawele.strawNoise());
 	  for(unsigned iend=0;iend<2;++iend){
 	    // insure a minimum time buffer between crossings
 	    wfx[iend]._time += strawele.deadTimeAnalog();
 	    // skip to the next clust
 	    ++(wfx[iend]._iclust);
 	    // update threshold for incoherent noise
-	    thresh[iend] = _randgauss.fire(strawele.threshold(swfp[0].straw().id(),static_cast<StrawEnd::End>(iend)),strawele.analogNoise(StrawElectronics::thresh));
+	    thresh[iend] = randgauss.fire(strawele.threshold(swfp[0].straw().id(),static_cast<StrawEnd::End>(iend)),strawele.analogNoise(StrawElectronics::thresh));
 	    // find next crossing
 	    crosses[iend] = swfp[iend].crossesThreshold(strawele,thresh[iend],wfx[iend]);
 	  }
@@ -738,6 +855,7 @@ namespace mu2e {
 	Tracker const& tracker,
 	WFXPList const& xings, SWFP const& wf,
 	StrawId sid,
+	CLHEP::RandGaussQ& randgauss,
 	StrawDigiCollection* digis, StrawDigiMCCollection* mcdigis ) {
 	//
       Straw const& straw = tracker.getStraw(sid);
@@ -745,7 +863,7 @@ namespace mu2e {
       for(auto xpair : xings) {
 	// create a digi from this pair.  This also performs a finial test
 	// on whether the pair should make a digi
-	if(createDigi(strawele,xpair,wf,sid,digis)){
+	if(createDigi(strawele,xpair,wf,sid,randgauss,digis)){
 	  // fill associated MC truth matching. Only count the same step once
 	  StrawDigiMC::SGSPA sgspa;
 	  StrawDigiMC::PA cpos;
@@ -780,7 +898,7 @@ namespace mu2e {
     }
 
     bool StrawDigisFromStrawGasSteps::createDigi(StrawElectronics const& strawele, WFXP const& xpair, SWFP const& waveform,
-	StrawId sid, StrawDigiCollection* digis){
+	StrawId sid, CLHEP::RandGaussQ& randgauss, StrawDigiCollection* digis){
       // initialize the float variables that we later digitize
       TDCTimes xtimes = {0.0,0.0};
       TrkTypes::TOTValues tot;
@@ -797,21 +915,22 @@ namespace mu2e {
 	WFX const& wfx = xpair[iend];
 	// record the crossing time for this end, including clock jitter  These already include noise effects
 	// add noise for TDC on each side
-	double tdc_jitter = _randgauss.fire(0.0,strawele.TDCResolution());
+	double tdc_jitter = randgauss.fire(0.0,strawele.TDCResolution());
 	xtimes[iend] = wfx._time+dt+tdc_jitter;
 	// randomize threshold using the incoherent noise
-	double threshold = _randgauss.fire(wfx._vcross,strawele.analogNoise(StrawElectronics::thresh));
+	double threshold = randgauss.fire(wfx._vcross,strawele.analogNoise(StrawElectronics::thresh));
 	// find TOT
 	tot[iend] = waveform[iend].digitizeTOT(strawele,threshold,wfx._time + dt);
 	// sample ADC
 	waveform[iend].sampleADCWaveform(strawele,adctimes,wf[iend]);
+	if(_validateResponse)validateResponse(strawele,waveform[iend],wfx,adctimes,wf[iend]);
       }
       // uncalibrate
       strawele.uncalibrateTimes(xtimes,sid);
       // add ends and add noise
       ADCVoltages wfsum; wfsum.reserve(adctimes.size());
       for(unsigned isamp=0;isamp<adctimes.size();++isamp){
-	wfsum.push_back(wf[0][isamp]+wf[1][isamp]+_randgauss.fire(0.0,strawele.analogNoise(StrawElectronics::adc)));
+	wfsum.push_back(wf[0][isamp]+wf[1][isamp]+randgauss.fire(0.0,strawele.analogNoise(StrawElectronics::adc)));
       }
       // digitize, and make final test.  This call includes the clock error WRT the proton pulse
       TrkTypes::TDCValues tdcs;
@@ -830,6 +949,26 @@ namespace mu2e {
       return digitize;
     }
 
+    void StrawDigisFromStrawGasSteps::validateResponse(StrawElectronics const& strawele, StrawWaveform const& wf, WFX const& wfx,
+	ADCTimes const& adctimes, ADCVoltages const& volts) {
+      // compare the threshold response at the crossing
+      checkResponse(StrawElectronics::thresh,wf.sampleWaveform(strawele,StrawElectronics::thresh,wfx._time),
+	  wf.referenceWaveform(strawele,StrawElectronics::thresh,wfx._time));
+      // compare the ADC samples when they are the linear response.  The voltages are stored as float
+      if(wf.xtalk().self() && !wf.saturates(strawele)){
+	for(size_t isamp=0;isamp<adctimes.size();++isamp)
+	  checkResponse(StrawElectronics::adc,volts[isamp],(float)wf.referenceWaveform(strawele,StrawElectronics::adc,adctimes[isamp]));
+      }
+    }
+
+    void StrawDigisFromStrawGasSteps::checkResponse(StrawElectronics::Path ipath, double sampled, double direct) {
+      double diff = fabs(sampled-direct);
+      _hrespdiff[ipath]->Fill(diff > 0.0 ? log10(diff) : -15.99);
+      _maxrespdiff = std::max(_maxrespdiff,diff);
+      ++_nrespcheck;
+      if(diff > _responseTolerance)++_nrespfail;
+    }
+
     // find straws which couple to the given one, and record them and their couplings in XTalk objects.
     // For now, this is just a fixed number for adjacent straws,
     // the couplings and straw identities should eventually come from a database, FIXME!!!
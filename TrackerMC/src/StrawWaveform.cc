@@ -7,18 +7,39 @@
 //
 #include "TrackerMC/inc/StrawWaveform.hh"
 #include <cmath>
+#include <algorithm>
 #include <boost/math/special_functions/binomial.hpp>
 
 using namespace std;
 namespace mu2e {
   using namespace TrkTypes;
   namespace TrackerMC {
-    StrawWaveform::StrawWaveform(Straw const& straw, StrawClusterSequence const& hseq, XTalk const& xtalk) :
-      _cseq(hseq), _xtalk(xtalk), _straw(straw)
-    {}
+    StrawWaveform::StrawWaveform(StrawElectronics const& strawele, Straw const& straw, StrawClusterSequence const& hseq, XTalk const& xtalk) :
+      _cseq(hseq), _xtalk(xtalk), _straw(straw), _tconst(strawele.constantResponseTime(straw))
+    {
+      // accumulate the late-time response of each clust, so that sampling only needs to
+      // evaluate the clusts whose response is still changing
+      StrawClusterList const& hlist = _cseq.clustList();
+      _cresp.reserve(hlist.size());
+      for(auto& tailsum : _tailsum){
+	tailsum.reserve(hlist.size()+1);
+	tailsum.push_back(0.0);
+      }
+      _sattailsum.reserve(hlist.size()+1);
+      _sattailsum.push_back(0.0);
+      for(auto const& clust : hlist){
+	_cresp.push_back(strawele.chargeResponse(_straw,clust.charge(),clust.wireDistance()));
+	for(int ipath=0;ipath<StrawElectronics::npaths;++ipath)
+	  _tailsum[ipath].push_back(_tailsum[ipath].back() +
+	      strawele.linearResponse(_cresp.back(),static_cast<StrawElectronics::Path>(ipath),_tconst));
+	_sattailsum.push_back(_sattailsum.back() +
+	    strawele.linearResponse(_cresp.back(),StrawElectronics::thresh,_tconst,true));
+      }
+    }
 
     StrawWaveform::StrawWaveform(StrawWaveform const& other) : _cseq(other._cseq),
-    _xtalk(other._xtalk), _straw(other._straw)
+    _xtalk(other._xtalk), _straw(other._straw), _tconst(other._tconst), _cresp(other._cresp),
+    _tailsum(other._tailsum), _sattailsum(other._sattailsum)
     {}
 
     bool StrawWaveform::crossesThreshold(StrawElectronics const& strawele,double threshold,WFX& wfx) const {
@@ -146,15 +167,33 @@ namespace mu2e {
       return linresp;
     }
 
-    double StrawWaveform::sampleWaveform(StrawElectronics const& strawele,StrawElectronics::Path ipath,double time) const {
+    double StrawWaveform::linearResponse(StrawElectronics const& strawele,StrawElectronics::Path ipath,bool forsaturation,
+	double time,StrawClusterList::const_iterator ifirst) const {
+      // sum the response at this time of the clusts from ifirst on which start before it.  Clusts
+      // are time-ordered, so both the clusts that contribute and the old ones with constant
+      // response are contiguous ranges, found by binary search
+      StrawClusterList const& hlist = _cseq.clustList();
+      double lookback = strawele.clusterLookbackTime();
+      auto iend = std::partition_point(ifirst,hlist.end(),
+	  [lookback,time](StrawCluster const& clust){ return clust.time()-lookback < time; });
+      auto ivary = std::partition_point(ifirst,iend,
+	  [this,time](StrawCluster const& clust){ return time-clust.time() >= _tconst; });
+      std::vector<double> const& tailsum = forsaturation ? _sattailsum : _tailsum[ipath];
+      double linresp = tailsum[ivary-hlist.begin()] - tailsum[ifirst-hlist.begin()];
+      for(auto iclust = ivary; iclust != iend; ++iclust){
+	// compute the linear straw electronics response to this charge.  This is pre-saturation
+	linresp += strawele.linearResponse(_cresp[iclust-hlist.begin()],ipath,time-iclust->time(),forsaturation);
+      }
+      return linresp;
+    }
+
+    double StrawWaveform::referenceWaveform(StrawElectronics const& strawele,StrawElectronics::Path ipath,double time) const {
       // loop over all clusts and add their response at this time
       StrawClusterList const& hlist = _cseq.clustList();
       double linresp(0.0);
       auto iclust = hlist.begin();
       while(iclust != hlist.end() && iclust->time()-strawele.clusterLookbackTime() < time){
-	// compute the linear straw electronics response to this charge.  This is pre-saturation
 	linresp += strawele.linearResponse(_straw,ipath,time-iclust->time(),iclust->charge(),iclust->wireDistance());
-	// move to next clust
 	++iclust;
       }
       double totresp = linresp * _xtalk._postamp;
@@ -163,6 +202,23 @@ namespace mu2e {
       return totresp;
     }
 
+    bool StrawWaveform::saturates(StrawElectronics const& strawele) const {
+      double max_possible_voltage = 0;
+      for (auto iclust = _cseq.clustList().begin();iclust != _cseq.clustList().end();++iclust){
+        max_possible_voltage += maxLinearResponse(strawele,iclust);
+      }
+      return max_possible_voltage > strawele.saturationVoltage();
+    }
+
+    double StrawWaveform::sampleWaveform(StrawElectronics const& strawele,StrawElectronics::Path ipath,double time) const {
+      // add the response of all clusts at this time
+      double linresp = linearResponse(strawele,ipath,false,time,_cseq.clustList().begin());
+      double totresp = linresp * _xtalk._postamp;
+      if(_xtalk._preamp>0.0)
+	totresp += _xtalk._preamp*linresp;
+      return totresp;
+    }
+
     void StrawWaveform::sampleADCWaveform(StrawElectronics const& strawele,ADCTimes const& times,ADCVoltages& volts) const {
       volts.clear();
       volts.reserve(times.size());
@@ -175,11 +231,7 @@ namespace mu2e {
       }
 
       // check if going to be saturated
-      double max_possible_voltage = 0;
-      for (auto iclust = _cseq.clustList().begin();iclust != _cseq.clustList().end();++iclust){
-        max_possible_voltage += maxLinearResponse(strawele,iclust);
-      }
-      if (max_possible_voltage > strawele.saturationVoltage()){
+      if (saturates(strawele)){
         // create waveform of threshold circuit output
         // step along waveform and apply saturation
         // for each time, get contribution from each step in waveform using impulse response
@@ -198,18 +250,15 @@ namespace mu2e {
         for (size_t j=0;j<times.size();j++){
           volts.push_back(0);
         }
+        if (iclust == _cseq.clustList().end())
+          return;
 
         int num_steps = (int)ceil((times[times.size()-1]-iclust->time()-strawele.clusterLookbackTime())/strawele.saturationTimeStep());
 
         for (int i=0;i<num_steps;i++){
           double time = iclust->time()-strawele.clusterLookbackTime() + i*strawele.saturationTimeStep();
           // sum up the preamp response at this step
-          double response = 0;
-          auto jclust = iclust;
-          while(jclust != _cseq.clustList().end() && jclust->time()-strawele.clusterLookbackTime() < time){
-            response += strawele.linearResponse(_straw,StrawElectronics::thresh,time-jclust->time(),jclust->charge(),jclust->wireDistance(),true);
-            ++jclust;
-          }
+          double response = linearResponse(strawele,StrawElectronics::thresh,true,time,iclust);
           // now saturate it
           double sat_response = strawele.saturatedResponse(response);
           // then calculate the impulse response at each of the adctimes and add it to that
@@ -218,10 +267,24 @@ namespace mu2e {
             volts[j] += strawele.adcImpulseResponse(_straw.id(),times[j]-time,sat_response);
           }
         }
-      }else{
-        for(auto itime=times.begin();itime!=times.end();++itime){
-          volts.push_back(sampleWaveform(strawele,StrawElectronics::adc,*itime));
+      }else if (!times.empty()){
+        // add the response of each clust to all the samples in one pass.  Clusts whose response is
+        // constant over the whole (time-ordered) window are summed from the tails
+        StrawClusterList const& hlist = _cseq.clustList();
+        double lookback = strawele.clusterLookbackTime();
+        double tfirst = times.front(), tlast = times.back();
+        auto iend = std::partition_point(hlist.begin(),hlist.end(),
+            [lookback,tlast](StrawCluster const& clust){ return clust.time()-lookback < tlast; });
+        auto ivary = std::partition_point(hlist.begin(),iend,
+            [this,tfirst](StrawCluster const& clust){ return tfirst-clust.time() >= _tconst; });
+        std::vector<double> linresp(times.size(),_tailsum[StrawElectronics::adc][ivary-hlist.begin()]);
+        for(auto iclust = ivary; iclust != iend; ++iclust){
+          strawele.addLinearResponse(_cresp[iclust-hlist.begin()],StrawElectronics::adc,
+              iclust->time(),iclust->time()-lookback,times,linresp.data());
         }
+        // self x-talk only: see above
+        for(auto resp : linresp)
+          volts.push_back(resp * _xtalk._postamp);
       }
     }
 
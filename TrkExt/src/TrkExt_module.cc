@@ -516,38 +516,7 @@ namespace mu2e {
                                       double & byx, double & byy, double & byz, 
                                       double & bzx, double & bzy, double & bzz) {
 
-    Hep3Vector B0 = getBField(x);
-
-    if (_bFieldGradientMode == 1) {
-      double xx = x.x();
-      double yy = x.y();
-      double zz = x.z();
-      double h = 5.;
-      Hep3Vector mx (xx-h,yy,zz);
-      Hep3Vector px (xx+h,yy,zz);
-      Hep3Vector my (xx,yy-h,zz);
-      Hep3Vector py (xx,yy+h,zz);
-      Hep3Vector mz (xx,yy,zz-h);
-      Hep3Vector pz (xx,yy,zz+h);
-
-      Hep3Vector Bmx = getBField(mx);
-      Hep3Vector Bpx = getBField(px);
-      Hep3Vector Bmy = getBField(my);
-      Hep3Vector Bpy = getBField(py);
-      Hep3Vector Bmz = getBField(mz);
-      Hep3Vector Bpz = getBField(pz);
-
-      bxx = (Bpx.x() - Bmx.x()) / (2.*h);
-      bxy = (Bpy.x() - Bmy.x()) / (2.*h);
-      bxz = (Bpz.x() - Bmz.x()) / (2.*h);
-      byx = (Bpx.y() - Bmx.y()) / (2.*h);
-      byy = (Bpy.y() - Bmy.y()) / (2.*h);
-      byz = (Bpz.y() - Bmz.y()) / (2.*h);
-      bzx = (Bpx.z() - Bmx.z()) / (2.*h);
-      bzy = (Bpy.z() - Bmy.z()) / (2.*h);
-      bzz = (Bpz.z() - Bmz.z()) / (2.*h);
-    }
-    else {
+    if (_bFieldGradientMode != 1) {
       bxx = 0;
       bxy = 0;
       bxz = 0;
@@ -557,7 +526,27 @@ namespace mu2e {
       bzx = 0;
       bzy = 0;
       bzz = 0;
+      return getBField(x);
+    }
+
+    // field and derivatives from a single lookup in the map that contains x
+    Hep3Vector xx = x + _origin;
+    Hep3Vector B0;
+    double grad[3][3];
+    _bfMgr->getBFieldWithGradient(xx, B0, grad);
+    if (B0.mag() >10) {
+      if (_verbosity>=0) cout << "TrkExt: Crazy bfield : (" << B0.x() << ", " << B0.y() << ", " << B0.z() << ") at (" << xx.x() << ", " << xx.y() << ", " << xx.z() << ")" << endl;
     }
+
+    bxx = grad[0][0];
+    bxy = grad[0][1];
+    bxz = grad[0][2];
+    byx = grad[1][0];
+    byy = grad[1][1];
+    byz = grad[1][2];
+    bzx = grad[2][0];
+    bzy = grad[2][1];
+    bzz = grad[2][2];
     return B0;
   }
 
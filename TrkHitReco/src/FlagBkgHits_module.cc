@@ -22,6 +22,7 @@
 #include "Mu2eUtilities/inc/MVATools.hh"
 #include "TrkReco/inc/TNTClusterer.hh"
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -69,7 +70,7 @@ namespace mu2e
          bool                                        filter_, flagch_, flagsh_;
          bool                                        savebkg_;
          StrawHitFlag                                bkgmsk_, stereo_;
-         BkgClusterer*                               clusterer_;
+         std::unique_ptr<BkgClusterer>               clusterer_;
          float                                       cperr2_;
          float                                       bkgMVAcut_;
          MVATools                                    bkgMVA_;
@@ -80,7 +81,7 @@ namespace mu2e
          void classifyCluster(BkgClusterCollection& bkgccol, BkgQualCollection& bkgqcol, 
                               StrawHitFlagCollection& chfcol, const ComboHitCollection& chcol) const;
          void fillBkgQual(    const BkgCluster& cluster, BkgQual& cqual, const ComboHitCollection& chcol) const;
-         void fillMVA(        BkgQual& cqual) const;
+         void fillMVA(        std::vector<BkgQual>& cquals) const;
          void countHits(      const BkgCluster& cluster, unsigned& nactive, unsigned& nstereo, const ComboHitCollection& chcol) const;
          void countPlanes(    const BkgCluster& cluster, BkgQual& cqual, const ComboHitCollection& chcol) const;
          int  findClusterIdx( BkgClusterCollection& bkgccol, unsigned ich) const;
@@ -125,7 +126,7 @@ namespace mu2e
       switch ( ctype )
       {
         case TwoNiveauThreshold:
-           clusterer_ = new TNTClusterer(config().TNTClustering());
+           clusterer_.reset(new TNTClusterer(config().TNTClustering()));
            break;
        default:
            throw cet::exception("RECO")<< "Unknown clusterer" << ctype << std::endl;
@@ -250,11 +251,15 @@ namespace mu2e
   void FlagBkgHits::classifyCluster(BkgClusterCollection& bkgccol, BkgQualCollection& bkgqcol, 
                                     StrawHitFlagCollection& chfcol, const ComboHitCollection& chcol) const
   {   
-      for (auto& cluster : bkgccol)
+      // fill the qualities of all clusters first, so the MVA is evaluated in a single batch
+      std::vector<BkgQual> cquals(bkgccol.size());
+      for (size_t ic=0;ic<bkgccol.size();++ic) fillBkgQual(bkgccol[ic], cquals[ic], chcol);
+      fillMVA(cquals);
+
+      for (size_t ic=0;ic<bkgccol.size();++ic)
       {                
-           BkgQual cqual;
-           fillBkgQual(cluster, cqual, chcol);
-           fillMVA(cqual);
+           auto& cluster = bkgccol[ic];
+           auto& cqual   = cquals[ic];
 
            StrawHitFlag flag(StrawHitFlag::bkgclust);
            if (cqual.MVAOutput() > bkgMVAcut_)
@@ -311,22 +316,35 @@ namespace mu2e
   
   
   //----------------------------------------------
-  void FlagBkgHits::fillMVA(BkgQual& cqual) const
+  void FlagBkgHits::fillMVA(std::vector<BkgQual>& cquals) const
   {
-       if (cqual.status() == MVAStatus::unset) return;
-
-       std::vector<float> mvavars(7,0.0);
-       mvavars[0] = cqual.varValue(BkgQual::crho);
-       mvavars[1] = cqual.varValue(BkgQual::zmin);
-       mvavars[2] = cqual.varValue(BkgQual::zmax);
-       mvavars[3] = cqual.varValue(BkgQual::zgap);
-       mvavars[4] = cqual.varValue(BkgQual::np);
-       mvavars[5] = cqual.varValue(BkgQual::npfrac);
-       mvavars[6] = cqual.varValue(BkgQual::nhits);
-       float mvaout = bkgMVA_.evalMVA(mvavars);
-
-       cqual.setMVAValue(mvaout);
-       cqual.setMVAStatus(MVAStatus::calculated);
+       const size_t nvar(7);
+       std::vector<float> mvavars;
+       std::vector<size_t> iquals;
+       for (size_t iq=0;iq<cquals.size();++iq)
+       {
+           const auto& cqual = cquals[iq];
+           if (cqual.status() == MVAStatus::unset) continue;
+           iquals.push_back(iq);
+           mvavars.push_back(cqual.varValue(BkgQual::crho));
+           mvavars.push_back(cqual.varValue(BkgQual::zmin));
+           mvavars.push_back(cqual.varValue(BkgQual::zmax));
+           mvavars.push_back(cqual.varValue(BkgQual::zgap));
+           mvavars.push_back(cqual.varValue(BkgQual::np));
+           mvavars.push_back(cqual.varValue(BkgQual::npfrac));
+           mvavars.push_back(cqual.varValue(BkgQual::nhits));
+       }
+       if (iquals.empty()) return;
+
+       MVATools::Scratch scratch;
+       std::vector<float> mvaout(iquals.size());
+       bkgMVA_.evalMVA(mvavars.data(), iquals.size(), nvar, mvaout.data(), scratch);
+
+       for (size_t i=0;i<iquals.size();++i)
+       {
+           cquals[iquals[i]].setMVAValue(mvaout[i]);
+           cquals[iquals[i]].setMVAStatus(MVAStatus::calculated);
+       }
    }
 
 
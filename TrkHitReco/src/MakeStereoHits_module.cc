@@ -25,6 +25,7 @@
 #include "RecoDataProducts/inc/ComboHit.hh"
 #include "RecoDataProducts/inc/StrawHitFlag.hh"
 #include "Mu2eUtilities/inc/MVATools.hh"
+#include "Mu2eUtilities/inc/ScratchArena.hh"
 // boost
 #include <boost/accumulators/accumulators.hpp>
 #include <boost/accumulators/statistics/mean.hpp>
@@ -86,6 +87,7 @@ namespace mu2e {
 
       MVATools _mvatool;
       StereoMVA _vmva; 
+      ScratchArena _arena; // per-event temporary storage
 
       std::array<std::vector<StrawId>,StrawId::_nupanels > _panelOverlap;   // which panels overlap each other
       void genMap();    
@@ -109,7 +111,8 @@ namespace mu2e {
     _doMVA(pset.get<bool>(  "doMVA",false)),
     _maxfsep(pset.get<unsigned>("MaxFaceSeparation",3)), // max separation between faces in a station
     _testflag(pset.get<bool>("TestFlag")),
-    _mvatool(pset.get<fhicl::ParameterSet>("MVATool",fhicl::ParameterSet()))
+    _mvatool(pset.get<fhicl::ParameterSet>("MVATool",fhicl::ParameterSet())),
+    _arena("MakeStereoHits",_debug > 0)
     {
       float minR = pset.get<float>("minimumRadius",395); // mm
       _minR2 = minR*minR;
@@ -137,6 +140,7 @@ namespace mu2e {
   }
 
   void MakeStereoHits::produce(art::Event& event) {
+    ScratchArena::Scope scratch(_arena);
 // find input: I have to get a Handle, not ValidHandle, to get the productID
     art::Handle<ComboHitCollection> chH;
     if(!event.getByLabel(_chTag, chH))
@@ -148,10 +152,11 @@ namespace mu2e {
     // reference the parent in the new collection
     chcol->setParent(chH);
     // sort hits by unique panel.  This should be built in by construction upstream FIXME!!
-    std::array<std::vector<uint16_t>,StrawId::_nupanels> phits;
+    ScratchVector<ScratchVector<uint16_t> > phits(StrawId::_nupanels,ScratchVector<uint16_t>(_arena.allocator<uint16_t>()),
+                                                  _arena.allocator<ScratchVector<uint16_t> >());
     size_t nch = _chcol->size();
     if(_debug > 1)cout << "MakeStereoHits found " << nch << " Input hits" << endl;
-    std::vector<bool> used(nch,false);
+    ScratchVector<bool> used(nch,false,_arena.allocator<bool>());
     for(uint16_t ihit=0;ihit<nch;++ihit){
       ComboHit const& ch = (*_chcol)[ihit];
       // select hits based on flag
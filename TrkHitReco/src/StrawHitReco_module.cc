@@ -21,7 +21,7 @@
 #include "ConditionsBase/inc/TrackerCalibrationStructs.hh"
 #include "ConfigTools/inc/ConfigFileLookupPolicy.hh"
 #include "GeometryService/inc/GeomHandle.hh"
-#include "TrackerGeom/inc/Tracker.hh"
+#include "TrackerConditions/inc/StrawGeometry.hh"
 #include "TrackerConditions/inc/StrawResponse.hh"
 #include "TrackerConditions/inc/DeadStraw.hh"
 
@@ -37,6 +37,8 @@
 #include "RecoDataProducts/inc/ComboHit.hh"
 #include "RecoDataProducts/inc/StrawHit.hh"
 
+#include "Mu2eUtilities/inc/ScratchArena.hh"
+
 #include "TH1F.h"
 
 #include <memory>
@@ -82,6 +84,7 @@ namespace mu2e {
        art::InputTag _ewMarkerTag; // name of the module that makes eventwindowmarkers
        fhicl::ParameterSet _peakfit;  // peak fit (charge reconstruction) parameters
        std::unique_ptr<TrkHitReco::PeakFit> _pfit; // peak fitting algorithm
+       ScratchArena _arena; // per-event temporary storage
        // diagnostic
        TH1F* _maxiter;
        // helper function
@@ -89,7 +92,7 @@ namespace mu2e {
        float peakMinusPed(StrawId id, TrkTypes::ADCWaveform const& adcData) const;
     ProditionsHandle<StrawResponse> _strawResponse_h;
     ProditionsHandle<DeadStraw> _deadStraw_h;
-    ProditionsHandle<Tracker> _alignedTracker_h;
+    ProditionsHandle<StrawGeometry> _strawGeom_h;
 
 
  };
@@ -115,7 +118,8 @@ namespace mu2e {
       _sdtoken{consumes<StrawDigiCollection>(pset.get<art::InputTag>("StrawDigiCollection","makeSD"))},
       _cctoken{mayConsume<CaloClusterCollection>(pset.get<art::InputTag>("caloClusterModuleLabel","CaloClusterFast"))},
       _ewMarkerTag(pset.get<art::InputTag>("EventWindowMarkerLabel")),
-      _peakfit(pset.get<fhicl::ParameterSet>("PeakFitter", {}))
+      _peakfit(pset.get<fhicl::ParameterSet>("PeakFitter", {})),
+      _arena("StrawHitReco",_printLevel > 0)
   {
       consumes<EventWindowMarker>(_ewMarkerTag);
       produces<ComboHitCollection>();
@@ -161,10 +165,11 @@ namespace mu2e {
   {
       if (_printLevel > 0) std::cout << "In StrawHitReco produce " << std::endl;
 
-      const Tracker& tt = _alignedTracker_h.get(event.id());
+      ScratchArena::Scope scratch(_arena);
+      StrawGeometry const& sgeom = _strawGeom_h.get(event.id());
 
-      size_t nplanes = tt.nPlanes();
-      size_t npanels = tt.getPlane(0).nPanels();
+      size_t nplanes = StrawId::_nplanes;
+      size_t npanels = StrawId::_npanels;
       auto const& srep = _strawResponse_h.get(event.id());
       auto sdH = event.getValidHandle(_sdtoken);
       const StrawDigiCollection& sdcol(*sdH);
@@ -190,8 +195,9 @@ namespace mu2e {
       std::unique_ptr<ComboHitCollection> chCol(new ComboHitCollection());
       chCol->reserve(sdcol.size());
 
-      std::vector<std::vector<size_t> > hits_by_panel(nplanes*npanels,std::vector<size_t>());
-      std::vector<size_t> largeHits, largeHitPanels;
+      ScratchVector<ScratchVector<size_t> > hits_by_panel(nplanes*npanels,ScratchVector<size_t>(_arena.allocator<size_t>()),
+                                                          _arena.allocator<ScratchVector<size_t> >());
+      ScratchVector<size_t> largeHits(_arena.allocator<size_t>()), largeHitPanels(_arena.allocator<size_t>());
       largeHits.reserve(sdcol.size());
       largeHitPanels.reserve(sdcol.size());
 
@@ -259,35 +265,37 @@ namespace mu2e {
 	float tot = tots[eend.end()];
 	// filter on specific ionization FIXME!
 	// filter based on composite e/P separation FIXME!
-	const Straw& straw  = tt.getStraw( digi.strawId() );
+	StrawId const& sid = digi.strawId();
+	float halflen = sgeom.halfLength(sid);
 	double dw, dwerr;
 	double dt = times[StrawEnd::cal] - times[StrawEnd::hv];
         double halfpv;
 	// get distance along wire from the straw center and it's estimated error
-	bool td = srep.wireDistance(straw,energy,dt, dw,dwerr,halfpv);
-        float propd = straw.halfLength()+dw;
+	bool td = srep.wireDistance(halflen,energy,dt, dw,dwerr,halfpv);
+        float propd = halflen+dw;
         if (eend == StrawEnd(StrawEnd::hv))
-          propd = straw.halfLength()-dw;
-	XYZVec pos = Geom::toXYZVec(straw.getMidPoint()+dw*straw.getDirection());
+          propd = halflen-dw;
+	XYZVec wdir = sgeom.direction(sid);
+	XYZVec pos = sgeom.midPoint(sid)+dw*wdir;
 	// create combo hit
 	static const XYZVec _zdir(0.0,0.0,1.0);
 	ComboHit ch;
 	ch._nsh = 1; // 'combo' of 1 hit
 	ch._pos = pos;
-	ch._wdir = straw.getDirection();
+	ch._wdir = wdir;
 	ch._sdir = _zdir.Cross(ch._wdir);
 	ch._wdist = dw;
 	ch._wres = dwerr;
 	ch._time = time;
 	ch._edep = energy;
-	ch._sid = straw.id();
-	ch._dtime = srep.driftTime(straw,tot,energy);
+	ch._sid = sid;
+	ch._dtime = srep.driftTime(sid,tot,energy);
         ch._ptime = propd/(2*halfpv);
-	ch._pathlength = srep.pathLength(straw,tot);
+	ch._pathlength = srep.pathLength(sid,tot);
 	ch.addIndex(isd); // reference the digi; this allows MC truth matching to work
 	// crude initial estimate of the transverse error
 	static const float invsqrt12 = 1.0/sqrt(12.0);
-	ch._tres = straw.getRadius()*invsqrt12;
+	ch._tres = sgeom.radius(sid)*invsqrt12;
 	// set flags
 	ch._mask = _mask;
 	ch._flag = flag;
@@ -295,8 +303,8 @@ namespace mu2e {
 	ch._tend = eend;
 	if(!_filter && _flagXT){
 	  //buffer large hit for cross-talk analysis
-	  size_t iplane       = straw.id().getPlane();
-	  size_t ipnl         = straw.id().getPanel();
+	  size_t iplane       = sid.getPlane();
+	  size_t ipnl         = sid.getPanel();
 	  size_t global_panel = ipnl + iplane*npanels;
 	  hits_by_panel[global_panel].push_back(shCol->size());
 	  if (energy >= _ctE) {largeHits.push_back(shCol->size()); largeHitPanels.push_back(global_panel);}
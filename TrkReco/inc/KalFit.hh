@@ -35,6 +35,7 @@
 #include "TrackerConditions/inc/StrawResponse.hh"
 #include "TrackerConditions/inc/Mu2eDetector.hh"
 #include "TrkReco/inc/TrkPrintUtils.hh"
+#include "Mu2eUtilities/inc/ScratchArena.hh"
 
 //CLHEP
 #include "CLHEP/Units/PhysicalConstants.h"
@@ -139,6 +140,7 @@ namespace mu2e
     std::array<float,2> _zmaxcalo, _zmincalo, _rmaxcalo, _rmincalo;
 
     TrkPrintUtils*  _printUtils;
+    ScratchArena    _arena; // temporary storage of addMaterial
 
   // helper functions
     bool fitable(KalSeed const& kseed);
@@ -39,10 +39,22 @@ namespace mu2e {
 	// update the hit state and the t0 value.
 	virtual bool resolveTrk(KalRep* krep) const;
       private:
+	// chisquared of a panel state, identified by its index in the PanelStateIterator sequence
+	struct StateChisq {
+	  Float_t _chisq;
+	  unsigned _istate;
+	};
+	typedef std::vector<StateChisq> SCV;
 	// resolve the ambiguity on a single panel
 	bool resolvePanel(TrkStrawHitVector& phits, KalRep* krep) const;
 	// fill information about a given panel's track and hits
 	bool fillPanelInfo(TrkStrawHitVector const& phits, const KalRep* krep, PanelInfo& pinfo) const;
+	// compute the chisquared of all the ambiguity/activity states with a solution, sorted by chisquared
+	void searchStates(PanelInfo const& pinfo,TrkT0 const& t0, SCV& chisqs) const;
+	// set the hit states and penalties from the best states, and fill diagnostics
+	bool applyResults(TrkStrawHitVector& phits, PanelInfo const& pinfo,TrkT0 const& t0, SCV const& chisqs) const;
+	// panel state from its index
+	PanelState panelState(PanelInfo const& pinfo, unsigned istate) const;
 	// compute the panel result for a given ambiguity/activity state and the ionput t0
 	void fillResult(PanelInfo const& pinfo,TrkT0 const& t0, PanelResult& result) const;
 	// parameters
@@ -57,6 +69,7 @@ namespace mu2e {
 	double _maxhitu; // maximum u value allowed for a hit
 	bool _fixunallowed; // fix the state of any hit whose initial state isn't allowed
 	unsigned _maxnpanel; // max # of hits to consider for a panel
+	bool _concurrent; // search the states of all the panels of a track concurrently
 	int _diag; // diagnostic level`
 	// TTree variables, mutable so they don't change const
 	mutable TTree *_padiag, *_pudiag; // diagnostic TTree
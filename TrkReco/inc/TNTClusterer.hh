@@ -9,6 +9,7 @@
 #include "fhiclcpp/types/Atom.h"
 #include "RecoDataProducts/inc/StrawDigiCollection.hh"
 #include "TrkReco/inc/BkgClusterer.hh"
+#include "Mu2eUtilities/inc/ScratchArena.hh"
 #include "fhiclcpp/types/Sequence.h"
 
 #include <string>
@@ -65,7 +66,7 @@ namespace mu2e {
 
       private:                   
           static const int numBuckets = 256; //number of buckets to store the clusters vs time - optimized for speed
-          using arrayVecBkg = std::array<std::vector<int>,numBuckets>;
+          using arrayVecBkg = ScratchVector<ScratchVector<int>>;
 
           void     initClu(const ComboHitCollection& chcol, std::vector<BkgCluster>& clusters, std::vector<BkgHit>& hinfo); 
           void     clusterAlgo(const ComboHitCollection& chcol, std::vector<BkgCluster>& clusters, 
@@ -99,6 +100,7 @@ namespace mu2e {
 	  bool	           testflag_;   
           int              diag_;
 	  int              ditime_;
+          ScratchArena     arena_;
    };
 }
 #endif
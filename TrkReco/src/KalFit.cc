@@ -125,7 +125,8 @@ namespace mu2e
     _exup((extent)pset.get<int>("UpstreamExtent",noextension)),
     _exdown((extent)pset.get<int>("DownstreamExtent",noextension)),
     _ttcalc            (pset.get<fhicl::ParameterSet>("T0Calculator",fhicl::ParameterSet())),
-    _bfield(0)
+    _bfield(0),
+    _arena("KalFit",_debug > 0)
   {
 // set KalContext parameters
     _disttol = pset.get<double>("IterationTolerance",0.1);
@@ -565,8 +566,9 @@ namespace mu2e
 // Tracker geometry
     const Tracker& tracker = *_tracker;
 // storage of potential straws
+    ScratchArena::Scope scratch(_arena);
     StrawFlightComp strawcomp(_maxmatfltdiff);
-    std::set<StrawFlight,StrawFlightComp> matstraws(strawcomp);
+    std::set<StrawFlight,StrawFlightComp,ScratchAllocator<StrawFlight> > matstraws(strawcomp,_arena.allocator<StrawFlight>());
 // loop over Planes
     double strawradius = tracker.strawOuterRadius();
     unsigned nadded(0);
@@ -6,7 +6,6 @@
 // $Date: 2012/08/31 22:39:00 $
 //
 #include "TrkReco/inc/PanelAmbigResolver.hh"
-#include "TrkReco/inc/PanelStateIterator.hh"
 #include "BTrkData/inc/TrkStrawHit.hh"
 #include "BTrk/BaBar/BaBar.hh"
 #include "BTrk/TrkBase/TrkT0.hh"
@@ -16,6 +15,10 @@
 #include "BTrk/TrkBase/TrkPoca.hh"
 #include "BTrk/difAlgebra/DifPoint.hh"
 #include "BTrk/difAlgebra/DifVector.hh"
+#include "Math/SMatrix.h"
+#include "Math/SVector.h"
+#include "tbb/parallel_for.h"
+#include "tbb/blocked_range.h"
 #include <vector>
 #include <algorithm>
 #include <functional>
@@ -33,14 +36,14 @@ namespace mu2e {
       bool operator()(TrkStrawHit* x, TrkStrawHit* y) { return x->straw().id().getPanelId() < y->straw().id().getPanelId(); }
     };
 
-    // functor to sort panel results by chisquared
-    struct resultcomp : public std::binary_function<PanelResult const&, PanelResult const&,bool> {
-      bool operator()(PanelResult const& a, PanelResult const& b) { return a._chisq < b._chisq; }
-    };
-
     typedef TrkStrawHitVector::iterator TSHI;
     typedef TrkStrawHitVector::const_iterator TSHCI;
 
+    // sums of the terms of the chisquared expansion over the panel hits, and the chisquared penalty
+    enum PanelSum {wsum=0,uwsum,vwsum,uuwsum,vvwsum,uvwsum,penalty,nsums};
+    typedef ROOT::Math::SVector<double,nsums> PanelSums;
+    typedef ROOT::Math::SMatrix<double,2,2,ROOT::Math::MatRepSym<double,2> > SymMat2;
+
 
     PanelAmbigResolver::PanelAmbigResolver(fhicl::ParameterSet const& pset, double tmpErr, size_t iter): 
       AmbigResolver(tmpErr),
@@ -53,6 +56,7 @@ namespace mu2e {
       _maxhitu(pset.get<double>("MaximumHitU",8.0)),
       _fixunallowed(pset.get<bool>("FixUnallowedHitStates",true)),
       _maxnpanel(pset.get<unsigned>("MaxHitsPerPanel",8)),
+      _concurrent(pset.get<bool>("ConcurrentPanels",false)),
       _diag(pset.get<int>("DiagLevel",0))
     {
       double nullerr = pset.get<double>("ExtraNullAmbigError",0.0);
@@ -95,19 +99,51 @@ namespace mu2e {
       convert(krep->hitVector(),tshv);
       std::sort(tshv.begin(),tshv.end(),panelcomp());
       // collect hits in the same panel
+      std::vector<TrkStrawHitVector> panels;
       auto ihit=tshv.begin();
       while(ihit!=tshv.end()){
 	PanelId pid = (*ihit)->straw().id().getPanelId();
-	(*ihit)->setTemperature(AmbigResolver::_tmpErr);
 	TrkStrawHitVector phits;
 	auto jhit=ihit;
 	while(jhit != tshv.end() && (*jhit)->straw().id().getPanelId() == pid){
 	  phits.push_back(*jhit++);
 	}
-	// resolve the panel hits
-	retval |= resolvePanel(phits,krep);
+	panels.push_back(phits);
 	ihit = jhit;
       }
+      if(_concurrent){
+	// project all the panels on the input fit, search their states concurrently, then
+	// update the hits in panel order.  Unlike the panel-by-panel resolution, a panel
+	// does not see the hit states set on the panels before it
+	size_t npanels = panels.size();
+	std::vector<PanelInfo> pinfos(npanels);
+	std::vector<bool> usable(npanels);
+	for(size_t ipanel=0;ipanel<npanels;++ipanel){
+	  panels[ipanel].front()->setTemperature(AmbigResolver::_tmpErr);
+	  std::sort(panels[ipanel].begin(),panels[ipanel].end(),hitsort());
+	  usable[ipanel] = fillPanelInfo(panels[ipanel],krep,pinfos[ipanel]);
+	}
+	TrkT0 const& t0 = krep->t0();
+	std::vector<SCV> chisqs(npanels);
+	tbb::parallel_for(tbb::blocked_range<size_t>(0,npanels),
+	    [&](tbb::blocked_range<size_t> const& range){
+	    for(size_t ipanel=range.begin();ipanel!=range.end();++ipanel){
+	      if(usable[ipanel])searchStates(pinfos[ipanel],t0,chisqs[ipanel]);
+	    }
+	  });
+	for(size_t ipanel=0;ipanel<npanels;++ipanel){
+	  if(usable[ipanel])
+	    retval |= applyResults(panels[ipanel],pinfos[ipanel],t0,chisqs[ipanel]);
+	  else
+	    std::cout << "PanelAmbigResolver: Panel with " << panels[ipanel].size() << " hits has no usable info" << std::endl;
+	}
+      } else {
+	// resolve the panel hits
+	for(auto& phits : panels){
+	  phits.front()->setTemperature(AmbigResolver::_tmpErr);
+	  retval |= resolvePanel(phits,krep);
+	}
+      }
       return retval;
     }
 
@@ -118,55 +154,194 @@ namespace mu2e {
       // fill panel information
       PanelInfo pinfo;
       if(fillPanelInfo(phits,krep,pinfo)){
-	// loop over all ambiguity/activity states for this panel
-	PanelStateIterator psi(pinfo._uinfo,_allowed);
-	PRV results;
-	do {
-	  // for each state, fill the result of the 1-dimensional optimization
-	  PanelResult result(psi.current());
-	  fillResult(pinfo,krep->t0(),result);
-	  if(result._status == 0)results.push_back(result);
-	} while(psi.increment());
-	if(results.size() > 0){
-	  // sort the results to have lowest chisquard first
-	  std::sort(results.begin(),results.end(),resultcomp());
-	  // for now, set the hit state according to the best result.  In future, maybe we want to treat
-	  // cases with different ambiguities differently from inactive hits
-	  retval |= setHitStates(results[0]._state,phits);
-	  // if the chisq difference between patterns is negligible, inflate the errors of the
-	  // hit which changes
-	  size_t nhits = results[0]._state.size();
-	  size_t ires(1);
-	  while (ires < results.size() && results[ires]._chisq - results[0]._chisq < _minsep){
-	    for(size_t ihit=0;ihit<nhits;++ihit){
-	      if(results[ires]._state[ihit] != results[0]._state[ihit]){
-		phits[ihit]->setPenalty(_penaltyres);
-	      }
+	// find the chisquared of all ambiguity/activity states for this panel
+	SCV chisqs;
+	searchStates(pinfo,krep->t0(),chisqs);
+	retval |= applyResults(phits,pinfo,krep->t0(),chisqs);
+      } else 
+	std::cout << "PanelAmbigResolver: Panel with " << phits.size() << " hits has no usable info" << std::endl;
+
+      return retval;
+    }
+
+    // Find the 1-dimensional optimization of every state given by PanelStateIterator.
+    // The states are visited in a reflected (Gray code) order, in which consecutive states
+    // differ by the state of a single hit, and the sums over the hits are kept for each
+    // leading subset of the hits.  Changing the state of a hit then only requires
+    // re-adding the terms of that hit and the ones after it, which on average is about one
+    // hit per state.  The sums are formed in the same order as fillResult, and the solution
+    // repeats its arithmetic, so the chisquared values are identical to it: subtracting
+    // the old terms of the hit instead would be cheaper, but the rounding could reorder
+    // states with close chisquared.  The results are sorted from the sequence of
+    // PanelStateIterator, so that states with equal chisquared come out in the same order.
+    void PanelAmbigResolver::searchStates(PanelInfo const& pinfo,TrkT0 const& t0, SCV& chisqs) const {
+      chisqs.clear();
+      // if there are no used hits, no state has a solution
+      if(pinfo._nused == 0)return;
+      // terms of each allowed state of each used hit.  Only free hits change state
+      size_t nallowed = _allowed.size();
+      std::vector<PanelSums> terms;
+      std::vector<size_t> first, nterms; // terms of each used hit
+      std::vector<int> stride; // change of the state index for a change of the hit state
+      terms.reserve(pinfo._nused*nallowed);
+      unsigned nstates(1);
+      for(auto const& tshui : pinfo._uinfo) {
+	if(tshui._use == TSHUInfo::unused)continue;
+	first.push_back(terms.size());
+	HSV states;
+	if(tshui._use == TSHUInfo::free){
+	  states = _allowed;
+	  stride.push_back(nstates);
+	  nstates *= nallowed;
+	} else {
+	  states.push_back(tshui._hstate);
+	  stride.push_back(0);
+	}
+	for(auto const& tshs : states) {
+	  PanelSums hterms;
+	  if(tshs._state != HitState::inactive){
+	    double w = tshui._uwt;
+	    double r = tshui._dr;
+	    double v = tshui._dv;
+	    // sign for ambiguity
+	    if(tshs._state == HitState::negambig){
+	      r *= -1;
+	      v *= -1;
+	    } else if(tshs._state == HitState::noambig){
+	      r = 0.; // inactive hits don't depend on time
+	      v = 0.;
+	      w = 1.0/(1.0/w + _nullerr2); // increase the error on 0 ambiguity hits
+	      hterms[penalty] = _nullpenalty;
 	    }
-	    ++ires;
-	  }
+	    double u = tshui._upos + r;
+	    hterms[wsum] = w;
+	    hterms[uwsum] = u*w;
+	    hterms[vwsum] = v*w;
+	    hterms[uuwsum] = u*u*w;
+	    hterms[vvwsum] = v*v*w;
+	    hterms[uvwsum] = u*v*w;
+	  } else // penalize inactive hits
+	    hterms[penalty] = _inactivepenalty;
+	  terms.push_back(hterms);
 	}
-	if( _diag > 1 ) {
-	  _nuhits = _nrhits = pinfo._uinfo.size();
-	  _nactive = 0;
-	  for(auto const& ishi : pinfo._uinfo) {
-	    if(ishi._active)++_nactive;
-	  }
-	  _nres = results.size();
-	  _results = results;
-	  _padiag->Fill();
-	  //
-	  _tupos = pinfo._tupos;
-	  _tuerr = pinfo._tuerr;
-	  _uinfo = pinfo._uinfo;
-	  _pudiag->Fill();
+	nterms.push_back(states.size());
+      }
+      size_t nused = first.size();
+      // sums over the leading hits, the state of each hit and its direction of change
+      std::vector<PanelSums> sums(nused+1);
+      std::vector<size_t> ihs(nused,0);
+      std::vector<int> dir(nused,1);
+      for(size_t iused=0;iused<nused;++iused)
+	sums[iused+1] = sums[iused] + terms[first[iused]];
+      double t0wt = 1.0/(t0._t0err*t0._t0err);
+      std::vector<Float_t> chisq(nstates);
+      std::vector<bool> solved(nstates,false);
+      int istate(0);
+      while(true) {
+	// see fillResult for the solution
+	PanelSums const& psums = sums[nused];
+	SymMat2 gamma;
+	gamma(0,0) = psums[wsum];
+	gamma(1,1) = psums[vvwsum] + t0wt;
+	gamma(0,1) = psums[vwsum];
+	if(_addtrkpos || pinfo._nused == 1)gamma(0,0) += pinfo._tuwt;
+	double det = gamma(0,0)*gamma(1,1) - gamma(0,1)*gamma(0,1);
+	if(det != 0){
+	  double s = 1.0/det;
+	  double g11 = s*gamma(1,1);
+	  double g22 = s*gamma(0,0);
+	  gamma(0,1) *= -s;
+	  gamma(0,0) = g11;
+	  gamma(1,1) = g22;
+	  double b1 = psums[uwsum];
+	  double b2 = psums[uvwsum];
+	  double d1 = gamma(0,0)*b1 + gamma(0,1)*b2;
+	  double d2 = gamma(1,0)*b1 + gamma(1,1)*b2;
+	  chisq[istate] = psums[uuwsum] - (d1*b1 + d2*b2) + psums[penalty];
+	  solved[istate] = true;
 	}
-      } else 
-	std::cout << "PanelAmbigResolver: Panel with " << phits.size() << " hits has no usable info" << std::endl;
+	// change the state of the last hit which can move in its direction; the hits
+	// after it are at the end of their states, and reverse direction
+	size_t iused = nused;
+	while(iused > 0){
+	  size_t jhs = ihs[iused-1] + dir[iused-1];
+	  if(jhs < nterms[iused-1])break; // also catches stepping back from 0
+	  dir[iused-1] = -dir[iused-1];
+	  --iused;
+	}
+	if(iused == 0)break;
+	--iused;
+	ihs[iused] += dir[iused];
+	istate += dir[iused]*stride[iused];
+	for(size_t jused=iused;jused<nused;++jused)
+	  sums[jused+1] = sums[jused] + terms[first[jused]+ihs[jused]];
+      }
+      for(unsigned jstate=0;jstate<nstates;++jstate){
+	if(solved[jstate])chisqs.push_back(StateChisq{chisq[jstate],jstate});
+      }
+      // sort the results to have lowest chisquard first
+      std::sort(chisqs.begin(),chisqs.end(),
+	  [](StateChisq const& a, StateChisq const& b) { return a._chisq < b._chisq; });
+    }
 
+    bool PanelAmbigResolver::applyResults(TrkStrawHitVector& phits, PanelInfo const& pinfo,TrkT0 const& t0, SCV const& chisqs) const {
+      bool retval(false); // assume nothing changes
+      if(chisqs.size() > 0){
+	// for now, set the hit state according to the best result.  In future, maybe we want to treat
+	// cases with different ambiguities differently from inactive hits
+	PanelState best = panelState(pinfo,chisqs[0]._istate);
+	retval |= setHitStates(best,phits);
+	// if the chisq difference between patterns is negligible, inflate the errors of the
+	// hit which changes
+	size_t nhits = best.size();
+	size_t ires(1);
+	while (ires < chisqs.size() && chisqs[ires]._chisq - chisqs[0]._chisq < _minsep){
+	  PanelState state = panelState(pinfo,chisqs[ires]._istate);
+	  for(size_t ihit=0;ihit<nhits;++ihit){
+	    if(state[ihit] != best[ihit]){
+	      phits[ihit]->setPenalty(_penaltyres);
+	    }
+	  }
+	  ++ires;
+	}
+      }
+      if( _diag > 1 ) {
+	_nuhits = _nrhits = pinfo._uinfo.size();
+	_nactive = 0;
+	for(auto const& ishi : pinfo._uinfo) {
+	  if(ishi._active)++_nactive;
+	}
+	_nres = chisqs.size();
+	_results.clear();
+	for(auto const& sc : chisqs) {
+	  PanelResult result(panelState(pinfo,sc._istate));
+	  fillResult(pinfo,t0,result);
+	  _results.push_back(result);
+	}
+	_padiag->Fill();
+	//
+	_tupos = pinfo._tupos;
+	_tuerr = pinfo._tuerr;
+	_uinfo = pinfo._uinfo;
+	_pudiag->Fill();
+      }
       return retval;
     }
 
+    // the state sequence of PanelStateIterator: free hits take the allowed states in turn, the first hit fastest
+    PanelState PanelAmbigResolver::panelState(PanelInfo const& pinfo, unsigned istate) const {
+      PanelState pstate;
+      pstate.reserve(pinfo._uinfo.size());
+      for(auto const& tshui : pinfo._uinfo) {
+	if(tshui._use == TSHUInfo::free){
+	  pstate.push_back(_allowed[istate%_allowed.size()]);
+	  istate /= _allowed.size();
+	} else
+	  pstate.push_back(tshui._hstate);
+      }
+      return pstate;
+    }
+
     bool PanelAmbigResolver::fillPanelInfo(TrkStrawHitVector const& phits, const KalRep* krep, PanelInfo& pinfo) const {
       bool retval(false);
       // find the best trajectory we can local to these hits, but excluding their information ( if possible).
@@ -19,7 +19,8 @@ namespace mu2e
       bkgmask_   (config.bkgmsk()),
       sigmask_   (config.sigmsk()),
       testflag_  (config.testflag()),
-      diag_      (config.diag())
+      diag_      (config.diag()),
+      arena_     ("TNTClusterer",diag_ > 0)
    {
        // cache some values
        float minerr (config.minHitError());
@@ -40,6 +41,7 @@ namespace mu2e
    //----------------------------------------------------------------------------------------------------------
    void TNTClusterer::findClusters(BkgClusterCollection& clusters, const ComboHitCollection& chcol, float mbtime, int iev)
    {        
+        ScratchArena::Scope scratch(arena_);
         std::vector<BkgHit> BkgHits;
         BkgHits.reserve(chcol.size());
 
@@ -83,7 +85,7 @@ namespace mu2e
    //----------------------------------------------------------------------------------------------------------------------
    void TNTClusterer::clusterAlgo(const ComboHitCollection& chcol, std::vector<BkgCluster>& clusters, std::vector<BkgHit>& BkgHits, float tbin)
    {                            
-        arrayVecBkg hitIndex;
+        arrayVecBkg hitIndex(numBuckets,ScratchVector<int>(arena_.allocator<int>()),arena_.allocator<ScratchVector<int>>());
         for (auto& vec : hitIndex) vec.reserve(16);
               
         unsigned niter(0);